@@ -0,0 +1,24 @@
+#include <benchmark/benchmark.h>
+
+#include <dcsm.hpp>
+
+// Counters: bytes_per_second covers the range string, items_per_second is ranges parsed per second.
+
+static void bm_parse_address_range(benchmark::State& a_state, std::string const& a_range) {
+    for (auto _ : a_state) {
+        auto range = dcsm::parse_address_range(a_range);
+        benchmark::DoNotOptimize(range);
+    }
+
+    a_state.SetBytesProcessed(static_cast<int64_t>(a_state.iterations() * a_range.size()));
+    a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations()));
+}
+
+BENCHMARK_CAPTURE(bm_parse_address_range, single,         std::string("1/20"));
+BENCHMARK_CAPTURE(bm_parse_address_range, small,          std::string("1/20 thru 1/40"));
+BENCHMARK_CAPTURE(bm_parse_address_range, universe,       std::string("1/1 thru 1/512"));
+BENCHMARK_CAPTURE(bm_parse_address_range, huge_64,        std::string("1/1 thru 64/512"));
+BENCHMARK_CAPTURE(bm_parse_address_range, huge_512,       std::string("1/1 thru 512/512"));
+BENCHMARK_CAPTURE(bm_parse_address_range, selector_odd,   std::string("1/1 thru 8/512 odd"));
+BENCHMARK_CAPTURE(bm_parse_address_range, selector_chain, std::string("1/1 thru 8/512 even offset 3"));
+BENCHMARK_CAPTURE(bm_parse_address_range, combinations,   std::string("1/1 thru 8/512 odd offset 3 + 10/1 thru 12/512 even - 11/100 thru 11/200 + 20 thru 40"));
@@ -0,0 +1,105 @@
+#include <benchmark/benchmark.h>
+
+#include <dcsm.hpp>
+#include <dcsm_artnet.hpp>
+
+// Art-Net ingest of 256 universes per frame, in packets per second (items_per_second): parsing, mapping
+// and change suppression in memory, and the whole path through a loopback UDP socket on Linux. The
+// frame_budget counter is the share of a 44 Hz frame (22.7 ms) spent per frame of 256 universes.
+
+namespace {
+    constexpr size_t artnet_universes = 256;
+    constexpr double frame_period = 1.0 / 44;
+
+    /// One full packet per port-address; a_changed_addresses change every frame, as during a fade.
+    struct artnet_traffic {
+        std::vector<std::vector<uint8_t>> packets = std::vector<std::vector<uint8_t>>(artnet_universes);
+        std::vector<uint8_t> data = std::vector<uint8_t>(512, 0);
+        uint8_t sequence = 0;
+
+        void next_frame(size_t const a_changed_addresses) {
+            for (size_t i = 0; i < a_changed_addresses; ++i) {
+                ++data[(sequence * 7 + i * 37) % 512];
+            }
+
+            sequence = static_cast<uint8_t>(sequence == 255 ? 1 : sequence + 1);
+
+            for (size_t i = 0; i < packets.size(); ++i) {
+                packets[i].clear();
+                dcsm::append_artdmx(packets[i], static_cast<uint16_t>(i), sequence, data.data(), 512);
+            }
+        }
+    };
+
+    dcsm::artnet_bridge make_bridge() {
+        dcsm::artnet_bridge bridge([](uint8_t const* a_frame, size_t const a_size) {
+            benchmark::DoNotOptimize(a_frame);
+        });
+
+        for (size_t i = 0; i < artnet_universes; ++i) {
+            bridge.map(static_cast<uint16_t>(i), static_cast<uint16_t>(i + 1));
+        }
+
+        return bridge;
+    }
+}
+
+/// Argument: addresses changed per universe and frame (0 unchanged, 512 every address).
+static void bm_artnet_bridge(benchmark::State& a_state) {
+    auto bridge = make_bridge();
+    artnet_traffic traffic;
+    auto const now = dcsm::universe_bridge::clock::now();
+
+    for (auto _ : a_state) {
+        a_state.PauseTiming();
+        traffic.next_frame(static_cast<size_t>(a_state.range(0)));
+        a_state.ResumeTiming();
+
+        for (auto const& packet : traffic.packets) {
+            benchmark::DoNotOptimize(bridge.receive(packet.data(), packet.size(), now));
+        }
+    }
+
+    a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations() * artnet_universes));
+    a_state.counters["frame_budget"] = benchmark::Counter(static_cast<double>(a_state.iterations()) * frame_period,
+                                                          benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+BENCHMARK(bm_artnet_bridge)->Arg(0)->Arg(4)->Arg(512);
+
+#if defined(__linux__)
+static void bm_artnet_udp(benchmark::State& a_state) {
+    auto bridge = make_bridge();
+    dcsm::artnet_receiver receiver(0, "127.0.0.1");
+    int const sender = ::socket(AF_INET, SOCK_DGRAM, 0);
+
+    sockaddr_in destination{};
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons(receiver.port());
+    ::inet_pton(AF_INET, "127.0.0.1", &destination.sin_addr);
+
+    artnet_traffic traffic;
+    size_t received = 0;
+
+    for (auto _ : a_state) {
+        a_state.PauseTiming();
+        traffic.next_frame(4);
+        a_state.ResumeTiming();
+
+        for (auto const& packet : traffic.packets) {
+            ::sendto(sender, packet.data(), packet.size(), 0, reinterpret_cast<sockaddr const*>(&destination), sizeof(destination));
+        }
+
+        received += receiver.poll(bridge, 0);
+    }
+
+    ::close(sender);
+
+    a_state.SetItemsProcessed(static_cast<int64_t>(received));
+    a_state.counters["lost"] = static_cast<double>(a_state.iterations() * artnet_universes - received);
+    a_state.counters["frame_budget"] = benchmark::Counter(static_cast<double>(a_state.iterations()) * frame_period,
+                                                          benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+BENCHMARK(bm_artnet_udp);
+#endif
@@ -0,0 +1,43 @@
+#include <benchmark/benchmark.h>
+
+#include <dcsm.hpp>
+
+// Counters: bytes_per_second covers the 64 packed mask bytes, items_per_second is masks converted per second.
+
+static void bm_bytes_to_bitset(benchmark::State& a_state) {
+    std::array<uint8_t, 64> bytes;
+
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<uint8_t>(i * 37 + 11);
+    }
+
+    for (auto _ : a_state) {
+        benchmark::DoNotOptimize(bytes.data());
+        auto set = dcsm::bytes_to_bitset<512>(bytes.data());
+        benchmark::DoNotOptimize(set);
+    }
+
+    a_state.SetBytesProcessed(static_cast<int64_t>(a_state.iterations() * bytes.size()));
+    a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations()));
+}
+
+static void bm_bitset_to_bytes(benchmark::State& a_state) {
+    std::array<uint8_t, 64> bytes;
+    dcsm::universe_mask set;
+
+    for (size_t i = 0; i < set.size(); i += 3) {
+        set.set(i);
+    }
+
+    for (auto _ : a_state) {
+        benchmark::DoNotOptimize(&set);
+        dcsm::bitset_to_bytes(bytes.data(), set);
+        benchmark::DoNotOptimize(bytes.data());
+    }
+
+    a_state.SetBytesProcessed(static_cast<int64_t>(a_state.iterations() * bytes.size()));
+    a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations()));
+}
+
+BENCHMARK(bm_bytes_to_bitset);
+BENCHMARK(bm_bitset_to_bytes);
@@ -0,0 +1,92 @@
+#include <benchmark/benchmark.h>
+
+#include <dcsm.hpp>
+
+// Counters: bytes_per_second covers the command plaintext, items_per_second is commands per second.
+
+struct bench_command_interface final : dcsm::dispatch_interface {
+    void dcsm_setutv(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const a_value, dcsm::universe_mask const &a_mask) override {
+        benchmark::DoNotOptimize(&a_mask);
+    }
+
+    void dcsm_setmtv(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const a_value, dcsm::universe_mask const &a_mask) override {
+        benchmark::DoNotOptimize(&a_mask);
+    }
+
+    void dcsm_geta(dcsm::command_context &a_ctx, std::vector<dcsm::address_pack> const &a_addresses) override {
+        benchmark::DoNotOptimize(a_addresses.data());
+    }
+
+    void dcsm_getma(dcsm::command_context &a_ctx, std::vector<dcsm::address_pack> const &a_addresses) override {
+        benchmark::DoNotOptimize(a_addresses.data());
+    }
+};
+
+/// Commands as typed at a console during programming and playback.
+static std::string const command_corpus[] {
+    "set 1 @ full",
+    "set 20 thru 40 @ 50%",
+    "set 1/20 thru 1/30 @ 255",
+    "set 1/1 thru 1/512 @ out",
+    "set 1 thru 96 odd @ 75%",
+    "set 1/1 thru 2/512 offset 4 @ half",
+    "set 1/1 thru 1/48 + 2/1 thru 2/48 - 1/10 thru 1/12 @ 10",
+    "mset 2/1 thru 2/16 @ 50%",
+    "get 2/400 thru 2/450",
+    "mget 2/1 thru 2/32",
+    "copy 1 to 2",
+    "patch 4 to 5",
+    "patch 1 to 2 mask 3",
+    "unpatch 5",
+    "patches",
+    "framerate 44",
+    "framerate",
+    "identify",
+    "ports",
+    "createmask 3",
+    "masks",
+    "clearmask 3",
+    "deletemask 3",
+};
+
+static void bm_command_corpus(benchmark::State& a_state) {
+    bench_command_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    size_t corpus_bytes = 0;
+
+    for (auto const& command : command_corpus) {
+        corpus_bytes += command.size();
+    }
+
+    for (auto _ : a_state) {
+        for (auto const& command : command_corpus) {
+            benchmark::DoNotOptimize(dsp.process_command(command));
+        }
+    }
+
+    a_state.SetBytesProcessed(static_cast<int64_t>(a_state.iterations() * corpus_bytes));
+    a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations() * (sizeof(command_corpus) / sizeof(command_corpus[0]))));
+}
+
+static void bm_command(benchmark::State& a_state, std::string const& a_command) {
+    bench_command_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    for (auto _ : a_state) {
+        benchmark::DoNotOptimize(dsp.process_command(a_command));
+    }
+
+    a_state.SetBytesProcessed(static_cast<int64_t>(a_state.iterations() * a_command.size()));
+    a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations()));
+}
+
+BENCHMARK(bm_command_corpus);
+
+BENCHMARK_CAPTURE(bm_command, set_single,    std::string("set 1 @ full"));
+BENCHMARK_CAPTURE(bm_command, set_range,     std::string("set 1/20 thru 1/30 @ 255"));
+BENCHMARK_CAPTURE(bm_command, set_universe,  std::string("set 1/1 thru 1/512 @ out"));
+BENCHMARK_CAPTURE(bm_command, set_selectors, std::string("set 1/1 thru 2/512 offset 4 @ half"));
+BENCHMARK_CAPTURE(bm_command, get_range,     std::string("get 2/400 thru 2/450"));
+BENCHMARK_CAPTURE(bm_command, patch,         std::string("patch 1 to 2 mask 3"));
+BENCHMARK_CAPTURE(bm_command, batch,         std::string("set 1 thru 24 @ full; set 25 thru 48 @ out; mset 2/1 @ 50%"));
@@ -0,0 +1,419 @@
+#include <benchmark/benchmark.h>
+
+#include <dcsm.hpp>
+#include <dcsm_changes.hpp>
+#include <dcsm_encoder.hpp>
+
+// Counters: bytes_per_second covers the whole frame (identifying byte + header + body),
+// items_per_second is messages per second.
+
+struct bench_message_interface final : dcsm::dispatch_interface {
+    std::array<uint8_t, 512> universe{};
+
+    uint8_t* dcsm_universe_buffer(dcsm::command_context &a_ctx, uint16_t const a_universe) override {
+        return universe.data();
+    }
+
+    void dcsm_setu(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const *a_data) override {
+        benchmark::DoNotOptimize(a_data);
+    }
+
+    void dcsm_setv(dcsm::command_context &a_ctx, std::vector<std::pair<dcsm::address_pack, uint8_t>> const &a_pairs) override {
+        benchmark::DoNotOptimize(a_pairs.data());
+    }
+
+    void dcsm_setmu(dcsm::command_context &a_ctx, uint16_t const a_universe, dcsm::universe_mask const &a_mask, uint8_t const *a_data) override {
+        benchmark::DoNotOptimize(&a_mask);
+    }
+
+    void dcsm_setmv(dcsm::command_context &a_ctx, uint16_t const a_universe, std::vector<std::tuple<uint16_t, bool, uint8_t>> const &a_pairs) override {
+        benchmark::DoNotOptimize(a_pairs.data());
+    }
+
+    void dcsm_setsp(dcsm::command_context &a_ctx, std::vector<dcsm::universe_span> const &a_spans) override {
+        benchmark::DoNotOptimize(a_spans.data());
+    }
+
+    void dcsm_setutv(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const a_value, dcsm::universe_mask const &a_mask) override {
+        benchmark::DoNotOptimize(&a_mask);
+    }
+
+    void dcsm_setmtv(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const a_value, dcsm::universe_mask const &a_mask) override {
+        benchmark::DoNotOptimize(&a_mask);
+    }
+
+    void dcsm_geta(dcsm::command_context &a_ctx, std::vector<dcsm::address_pack> const &a_addresses) override {
+        benchmark::DoNotOptimize(a_addresses.data());
+    }
+
+    void dcsm_getma(dcsm::command_context &a_ctx, std::vector<dcsm::address_pack> const &a_addresses) override {
+        benchmark::DoNotOptimize(a_addresses.data());
+    }
+};
+
+/// Build a complete direct control frame (identifying byte, header, body).
+static std::vector<uint8_t> make_frame(uint16_t const a_opcode, std::vector<uint8_t> const& a_body) {
+    std::vector<uint8_t> frame(5 + a_body.size());
+
+    dcsm::message_header const header { a_opcode, static_cast<uint16_t>(a_body.size()) };
+
+    frame[0] = 0x00;
+    memcpy(frame.data() + 1, &header, sizeof(header));
+    std::copy(a_body.begin(), a_body.end(), frame.begin() + 5);
+
+    return frame;
+}
+
+/// Deterministic filler so bodies are not trivially compressible or all-zero.
+static std::vector<uint8_t> make_bytes(size_t const a_size, uint8_t a_seed = 1) {
+    std::vector<uint8_t> bytes(a_size);
+
+    for (auto& byte : bytes) {
+        a_seed = static_cast<uint8_t>(a_seed * 33 + 7);
+        byte = a_seed;
+    }
+
+    return bytes;
+}
+
+static void append_u16(std::vector<uint8_t>& a_body, uint16_t const a_value) {
+    uint8_t bytes[2];
+    memcpy(bytes, &a_value, sizeof(a_value));
+    a_body.insert(a_body.end(), bytes, bytes + 2);
+}
+
+static std::vector<uint8_t> universe_body(uint16_t const a_universe) {
+    std::vector<uint8_t> body;
+    append_u16(body, a_universe);
+    return body;
+}
+
+static void run_frame(benchmark::State& a_state, std::vector<uint8_t> const& a_frame) {
+    bench_message_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    for (auto _ : a_state) {
+        benchmark::DoNotOptimize(dsp.process_message(a_frame.data()));
+    }
+
+    a_state.SetBytesProcessed(static_cast<int64_t>(a_state.iterations() * a_frame.size()));
+    a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations()));
+}
+
+// ------------------------ FIXED-SIZE BODIES ------------------------
+
+static void bm_message(benchmark::State& a_state, uint16_t const a_opcode, std::vector<uint8_t> const& a_body) {
+    run_frame(a_state, make_frame(a_opcode, a_body));
+}
+
+static std::vector<uint8_t> setu_body() {
+    auto body = universe_body(3);
+    auto const data = make_bytes(512);
+    body.insert(body.end(), data.begin(), data.end());
+    return body;
+}
+
+static std::vector<uint8_t> setmu_body() {
+    auto body = universe_body(3);
+    auto const mask_and_data = make_bytes(64 + 512);
+    body.insert(body.end(), mask_and_data.begin(), mask_and_data.end());
+    return body;
+}
+
+static std::vector<uint8_t> to_value_body() {
+    auto body = universe_body(3);
+    body.push_back(200);
+    auto const mask = make_bytes(64);
+    body.insert(body.end(), mask.begin(), mask.end());
+    return body;
+}
+
+static std::vector<uint8_t> universes_body(std::initializer_list<uint16_t> const a_universes) {
+    std::vector<uint8_t> body;
+
+    for (auto const universe : a_universes) {
+        append_u16(body, universe);
+    }
+
+    return body;
+}
+
+BENCHMARK_CAPTURE(bm_message, id,     0x0001, std::vector<uint8_t>{});
+BENCHMARK_CAPTURE(bm_message, setu,   0x0002, setu_body());
+BENCHMARK_CAPTURE(bm_message, getu,   0x0004, universe_body(3));
+BENCHMARK_CAPTURE(bm_message, setfr,  0x0005, std::vector<uint8_t>{ 44 });
+BENCHMARK_CAPTURE(bm_message, getfr,  0x0006, std::vector<uint8_t>{});
+BENCHMARK_CAPTURE(bm_message, newmu,  0x0007, universe_body(3));
+BENCHMARK_CAPTURE(bm_message, listmu, 0x0008, std::vector<uint8_t>{});
+BENCHMARK_CAPTURE(bm_message, delmu,  0x0009, universe_body(3));
+BENCHMARK_CAPTURE(bm_message, setmu,  0x000A, setmu_body());
+BENCHMARK_CAPTURE(bm_message, getmu,  0x000C, universe_body(3));
+BENCHMARK_CAPTURE(bm_message, clrmu,  0x000D, universe_body(3));
+BENCHMARK_CAPTURE(bm_message, patch,  0x000E, universes_body({ 1, 2, 3 }));
+BENCHMARK_CAPTURE(bm_message, unpat,  0x000F, universe_body(2));
+BENCHMARK_CAPTURE(bm_message, listp,  0x0010, std::vector<uint8_t>{});
+BENCHMARK_CAPTURE(bm_message, copy,   0x0011, universes_body({ 1, 2 }));
+BENCHMARK_CAPTURE(bm_message, setutv, 0x0012, to_value_body());
+BENCHMARK_CAPTURE(bm_message, setmtv, 0x0013, to_value_body());
+BENCHMARK_CAPTURE(bm_message, listu,  0x0014, std::vector<uint8_t>{});
+
+// ---------------------- VARIABLE-SIZE BODIES -----------------------
+// Argument: number of entries. 8 (a fader move), 64 (a fixture group), 512 (a universe), 4096 (a large cue).
+
+static void bm_setv(benchmark::State& a_state) {
+    std::vector<uint8_t> body;
+    auto const values = make_bytes(static_cast<size_t>(a_state.range(0)));
+
+    for (size_t i = 0; i < values.size(); ++i) {
+        append_u16(body, static_cast<uint16_t>(1 + i / 512));
+        append_u16(body, static_cast<uint16_t>(1 + i % 512));
+        body.push_back(values[i]);
+    }
+
+    run_frame(a_state, make_frame(0x0003, body));
+}
+
+static void bm_setmv(benchmark::State& a_state) {
+    auto body = universe_body(3);
+    auto const values = make_bytes(static_cast<size_t>(a_state.range(0)));
+
+    for (size_t i = 0; i < values.size(); ++i) {
+        append_u16(body, static_cast<uint16_t>(1 + i % 512));
+        body.push_back(i % 2);
+        body.push_back(values[i]);
+    }
+
+    run_frame(a_state, make_frame(0x000B, body));
+}
+
+static std::vector<uint8_t> addresses_body(size_t const a_count) {
+    std::vector<uint8_t> body;
+
+    for (size_t i = 0; i < a_count; ++i) {
+        append_u16(body, static_cast<uint16_t>(1 + i / 512));
+        append_u16(body, static_cast<uint16_t>(1 + i % 512));
+    }
+
+    return body;
+}
+
+static void bm_geta(benchmark::State& a_state) {
+    run_frame(a_state, make_frame(0x0015, addresses_body(static_cast<size_t>(a_state.range(0)))));
+}
+
+static void bm_getma(benchmark::State& a_state) {
+    run_frame(a_state, make_frame(0x0016, addresses_body(static_cast<size_t>(a_state.range(0)))));
+}
+
+BENCHMARK(bm_setv) ->Arg(8)->Arg(64)->Arg(512)->Arg(4096);
+BENCHMARK(bm_setmv)->Arg(8)->Arg(64)->Arg(512)->Arg(4096);
+BENCHMARK(bm_geta) ->Arg(8)->Arg(64)->Arg(512)->Arg(4096);
+BENCHMARK(bm_getma)->Arg(8)->Arg(64)->Arg(512)->Arg(4096);
+
+// ------------------------ COMPRESSED UNIVERSES ------------------------
+// Show-like data (runs of 0 and 255, a few faded channels) against setu of the same universe.
+
+static std::array<uint8_t, 512> show_universe(uint8_t const a_fade) {
+    std::array<uint8_t, 512> data{};
+
+    std::fill(data.begin() + 40, data.begin() + 120, 255);
+    std::fill(data.begin() + 300, data.begin() + 324, a_fade);
+
+    return data;
+}
+
+static void bm_setuc(benchmark::State& a_state, bool const a_delta) {
+    auto const previous = show_universe(100);
+    auto const current  = show_universe(140);
+
+    std::vector<uint8_t> frame;
+    dcsm::encode_setuc(frame, 3, current.data(), a_delta ? previous.data() : nullptr);
+
+    run_frame(a_state, frame);
+}
+
+static void bm_setuc_encode(benchmark::State& a_state, bool const a_delta) {
+    auto const previous = show_universe(100);
+    auto const current  = show_universe(140);
+
+    std::vector<uint8_t> frame;
+
+    for (auto _ : a_state) {
+        frame.clear();
+        dcsm::encode_setuc(frame, 3, current.data(), a_delta ? previous.data() : nullptr);
+        benchmark::DoNotOptimize(frame.data());
+    }
+
+    a_state.SetBytesProcessed(static_cast<int64_t>(a_state.iterations() * 512));
+    a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations()));
+}
+
+BENCHMARK_CAPTURE(bm_setuc, runs,  false);
+BENCHMARK_CAPTURE(bm_setuc, delta, true);
+BENCHMARK_CAPTURE(bm_setuc_encode, runs,  false);
+BENCHMARK_CAPTURE(bm_setuc_encode, delta, true);
+
+// ------------------------- BULK UNIVERSES --------------------------
+// Argument: number of universes, sent as one setub frame or as that many setu frames.
+
+static void bm_setub(benchmark::State& a_state) {
+    auto const data = make_bytes(512);
+    std::vector<std::pair<uint16_t, uint8_t const*>> universes;
+
+    for (int64_t i = 0; i < a_state.range(0); ++i) {
+        universes.emplace_back(static_cast<uint16_t>(i + 1), data.data());
+    }
+
+    std::vector<uint8_t> frame;
+    dcsm::encode_setub(frame, universes);
+
+    run_frame(a_state, frame);
+    a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations()) * a_state.range(0));
+}
+
+static void bm_setu_repeated(benchmark::State& a_state) {
+    bench_message_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    auto const data = make_bytes(512);
+    std::vector<uint8_t> frames;
+
+    for (int64_t i = 0; i < a_state.range(0); ++i) {
+        dcsm::encode_setu(frames, static_cast<uint16_t>(i + 1), data.data());
+    }
+
+    size_t const frame_size = dcsm::message_header_size + 2 + 512;
+
+    for (auto _ : a_state) {
+        for (size_t offset = 0; offset < frames.size(); offset += frame_size) {
+            benchmark::DoNotOptimize(dsp.process_message(frames.data() + offset));
+        }
+    }
+
+    a_state.SetBytesProcessed(static_cast<int64_t>(a_state.iterations() * frames.size()));
+    a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations()) * a_state.range(0));
+}
+
+BENCHMARK(bm_setub)        ->Arg(4)->Arg(16)->Arg(127);
+BENCHMARK(bm_setu_repeated)->Arg(4)->Arg(16)->Arg(127);
+
+// ------------------------------ SPANS ------------------------------
+// Argument: consecutive addresses (one moving light is ~40), as one setsp span or as setv pairs.
+
+static void bm_setsp(benchmark::State& a_state) {
+    auto const values = make_bytes(static_cast<size_t>(a_state.range(0)));
+
+    std::vector<uint8_t> frame;
+    dcsm::encode_setsp(frame, { { 3, 1, static_cast<uint16_t>(values.size()), values.data() } });
+
+    run_frame(a_state, frame);
+}
+
+static void bm_setv_consecutive(benchmark::State& a_state) {
+    auto const values = make_bytes(static_cast<size_t>(a_state.range(0)));
+    std::vector<std::pair<dcsm::address_pack, uint8_t>> pairs;
+
+    for (size_t i = 0; i < values.size(); ++i) {
+        pairs.emplace_back(dcsm::address_pack{ 3, static_cast<uint16_t>(i + 1) }, values[i]);
+    }
+
+    std::vector<uint8_t> frame;
+    dcsm::encode_setv(frame, pairs);
+
+    run_frame(a_state, frame);
+}
+
+BENCHMARK(bm_setsp)           ->Arg(8)->Arg(40)->Arg(512);
+BENCHMARK(bm_setv_consecutive)->Arg(8)->Arg(40)->Arg(512);
+
+// ---------------------------- CHECKSUMS ----------------------------
+// Same setu frame with and without a CRC-32C trailer; crc32c alone for the hardware and portable paths.
+
+static void bm_setu_checksummed(benchmark::State& a_state) {
+    auto const data = make_bytes(512);
+
+    std::vector<uint8_t> frame;
+    dcsm::encode_setu(frame, 3, data.data());
+    dcsm::append_checksum(frame, 0);
+
+    run_frame(a_state, frame);
+}
+
+static void bm_crc32c(benchmark::State& a_state, uint32_t (*a_crc)(uint8_t const*, size_t, uint32_t)) {
+    auto const data = make_bytes(static_cast<size_t>(a_state.range(0)));
+
+    for (auto _ : a_state) {
+        benchmark::DoNotOptimize(a_crc(data.data(), data.size(), 0));
+    }
+
+    a_state.SetBytesProcessed(static_cast<int64_t>(a_state.iterations() * data.size()));
+}
+
+BENCHMARK(bm_setu_checksummed);
+BENCHMARK_CAPTURE(bm_crc32c, selected, dcsm::crc32c)         ->Arg(16)->Arg(521);
+BENCHMARK_CAPTURE(bm_crc32c, portable, dcsm::crc32c_portable)->Arg(16)->Arg(521);
+
+// Universe hash for hashu sync verification: one universe, and 64 of them as a device answers a combined hashu.
+
+static void bm_hash_universe(benchmark::State& a_state) {
+    auto const data = make_bytes(512);
+    size_t const universes = static_cast<size_t>(a_state.range(0));
+    std::vector<uint64_t> hashes(universes);
+
+    for (auto _ : a_state) {
+        for (auto& hash : hashes) {
+            hash = dcsm::hash_universe(data.data());
+        }
+
+        benchmark::DoNotOptimize(dcsm::combine_hashes(hashes.data(), hashes.size()));
+    }
+
+    a_state.SetBytesProcessed(static_cast<int64_t>(a_state.iterations() * universes * 512));
+}
+
+BENCHMARK(bm_hash_universe)->Arg(1)->Arg(64);
+
+// --------------------- DIFFERENTIAL READBACK -----------------------
+// getud reply for an idle universe and one with a few changes; the universe diff alone for the SIMD
+// and portable paths.
+
+static void bm_getud_reply(benchmark::State& a_state) {
+    auto data = make_bytes(512);
+    dcsm::differential_readback readback;
+
+    std::vector<uint8_t> reply;
+    readback.reply(reply, 1, 1, 0, data.data());
+    uint32_t generation = 0;
+    std::memcpy(&generation, reply.data() + dcsm::message_header_size + 2, sizeof(generation));
+
+    int64_t const changes = a_state.range(0);
+
+    for (auto _ : a_state) {
+        for (int64_t i = 0; i < changes; ++i) {
+            data[static_cast<size_t>(i * 37 % 512)] ^= 1;
+        }
+
+        reply.clear();
+        readback.reply(reply, 1, 1, generation, data.data());
+        std::memcpy(&generation, reply.data() + dcsm::message_header_size + 2, sizeof(generation));
+        benchmark::DoNotOptimize(reply.data());
+    }
+
+    a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations()));
+}
+
+static void bm_diff_universe(benchmark::State& a_state, dcsm::universe_diff (*a_diff)(uint8_t const*, uint8_t const*)) {
+    auto const lhs = make_bytes(512);
+    auto rhs = lhs;
+    rhs[100] ^= 1;
+
+    for (auto _ : a_state) {
+        benchmark::DoNotOptimize(a_diff(lhs.data(), rhs.data()));
+    }
+
+    a_state.SetBytesProcessed(static_cast<int64_t>(a_state.iterations() * 512));
+}
+
+BENCHMARK(bm_getud_reply)->Arg(0)->Arg(8);
+BENCHMARK_CAPTURE(bm_diff_universe, selected, dcsm::diff_universe);
+BENCHMARK_CAPTURE(bm_diff_universe, portable, dcsm::diff_universe_portable);
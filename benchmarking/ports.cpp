@@ -0,0 +1,128 @@
+#include <benchmark/benchmark.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+#include <dcsm_ports.hpp>
+
+// One thread feeding many devices, with pseudo-terminals standing in for their USB serial ports.
+// Arguments: ports, universes per port per output frame. items_per_second counts universes; the
+// devices_at_44hz counter is how many such devices the thread keeps at 44 frames per second. The
+// device ends are drained on the same thread, so the figures are a lower bound.
+
+#if defined(__linux__)
+namespace {
+    struct pty_rack {
+        std::vector<int> devices;
+
+        /// Open a_count pty pairs; returns the host ends.
+        std::vector<int> open(size_t const a_count) {
+            std::vector<int> hosts;
+
+            for (size_t i = 0; i < a_count; ++i) {
+                int const host = ::posix_openpt(O_RDWR | O_NOCTTY);
+                ::grantpt(host);
+                ::unlockpt(host);
+
+                int const device = ::open(::ptsname(host), O_RDWR | O_NOCTTY | O_NONBLOCK);
+                termios attributes{};
+                ::tcgetattr(device, &attributes);
+                ::cfmakeraw(&attributes);
+                ::tcsetattr(device, TCSANOW, &attributes);
+
+                hosts.push_back(host);
+                devices.push_back(device);
+            }
+
+            return hosts;
+        }
+
+        ~pty_rack() {
+            for (int const fd : devices) {
+                ::close(fd);
+            }
+        }
+
+        void drain() {
+            uint8_t buffer[16384];
+
+            for (int const fd : devices) {
+                while (::read(fd, buffer, sizeof(buffer)) > 0) {}
+            }
+        }
+    };
+
+    void set_counters(benchmark::State& a_state, size_t const a_ports, size_t const a_universes) {
+        a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations() * a_ports * a_universes));
+        a_state.SetBytesProcessed(static_cast<int64_t>(a_state.iterations() * a_ports * a_universes * (dcsm::message_header_size + 514)));
+        a_state.counters["devices_at_44hz"] = benchmark::Counter(static_cast<double>(a_state.iterations() * a_ports) / 44, benchmark::Counter::kIsRate);
+    }
+}
+
+static void bm_port_driver(benchmark::State& a_state) {
+    size_t const ports = static_cast<size_t>(a_state.range(0));
+    size_t const universes = static_cast<size_t>(a_state.range(1));
+
+    pty_rack rack;
+    dcsm::port_driver driver;
+
+    for (int const fd : rack.open(ports)) {
+        size_t const port = driver.add_port(fd);
+        driver.route_range(static_cast<uint16_t>(1 + port * universes), static_cast<uint16_t>(universes), port);
+    }
+
+    std::vector<uint8_t> data(512, 0x55);
+    uint64_t writes = 0;
+
+    for (auto _ : a_state) {
+        for (size_t u = 1; u <= ports * universes; ++u) {
+            driver.setu(static_cast<uint16_t>(u), data.data());
+        }
+
+        while (driver.poll(0) != 0) {
+            rack.drain();
+        }
+
+        rack.drain();
+    }
+
+    for (size_t i = 0; i < ports; ++i) {
+        writes += driver.stats(i).writes;
+    }
+
+    set_counters(a_state, ports, universes);
+    a_state.counters["writes_per_port_frame"] = static_cast<double>(writes) / static_cast<double>(a_state.iterations() * ports);
+}
+
+/// Baseline: a write per frame, as with a blocking writer per device.
+static void bm_port_per_frame_writes(benchmark::State& a_state) {
+    size_t const ports = static_cast<size_t>(a_state.range(0));
+    size_t const universes = static_cast<size_t>(a_state.range(1));
+
+    pty_rack rack;
+    auto const hosts = rack.open(ports);
+
+    std::vector<uint8_t> data(512, 0x55);
+    std::vector<uint8_t> frame;
+
+    for (auto _ : a_state) {
+        for (size_t p = 0; p < ports; ++p) {
+            for (size_t u = 0; u < universes; ++u) {
+                frame.clear();
+                dcsm::encode_setu(frame, static_cast<uint16_t>(1 + p * universes + u), data.data());
+                benchmark::DoNotOptimize(::write(hosts[p], frame.data(), frame.size()));
+            }
+        }
+
+        rack.drain();
+    }
+
+    for (int const fd : hosts) {
+        ::close(fd);
+    }
+
+    set_counters(a_state, ports, universes);
+}
+
+BENCHMARK(bm_port_driver)->Args({ 8, 16 })->Args({ 16, 16 });
+BENCHMARK(bm_port_per_frame_writes)->Args({ 8, 16 })->Args({ 16, 16 });
+#endif
@@ -0,0 +1,113 @@
+#include <benchmark/benchmark.h>
+
+#include <dcsm.hpp>
+#include <dcsm_sacn.hpp>
+
+// sACN ingest in packets per second (items_per_second): parsing and change suppression in memory, and
+// the whole path through a loopback UDP socket on Linux. Argument: universes sent round-robin.
+
+namespace {
+    /// One full packet per universe; a_changing alters every frame, as during a fade.
+    struct sacn_traffic {
+        dcsm::sacn_source source;
+        std::vector<std::vector<uint8_t>> packets;
+        std::vector<uint8_t> data = std::vector<uint8_t>(512, 0);
+        uint8_t sequence = 0;
+
+        explicit sacn_traffic(size_t const a_universes) :
+            packets(a_universes)
+        {
+            source.cid.fill(1);
+            source.name = "bench";
+        }
+
+        void next_frame(bool const a_changing) {
+            if (a_changing) {
+                ++data[sequence % 512];
+            }
+
+            ++sequence;
+
+            for (size_t i = 0; i < packets.size(); ++i) {
+                packets[i].clear();
+                dcsm::append_sacn(packets[i], source, static_cast<uint16_t>(i + 1), sequence, data.data(), 512);
+            }
+        }
+    };
+
+    dcsm::universe_bridge::output discard_output() {
+        return [](uint8_t const* a_frame, size_t const a_size) {
+            benchmark::DoNotOptimize(a_frame);
+        };
+    }
+}
+
+static void bm_sacn_bridge(benchmark::State& a_state, bool const a_changing) {
+    size_t const universes = static_cast<size_t>(a_state.range(0));
+
+    dcsm::sacn_bridge bridge(discard_output());
+
+    for (size_t i = 1; i <= universes; ++i) {
+        bridge.map(static_cast<uint16_t>(i), static_cast<uint16_t>(i));
+    }
+
+    sacn_traffic traffic(universes);
+    auto const now = dcsm::universe_bridge::clock::now();
+
+    for (auto _ : a_state) {
+        a_state.PauseTiming();
+        traffic.next_frame(a_changing);
+        a_state.ResumeTiming();
+
+        for (auto const& packet : traffic.packets) {
+            benchmark::DoNotOptimize(bridge.receive(packet.data(), packet.size(), now));
+        }
+    }
+
+    a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations() * universes));
+}
+
+BENCHMARK_CAPTURE(bm_sacn_bridge, unchanged, false)->Arg(1)->Arg(64);
+BENCHMARK_CAPTURE(bm_sacn_bridge, changing, true)  ->Arg(1)->Arg(64);
+
+#if defined(__linux__)
+static void bm_sacn_udp(benchmark::State& a_state) {
+    size_t const universes = static_cast<size_t>(a_state.range(0));
+
+    dcsm::sacn_bridge bridge(discard_output());
+
+    for (size_t i = 1; i <= universes; ++i) {
+        bridge.map(static_cast<uint16_t>(i), static_cast<uint16_t>(i));
+    }
+
+    dcsm::sacn_receiver receiver(0, "127.0.0.1");
+    int const sender = ::socket(AF_INET, SOCK_DGRAM, 0);
+
+    sockaddr_in destination{};
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons(receiver.port());
+    ::inet_pton(AF_INET, "127.0.0.1", &destination.sin_addr);
+
+    sacn_traffic traffic(universes);
+    size_t received = 0;
+
+    for (auto _ : a_state) {
+        a_state.PauseTiming();
+        traffic.next_frame(true);
+        a_state.ResumeTiming();
+
+        for (auto const& packet : traffic.packets) {
+            ::sendto(sender, packet.data(), packet.size(), 0, reinterpret_cast<sockaddr const*>(&destination), sizeof(destination));
+        }
+
+        received += receiver.poll(bridge, 0);
+    }
+
+    ::close(sender);
+
+    a_state.SetItemsProcessed(static_cast<int64_t>(received));
+    a_state.counters["lost"] = static_cast<double>(a_state.iterations() * universes - received);
+}
+
+BENCHMARK(bm_sacn_udp)->Arg(1)->Arg(16);
+#endif
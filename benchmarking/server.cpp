@@ -0,0 +1,130 @@
+#include <benchmark/benchmark.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+#include <dcsm_reference_store.hpp>
+#include <dcsm_server.hpp>
+
+// Software node throughput over loopback TCP, in messages per second across all connections
+// (items_per_second). Arguments: connections, messages each sends per round. Clients and the server
+// share the benchmark thread: every round, each client writes its messages and the server serves
+// until it has dispatched them all.
+
+#if defined(__linux__)
+namespace {
+    struct server_fixture {
+        dcsm::reference_store store{ 64 };
+        dcsm::server server{ store };
+        std::vector<int> clients;
+
+        explicit server_fixture(size_t const a_connections) {
+            uint16_t const port = server.listen_tcp(0, "127.0.0.1");
+
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port);
+            ::inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+
+            for (size_t i = 0; i < a_connections; ++i) {
+                int const fd = ::socket(AF_INET, SOCK_STREAM, 0);
+                int const enable = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+                ::connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address));
+                clients.push_back(fd);
+            }
+
+            while (server.connection_count() < a_connections) {
+                server.poll(10);
+            }
+        }
+
+        ~server_fixture() {
+            for (int const fd : clients) {
+                ::close(fd);
+            }
+        }
+
+        void serve(uint64_t const a_frames) {
+            while (server.frames() < a_frames) {
+                server.poll(10);
+            }
+        }
+    };
+}
+
+static void bm_server_setu(benchmark::State& a_state) {
+    size_t const connections = static_cast<size_t>(a_state.range(0));
+    size_t const messages = static_cast<size_t>(a_state.range(1));
+
+    server_fixture fixture(connections);
+
+    // Each client sets its own universes.
+    std::vector<std::vector<uint8_t>> rounds(connections);
+    std::vector<uint8_t> data(512, 0x55);
+
+    for (size_t c = 0; c < connections; ++c) {
+        for (size_t m = 0; m < messages; ++m) {
+            dcsm::encode_setu(rounds[c], static_cast<uint16_t>(1 + (c + m) % 64), data.data());
+        }
+    }
+
+    uint64_t expected = 0;
+
+    for (auto _ : a_state) {
+        for (size_t c = 0; c < connections; ++c) {
+            ::send(fixture.clients[c], rounds[c].data(), rounds[c].size(), 0);
+        }
+
+        expected += connections * messages;
+        fixture.serve(expected);
+    }
+
+    a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations() * connections * messages));
+    a_state.SetBytesProcessed(static_cast<int64_t>(a_state.iterations() * connections * rounds[0].size()));
+}
+
+BENCHMARK(bm_server_setu)->Args({ 1, 64 })->Args({ 8, 64 })->Args({ 64, 16 });
+
+static void bm_server_getu(benchmark::State& a_state) {
+    size_t const connections = static_cast<size_t>(a_state.range(0));
+    size_t const messages = static_cast<size_t>(a_state.range(1));
+
+    server_fixture fixture(connections);
+
+    std::vector<uint8_t> round;
+
+    for (size_t m = 0; m < messages; ++m) {
+        dcsm::encode_getu(round, static_cast<uint16_t>(1 + m % 64));
+    }
+
+    size_t const reply_size = messages * (dcsm::message_header_size + 514);
+    std::vector<uint8_t> replies(reply_size);
+    uint64_t expected = 0;
+
+    for (auto _ : a_state) {
+        for (int const fd : fixture.clients) {
+            ::send(fd, round.data(), round.size(), 0);
+        }
+
+        expected += connections * messages;
+        fixture.serve(expected);
+
+        // Every client reads its replies before the next round.
+        for (int const fd : fixture.clients) {
+            for (size_t received = 0; received < reply_size;) {
+                ssize_t const size = ::recv(fd, replies.data(), reply_size - received, MSG_DONTWAIT);
+
+                if (size > 0) {
+                    received += static_cast<size_t>(size);
+                } else {
+                    fixture.server.poll(0); // Replies still queued on the server side.
+                }
+            }
+        }
+    }
+
+    a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations() * connections * messages));
+}
+
+BENCHMARK(bm_server_getu)->Args({ 1, 16 })->Args({ 8, 16 });
+#endif
@@ -0,0 +1,120 @@
+#include <benchmark/benchmark.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+#include <dcsm_reference_store.hpp>
+#include <dcsm_shm.hpp>
+
+#include <thread>
+
+// Round trip between two threads of a co-located producer and node: a getu out and the setu reply
+// back, through a pair of shared-memory rings or a Unix socket pair. Time per iteration is one round
+// trip. For the rings, the argument is how often the waiting side checks before sleeping on the futex;
+// 0 measures the futex wakeup path on every message (as does any argument on a single CPU).
+
+#if defined(__linux__)
+#include <sys/socket.h>
+
+namespace {
+    struct reply_counter final : dcsm::dispatch_interface {
+        size_t replies = 0;
+
+        void dcsm_setu(dcsm::command_context& a_ctx, uint16_t const a_universe, uint8_t const* a_data) override {
+            ++replies;
+        }
+    };
+}
+
+static void bm_shm_round_trip(benchmark::State& a_state) {
+    unsigned const spin = static_cast<unsigned>(a_state.range(0));
+
+    dcsm::shm_ring requests(1 << 16);
+    dcsm::shm_ring replies(1 << 16);
+    std::atomic<bool> running{ true };
+
+    // The node: answers each query from its store straight into the reply ring.
+    std::thread node([&] {
+        dcsm::reference_store store(1);
+        dcsm::dispatch dsp(store);
+        std::vector<uint8_t> reply;
+        store.reply_to(&reply);
+
+        while (running.load(std::memory_order_relaxed)) {
+            if (requests.wait(10, spin)) {
+                requests.consume(dsp);
+                replies.push(reply.data(), reply.size());
+                reply.clear();
+            }
+        }
+    });
+
+    reply_counter counter;
+    dcsm::dispatch dsp(counter);
+    std::vector<uint8_t> query;
+    dcsm::encode_getu(query, 1);
+
+    for (auto _ : a_state) {
+        requests.push(query.data(), query.size());
+
+        while (!replies.wait(-1, spin)) {}
+
+        replies.consume(dsp);
+    }
+
+    running = false;
+    node.join();
+
+    a_state.SetItemsProcessed(static_cast<int64_t>(counter.replies));
+}
+
+/// Baseline: the same exchange over a Unix stream socket pair, split into frames by frame_decoder.
+static void bm_socket_round_trip(benchmark::State& a_state) {
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds);
+
+    std::thread node([fd = fds[1]] {
+        dcsm::reference_store store(1);
+        dcsm::dispatch dsp(store);
+        dcsm::frame_decoder decoder(dsp);
+        std::vector<uint8_t> reply;
+        store.reply_to(&reply);
+
+        uint8_t buffer[4096];
+        ssize_t size;
+
+        while ((size = ::read(fd, buffer, sizeof(buffer))) > 0) {
+            decoder.feed(buffer, static_cast<size_t>(size));
+            benchmark::DoNotOptimize(::write(fd, reply.data(), reply.size()));
+            reply.clear();
+        }
+    });
+
+    reply_counter counter;
+    dcsm::dispatch dsp(counter);
+    dcsm::frame_decoder decoder(dsp);
+    std::vector<uint8_t> query;
+    dcsm::encode_getu(query, 1);
+
+    uint8_t buffer[4096];
+
+    for (auto _ : a_state) {
+        benchmark::DoNotOptimize(::write(fds[0], query.data(), query.size()));
+
+        size_t frames = 0;
+
+        while (frames == 0) {
+            ssize_t const size = ::read(fds[0], buffer, sizeof(buffer));
+            frames += decoder.feed(buffer, static_cast<size_t>(size));
+        }
+    }
+
+    ::close(fds[0]);
+    node.join();
+    ::close(fds[1]);
+
+    a_state.SetItemsProcessed(static_cast<int64_t>(counter.replies));
+}
+
+BENCHMARK(bm_shm_round_trip)->Arg(0)->Arg(200)->UseRealTime();
+BENCHMARK(bm_socket_round_trip)->UseRealTime();
+#endif
@@ -0,0 +1,102 @@
+#include <benchmark/benchmark.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+#include <dcsm_shm_store.hpp>
+
+#include <thread>
+
+// Universes published in shared memory. bm_shm_reader copies all 64 universes per iteration
+// (items_per_second counts universes) with the node writing setu at full rate on another thread
+// (argument 1) or idle (0); retries_per_read is how often a copy had to start over, and
+// writer_universes the node's rate meanwhile. bm_store_setu is the node side: setu through dispatch
+// into a plain reference_store (0) or a shm_reference_store (1), i.e. what the seqlock costs.
+
+#if defined(__linux__)
+namespace {
+    constexpr uint16_t universe_count = 64;
+
+    std::vector<uint8_t> setu_frames() {
+        std::vector<uint8_t> data(512, 0x55);
+        std::vector<uint8_t> frames;
+
+        for (uint16_t u = 1; u <= universe_count; ++u) {
+            dcsm::encode_setu(frames, u, data.data());
+        }
+
+        return frames;
+    }
+
+    /// Dispatch a_frames (setu frames for every universe) until a_running is cleared; returns the universes written.
+    uint64_t write_universes(dcsm::dispatch& a_dispatch, std::vector<uint8_t> const& a_frames, std::atomic<bool> const& a_running) {
+        size_t const frame_size = a_frames.size() / universe_count;
+        uint64_t written = 0;
+
+        while (a_running.load(std::memory_order_relaxed)) {
+            for (size_t offset = 0; offset < a_frames.size(); offset += frame_size) {
+                a_dispatch.process_message(a_frames.data() + offset);
+            }
+
+            written += universe_count;
+        }
+
+        return written;
+    }
+}
+
+static void bm_shm_reader(benchmark::State& a_state) {
+    dcsm::shm_reference_store store(universe_count);
+    dcsm::dispatch dsp(store);
+    dcsm::shm_universe_reader reader(::dup(store.fd()));
+
+    auto const frames = setu_frames();
+    std::atomic<bool> running{ a_state.range(0) != 0 };
+    uint64_t written = 0;
+
+    std::thread writer([&] {
+        written = write_universes(dsp, frames, running);
+    });
+
+    std::vector<uint8_t> out(512);
+
+    for (auto _ : a_state) {
+        for (uint16_t u = 1; u <= universe_count; ++u) {
+            reader.read(u, out.data());
+            benchmark::DoNotOptimize(out.data());
+        }
+    }
+
+    running = false;
+    writer.join();
+
+    uint64_t const reads = static_cast<uint64_t>(a_state.iterations()) * universe_count;
+    a_state.SetItemsProcessed(static_cast<int64_t>(reads));
+    a_state.counters["retries_per_read"] = static_cast<double>(reader.retries()) / static_cast<double>(reads);
+    a_state.counters["writer_universes"] = benchmark::Counter(static_cast<double>(written), benchmark::Counter::kIsRate);
+}
+
+static void bm_store_setu(benchmark::State& a_state) {
+    std::unique_ptr<dcsm::reference_store> store;
+
+    if (a_state.range(0) != 0) {
+        store.reset(new dcsm::shm_reference_store(universe_count));
+    } else {
+        store.reset(new dcsm::reference_store(universe_count));
+    }
+
+    dcsm::dispatch dsp(*store);
+    auto const frames = setu_frames();
+    size_t const frame_size = frames.size() / universe_count;
+
+    for (auto _ : a_state) {
+        for (size_t offset = 0; offset < frames.size(); offset += frame_size) {
+            dsp.process_message(frames.data() + offset);
+        }
+    }
+
+    a_state.SetItemsProcessed(static_cast<int64_t>(a_state.iterations() * universe_count));
+}
+
+BENCHMARK(bm_shm_reader)->Arg(0)->Arg(1)->UseRealTime();
+BENCHMARK(bm_store_setu)->Arg(0)->Arg(1);
+#endif
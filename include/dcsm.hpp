@@ -6,12 +6,61 @@
 #define DCSM_HPP
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <map>
 #include <vector>
 #include <bitset>
 #include <string>
 #include <array>
 #include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+
+/// Set to 1 to collect per-opcode/per-command statistics in dispatch (see dcsm::dispatch_statistics).
+#ifndef DCSM_ENABLE_STATISTICS
+#define DCSM_ENABLE_STATISTICS 0
+#endif
+
+/// Set to 0 to use the portable CRC-32C even where the target has CRC instructions (SSE4.2, ARMv8 CRC).
+#ifndef DCSM_CRC32C_HARDWARE
+#if defined(__SSE4_2__) || defined(__ARM_FEATURE_CRC32)
+#define DCSM_CRC32C_HARDWARE 1
+#else
+#define DCSM_CRC32C_HARDWARE 0
+#endif
+#endif
+
+/// Set to 0 to use the portable hash64 lanes even where the target has SIMD (SSE2, AArch64 NEON). Results are the same.
+#ifndef DCSM_HASH_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(__aarch64__) && defined(__ARM_NEON))
+#define DCSM_HASH_SIMD 1
+#else
+#define DCSM_HASH_SIMD 0
+#endif
+#endif
+
+#if DCSM_CRC32C_HARDWARE
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#else
+#error "DCSM_CRC32C_HARDWARE needs a target with SSE4.2 or the ARMv8 CRC extension (e.g. -msse4.2)"
+#endif
+#endif
+
+#if DCSM_HASH_SIMD
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
 
 namespace dcsm {
     constexpr char version[] = "1.0.0";
@@ -25,24 +74,50 @@ namespace dcsm {
         success           = 0x00,
         invalid_body_size = 0x01,
         malformed_syntax  = 0x02,
-        invalid_header    = 0x03
+        invalid_header    = 0x03,
+        unsupported       = 0x04, ///< Well-formed, but cannot be served (e.g. an unknown setuc encoding, or delta without a universe buffer).
+        out_of_sequence   = 0x05, ///< A sequenced frame was dropped because it was not the next one expected (see dcsm_ack).
+        checksum_mismatch = 0x06  ///< A checksummed frame was dropped because its CRC-32C trailer did not match.
     };
 
+    constexpr size_t dispatch_status_count = 7;
+
     struct command_context {
         interface_mode mode;
     };
 
     constexpr size_t addresses_per_universe = 512;
 
+    constexpr char command_separator = ';'; ///< Separates the commands of an atomic command batch.
+
+    constexpr char fine_value_prefix[] = "16b:"; ///< Marks a 16-bit value in commands (e.g. "@ 16b:40000" or "@ 16b:50%").
+
+    constexpr size_t opcode_count  = 0x26; ///< Number of direct control opcodes, including the unused 0x0000.
+    constexpr size_t command_count = 15;   ///< Number of command interface commands.
+
     using universe_mask = std::bitset<512>;                  ///< A mask to specify which addresses in a universe are targeted (0 for non-targeted, 1 for targeted).
     using address_range = std::map<uint16_t, universe_mask>; ///< Key: universe number. Value: universe mask (selected addresses).
     using address_pack = std::pair<uint16_t, uint16_t>;      ///< First member: universe number. Second member: local address.
 
+    /// Consecutive addresses of one universe set to individual values (setsp), or changed values (chgu).
+    struct universe_span {
+        uint16_t       universe;
+        uint16_t       start; ///< First local address (1-512).
+        uint16_t       count; ///< Number of addresses; the span ends within the universe.
+        uint8_t const* data;  ///< count values. Only valid for the duration of the callback.
+    };
+
     struct dispatch_interface {
         virtual ~dispatch_interface() = default;
 
         virtual void dcsm_id    (command_context& a_ctx) {}
         virtual void dcsm_setu  (command_context& a_ctx, uint16_t a_universe, uint8_t const* a_data) {}
+        /// pair: universe number, universe data (512 bytes). Defaults to dcsm_setu for each universe.
+        virtual void dcsm_setu_bulk(command_context& a_ctx, std::vector<std::pair<uint16_t, uint8_t const*>> const& a_universes) {
+            for (auto const& universe : a_universes) {
+                dcsm_setu(a_ctx, universe.first, universe.second);
+            }
+        }
         /// pair: address, value
         virtual void dcsm_setv  (command_context& a_ctx, std::vector<std::pair<address_pack, uint8_t>> const& a_pairs) {}
         virtual void dcsm_getu  (command_context& a_ctx, uint16_t a_universe) {}
@@ -62,9 +137,101 @@ namespace dcsm {
         virtual void dcsm_copy  (command_context& a_ctx, uint16_t a_source_universe, uint16_t a_destination_universe) {}
         virtual void dcsm_setutv(command_context& a_ctx, uint16_t a_universe, uint8_t a_value, universe_mask const& a_mask) {}
         virtual void dcsm_setmtv(command_context& a_ctx, uint16_t a_universe, uint8_t a_value, universe_mask const& a_mask) {}
+        /// pair: address of the coarse channel (1-511), 16-bit value (MSB to the address, LSB to the address + 1). Defaults to dcsm_setv with both bytes of every value.
+        virtual void dcsm_setv16(command_context& a_ctx, std::vector<std::pair<address_pack, uint16_t>> const& a_pairs) {
+            std::vector<std::pair<address_pack, uint8_t>> pairs;
+
+            for (auto const& pair : a_pairs) {
+                pairs.emplace_back(pair.first, static_cast<uint8_t>(pair.second >> 8));
+                pairs.emplace_back(address_pack{ pair.first.first, static_cast<uint16_t>(pair.first.second + 1) }, static_cast<uint8_t>(pair.second & 0xFF));
+            }
+
+            dcsm_setv(a_ctx, pairs);
+        }
+        /// a_mask selects coarse channels (MSB to the address, LSB to the address + 1). Defaults to dcsm_setv with both bytes of every selected address.
+        virtual void dcsm_setutv16(command_context& a_ctx, uint16_t a_universe, uint16_t a_value, universe_mask const& a_mask) {
+            std::vector<std::pair<address_pack, uint16_t>> pairs;
+
+            for (uint16_t i = 0; i < 512; ++i) {
+                if (a_mask.test(i)) {
+                    pairs.emplace_back(address_pack{ a_universe, static_cast<uint16_t>(i + 1) }, a_value);
+                }
+            }
+
+            dcsm_setv16(a_ctx, pairs);
+        }
+        /// Defaults to dcsm_setv with a pair per address.
+        virtual void dcsm_setsp (command_context& a_ctx, std::vector<universe_span> const& a_spans) {
+            std::vector<std::pair<address_pack, uint8_t>> pairs;
+
+            for (auto const& span : a_spans) {
+                for (uint16_t i = 0; i < span.count; ++i) {
+                    pairs.emplace_back(address_pack{ span.universe, static_cast<uint16_t>(span.start + i) }, span.data[i]);
+                }
+            }
+
+            dcsm_setv(a_ctx, pairs);
+        }
         virtual void dcsm_listu (command_context& a_ctx) {}
         virtual void dcsm_geta  (command_context& a_ctx, std::vector<address_pack> const& a_addresses) {}
         virtual void dcsm_getma (command_context& a_ctx, std::vector<address_pack> const& a_addresses) {}
+        /// Addresses a_start to a_start + a_count - 1 (one-based, within the universe).
+        virtual void dcsm_getr  (command_context& a_ctx, uint16_t a_universe, uint16_t a_start, uint16_t a_count) {}
+        /// Addresses a_start to a_start + a_count - 1 (one-based, within the universe) of a mask universe.
+        virtual void dcsm_getmr (command_context& a_ctx, uint16_t a_universe, uint16_t a_start, uint16_t a_count) {}
+        /// Start sending change notifications (chgu) for a universe, beginning with its full contents (see change_tracker).
+        virtual void dcsm_sub   (command_context& a_ctx, uint16_t a_universe) {}
+        /// Stop sending change notifications for a universe.
+        virtual void dcsm_unsub (command_context& a_ctx, uint16_t a_universe) {}
+        /// Host side: a change notification from the device, holding every change since the previous one.
+        virtual void dcsm_chgu  (command_context& a_ctx, std::vector<universe_span> const& a_spans) {}
+        /// Differential readback: reply with the changes since a_generation, as last seen by the client session a_session (see differential_readback).
+        virtual void dcsm_getud (command_context& a_ctx, uint16_t a_universe, uint16_t a_session, uint32_t a_generation) {}
+        /// Host side: reply to getud. The spans bring the universe to a_generation; none means it did not change.
+        virtual void dcsm_difu  (command_context& a_ctx, uint16_t a_universe, uint32_t a_generation, std::vector<universe_span> const& a_spans) {}
+        /// Reply with hash_universe of universes a_first to a_first + a_count - 1, or with their combine_hashes if a_combined.
+        virtual void dcsm_hashu (command_context& a_ctx, uint16_t a_first, uint16_t a_count, bool a_combined) {}
+        /// Host side: reply to hashu. a_hashes holds a_count hashes, or one combined hash.
+        virtual void dcsm_hashr (command_context& a_ctx, uint16_t a_first, uint16_t a_count, std::vector<uint64_t> const& a_hashes) {}
+
+        /// 512-byte storage of a universe that setuc messages decode straight into, or nullptr to receive them as dcsm_setu instead. Delta-encoded setuc requires a buffer.
+        virtual uint8_t* dcsm_universe_buffer(command_context& a_ctx, uint16_t a_universe) { return nullptr; }
+        /// Called after a setuc message was decoded into the dcsm_universe_buffer of a universe.
+        virtual void dcsm_setuc (command_context& a_ctx, uint16_t a_universe) {}
+
+        /// Number of addresses the handler can still accept for the current get/mget readback. Return 0 once the output buffer is full.
+        virtual size_t dcsm_readback_capacity(command_context& a_ctx) { return std::numeric_limits<size_t>::max(); }
+        /// Called when a get/mget readback stopped before the end of its range. Request the next page with "from <a_next>".
+        virtual void dcsm_readback_continue(command_context& a_ctx, address_pack a_next) {}
+
+        /**
+         * Called after every sequenced frame. Report a_sequence, together with how many bytes of frames the device
+         * can hold unacknowledged (its window), back to the host with an ack message (see encode_ack).
+         *
+         * @param a_sequence The last sequenced frame processed in order (cumulative acknowledgement).
+         * @param a_status   Status of the frame that triggered the acknowledgement; out_of_sequence if it was dropped.
+         */
+        virtual void dcsm_ack(command_context& a_ctx, uint16_t a_sequence, dispatch_status a_status) {}
+        /// Host side: an ack message from the device. Feed a_sequence and a_window to flow_window::acknowledge.
+        virtual void dcsm_ackr(command_context& a_ctx, uint16_t a_sequence, uint32_t a_window, dispatch_status a_status) {}
+
+        /**
+         * Called when an extended-length frame starts. The body of a record-streamed opcode (setu, setmu, patch; see
+         * stream_record_size) is then delivered record by record through the usual callbacks (in a checksummed frame,
+         * only once the CRC matched), any other body in chunks through dcsm_stream_data. Return false to skip the body
+         * as unsupported; by default, only record-streamed opcodes are accepted.
+         */
+        virtual bool dcsm_stream_begin(command_context& a_ctx, uint16_t a_opcode, uint32_t a_length);
+        /// A chunk of the body of an accepted extended-length frame whose opcode is not record-streamed.
+        virtual void dcsm_stream_data (command_context& a_ctx, uint8_t const* a_data, size_t a_size) {}
+        /// Called when an accepted extended-length frame ends. Chunks of dcsm_stream_data were delivered as they arrived,
+        /// so on checksum_mismatch (or any other failure) drop anything staged from them since dcsm_stream_begin.
+        virtual void dcsm_stream_end  (command_context& a_ctx, dispatch_status a_status) {}
+
+        /// Called before the commands of a batch are delivered. Every call up to dcsm_end_batch belongs to the batch.
+        virtual void dcsm_begin_batch(command_context& a_ctx, size_t a_command_count) {}
+        /// Called after the last command of a batch was delivered. Apply the batch here (e.g. in a single frame swap).
+        virtual void dcsm_end_batch  (command_context& a_ctx) {}
     };
 
     struct message_header {
@@ -72,6 +239,116 @@ namespace dcsm {
         uint16_t length;
     };
 
+    /// Direct control opcodes (see dispatch::message_table).
+    enum class opcode : uint16_t {
+        id       = 0x0001,
+        setu     = 0x0002,
+        setv     = 0x0003,
+        getu     = 0x0004,
+        setfr    = 0x0005,
+        getfr    = 0x0006,
+        newmu    = 0x0007,
+        listmu   = 0x0008,
+        delmu    = 0x0009,
+        setmu    = 0x000A,
+        setmv    = 0x000B,
+        getmu    = 0x000C,
+        clrmu    = 0x000D,
+        patch    = 0x000E,
+        unpat    = 0x000F,
+        listp    = 0x0010,
+        copy     = 0x0011,
+        setutv   = 0x0012,
+        setmtv   = 0x0013,
+        listu    = 0x0014,
+        geta     = 0x0015,
+        getma    = 0x0016,
+        setuc    = 0x0017,
+        setub    = 0x0018,
+        setsp    = 0x0019,
+        getr     = 0x001A,
+        getmr    = 0x001B,
+        setv16   = 0x001C,
+        setutv16 = 0x001D,
+        sub      = 0x001E,
+        unsub    = 0x001F,
+        chgu     = 0x0020,
+        getud    = 0x0021,
+        difu     = 0x0022,
+        hashu    = 0x0023,
+        hashr    = 0x0024,
+        ack      = 0x0025,
+    };
+
+    constexpr size_t bulk_universe_max = (0xFFFF - 2) / (2 + 512); ///< Most universes a single setub message can carry.
+    constexpr size_t hash_universe_max = (0xFFFF - 4) / 8;         ///< Most per-universe hashes a single hashr message can carry.
+
+    /// Encoding of the universe data in a setuc message.
+    enum class universe_encoding : uint8_t {
+        runs  = 0x00, ///< The data itself, run-length encoded.
+        delta = 0x01  ///< The data XOR the current universe data, run-length encoded.
+    };
+
+    constexpr size_t compressed_universe_max_size = 512 + 512 / 128; ///< Worst case of compress_universe (incompressible data).
+
+    constexpr size_t message_header_size = 5; ///< Identifying byte + opcode + length.
+
+    /*
+     * The identifying byte of a direct control frame is 0x00, or a combination of flags that each add
+     * a field between the identifying byte and the message header:
+     *
+     *   0x01 (sequenced): uint16_t sequence number, for pipelined flow control (see dcsm_flow.hpp)
+     *   0x04 (extended):  the length in the message header is a uint32_t, and the body is streamed
+     *                     instead of buffered (see dispatch::begin_stream)
+     *
+     * and, after the body:
+     *
+     *   0x02 (checksummed): uint32_t CRC-32C of everything before it (see crc32c)
+     */
+
+    constexpr uint8_t frame_flag_sequenced   = 0x01;
+    constexpr uint8_t frame_flag_checksummed = 0x02;
+    constexpr uint8_t frame_flag_extended    = 0x04;
+    constexpr uint8_t frame_flags            = frame_flag_sequenced | frame_flag_checksummed | frame_flag_extended; ///< Every supported flag.
+
+    /// True if a byte starts a direct control frame rather than a command.
+    constexpr bool is_frame_start(uint8_t const a_byte) noexcept {
+        return (a_byte & ~frame_flags) == 0;
+    }
+
+    /// Size of a frame up to its body (identifying byte, flag fields and message header).
+    constexpr size_t frame_header_size(uint8_t const a_flags) noexcept {
+        return message_header_size + ((a_flags & frame_flag_sequenced) != 0 ? 2 : 0) + ((a_flags & frame_flag_extended) != 0 ? 2 : 0);
+    }
+
+    /// Size of a frame after its body.
+    constexpr size_t frame_trailer_size(uint8_t const a_flags) noexcept {
+        return (a_flags & frame_flag_checksummed) != 0 ? 4 : 0;
+    }
+
+    /// Size of the records the body of an extended-length frame is split into, or 0 if the opcode is not record-streamed.
+    constexpr size_t stream_record_size(uint16_t const a_opcode) noexcept {
+        return a_opcode == static_cast<uint16_t>(opcode::setu)  ? 2 + 512 :
+               a_opcode == static_cast<uint16_t>(opcode::setmu) ? 2 + 64 + 512 :
+               a_opcode == static_cast<uint16_t>(opcode::patch) ? 6 : 0;
+    }
+
+    inline bool dispatch_interface::dcsm_stream_begin(command_context& a_ctx, uint16_t const a_opcode, uint32_t const a_length) {
+        return stream_record_size(a_opcode) != 0;
+    }
+
+    /**
+     * @brief Receives raw traffic as it enters dispatch (see dispatch::set_capture and dcsm_capture.hpp).
+     */
+    struct capture_sink {
+        virtual ~capture_sink() = default;
+
+        /// A direct control message as it enters process_message.
+        virtual void capture_message(message_header a_header, uint8_t const* a_body) = 0;
+        /// A command line (or batch) as it enters process_command.
+        virtual void capture_command(std::string const& a_command) = 0;
+    };
+
     /**
      * @brief Cast ambiguous data to a type without undefined behavior.
      *
@@ -89,39 +366,633 @@ namespace dcsm {
         return value;
     }
 
+    /// True if a_size bytes hold exactly one complete frame, as process_message expects.
+    inline bool is_complete_frame(uint8_t const* a_frame, size_t const a_size) noexcept {
+        if (a_size == 0 || !is_frame_start(a_frame[0]) || a_size < frame_header_size(a_frame[0])) {
+            return false;
+        }
+
+        uint8_t const flags = a_frame[0];
+        size_t const header_size = frame_header_size(flags);
+        size_t const length = (flags & frame_flag_extended) != 0 ? bit_cast<uint32_t>(a_frame + header_size - 4)
+                                                                   : bit_cast<uint16_t>(a_frame + header_size - 2);
+
+        return a_size == header_size + length + frame_trailer_size(flags);
+    }
+
+    // -------------------------- CHECKSUM ---------------------------
+
+    /// Slicing-by-8 lookup tables for CRC-32C (reflected polynomial 0x82F63B78).
+    struct crc32c_tables {
+        uint32_t values[8][256];
+    };
+
+    constexpr crc32c_tables make_crc32c_tables() {
+        crc32c_tables tables{};
+
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+
+            for (size_t bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ ((crc & 1) != 0 ? 0x82F63B78 : 0);
+            }
+
+            tables.values[0][i] = crc;
+        }
+
+        for (size_t slice = 1; slice < 8; ++slice) {
+            for (size_t i = 0; i < 256; ++i) {
+                uint32_t const previous = tables.values[slice - 1][i];
+                tables.values[slice][i] = (previous >> 8) ^ tables.values[0][previous & 0xFF];
+            }
+        }
+
+        return tables;
+    }
+
+    inline crc32c_tables const& crc32c_table() noexcept {
+        static constexpr crc32c_tables tables = make_crc32c_tables();
+        return tables;
+    }
+
+    /// Bytes at a_data as a little-endian uint32_t, regardless of host byte order.
+    inline uint32_t load_le32(uint8_t const* a_data) noexcept {
+        return static_cast<uint32_t>(a_data[0])       | static_cast<uint32_t>(a_data[1]) << 8 |
+               static_cast<uint32_t>(a_data[2]) << 16 | static_cast<uint32_t>(a_data[3]) << 24;
+    }
+
+    /**
+     * @brief CRC-32C (Castagnoli) using slicing-by-8, for targets without CRC instructions.
+     *
+     * @param a_data The data over which to compute the CRC.
+     * @param a_size The size of the data.
+     * @param a_crc  The CRC of the preceding data, to continue a CRC in pieces.
+     *
+     * @return The CRC of the preceding data followed by a_data.
+     */
+    inline uint32_t crc32c_portable(uint8_t const* a_data, size_t a_size, uint32_t a_crc = 0) noexcept {
+        auto const& table = crc32c_table().values;
+        uint32_t crc = ~a_crc;
+
+        for (; a_size >= 8; a_size -= 8, a_data += 8) {
+            uint32_t const low  = crc ^ load_le32(a_data);
+            uint32_t const high = load_le32(a_data + 4);
+
+            crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24] ^
+                  table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^ table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+        }
+
+        for (; a_size != 0; --a_size, ++a_data) {
+            crc = (crc >> 8) ^ table[0][(crc ^ *a_data) & 0xFF];
+        }
+
+        return ~crc;
+    }
+
+    /**
+     * @brief CRC-32C (Castagnoli), as used by frame trailers.
+     *
+     * Uses the SSE4.2 or ARMv8 CRC instructions when the target has them (see DCSM_CRC32C_HARDWARE),
+     * otherwise crc32c_portable. Parameters as crc32c_portable.
+     */
+    inline uint32_t crc32c(uint8_t const* a_data, size_t a_size, uint32_t const a_crc = 0) noexcept {
+#if DCSM_CRC32C_HARDWARE && defined(__SSE4_2__)
+        uint32_t crc = ~a_crc;
+
+    #if defined(__x86_64__)
+        uint64_t crc64 = crc;
+
+        for (; a_size >= 8; a_size -= 8, a_data += 8) {
+            crc64 = _mm_crc32_u64(crc64, bit_cast<uint64_t>(a_data));
+        }
+
+        crc = static_cast<uint32_t>(crc64);
+    #endif
+
+        for (; a_size >= 4; a_size -= 4, a_data += 4) {
+            crc = _mm_crc32_u32(crc, bit_cast<uint32_t>(a_data));
+        }
+
+        for (; a_size != 0; --a_size, ++a_data) {
+            crc = _mm_crc32_u8(crc, *a_data);
+        }
+
+        return ~crc;
+#elif DCSM_CRC32C_HARDWARE
+        uint32_t crc = ~a_crc;
+
+        for (; a_size >= 8; a_size -= 8, a_data += 8) {
+            crc = __crc32cd(crc, bit_cast<uint64_t>(a_data));
+        }
+
+        for (; a_size != 0; --a_size, ++a_data) {
+            crc = __crc32cb(crc, *a_data);
+        }
+
+        return ~crc;
+#else
+        return crc32c_portable(a_data, a_size, a_crc);
+#endif
+    }
+
+    /// Secret keys of hash64: 8 lanes, shifted by one per 64-byte stripe of a 512-byte block.
+    struct hash64_keys {
+        uint64_t values[15];
+    };
+
+    constexpr hash64_keys make_hash64_keys() {
+        hash64_keys keys{};
+        uint64_t state = 0x9E3779B97F4A7C15;
+
+        // splitmix64
+        for (auto& value : keys.values) {
+            uint64_t z = state += 0x9E3779B97F4A7C15;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+            value = z ^ (z >> 31);
+        }
+
+        return keys;
+    }
+
+    inline hash64_keys const& hash64_key() noexcept {
+        static constexpr hash64_keys keys = make_hash64_keys();
+        return keys;
+    }
+
+    /// Bytes at a_data as a little-endian uint64_t, regardless of host byte order.
+    inline uint64_t load_le64(uint8_t const* a_data) noexcept {
+        return static_cast<uint64_t>(load_le32(a_data)) | static_cast<uint64_t>(load_le32(a_data + 4)) << 32;
+    }
+
+    /// Accumulate one 64-byte stripe into 8 lanes: each lane adds its neighbour's input and the product of the halves of its keyed input.
+    inline void hash64_stripe_portable(uint64_t (&a_acc)[8], uint8_t const* a_stripe, uint64_t const* a_keys) noexcept {
+        for (size_t lane = 0; lane < 8; ++lane) {
+            uint64_t const value = load_le64(a_stripe + lane * 8);
+            uint64_t const keyed = value ^ a_keys[lane];
+
+            a_acc[lane ^ 1] += value;
+            a_acc[lane]     += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+        }
+    }
+
+    /// As hash64_stripe_portable, two lanes per instruction with SSE2 or NEON where the target has them (see DCSM_HASH_SIMD).
+    inline void hash64_stripe(uint64_t (&a_acc)[8], uint8_t const* a_stripe, uint64_t const* a_keys) noexcept {
+#if DCSM_HASH_SIMD && (defined(__SSE2__) || defined(_M_X64))
+        for (size_t lane = 0; lane < 8; lane += 2) {
+            __m128i const value   = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a_stripe + lane * 8));
+            __m128i const keyed   = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<__m128i const*>(a_keys + lane)));
+            __m128i const product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+            __m128i const swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+            __m128i const acc     = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a_acc + lane));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(a_acc + lane), _mm_add_epi64(acc, _mm_add_epi64(product, swapped)));
+        }
+#elif DCSM_HASH_SIMD
+        for (size_t lane = 0; lane < 8; lane += 2) {
+            uint64x2_t const value   = vreinterpretq_u64_u8(vld1q_u8(a_stripe + lane * 8));
+            uint64x2_t const keyed   = veorq_u64(value, vld1q_u64(a_keys + lane));
+            uint64x2_t const product = vmull_u32(vmovn_u64(keyed), vshrn_n_u64(keyed, 32));
+            uint64x2_t const swapped = vextq_u64(value, value, 1);
+
+            vst1q_u64(a_acc + lane, vaddq_u64(vld1q_u64(a_acc + lane), vaddq_u64(product, swapped)));
+        }
+#else
+        hash64_stripe_portable(a_acc, a_stripe, a_keys);
+#endif
+    }
+
+    inline uint64_t hash64_avalanche(uint64_t a_hash) noexcept {
+        a_hash ^= a_hash >> 33;
+        a_hash *= 0xC2B2AE3D27D4EB4F;
+        a_hash ^= a_hash >> 29;
+        a_hash *= 0x165667B19E3779F9;
+        a_hash ^= a_hash >> 32;
+        return a_hash;
+    }
+
+    /**
+     * @brief Fast 64-bit hash for sync verification (hashu); not a checksum and not cryptographic.
+     *
+     * Processes 64 bytes per step in 8 independent lanes (two per instruction with SSE2 or NEON), so a
+     * universe hashes in about half the time of its CRC-32C. The result is the same on every target.
+     *
+     * @param a_data The data to hash.
+     * @param a_size The size of the data.
+     * @param a_seed Chains hashes: pass the hash of the preceding data.
+     */
+    inline uint64_t hash64(uint8_t const* a_data, size_t const a_size, uint64_t const a_seed = 0) noexcept {
+        auto const& keys = hash64_key().values;
+
+        uint64_t acc[8];
+
+        for (size_t lane = 0; lane < 8; ++lane) {
+            acc[lane] = keys[lane] + a_seed;
+        }
+
+        size_t stripe = 0;
+        size_t remaining = a_size;
+
+        for (; remaining >= 64; remaining -= 64, a_data += 64, ++stripe) {
+            if (stripe != 0 && stripe % 8 == 0) {
+                // Once per 512 bytes, so that blocks do not commute.
+                for (auto& lane : acc) {
+                    lane = (lane ^ (lane >> 47) ^ keys[7]) * 0x9E3779B1;
+                }
+            }
+
+            hash64_stripe(acc, a_data, keys + stripe % 8);
+        }
+
+        if (remaining != 0) {
+            uint8_t last[64]{};
+            std::memcpy(last, a_data, remaining);
+            hash64_stripe(acc, last, keys + stripe % 8);
+        }
+
+        uint64_t hash = a_size * 0x9E3779B185EBCA87 ^ a_seed;
+
+        for (size_t lane = 0; lane < 8; ++lane) {
+            hash = (hash ^ hash64_avalanche(acc[lane] ^ keys[lane + 7])) * 0x9E3779B185EBCA87 + 0x85EBCA77C2B2AE63;
+        }
+
+        return hash64_avalanche(hash);
+    }
+
+    /**
+     * @brief Hash of the state of one universe, as returned by hashu.
+     *
+     * Covers everything that affects the output of the universe. Host and device compute it the same way,
+     * so a host compares it against its own copy instead of pulling the universe with getu.
+     *
+     * @param a_data      Universe data (512 bytes).
+     * @param a_mask_data Data of the mask universe of the same number (512 bytes), or nullptr if there is none.
+     * @param a_mask      Masking flags of that mask universe. Ignored without a_mask_data.
+     * @param a_patch     Patch outputting to the universe as { input universe, mask universe }, or nullptr if there is none.
+     */
+    inline uint64_t hash_universe(uint8_t const* a_data, uint8_t const* a_mask_data = nullptr, universe_mask const* a_mask = nullptr,
+                                  std::pair<uint16_t, uint16_t> const* a_patch = nullptr) noexcept {
+        uint64_t hash = hash64(a_data, 512);
+
+        if (a_mask_data != nullptr) {
+            uint8_t flags[64]{};
+
+            for (size_t i = 0; a_mask != nullptr && i < 512; ++i) {
+                flags[i / 8] |= static_cast<uint8_t>(a_mask->test(i) ? 1 << (i % 8) : 0);
+            }
+
+            hash = hash64(a_mask_data, 512, hash ^ 1);
+            hash = hash64(flags, sizeof(flags), hash);
+        }
+
+        if (a_patch != nullptr) {
+            uint8_t const patch[4] {
+                static_cast<uint8_t>(a_patch->first),  static_cast<uint8_t>(a_patch->first >> 8),
+                static_cast<uint8_t>(a_patch->second), static_cast<uint8_t>(a_patch->second >> 8)
+            };
+
+            hash = hash64(patch, sizeof(patch), hash ^ 2);
+        }
+
+        return hash;
+    }
+
+    /// Hash of a range of universes from their hash_universe results, as returned by a combined hashu.
+    inline uint64_t combine_hashes(uint64_t const* a_hashes, size_t const a_count) noexcept {
+        uint64_t hash = 0;
+
+        for (size_t i = 0; i < a_count; ++i) {
+            uint8_t bytes[8];
+
+            for (size_t byte = 0; byte < 8; ++byte) {
+                bytes[byte] = static_cast<uint8_t>(a_hashes[i] >> (byte * 8));
+            }
+
+            hash = hash64(bytes, sizeof(bytes), hash);
+        }
+
+        return hash;
+    }
+
+    // ------------------------ END CHECKSUM -------------------------
+
+    // ------------------------- STATISTICS --------------------------
+
+    constexpr size_t latency_bucket_count = 32; ///< Bucket i holds latencies in [2^i, 2^(i+1)) ns. The last bucket also holds anything longer.
+
+    /// Point-in-time copy of dispatch statistics.
+    struct statistics_snapshot {
+        struct entry {
+            uint64_t messages = 0; ///< Messages or commands dispatched.
+            uint64_t bytes    = 0; ///< Body bytes (direct control) or plaintext bytes (commands).
+            std::array<uint64_t, latency_bucket_count> latency{}; ///< Log2-bucketed handler latency histogram.
+        };
+
+        std::array<entry, opcode_count>  opcodes{};  ///< Indexed by opcode.
+        std::array<entry, command_count> commands{}; ///< Indexed by position in the command table (see dispatch::command_name).
+        std::array<uint64_t, dispatch_status_count> statuses{}; ///< Indexed by dispatch_status value.
+    };
+
+    /// Statistics sink used when DCSM_ENABLE_STATISTICS is 0. Every call compiles away.
+    struct null_statistics {
+        static constexpr bool enabled = false;
+
+        uint64_t start() const noexcept { return 0; }
+
+        void record_message(uint16_t a_opcode, size_t a_bytes, dispatch_status a_status, uint64_t a_start) noexcept {}
+        void record_command(size_t a_command, size_t a_bytes, dispatch_status a_status, uint64_t a_start) noexcept {}
+        void record_status(dispatch_status a_status) noexcept {}
+
+        statistics_snapshot snapshot() const noexcept { return {}; }
+    };
+
+    /**
+     * @brief Statistics sink used when DCSM_ENABLE_STATISTICS is 1.
+     *
+     * Counters are relaxed atomics, so snapshot() may be called from another thread while dispatching.
+     */
+    class dispatch_statistics {
+        struct entry {
+            std::atomic<uint64_t> messages{ 0 };
+            std::atomic<uint64_t> bytes{ 0 };
+            std::array<std::atomic<uint64_t>, latency_bucket_count> latency{};
+        };
+
+        std::array<entry, opcode_count>  m_opcodes;
+        std::array<entry, command_count> m_commands;
+        std::array<std::atomic<uint64_t>, dispatch_status_count> m_statuses{};
+
+    public:
+        static constexpr bool enabled = true;
+
+        /// Timestamp (ns) to pass to record_message/record_command.
+        uint64_t start() const noexcept {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        void record_message(uint16_t const a_opcode, size_t const a_bytes, dispatch_status const a_status, uint64_t const a_start) noexcept {
+            record(m_opcodes[a_opcode], a_bytes, a_start);
+            record_status(a_status);
+        }
+
+        void record_command(size_t const a_command, size_t const a_bytes, dispatch_status const a_status, uint64_t const a_start) noexcept {
+            record(m_commands[a_command], a_bytes, a_start);
+            record_status(a_status);
+        }
+
+        void record_status(dispatch_status const a_status) noexcept {
+            m_statuses[static_cast<size_t>(a_status)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /// Copy the counters out. Counters keep running; the copy is not a single atomic cut.
+        statistics_snapshot snapshot() const noexcept {
+            statistics_snapshot result;
+
+            copy_entries(m_opcodes, result.opcodes);
+            copy_entries(m_commands, result.commands);
+
+            for (size_t i = 0; i < dispatch_status_count; ++i) {
+                result.statuses[i] = m_statuses[i].load(std::memory_order_relaxed);
+            }
+
+            return result;
+        }
+
+    private:
+        /// Index of the log2 bucket holding a latency.
+        static size_t latency_bucket(uint64_t a_nanoseconds) noexcept {
+            size_t bucket = 0;
+
+            while (a_nanoseconds >>= 1) {
+                ++bucket;
+            }
+
+            return std::min(bucket, latency_bucket_count - 1);
+        }
+
+        void record(entry& a_entry, size_t const a_bytes, uint64_t const a_start) noexcept {
+            a_entry.messages.fetch_add(1, std::memory_order_relaxed);
+            a_entry.bytes.fetch_add(a_bytes, std::memory_order_relaxed);
+            a_entry.latency[latency_bucket(start() - a_start)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        template <size_t v_count>
+        static void copy_entries(std::array<entry, v_count> const& a_source, std::array<statistics_snapshot::entry, v_count>& a_destination) noexcept {
+            for (size_t i = 0; i < v_count; ++i) {
+                a_destination[i].messages = a_source[i].messages.load(std::memory_order_relaxed);
+                a_destination[i].bytes    = a_source[i].bytes.load(std::memory_order_relaxed);
+
+                for (size_t bucket = 0; bucket < latency_bucket_count; ++bucket) {
+                    a_destination[i].latency[bucket] = a_source[i].latency[bucket].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    };
+
+    /// Statistics sink selected at compile time by DCSM_ENABLE_STATISTICS.
+    using statistics_type = std::conditional<DCSM_ENABLE_STATISTICS != 0, dispatch_statistics, null_statistics>::type;
+
+    // ------------------------ END STATISTICS ------------------------
+
     class dispatch {
     public:
         using command_handler = dispatch_status (dispatch::*)(command_context&, std::string const&);
         using message_handler = dispatch_status (dispatch::*)(command_context&, message_header, uint8_t const*);
+        using readback_handler = void (dispatch_interface::*)(command_context&, std::vector<address_pack> const&);
+
+        struct command_entry {
+            char const*     name;
+            command_handler handler;
+        };
 
     private:
         dispatch_interface& m_interface;
-        std::vector<message_handler> m_message_handlers;
-        std::map<std::string, command_handler> m_command_handlers;
+        statistics_type m_statistics;
+        capture_sink* m_capture = nullptr;
+        uint16_t m_next_sequence = 0; ///< Sequence number of the next sequenced frame expected.
+
+        /// The extended-length frame being streamed (see begin_stream).
+        struct stream_state {
+            uint8_t         flags         = 0;
+            uint16_t        opcode        = 0;
+            uint16_t        sequence      = 0;
+            uint32_t        remaining     = 0; ///< Body bytes still to come.
+            uint32_t        crc           = 0;
+            size_t          record_size   = 0; ///< 0: the body goes to dcsm_stream_data.
+            size_t          record_fill   = 0; ///< Bytes of a record split across chunks, held in m_stream_record.
+            dispatch_status status        = dispatch_status::success; ///< Why the body is skipped, if it is.
+            dispatch_status record_status = dispatch_status::success; ///< First failing record.
+            bool            staged        = false; ///< Records go to m_stream_staged until the CRC matched.
+        };
+
+        stream_state m_stream;
+        std::array<uint8_t, 2 + 64 + 512> m_stream_record; ///< Largest record (setmu).
+        std::vector<uint8_t> m_stream_staged;              ///< Records of a checksummed frame, held until its CRC matched.
+        size_t m_stream_staging_limit = size_t{ 1 } << 20;  ///< Largest checksummed record-streamed body accepted.
+
+        size_t m_readback_chunk_size = 100;                                ///< Addresses delivered per dcsm_geta/dcsm_getma call.
+        size_t m_readback_limit = std::numeric_limits<size_t>::max();     ///< Addresses delivered per get/mget command (page size).
+        std::vector<address_pack> m_readback_chunk;                        ///< Reused between readbacks to avoid reallocating.
+
+        // Decoded entries of variable-length messages. Reused between messages, so decoding only
+        // allocates when a message holds more entries than any before it (see reserve_scratch).
+        std::vector<std::pair<address_pack, uint8_t>>     m_setv_pairs;
+        std::vector<std::pair<address_pack, uint16_t>>    m_setv16_pairs;
+        std::vector<std::tuple<uint16_t, bool, uint8_t>>  m_setmv_pairs;
+        std::vector<address_pack>                          m_addresses;
+        std::vector<std::pair<uint16_t, uint8_t const*>>   m_bulk_universes;
+        std::vector<universe_span>                         m_spans;
+        std::vector<uint64_t>                              m_hashes;
+        std::vector<uint8_t>                               m_span_values;      ///< Values of a set command with a value list.
+        std::string                                        m_command_body;
+        std::array<uint8_t, 512>                           m_universe_data;    ///< setuc target when the handler has no universe buffer.
+
+        /// Staging dispatch of process_command_batch, created by the first batch and reused after.
+        struct batch_staging;
+        std::unique_ptr<batch_staging> m_batch;
+
+        /// Statistics of a batch's commands, held back until the batch is delivered.
+        struct staged_statistics {
+            struct command_record {
+                size_t          command;
+                size_t          bytes;
+                dispatch_status status;
+                uint64_t        start;
+            };
+
+            statistics_type const& clock;
+            std::vector<command_record> commands;
+
+            uint64_t start() const noexcept {
+                return clock.start();
+            }
+
+            void record_command(size_t const a_command, size_t const a_bytes, dispatch_status const a_status, uint64_t const a_start) {
+                if (statistics_type::enabled) {
+                    commands.push_back({ a_command, a_bytes, a_status, a_start });
+                }
+            }
+
+            /// Failures are recorded once, as the status of the batch.
+            void record_status(dispatch_status a_status) noexcept {}
+        };
 
     public:
+        /// Does not allocate.
         explicit dispatch(dispatch_interface& a_interface) noexcept :
             m_interface(a_interface)
-        {
-            initialize_handlers();
-        }
+        {}
+
+        ~dispatch();
 
         /**
          * @brief Process a human-readable command and dispatch.
          *
+         * Multiple commands separated by ';' form an atomic batch (see process_command_batch).
+         *
          * @param a_command The command plaintext.
          *
          * @return Status of call, either success or an error code.
          */
         dispatch_status process_command(std::string const& a_command) {
-            size_t const command_name_end_index = a_command.find_first_of(' ');
-            std::string const command_name = a_command.substr(0, command_name_end_index);
-            std::string const command_body = command_name_end_index == std::string::npos ? "" : a_command.substr(command_name_end_index + 1);
+            if (m_capture != nullptr) {
+                m_capture->capture_command(a_command);
+            }
 
-            command_context ctx{};
-            ctx.mode = interface_mode::command;
+            if (a_command.find(command_separator) != std::string::npos) {
+                return process_command_batch(a_command);
+            }
 
-            return (this->*m_command_handlers[command_name])(ctx, command_body);
+            return process_single_command(a_command, m_statistics);
+        }
+
+        /**
+         * @brief Process a batch of commands separated by ';' as a single atomic operation.
+         *
+         * Every command is parsed before anything is dispatched. If any command is malformed, the whole
+         * batch is rejected and nothing reaches the interface. Otherwise, the commands are delivered in
+         * order between dcsm_begin_batch and dcsm_end_batch.
+         *
+         * @param a_batch The batch plaintext, e.g. "set 1 thru 24 @ full; set 25 thru 48 @ out".
+         *
+         * @return Status of call, either success or the error code of the first failing command.
+         */
+        dispatch_status process_command_batch(std::string const& a_batch);
+
+        /**
+         * @brief Set the number of addresses delivered per dcsm_geta/dcsm_getma call by the get/mget commands.
+         *
+         * @param a_chunk_size The chunk size (at least 1).
+         */
+        void set_readback_chunk_size(size_t const a_chunk_size) noexcept {
+            m_readback_chunk_size = std::max<size_t>(a_chunk_size, 1);
+        }
+
+        /**
+         * @brief Set the maximum number of addresses delivered by a single get/mget command.
+         *
+         * When a range holds more addresses, dcsm_readback_continue reports where the next page starts.
+         *
+         * @param a_limit The page size.
+         */
+        void set_readback_limit(size_t const a_limit) noexcept {
+            m_readback_limit = a_limit;
+        }
+
+        /**
+         * @brief Set the largest body of a checksummed, record-streamed extended-length frame.
+         *
+         * Such bodies are held until the CRC-32C trailer matched, so that a corrupted frame delivers no
+         * record; larger ones are skipped as unsupported. Default: 1 MiB (about 2000 setu records).
+         *
+         * @param a_limit The limit in bytes.
+         */
+        void set_stream_staging_limit(size_t const a_limit) noexcept {
+            m_stream_staging_limit = a_limit;
+        }
+
+        /**
+         * @brief Pre-size the buffers used to decode setv, setv16, setmv, geta, getma, setub and setsp messages.
+         *
+         * Once reserved, decoding messages of up to this many entries never allocates.
+         *
+         * @param a_entries The largest expected number of entries per message.
+         */
+        void reserve_scratch(size_t const a_entries) {
+            m_setv_pairs.reserve(a_entries);
+            m_setv16_pairs.reserve(a_entries);
+            m_setmv_pairs.reserve(a_entries);
+            m_addresses.reserve(a_entries);
+            m_bulk_universes.reserve(std::min(a_entries, bulk_universe_max));
+            m_spans.reserve(a_entries);
+            m_hashes.reserve(std::min(a_entries, hash_universe_max));
+        }
+
+        /**
+         * @brief Record all incoming traffic into a capture sink.
+         *
+         * @param a_capture The sink, or nullptr to stop capturing.
+         */
+        void set_capture(capture_sink* const a_capture) noexcept {
+            m_capture = a_capture;
+        }
+
+        /**
+         * @brief Access the statistics sink, e.g. to take a snapshot with statistics().snapshot().
+         *
+         * Only collects anything when compiled with DCSM_ENABLE_STATISTICS set to 1.
+         */
+        statistics_type const& statistics() const noexcept {
+            return m_statistics;
+        }
+
+        /**
+         * @brief Get the name of a command by its index in statistics_snapshot::commands.
+         *
+         * @param a_command The command index (less than command_count).
+         */
+        static char const* command_name(size_t const a_command) noexcept {
+            return command_table()[a_command].name;
         }
 
         /**
@@ -133,62 +1004,179 @@ namespace dcsm {
          * @return Status of call, either success or an error code.
          */
         dispatch_status process_message(message_header const a_header, uint8_t const* a_body) {
+            if (m_capture != nullptr) {
+                m_capture->capture_message(a_header, a_body);
+            }
+
             command_context ctx{};
             ctx.mode = interface_mode::direct_control;
 
-            return (this->*m_message_handlers[a_header.opcode])(ctx, a_header, a_body);
+            if (a_header.opcode >= opcode_count || message_table()[a_header.opcode] == nullptr) {
+                m_statistics.record_status(dispatch_status::invalid_header);
+                return dispatch_status::invalid_header;
+            }
+
+            auto const start = m_statistics.start();
+            auto const status = (this->*message_table()[a_header.opcode])(ctx, a_header, a_body);
+            m_statistics.record_message(a_header.opcode, a_header.length, status, start);
+
+            return status;
         }
 
         /**
-         * @brief Process a direct control interface message and dispatch.
+         * @brief Process a direct control interface frame and dispatch.
+         *
+         * Sequenced frames are only processed in order. A duplicate or a frame after a gap is dropped
+         * with out_of_sequence, and the last acknowledgement is repeated so the host resends from there.
+         * A checksummed frame whose trailer does not match is dropped with checksum_mismatch before
+         * anything else (including its sequence number) is trusted.
          *
-         * @param a_body The body of the message.
+         * @param a_body The frame, starting with the identifying byte.
          *
          * @return Status of call, either success or an error code.
          */
         dispatch_status process_message(uint8_t const* a_body) {
-            command_context ctx{};
-            ctx.mode = interface_mode::direct_control;
+            uint8_t const flags = *a_body;
 
-            if (*a_body != 0x00) {
+            if (!is_frame_start(flags)) {
+                m_statistics.record_status(dispatch_status::invalid_header);
                 return dispatch_status::invalid_header;
             }
 
+            if ((flags & frame_flag_extended) != 0) {
+                size_t const header_size = frame_header_size(flags);
+                auto const length = bit_cast<uint32_t>(a_body + header_size - 4);
+
+                begin_stream(a_body);
+                stream_data(a_body + header_size, length);
+                return end_stream(a_body + header_size + length);
+            }
+
+            size_t const header_offset = frame_header_size(flags) - sizeof(message_header);
+
             message_header header{};
-            std::memcpy(&header, a_body + 1, sizeof(header));
+            std::memcpy(&header, a_body + header_offset, sizeof(header));
+
+            uint8_t const* const body = a_body + header_offset + sizeof(message_header);
+
+            command_context ctx{};
+            ctx.mode = interface_mode::direct_control;
+
+            if ((flags & frame_flag_checksummed) != 0) {
+                size_t const size = frame_header_size(flags) + header.length;
+
+                if (crc32c(a_body, size) != bit_cast<uint32_t>(a_body + size)) {
+                    m_statistics.record_status(dispatch_status::checksum_mismatch);
+
+                    if ((flags & frame_flag_sequenced) != 0) {
+                        m_interface.dcsm_ack(ctx, static_cast<uint16_t>(m_next_sequence - 1), dispatch_status::checksum_mismatch);
+                    }
+
+                    return dispatch_status::checksum_mismatch;
+                }
+            }
+
+            if ((flags & frame_flag_sequenced) == 0) {
+                return process_message(header, body);
+            }
+
+            auto const sequence = bit_cast<uint16_t>(a_body + 1);
+
+            if (sequence != m_next_sequence) {
+                m_statistics.record_status(dispatch_status::out_of_sequence);
+                m_interface.dcsm_ack(ctx, static_cast<uint16_t>(m_next_sequence - 1), dispatch_status::out_of_sequence);
+                return dispatch_status::out_of_sequence;
+            }
+
+            auto const status = process_message(header, body);
+
+            ++m_next_sequence;
+            m_interface.dcsm_ack(ctx, sequence, status);
+
+            return status;
+        }
+
+        /**
+         * @brief Start an extended-length frame, whose body is then passed to stream_data as it arrives.
+         *
+         * Records of record-streamed opcodes are dispatched as soon as they are complete, so the body is
+         * never buffered as a whole, unless the frame is checksummed: then the records are held until
+         * end_stream matched the CRC (see set_stream_staging_limit). frame_decoder streams extended-length
+         * frames on its own.
+         *
+         * @param a_header The frame up to its body (frame_header_size bytes), with frame_flag_extended set.
+         *
+         * @return success, or the reason the body will be skipped.
+         */
+        dispatch_status begin_stream(uint8_t const* a_header);
+
+        /**
+         * @brief Pass the next bytes of the body of the frame started with begin_stream.
+         *
+         * @param a_data The bytes.
+         * @param a_size The number of bytes. Bytes beyond the length in the header are ignored.
+         */
+        void stream_data(uint8_t const* a_data, size_t a_size);
+
+        /**
+         * @brief Finish the frame started with begin_stream.
+         *
+         * @param a_trailer The frame after its body (frame_trailer_size bytes).
+         *
+         * @return Status of the frame: the first failing record, or the frame-level error.
+         */
+        dispatch_status end_stream(uint8_t const* a_trailer);
 
-            return (this->*m_message_handlers[header.opcode])(ctx, header, a_body + 5);
+        /// Expect a_next as the next sequenced frame, e.g. when the host (re)opens the link.
+        void reset_sequence(uint16_t const a_next = 0) noexcept {
+            m_next_sequence = a_next;
         }
 
     private:
-        void initialize_handlers() {
-            m_message_handlers = {
-                nullptr,                           // 0x0000
-                &dispatch::process_id_message,     // 0x0001
-                &dispatch::process_setu_message,   // 0x0002
-                &dispatch::process_setv_message,   // 0x0003
-                &dispatch::process_getu_message,   // 0x0004
-                &dispatch::process_setfr_message,  // 0x0005
-                &dispatch::process_getfr_message,  // 0x0006
-                &dispatch::process_newmu_message,  // 0x0007
-                &dispatch::process_listmu_message, // 0x0008
-                &dispatch::process_delmu_message,  // 0x0009
-                &dispatch::process_setmu_message,  // 0x000A
-                &dispatch::process_setmv_message,  // 0x000B
-                &dispatch::process_getmu_message,  // 0x000C
-                &dispatch::process_clrmu_message,  // 0x000D
-                &dispatch::process_patch_message,  // 0x000E
-                &dispatch::process_unpat_message,  // 0x000F
-                &dispatch::process_listp_message,  // 0x0010
-                &dispatch::process_copy_message,   // 0x0011
-                &dispatch::process_setutv_message, // 0x0012
-                &dispatch::process_setmtv_message, // 0x0013
-                &dispatch::process_listu_message,  // 0x0014
-                &dispatch::process_geta_message,   // 0x0015
-                &dispatch::process_getma_message,  // 0x0016
-            };
+        /**
+         * @brief Parse and dispatch a single command.
+         *
+         * @param a_command    The command plaintext.
+         * @param a_statistics The sink to record into (a batch's staging dispatch holds them back in a staged_statistics).
+         */
+        template <typename t_statistics>
+        dispatch_status process_single_command(std::string const& a_command, t_statistics& a_statistics) {
+            auto const start = a_statistics.start();
+
+            size_t const command_name_end_index = a_command.find_first_of(' ');
+            size_t const command_name_length = command_name_end_index == std::string::npos ? a_command.size() : command_name_end_index;
+
+            auto const& table = command_table();
+            size_t command = 0;
+
+            while (command < table.size() && (std::strlen(table[command].name) != command_name_length || a_command.compare(0, command_name_length, table[command].name) != 0)) {
+                ++command;
+            }
+
+            if (command == table.size()) {
+                a_statistics.record_status(dispatch_status::malformed_syntax);
+                return dispatch_status::malformed_syntax;
+            }
 
-            m_command_handlers = {
+            // Reuse the body buffer, so bodies only allocate when longer than any before.
+            auto& command_body = m_command_body;
+            command_body.clear();
+
+            if (command_name_end_index != std::string::npos) {
+                command_body.append(a_command, command_name_end_index + 1, std::string::npos);
+            }
+
+            command_context ctx{};
+            ctx.mode = interface_mode::command;
+
+            auto const status = (this->*table[command].handler)(ctx, command_body);
+            a_statistics.record_command(command, a_command.size(), status, start);
+
+            return status;
+        }
+
+        static std::array<command_entry, command_count> const& command_table() noexcept {
+            static constexpr std::array<command_entry, command_count> table {{
                 { "set",        &dispatch::process_set_command        },
                 { "mset",       &dispatch::process_mset_command       },
                 { "get",        &dispatch::process_get_command        },
@@ -204,33 +1192,102 @@ namespace dcsm {
                 { "masks",      &dispatch::process_masks_command      },
                 { "deletemask", &dispatch::process_deletemask_command },
                 { "clearmask",  &dispatch::process_clearmask_command  },
-            };
+            }};
+
+            return table;
+        }
+
+        static std::array<message_handler, opcode_count> const& message_table() noexcept {
+            static constexpr std::array<message_handler, opcode_count> table {{
+                nullptr,                              // 0x0000
+                &dispatch::process_id_message,        // 0x0001
+                &dispatch::process_setu_message,      // 0x0002
+                &dispatch::process_setv_message,      // 0x0003
+                &dispatch::process_getu_message,      // 0x0004
+                &dispatch::process_setfr_message,     // 0x0005
+                &dispatch::process_getfr_message,     // 0x0006
+                &dispatch::process_newmu_message,     // 0x0007
+                &dispatch::process_listmu_message,    // 0x0008
+                &dispatch::process_delmu_message,     // 0x0009
+                &dispatch::process_setmu_message,     // 0x000A
+                &dispatch::process_setmv_message,     // 0x000B
+                &dispatch::process_getmu_message,     // 0x000C
+                &dispatch::process_clrmu_message,     // 0x000D
+                &dispatch::process_patch_message,     // 0x000E
+                &dispatch::process_unpat_message,     // 0x000F
+                &dispatch::process_listp_message,     // 0x0010
+                &dispatch::process_copy_message,      // 0x0011
+                &dispatch::process_setutv_message,    // 0x0012
+                &dispatch::process_setmtv_message,    // 0x0013
+                &dispatch::process_listu_message,     // 0x0014
+                &dispatch::process_geta_message,      // 0x0015
+                &dispatch::process_getma_message,     // 0x0016
+                &dispatch::process_setuc_message,     // 0x0017
+                &dispatch::process_setub_message,     // 0x0018
+                &dispatch::process_setsp_message,     // 0x0019
+                &dispatch::process_getr_message,      // 0x001A
+                &dispatch::process_getmr_message,     // 0x001B
+                &dispatch::process_setv16_message,    // 0x001C
+                &dispatch::process_setutv16_message,  // 0x001D
+                &dispatch::process_sub_message,       // 0x001E
+                &dispatch::process_unsub_message,     // 0x001F
+                &dispatch::process_chgu_message,      // 0x0020
+                &dispatch::process_getud_message,     // 0x0021
+                &dispatch::process_difu_message,      // 0x0022
+                &dispatch::process_hashu_message,     // 0x0023
+                &dispatch::process_hashr_message,     // 0x0024
+                &dispatch::process_ack_message,       // 0x0025
+            }};
+
+            return table;
         }
 
-        dispatch_status process_id_message     (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_setu_message   (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_setv_message   (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_getu_message   (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_setfr_message  (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_getfr_message  (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_newmu_message  (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_listmu_message (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_delmu_message  (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_setmu_message  (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_setmv_message  (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_getmu_message  (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_clrmu_message  (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_patch_message  (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_unpat_message  (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_listp_message  (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_copy_message   (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_setutv_message (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_setmtv_message (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_listu_message  (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_geta_message   (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
-        dispatch_status process_getma_message  (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_id_message       (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_setu_message     (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_setv_message     (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_getu_message     (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_setfr_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_getfr_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_newmu_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_listmu_message   (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_delmu_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_setmu_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_setmv_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_getmu_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_clrmu_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_patch_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_unpat_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_listp_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_copy_message     (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_setutv_message   (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_setmtv_message   (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_listu_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_geta_message     (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_getma_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_setuc_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_setub_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_setsp_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_getr_message     (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_getmr_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_setv16_message   (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_setutv16_message (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_sub_message      (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_unsub_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_chgu_message     (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_getud_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_difu_message     (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_hashu_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_hashr_message    (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+        dispatch_status process_ack_message      (command_context& a_ctx, message_header a_header, uint8_t const* a_body);
+
+        /// Shared by setsp and chgu.
+        dispatch_status process_spans          (command_context& a_ctx, message_header a_header, uint8_t const* a_body, void (dispatch_interface::*a_handler)(command_context&, std::vector<universe_span> const&));
+
+        /// Shared by getr and getmr.
+        dispatch_status process_range_readback (command_context& a_ctx, message_header a_header, uint8_t const* a_body, void (dispatch_interface::*a_handler)(command_context&, uint16_t, uint16_t, uint16_t));
 
         dispatch_status process_set_command        (command_context& a_ctx, std::string const& a_command);
+        dispatch_status process_set_values         (command_context& a_ctx, address_range const& a_range, std::string const& a_values);
         dispatch_status process_mset_command       (command_context& a_ctx, std::string const& a_command);
         dispatch_status process_get_command        (command_context& a_ctx, std::string const& a_command);
         dispatch_status process_mget_command       (command_context& a_ctx, std::string const& a_command);
@@ -245,8 +1302,202 @@ namespace dcsm {
         dispatch_status process_masks_command      (command_context& a_ctx, std::string const& a_command);
         dispatch_status process_deletemask_command (command_context& a_ctx, std::string const& a_command);
         dispatch_status process_clearmask_command  (command_context& a_ctx, std::string const& a_command);
+
+        dispatch_status process_readback(command_context& a_ctx, std::string const& a_command, readback_handler a_handler);
+    };
+
+    /**
+     * @brief Interface that records every call instead of acting on it, so it can be replayed later.
+     *
+     * Used to parse all commands of a batch before any of them are delivered.
+     */
+    class command_recorder final : public dispatch_interface {
+        using recorded_call = std::function<void(dispatch_interface&, command_context&)>;
+
+        std::vector<recorded_call> m_calls;
+        dispatch_interface* m_target;
+        size_t m_readback_recorded = 0; ///< Addresses of recorded readbacks, which the target has not seen yet.
+
+    public:
+        /// @param a_target The interface the calls are meant for; asked for its readback capacity while recording.
+        explicit command_recorder(dispatch_interface* const a_target = nullptr) noexcept :
+            m_target(a_target)
+        {}
+
+        /// Forget every recorded call, keeping the storage for the next recording.
+        void clear() noexcept {
+            m_calls.clear();
+            m_readback_recorded = 0;
+        }
+
+        /// The target's capacity, less what the recorded readbacks will take once replayed.
+        size_t dcsm_readback_capacity(command_context& a_ctx) override {
+            if (m_target == nullptr) {
+                return dispatch_interface::dcsm_readback_capacity(a_ctx);
+            }
+
+            size_t const capacity = m_target->dcsm_readback_capacity(a_ctx);
+            return capacity - std::min(capacity, m_readback_recorded);
+        }
+
+        /**
+         * @brief Deliver every recorded call, in order, to another interface.
+         *
+         * @param a_interface The interface to which to deliver.
+         * @param a_ctx       The context with which to deliver.
+         */
+        void replay(dispatch_interface& a_interface, command_context& a_ctx) const {
+            for (auto const& call : m_calls) {
+                call(a_interface, a_ctx);
+            }
+        }
+
+        void dcsm_id(command_context& a_ctx) override {
+            m_calls.emplace_back([](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_id(a_replay_ctx);
+            });
+        }
+
+        void dcsm_setfr(command_context& a_ctx, uint8_t const a_framerate) override {
+            m_calls.emplace_back([a_framerate](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_setfr(a_replay_ctx, a_framerate);
+            });
+        }
+
+        void dcsm_getfr(command_context& a_ctx) override {
+            m_calls.emplace_back([](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_getfr(a_replay_ctx);
+            });
+        }
+
+        void dcsm_newmu(command_context& a_ctx, uint16_t const a_universe) override {
+            m_calls.emplace_back([a_universe](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_newmu(a_replay_ctx, a_universe);
+            });
+        }
+
+        void dcsm_listmu(command_context& a_ctx) override {
+            m_calls.emplace_back([](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_listmu(a_replay_ctx);
+            });
+        }
+
+        void dcsm_delmu(command_context& a_ctx, uint16_t const a_universe) override {
+            m_calls.emplace_back([a_universe](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_delmu(a_replay_ctx, a_universe);
+            });
+        }
+
+        void dcsm_clrmu(command_context& a_ctx, uint16_t const a_universe) override {
+            m_calls.emplace_back([a_universe](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_clrmu(a_replay_ctx, a_universe);
+            });
+        }
+
+        void dcsm_patch(command_context& a_ctx, uint16_t const a_input_universe, uint16_t const a_output_universe, uint16_t const a_mask_universe) override {
+            m_calls.emplace_back([=](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_patch(a_replay_ctx, a_input_universe, a_output_universe, a_mask_universe);
+            });
+        }
+
+        void dcsm_unpat(command_context& a_ctx, uint16_t const a_output_universe) override {
+            m_calls.emplace_back([a_output_universe](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_unpat(a_replay_ctx, a_output_universe);
+            });
+        }
+
+        void dcsm_listp(command_context& a_ctx) override {
+            m_calls.emplace_back([](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_listp(a_replay_ctx);
+            });
+        }
+
+        void dcsm_copy(command_context& a_ctx, uint16_t const a_source_universe, uint16_t const a_destination_universe) override {
+            m_calls.emplace_back([=](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_copy(a_replay_ctx, a_source_universe, a_destination_universe);
+            });
+        }
+
+        void dcsm_setutv(command_context& a_ctx, uint16_t const a_universe, uint8_t const a_value, universe_mask const& a_mask) override {
+            m_calls.emplace_back([=](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_setutv(a_replay_ctx, a_universe, a_value, a_mask);
+            });
+        }
+
+        void dcsm_setutv16(command_context& a_ctx, uint16_t const a_universe, uint16_t const a_value, universe_mask const& a_mask) override {
+            m_calls.emplace_back([=](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_setutv16(a_replay_ctx, a_universe, a_value, a_mask);
+            });
+        }
+
+        void dcsm_setmtv(command_context& a_ctx, uint16_t const a_universe, uint8_t const a_value, universe_mask const& a_mask) override {
+            m_calls.emplace_back([=](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_setmtv(a_replay_ctx, a_universe, a_value, a_mask);
+            });
+        }
+
+        void dcsm_setsp(command_context& a_ctx, std::vector<universe_span> const& a_spans) override {
+            // Span data points into dispatch buffers, keep a copy for the replay.
+            std::vector<uint8_t> values;
+
+            for (auto const& span : a_spans) {
+                values.insert(values.end(), span.data, span.data + span.count);
+            }
+
+            m_calls.emplace_back([a_spans, values](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                auto spans = a_spans;
+                uint8_t const* it = values.data();
+
+                for (auto& span : spans) {
+                    span.data = it;
+                    it += span.count;
+                }
+
+                a_interface.dcsm_setsp(a_replay_ctx, spans);
+            });
+        }
+
+        void dcsm_listu(command_context& a_ctx) override {
+            m_calls.emplace_back([](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_listu(a_replay_ctx);
+            });
+        }
+
+        void dcsm_geta(command_context& a_ctx, std::vector<address_pack> const& a_addresses) override {
+            m_readback_recorded += a_addresses.size();
+            m_calls.emplace_back([a_addresses](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_geta(a_replay_ctx, a_addresses);
+            });
+        }
+
+        void dcsm_getma(command_context& a_ctx, std::vector<address_pack> const& a_addresses) override {
+            m_readback_recorded += a_addresses.size();
+            m_calls.emplace_back([a_addresses](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_getma(a_replay_ctx, a_addresses);
+            });
+        }
+
+        void dcsm_readback_continue(command_context& a_ctx, address_pack const a_next) override {
+            m_calls.emplace_back([a_next](dispatch_interface& a_interface, command_context& a_replay_ctx) {
+                a_interface.dcsm_readback_continue(a_replay_ctx, a_next);
+            });
+        }
     };
 
+    struct dispatch::batch_staging {
+        command_recorder  recorder;
+        dispatch          staging;
+        staged_statistics statistics;
+
+        explicit batch_staging(dispatch& a_owner) :
+            recorder(&a_owner.m_interface),
+            staging(recorder),
+            statistics{ a_owner.m_statistics, {} }
+        {}
+    };
+
+    inline dispatch::~dispatch() = default;
+
     // --------------------------- UTILITY ---------------------------
 
     /**
@@ -605,7 +1856,181 @@ namespace dcsm {
             return static_cast<uint8_t>(std::stod(a_string.substr(0, a_string.size() - 1)) / 100.0 * 255.0);
         }
 
-        return std::stoi(a_string);
+        return std::stoi(a_string);
+    }
+
+    /**
+     * @brief Parses a 16-bit value string like '40000', '50%' or 'full' (without the 16b: prefix).
+     *
+     * Percentages use the full 16-bit resolution.
+     *
+     * @param a_string The raw value string.
+     *
+     * @return The value that is represented by the string.
+     *
+     * @pre Input string should be trimmed (no surrounding whitespace).
+     */
+    inline uint16_t parse_value16(std::string const& a_string) {
+        if (a_string == "full") {
+            return 65535;
+        }
+
+        if (a_string == "half") {
+            return 32768;
+        }
+
+        if (a_string == "out") {
+            return 0;
+        }
+
+        // Percentage value.
+        if (a_string.find_last_of('%') != std::string::npos) {
+            return static_cast<uint16_t>(std::stod(a_string.substr(0, a_string.size() - 1)) / 100.0 * 65535.0);
+        }
+
+        unsigned long const value = std::stoul(a_string);
+
+        if (value > 0xFFFF) {
+            throw std::out_of_range("16-bit value out of range");
+        }
+
+        return static_cast<uint16_t>(value);
+    }
+
+    /// True if a value string carries the 16b: prefix.
+    inline bool is_fine_value(std::string const& a_string) noexcept {
+        return a_string.compare(0, sizeof(fine_value_prefix) - 1, fine_value_prefix) == 0;
+    }
+
+    /*
+     * Universe run-length encoding (setuc). A sequence of runs covering exactly 512 addresses, each
+     * starting with a control byte:
+     *
+     *   0x00-0x7F: literal, followed by (control + 1) bytes
+     *   0x80-0xFF: repeat, followed by one byte that is repeated (control - 0x80 + 1) times
+     *
+     * Show data is mostly long runs of 0 and 255, and the XOR of two consecutive frames mostly zero.
+     */
+
+    /**
+     * @brief Walk the runs of a compressed universe.
+     *
+     * @param a_data    The runs.
+     * @param a_size    The size of the runs.
+     * @param a_repeat  Called with (offset, count, value) for each repeat.
+     * @param a_literal Called with (offset, count, bytes) for each literal.
+     *
+     * @return False if the runs are truncated or do not cover exactly 512 addresses.
+     */
+    template <typename t_repeat, typename t_literal>
+    bool visit_universe_runs(uint8_t const* a_data, size_t const a_size, t_repeat&& a_repeat, t_literal&& a_literal) {
+        uint8_t const* it        = a_data;
+        uint8_t const* const end = a_data + a_size;
+        size_t offset = 0;
+
+        while (it != end) {
+            uint8_t const control = *it++;
+            size_t const count    = (control & 0x7F) + 1;
+            size_t const operand  = control & 0x80 ? 1 : count;
+
+            if (static_cast<size_t>(end - it) < operand || offset + count > 512) {
+                return false;
+            }
+
+            if (control & 0x80) {
+                a_repeat(offset, count, *it);
+            } else {
+                a_literal(offset, count, it);
+            }
+
+            it     += operand;
+            offset += count;
+        }
+
+        return offset == 512;
+    }
+
+    /// Check that compressed universe runs are well-formed without decoding them.
+    inline bool validate_universe_runs(uint8_t const* a_data, size_t const a_size) noexcept {
+        return visit_universe_runs(a_data, a_size, [](size_t, size_t, uint8_t) {}, [](size_t, size_t, uint8_t const*) {});
+    }
+
+    /// Decode validated runs into 512 bytes of universe data.
+    inline void expand_universe_runs(uint8_t* a_destination, uint8_t const* a_data, size_t const a_size) noexcept {
+        visit_universe_runs(a_data, a_size,
+            [a_destination](size_t const a_offset, size_t const a_count, uint8_t const a_value) {
+                std::memset(a_destination + a_offset, a_value, a_count);
+            },
+            [a_destination](size_t const a_offset, size_t const a_count, uint8_t const* a_bytes) {
+                std::memcpy(a_destination + a_offset, a_bytes, a_count);
+            });
+    }
+
+    /// XOR validated runs onto 512 bytes of universe data. Zero runs (unchanged addresses) are skipped.
+    inline void apply_universe_delta(uint8_t* a_destination, uint8_t const* a_data, size_t const a_size) noexcept {
+        visit_universe_runs(a_data, a_size,
+            [a_destination](size_t const a_offset, size_t const a_count, uint8_t const a_value) {
+                if (a_value != 0) {
+                    for (size_t i = 0; i < a_count; ++i) {
+                        a_destination[a_offset + i] ^= a_value;
+                    }
+                }
+            },
+            [a_destination](size_t const a_offset, size_t const a_count, uint8_t const* a_bytes) {
+                for (size_t i = 0; i < a_count; ++i) {
+                    a_destination[a_offset + i] ^= a_bytes[i];
+                }
+            });
+    }
+
+    /**
+     * @brief Run-length encode 512 bytes of universe data.
+     *
+     * @param a_destination Destination of the runs (at least compressed_universe_max_size bytes).
+     * @param a_data        The universe data.
+     *
+     * @return The size of the runs.
+     */
+    inline size_t compress_universe(uint8_t* a_destination, uint8_t const* a_data) noexcept {
+        size_t size          = 0;
+        size_t literal_start = 0;
+        size_t i             = 0;
+
+        auto const flush_literal = [&](size_t const a_end) {
+            while (literal_start < a_end) {
+                size_t const count = std::min<size_t>(a_end - literal_start, 128);
+
+                a_destination[size++] = static_cast<uint8_t>(count - 1);
+                std::memcpy(a_destination + size, a_data + literal_start, count);
+
+                size          += count;
+                literal_start += count;
+            }
+        };
+
+        while (i < 512) {
+            size_t run = 1;
+
+            while (i + run < 512 && run < 128 && a_data[i + run] == a_data[i]) {
+                ++run;
+            }
+
+            // Pairs only pay off when they do not split a literal.
+            if (run >= 3 || (run == 2 && literal_start == i)) {
+                flush_literal(i);
+
+                a_destination[size++] = static_cast<uint8_t>(0x80 | (run - 1));
+                a_destination[size++] = a_data[i];
+
+                literal_start = i + run;
+            }
+
+            i += run;
+        }
+
+        flush_literal(512);
+
+        return size;
     }
 
     // ---------------------------------------------------------------
@@ -638,7 +2063,8 @@ namespace dcsm {
         size_t const pair_count = a_header.length / 5;
 
         /// tuple: universe number, local address, value
-        std::vector<std::pair<address_pack, uint8_t>> pairs;
+        auto& pairs = m_setv_pairs;
+        pairs.clear();
 
         for (size_t i = 0; i < pair_count; ++i) {
             uint8_t const* it = a_body + (i * 5);
@@ -744,7 +2170,8 @@ namespace dcsm {
         size_t const pair_count = (a_header.length - 2) / 4;
 
         /// tuple: local address, masking, value
-        std::vector<std::tuple<uint16_t, bool, uint8_t>> pairs;
+        auto& pairs = m_setmv_pairs;
+        pairs.clear();
 
         for (size_t i = 0; i < pair_count; ++i) {
             uint8_t const* it = a_body + 2 + (i * 4);
@@ -834,79 +2261,553 @@ namespace dcsm {
             return dispatch_status::invalid_body_size;
         }
 
-        auto const universe_number = bit_cast<uint16_t>(a_body);
-        auto const value           = *(a_body + 2);
+        auto const universe_number = bit_cast<uint16_t>(a_body);
+        auto const value           = *(a_body + 2);
+
+        universe_mask const mask = bytes_to_bitset<512>(a_body + 3);
+
+        m_interface.dcsm_setutv(a_ctx, universe_number, value, mask);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_setmtv_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        // 2 (universe number) + 1 (value) + 64 (mask)
+        if (a_header.length != 67) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        auto const universe_number = bit_cast<uint16_t>(a_body);
+        auto const value           = *(a_body + 2);
+
+        universe_mask const mask = bytes_to_bitset<512>(a_body + 3);
+
+        m_interface.dcsm_setmtv(a_ctx, universe_number, value, mask);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_listu_message(command_context &a_ctx, message_header const a_header, uint8_t const *a_body) {
+        m_interface.dcsm_listu(a_ctx);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_geta_message(command_context &a_ctx, message_header const a_header, uint8_t const *a_body) {
+        // Body size must be evenly divisible into address pairs.
+        if (a_header.length < 4 || a_header.length % 4 != 0) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        size_t const pair_count = a_header.length / 4;
+
+        auto& addresses = m_addresses;
+        addresses.clear();
+
+        for (size_t i = 0; i < pair_count; ++i) {
+            uint8_t const* it = a_body + (i * 4);
+
+            auto const universe_number = bit_cast<uint16_t>(it);
+            auto const local_address   = bit_cast<uint16_t>(it + 2);
+
+            addresses.emplace_back(universe_number, local_address);
+        }
+
+        m_interface.dcsm_geta(a_ctx, addresses);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_getma_message(command_context &a_ctx, message_header const a_header, uint8_t const *a_body) {
+        // Body size must be evenly divisible into address pairs.
+        if (a_header.length < 4 || a_header.length % 4 != 0) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        size_t const pair_count = a_header.length / 4;
+
+        auto& addresses = m_addresses;
+        addresses.clear();
+
+        for (size_t i = 0; i < pair_count; ++i) {
+            uint8_t const* it = a_body + (i * 4);
+
+            auto const universe_number = bit_cast<uint16_t>(it);
+            auto const local_address   = bit_cast<uint16_t>(it + 2);
+
+            addresses.emplace_back(universe_number, local_address);
+        }
+
+        m_interface.dcsm_getma(a_ctx, addresses);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_setuc_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        // 2 (universe number) + 1 (encoding) + runs
+        if (a_header.length < 2 + 1 || !validate_universe_runs(a_body + 3, a_header.length - 3)) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        auto const universe_number = bit_cast<uint16_t>(a_body);
+        auto const encoding        = static_cast<universe_encoding>(*(a_body + 2));
+
+        if (encoding != universe_encoding::runs && encoding != universe_encoding::delta) {
+            return dispatch_status::unsupported;
+        }
+
+        uint8_t* const buffer = m_interface.dcsm_universe_buffer(a_ctx, universe_number);
+
+        if (buffer == nullptr) {
+            if (encoding == universe_encoding::delta) {
+                return dispatch_status::unsupported;
+            }
+
+            expand_universe_runs(m_universe_data.data(), a_body + 3, a_header.length - 3);
+            m_interface.dcsm_setu(a_ctx, universe_number, m_universe_data.data());
+
+            return dispatch_status::success;
+        }
+
+        if (encoding == universe_encoding::runs) {
+            expand_universe_runs(buffer, a_body + 3, a_header.length - 3);
+        } else {
+            apply_universe_delta(buffer, a_body + 3, a_header.length - 3);
+        }
+
+        m_interface.dcsm_setuc(a_ctx, universe_number);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_setub_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        // 2 (universe count) + universe count * (2 (universe number) + 512 (universe data))
+        if (a_header.length < 2) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        auto const universe_count = bit_cast<uint16_t>(a_body);
+
+        if (universe_count == 0 || a_header.length != 2 + universe_count * (2 + 512)) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        auto& universes = m_bulk_universes;
+        universes.clear();
+
+        for (size_t i = 0; i < universe_count; ++i) {
+            uint8_t const* it = a_body + 2 + (i * (2 + 512));
+            universes.emplace_back(bit_cast<uint16_t>(it), it + 2);
+        }
+
+        m_interface.dcsm_setu_bulk(a_ctx, universes);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_setsp_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        return process_spans(a_ctx, a_header, a_body, &dispatch_interface::dcsm_setsp);
+    }
+
+    inline dispatch_status dispatch::process_spans(command_context& a_ctx, message_header const a_header, uint8_t const* a_body, void (dispatch_interface::*a_handler)(command_context&, std::vector<universe_span> const&)) {
+        // One or more of: 2 (universe number) + 2 (start address) + 2 (count) + count (values)
+        if (a_header.length == 0) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        auto& spans = m_spans;
+        spans.clear();
+
+        uint8_t const* it        = a_body;
+        uint8_t const* const end = a_body + a_header.length;
+
+        while (it != end) {
+            if (end - it < 6) {
+                return dispatch_status::invalid_body_size;
+            }
+
+            universe_span const span { bit_cast<uint16_t>(it), bit_cast<uint16_t>(it + 2), bit_cast<uint16_t>(it + 4), it + 6 };
+
+            // Spans must lie within their universe.
+            if (span.start == 0 || span.count == 0 || span.start + span.count - 1 > 512 || static_cast<size_t>(end - span.data) < span.count) {
+                return dispatch_status::invalid_body_size;
+            }
+
+            spans.push_back(span);
+            it = span.data + span.count;
+        }
+
+        (m_interface.*a_handler)(a_ctx, spans);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_setv16_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        // Body size must be evenly divisible into address-value pairs.
+        if (a_header.length < 6 || a_header.length % 6 != 0) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        size_t const pair_count = a_header.length / 6;
+
+        auto& pairs = m_setv16_pairs;
+        pairs.clear();
+
+        for (size_t i = 0; i < pair_count; ++i) {
+            uint8_t const* it = a_body + (i * 6);
+
+            auto const universe_number = bit_cast<uint16_t>(it);
+            auto const local_address   = bit_cast<uint16_t>(it + 2);
+            auto const value           = bit_cast<uint16_t>(it + 4);
+
+            // The fine channel (address + 1) must lie within the universe.
+            if (local_address == 0 || local_address > 511) {
+                return dispatch_status::invalid_body_size;
+            }
+
+            pairs.emplace_back(address_pack{ universe_number, local_address }, value);
+        }
+
+        m_interface.dcsm_setv16(a_ctx, pairs);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_setutv16_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        // 2 (universe number) + 2 (value) + 64 (mask)
+        if (a_header.length != 2 + 2 + 64) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        auto const universe_number = bit_cast<uint16_t>(a_body);
+        auto const value           = bit_cast<uint16_t>(a_body + 2);
+
+        universe_mask const mask = bytes_to_bitset<512>(a_body + 4);
+
+        // Address 512 has no fine channel after it.
+        if (mask.test(511)) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        m_interface.dcsm_setutv16(a_ctx, universe_number, value, mask);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_getr_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        return process_range_readback(a_ctx, a_header, a_body, &dispatch_interface::dcsm_getr);
+    }
+
+    inline dispatch_status dispatch::process_getmr_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        return process_range_readback(a_ctx, a_header, a_body, &dispatch_interface::dcsm_getmr);
+    }
+
+    inline dispatch_status dispatch::process_range_readback(command_context& a_ctx, message_header const a_header, uint8_t const* a_body, void (dispatch_interface::*a_handler)(command_context&, uint16_t, uint16_t, uint16_t)) {
+        // 2 (universe number) + 2 (start address) + 2 (count)
+        if (a_header.length != 2 + 2 + 2) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        auto const universe_number = bit_cast<uint16_t>(a_body);
+        auto const start           = bit_cast<uint16_t>(a_body + 2);
+        auto const count           = bit_cast<uint16_t>(a_body + 4);
+
+        // The range must lie within the universe.
+        if (start == 0 || count == 0 || start + count - 1 > 512) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        (m_interface.*a_handler)(a_ctx, universe_number, start, count);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_sub_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        // 2 (universe number)
+        if (a_header.length != 2) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        auto const universe_number = bit_cast<uint16_t>(a_body);
+
+        m_interface.dcsm_sub(a_ctx, universe_number);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_unsub_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        // 2 (universe number)
+        if (a_header.length != 2) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        auto const universe_number = bit_cast<uint16_t>(a_body);
+
+        m_interface.dcsm_unsub(a_ctx, universe_number);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_chgu_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        // Same layout as setsp.
+        return process_spans(a_ctx, a_header, a_body, &dispatch_interface::dcsm_chgu);
+    }
+
+    inline dispatch_status dispatch::process_getud_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        // 2 (universe number) + 2 (session) + 4 (generation)
+        if (a_header.length != 8) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        auto const universe_number = bit_cast<uint16_t>(a_body);
+        auto const session         = bit_cast<uint16_t>(a_body + 2);
+        auto const generation      = bit_cast<uint32_t>(a_body + 4);
+
+        m_interface.dcsm_getud(a_ctx, universe_number, session, generation);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_difu_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        // 2 (universe number) + 4 (generation), then zero or more of: 2 (start address) + 2 (count) + count (values)
+        if (a_header.length < 6) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        auto const universe_number = bit_cast<uint16_t>(a_body);
+        auto const generation      = bit_cast<uint32_t>(a_body + 2);
+
+        auto& spans = m_spans;
+        spans.clear();
+
+        uint8_t const* it        = a_body + 6;
+        uint8_t const* const end = a_body + a_header.length;
+
+        while (it != end) {
+            if (end - it < 4) {
+                return dispatch_status::invalid_body_size;
+            }
+
+            universe_span const span { universe_number, bit_cast<uint16_t>(it), bit_cast<uint16_t>(it + 2), it + 4 };
+
+            // Spans must lie within the universe.
+            if (span.start == 0 || span.count == 0 || span.start + span.count - 1 > 512 || static_cast<size_t>(end - span.data) < span.count) {
+                return dispatch_status::invalid_body_size;
+            }
+
+            spans.push_back(span);
+            it = span.data + span.count;
+        }
+
+        m_interface.dcsm_difu(a_ctx, universe_number, generation, spans);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_hashu_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        // 2 (first universe number) + 2 (count) + 1 (flags: bit 0 combined)
+        if (a_header.length != 5) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        auto const first    = bit_cast<uint16_t>(a_body);
+        auto const count    = bit_cast<uint16_t>(a_body + 2);
+        bool const combined = (a_body[4] & 0x01) != 0;
+
+        // Per-universe hashes must fit the reply.
+        if (count == 0 || (!combined && count > hash_universe_max)) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        m_interface.dcsm_hashu(a_ctx, first, count, combined);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_hashr_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        // 2 (first universe number) + 2 (count), then count hashes or one combined hash (8 each)
+        if (a_header.length < 4) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        auto const first = bit_cast<uint16_t>(a_body);
+        auto const count = bit_cast<uint16_t>(a_body + 2);
+
+        size_t const hash_count = (a_header.length - 4) / 8;
+
+        if (count == 0 || a_header.length != 4 + hash_count * 8 || (hash_count != count && hash_count != 1)) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        auto& hashes = m_hashes;
+        hashes.clear();
+
+        for (size_t i = 0; i < hash_count; ++i) {
+            hashes.push_back(bit_cast<uint64_t>(a_body + 4 + i * 8));
+        }
+
+        m_interface.dcsm_hashr(a_ctx, first, count, hashes);
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::process_ack_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
+        // 2 (sequence number) + 4 (window) + 1 (status)
+        if (a_header.length != 7) {
+            return dispatch_status::invalid_body_size;
+        }
+
+        uint8_t const status = a_body[6];
+
+        // A status this version does not know.
+        if (status >= dispatch_status_count) {
+            return dispatch_status::unsupported;
+        }
+
+        m_interface.dcsm_ackr(a_ctx, bit_cast<uint16_t>(a_body), bit_cast<uint32_t>(a_body + 2), static_cast<dispatch_status>(status));
+        return dispatch_status::success;
+    }
+
+    inline dispatch_status dispatch::begin_stream(uint8_t const* a_header) {
+        uint8_t const flags = *a_header;
+        size_t const header_size = frame_header_size(flags);
+
+        m_stream = stream_state{};
+        m_stream.flags       = flags;
+        m_stream.opcode      = bit_cast<uint16_t>(a_header + header_size - 6);
+        m_stream.remaining   = bit_cast<uint32_t>(a_header + header_size - 4);
+        m_stream.record_size = stream_record_size(m_stream.opcode);
+
+        if ((flags & frame_flag_checksummed) != 0) {
+            m_stream.crc = crc32c(a_header, header_size);
+        }
+
+        command_context ctx{};
+        ctx.mode = interface_mode::direct_control;
+
+        if ((flags & frame_flag_sequenced) != 0) {
+            m_stream.sequence = bit_cast<uint16_t>(a_header + 1);
+
+            if (m_stream.sequence != m_next_sequence) {
+                m_stream.status = dispatch_status::out_of_sequence;
+                return m_stream.status;
+            }
+        }
+
+        // Records of a checksummed frame wait for its trailer.
+        m_stream.staged = (flags & frame_flag_checksummed) != 0 && m_stream.record_size != 0;
 
-        universe_mask const mask = bytes_to_bitset<512>(a_body + 3);
+        if (m_stream.staged && m_stream.remaining > m_stream_staging_limit) {
+            m_stream.status = dispatch_status::unsupported;
+            return m_stream.status;
+        }
 
-        m_interface.dcsm_setutv(a_ctx, universe_number, value, mask);
-        return dispatch_status::success;
+        if (!m_interface.dcsm_stream_begin(ctx, m_stream.opcode, m_stream.remaining)) {
+            m_stream.status = dispatch_status::unsupported;
+        } else if (m_stream.staged) {
+            m_stream_staged.clear();
+            m_stream_staged.reserve(m_stream.remaining);
+        }
+
+        return m_stream.status;
     }
 
-    inline dispatch_status dispatch::process_setmtv_message(command_context& a_ctx, message_header const a_header, uint8_t const* a_body) {
-        // 2 (universe number) + 1 (value) + 64 (mask)
-        if (a_header.length != 67) {
-            return dispatch_status::invalid_body_size;
+    inline void dispatch::stream_data(uint8_t const* a_data, size_t a_size) {
+        a_size = std::min<size_t>(a_size, m_stream.remaining);
+        m_stream.remaining -= static_cast<uint32_t>(a_size);
+
+        if ((m_stream.flags & frame_flag_checksummed) != 0) {
+            m_stream.crc = crc32c(a_data, a_size, m_stream.crc);
         }
 
-        auto const universe_number = bit_cast<uint16_t>(a_body);
-        auto const value           = *(a_body + 2);
+        if (m_stream.status != dispatch_status::success || a_size == 0) {
+            return;
+        }
 
-        universe_mask const mask = bytes_to_bitset<512>(a_body + 3);
+        size_t const record_size = m_stream.record_size;
 
-        m_interface.dcsm_setmtv(a_ctx, universe_number, value, mask);
-        return dispatch_status::success;
-    }
+        if (record_size == 0) {
+            command_context ctx{};
+            ctx.mode = interface_mode::direct_control;
 
-    inline dispatch_status dispatch::process_listu_message(command_context &a_ctx, message_header const a_header, uint8_t const *a_body) {
-        m_interface.dcsm_listu(a_ctx);
-        return dispatch_status::success;
-    }
+            m_interface.dcsm_stream_data(ctx, a_data, a_size);
+            return;
+        }
 
-    inline dispatch_status dispatch::process_geta_message(command_context &a_ctx, message_header const a_header, uint8_t const *a_body) {
-        // Body size must be evenly divisible into address pairs.
-        if (a_header.length < 4 || a_header.length % 4 != 0) {
-            return dispatch_status::invalid_body_size;
+        if (m_stream.staged) {
+            m_stream_staged.insert(m_stream_staged.end(), a_data, a_data + a_size);
+            return;
         }
 
-        size_t const pair_count = a_header.length / 4;
+        message_header const header { m_stream.opcode, static_cast<uint16_t>(record_size) };
 
-        std::vector<address_pack> addresses;
+        auto const deliver = [this, header](uint8_t const* a_record) {
+            auto const status = process_message(header, a_record);
 
-        for (size_t i = 0; i < pair_count; ++i) {
-            uint8_t const* it = a_body + (i * 4);
+            if (m_stream.record_status == dispatch_status::success) {
+                m_stream.record_status = status;
+            }
+        };
+
+        while (a_size != 0) {
+            // Whole records straight from the chunk; only records split across chunks are copied.
+            if (m_stream.record_fill == 0 && a_size >= record_size) {
+                deliver(a_data);
+                a_data += record_size;
+                a_size -= record_size;
+                continue;
+            }
 
-            auto const universe_number = bit_cast<uint16_t>(it);
-            auto const local_address   = bit_cast<uint16_t>(it + 2);
+            size_t const take = std::min(record_size - m_stream.record_fill, a_size);
+            std::memcpy(m_stream_record.data() + m_stream.record_fill, a_data, take);
+            m_stream.record_fill += take;
+            a_data += take;
+            a_size -= take;
 
-            addresses.emplace_back(universe_number, local_address);
+            if (m_stream.record_fill == record_size) {
+                deliver(m_stream_record.data());
+                m_stream.record_fill = 0;
+            }
         }
-
-        m_interface.dcsm_geta(a_ctx, addresses);
-        return dispatch_status::success;
     }
 
-    inline dispatch_status dispatch::process_getma_message(command_context &a_ctx, message_header const a_header, uint8_t const *a_body) {
-        // Body size must be evenly divisible into address pairs.
-        if (a_header.length < 4 || a_header.length % 4 != 0) {
-            return dispatch_status::invalid_body_size;
+    inline dispatch_status dispatch::end_stream(uint8_t const* a_trailer) {
+        command_context ctx{};
+        ctx.mode = interface_mode::direct_control;
+
+        bool const accepted = m_stream.status == dispatch_status::success;
+        dispatch_status status = m_stream.status;
+
+        if (accepted && (m_stream.remaining != 0 || m_stream.record_fill != 0)) {
+            // Ended early, or a partial record at the end.
+            status = dispatch_status::invalid_body_size;
         }
 
-        size_t const pair_count = a_header.length / 4;
+        if ((m_stream.flags & frame_flag_checksummed) != 0 && status != dispatch_status::out_of_sequence && m_stream.crc != bit_cast<uint32_t>(a_trailer)) {
+            status = dispatch_status::checksum_mismatch;
+        }
 
-        std::vector<address_pack> addresses;
+        if (accepted && m_stream.staged && status == dispatch_status::success) {
+            size_t const record_size = m_stream.record_size;
+            message_header const header { m_stream.opcode, static_cast<uint16_t>(record_size) };
 
-        for (size_t i = 0; i < pair_count; ++i) {
-            uint8_t const* it = a_body + (i * 4);
+            if (m_stream_staged.size() % record_size != 0) {
+                status = dispatch_status::invalid_body_size;
+            } else {
+                for (size_t offset = 0; offset != m_stream_staged.size(); offset += record_size) {
+                    auto const record_status = process_message(header, m_stream_staged.data() + offset);
 
-            auto const universe_number = bit_cast<uint16_t>(it);
-            auto const local_address   = bit_cast<uint16_t>(it + 2);
+                    if (m_stream.record_status == dispatch_status::success) {
+                        m_stream.record_status = record_status;
+                    }
+                }
+            }
+        }
 
-            addresses.emplace_back(universe_number, local_address);
+        if (status != dispatch_status::success) {
+            m_statistics.record_status(status);
+        } else {
+            status = m_stream.record_status;
         }
 
-        m_interface.dcsm_getma(a_ctx, addresses);
-        return dispatch_status::success;
+        if (accepted) {
+            m_interface.dcsm_stream_end(ctx, status);
+        }
+
+        if ((m_stream.flags & frame_flag_sequenced) != 0) {
+            if (status == dispatch_status::out_of_sequence || status == dispatch_status::checksum_mismatch) {
+                m_interface.dcsm_ack(ctx, static_cast<uint16_t>(m_next_sequence - 1), status);
+            } else {
+                ++m_next_sequence;
+                m_interface.dcsm_ack(ctx, m_stream.sequence, status);
+            }
+        }
+
+        m_stream = stream_state{};
+        return status;
     }
 
     // ----------------- END DIRECT CONTROL MESSAGES -----------------
@@ -914,31 +2815,71 @@ namespace dcsm {
 
     // -------------------------- COMMANDS ---------------------------
 
+    inline dispatch_status dispatch::process_command_batch(std::string const& a_batch) {
+        if (!m_batch) {
+            m_batch.reset(new batch_staging(*this));
+        }
+
+        m_batch->recorder.clear();
+        m_batch->statistics.commands.clear();
+        m_batch->staging.m_readback_chunk_size = m_readback_chunk_size;
+        m_batch->staging.m_readback_limit = m_readback_limit;
 
-    inline dispatch_status dispatch::process_set_command(command_context &a_ctx, std::string const &a_command) {
-        size_t const at_delim_index = a_command.find_first_of('@');
+        size_t command_count = 0;
 
-        if (at_delim_index == std::string::npos) {
-            return dispatch_status::malformed_syntax;
+        // Parse every command up front. Nothing is delivered unless the whole batch is well-formed.
+        for (size_t command_begin = 0; command_begin <= a_batch.size();) {
+            size_t command_end = a_batch.find(command_separator, command_begin);
+            command_end = command_end == std::string::npos ? a_batch.size() : command_end;
+
+            std::string command = a_batch.substr(command_begin, command_end - command_begin);
+            trim(command);
+
+            command_begin = command_end + 1;
+
+            // Tolerate empty commands, e.g. a trailing separator.
+            if (command.empty()) {
+                continue;
+            }
+
+            dispatch_status status;
+
+            try {
+                status = m_batch->staging.process_single_command(command, m_batch->statistics);
+            } catch (std::exception const&) {
+                // Address, value and universe parsing report malformed input by throwing.
+                status = dispatch_status::malformed_syntax;
+            }
+
+            if (status != dispatch_status::success) {
+                m_statistics.record_status(status);
+                return status;
+            }
+
+            ++command_count;
         }
 
-        std::string address_range_string = a_command.substr(0, at_delim_index);
-        trim(address_range_string);
+        if (command_count == 0) {
+            m_statistics.record_status(dispatch_status::malformed_syntax);
+            return dispatch_status::malformed_syntax;
+        }
 
-        std::string value_string = a_command.substr(at_delim_index + 1);
-        trim(value_string);
+        command_context ctx{};
+        ctx.mode = interface_mode::command;
 
-        auto const range = parse_address_range(address_range_string);
-        auto const value = parse_value(value_string);
+        m_interface.dcsm_begin_batch(ctx, command_count);
+        m_batch->recorder.replay(m_interface, ctx);
+        m_interface.dcsm_end_batch(ctx);
 
-        for (auto const& universe_pair : range) {
-            m_interface.dcsm_setutv(a_ctx, universe_pair.first, value, universe_pair.second);
+        for (auto const& record : m_batch->statistics.commands) {
+            m_statistics.record_command(record.command, record.bytes, record.status, record.start);
         }
 
         return dispatch_status::success;
     }
 
-    inline dispatch_status dispatch::process_mset_command(command_context &a_ctx, std::string const &a_command) {
+
+    inline dispatch_status dispatch::process_set_command(command_context &a_ctx, std::string const &a_command) {
         size_t const at_delim_index = a_command.find_first_of('@');
 
         if (at_delim_index == std::string::npos) {
@@ -952,71 +2893,139 @@ namespace dcsm {
         trim(value_string);
 
         auto const range = parse_address_range(address_range_string);
+
+        if (value_string.find(',') != std::string::npos) {
+            return process_set_values(a_ctx, range, value_string);
+        }
+
+        if (is_fine_value(value_string)) {
+            std::string fine_value_string = value_string.substr(sizeof(fine_value_prefix) - 1);
+            trim(fine_value_string);
+
+            auto const value = parse_value16(fine_value_string);
+
+            // Address 512 has no fine channel after it.
+            for (auto const& universe_pair : range) {
+                if (universe_pair.second.test(511)) {
+                    return dispatch_status::malformed_syntax;
+                }
+            }
+
+            for (auto const& universe_pair : range) {
+                m_interface.dcsm_setutv16(a_ctx, universe_pair.first, value, universe_pair.second);
+            }
+
+            return dispatch_status::success;
+        }
+
         auto const value = parse_value(value_string);
 
         for (auto const& universe_pair : range) {
-            m_interface.dcsm_setmtv(a_ctx, universe_pair.first, value, universe_pair.second);
+            m_interface.dcsm_setutv(a_ctx, universe_pair.first, value, universe_pair.second);
         }
 
         return dispatch_status::success;
     }
 
-    inline dispatch_status dispatch::process_get_command(command_context &a_ctx, std::string const &a_command) {
-        std::string address_range_string = a_command;
-        trim(address_range_string);
+    inline dispatch_status dispatch::process_set_values(command_context& a_ctx, address_range const& a_range, std::string const& a_values) {
+        // One value per selected address, in address order.
+        auto& values = m_span_values;
+        values.clear();
 
-        auto const range = parse_address_range(address_range_string);
+        size_t start = 0;
 
-        std::vector<address_pack> addresses;
+        while (start <= a_values.size()) {
+            size_t end = a_values.find(',', start);
 
-        for (auto const& universe_pair : range) {
-            auto const& set = universe_pair.second;
+            if (end == std::string::npos) {
+                end = a_values.size();
+            }
+
+            std::string value_string = a_values.substr(start, end - start);
+            trim(value_string);
+
+            // 16-bit values are not supported in value lists.
+            if (value_string.empty() || is_fine_value(value_string)) {
+                return dispatch_status::malformed_syntax;
+            }
+
+            values.push_back(parse_value(value_string));
+            start = end + 1;
+        }
 
+        auto& spans = m_spans;
+        spans.clear();
+
+        size_t value_index = 0;
+
+        for (auto const& universe_pair : a_range) {
             for (size_t i = 0; i < 512; ++i) {
-                if (set.test(i)) {
-                    const auto address_number = i + 1;
-                    addresses.emplace_back(universe_pair.first, address_number);
+                if (!universe_pair.second.test(i)) {
+                    continue;
+                }
 
-                    if (addresses.size() >= 100) {
-                        break;
-                    }
+                size_t count = 1;
+
+                while (i + count < 512 && universe_pair.second.test(i + count)) {
+                    ++count;
+                }
+
+                if (value_index + count > values.size()) {
+                    return dispatch_status::malformed_syntax;
                 }
+
+                spans.push_back({ universe_pair.first, static_cast<uint16_t>(i + 1), static_cast<uint16_t>(count), values.data() + value_index });
+
+                value_index += count;
+                i           += count;
             }
         }
 
-        m_interface.dcsm_geta(a_ctx, addresses);
+        if (value_index != values.size() || spans.empty()) {
+            return dispatch_status::malformed_syntax;
+        }
 
+        m_interface.dcsm_setsp(a_ctx, spans);
         return dispatch_status::success;
     }
 
-    inline dispatch_status dispatch::process_mget_command(command_context &a_ctx, std::string const &a_command) {
-        std::string address_range_string = a_command;
-        trim(address_range_string);
+    inline dispatch_status dispatch::process_mset_command(command_context &a_ctx, std::string const &a_command) {
+        size_t const at_delim_index = a_command.find_first_of('@');
 
-        auto const range = parse_address_range(address_range_string);
+        if (at_delim_index == std::string::npos) {
+            return dispatch_status::malformed_syntax;
+        }
 
-        std::vector<address_pack> addresses;
+        std::string address_range_string = a_command.substr(0, at_delim_index);
+        trim(address_range_string);
 
-        for (auto const& universe_pair : range) {
-            auto const& set = universe_pair.second;
+        std::string value_string = a_command.substr(at_delim_index + 1);
+        trim(value_string);
 
-            for (size_t i = 0; i < 512; ++i) {
-                if (set.test(i)) {
-                    const auto address_number = i + 1;
-                    addresses.emplace_back(universe_pair.first, address_number);
+        auto const range = parse_address_range(address_range_string);
 
-                    if (addresses.size() >= 100) {
-                        break;
-                    }
-                }
-            }
+        // Mask universes have no 16-bit set.
+        if (is_fine_value(value_string)) {
+            return dispatch_status::malformed_syntax;
         }
 
-        m_interface.dcsm_getma(a_ctx, addresses);
+        auto const value = parse_value(value_string);
+
+        for (auto const& universe_pair : range) {
+            m_interface.dcsm_setmtv(a_ctx, universe_pair.first, value, universe_pair.second);
+        }
 
         return dispatch_status::success;
     }
 
+    inline dispatch_status dispatch::process_get_command(command_context &a_ctx, std::string const &a_command) {
+        return process_readback(a_ctx, a_command, &dispatch_interface::dcsm_geta);
+    }
+
+    inline dispatch_status dispatch::process_mget_command(command_context &a_ctx, std::string const &a_command) {
+        return process_readback(a_ctx, a_command, &dispatch_interface::dcsm_getma);
+    }
+
     inline dispatch_status dispatch::process_copy_command(command_context &a_ctx, std::string const &a_command) {
         size_t const to_delim_index = a_command.find_first_of('t');
 
@@ -1152,9 +3161,289 @@ namespace dcsm {
         return dispatch_status::success;
     }
 
+    /**
+     * @brief Stream the addresses of a get/mget range to the interface in fixed-size chunks.
+     *
+     * Stops once the page limit is reached or the handler reports no remaining capacity, in which case
+     * dcsm_readback_continue receives the first undelivered address. Syntax: "<range> [from <address>]".
+     */
+    inline dispatch_status dispatch::process_readback(command_context &a_ctx, std::string const &a_command, readback_handler const a_handler) {
+        std::string address_range_string = a_command;
+        address_pack resume_address { 0, 0 };
+
+        size_t const from_delim_index = a_command.find(" from ");
+
+        if (from_delim_index != std::string::npos) {
+            std::string resume_address_string = a_command.substr(from_delim_index + 6);
+            trim(resume_address_string);
+
+            resume_address = parse_address(resume_address_string);
+            address_range_string = a_command.substr(0, from_delim_index);
+        }
+
+        trim(address_range_string);
+
+        auto const range = parse_address_range(address_range_string);
+
+        size_t remaining = m_readback_limit;
+        size_t chunk_capacity = 0;
+
+        m_readback_chunk.clear();
+
+        for (auto const& universe_pair : range) {
+            if (universe_pair.first < resume_address.first) {
+                continue;
+            }
+
+            auto const& set = universe_pair.second;
+            size_t const first_index = universe_pair.first == resume_address.first && resume_address.second > 0 ? resume_address.second - 1 : 0;
+
+            for (size_t i = first_index; i < 512; ++i) {
+                if (!set.test(i)) {
+                    continue;
+                }
+
+                const auto address_number = static_cast<uint16_t>(i + 1);
+
+                // Ask the handler how much it can take whenever a new chunk starts.
+                if (m_readback_chunk.empty()) {
+                    chunk_capacity = std::min(m_readback_chunk_size, m_interface.dcsm_readback_capacity(a_ctx));
+                }
+
+                if (remaining == 0 || chunk_capacity == 0) {
+                    if (!m_readback_chunk.empty()) {
+                        (m_interface.*a_handler)(a_ctx, m_readback_chunk);
+                        m_readback_chunk.clear();
+                    }
+
+                    m_interface.dcsm_readback_continue(a_ctx, { universe_pair.first, address_number });
+                    return dispatch_status::success;
+                }
+
+                m_readback_chunk.emplace_back(universe_pair.first, address_number);
+                --remaining;
+
+                if (m_readback_chunk.size() >= chunk_capacity) {
+                    (m_interface.*a_handler)(a_ctx, m_readback_chunk);
+                    m_readback_chunk.clear();
+                }
+            }
+        }
+
+        if (!m_readback_chunk.empty()) {
+            (m_interface.*a_handler)(a_ctx, m_readback_chunk);
+            m_readback_chunk.clear();
+        }
+
+        return dispatch_status::success;
+    }
+
     // ------------------------ END COMMANDS -------------------------
 
 
+    // -------------------------- FRAMING ----------------------------
+
+    /**
+     * @brief Splits a serial byte stream into messages and commands and dispatches them.
+     *
+     * An identifying byte (0x00 or a combination of frame flags) starts a direct control message, whose
+     * length is taken from its header. Any other byte starts a command, which runs until '\n' or '\r'.
+     * Bytes may be fed in arbitrarily sized pieces.
+     */
+    class frame_decoder {
+        enum class state {
+            idle,
+            message,
+            stream,
+            command,
+            discard_message,
+            discard_command
+        };
+
+        dispatch& m_dispatch;
+        std::vector<uint8_t> m_buffer;
+        std::string m_command; ///< Reused so short-lived command strings do not allocate per line.
+        size_t m_max_body_size;
+        size_t m_frame_size = 0;  ///< Expected size of the message being received (header only until known).
+        size_t m_header_size = 0; ///< Size of the message being received up to its body.
+        size_t m_discard_remaining = 0;
+        size_t m_stream_remaining = 0; ///< Body bytes of the extended-length frame being streamed still to come.
+        size_t m_trailer_size = 0;
+        state m_state = state::idle;
+        dispatch_status m_last_status = dispatch_status::success;
+
+    public:
+        /**
+         * @param a_dispatch      The dispatch to feed.
+         * @param a_max_body_size Largest accepted message body or command. Larger ones are skipped. Extended-length
+         *                        frames are streamed, so their bodies are not limited.
+         */
+        explicit frame_decoder(dispatch& a_dispatch, size_t const a_max_body_size = 0xFFFF) :
+            m_dispatch(a_dispatch),
+            m_max_body_size(a_max_body_size)
+        {
+            m_buffer.reserve(frame_header_size(frame_flags) + a_max_body_size + frame_trailer_size(frame_flags));
+        }
+
+        /**
+         * @brief Feed received bytes, dispatching every frame they complete.
+         *
+         * @param a_data The received bytes.
+         * @param a_size The number of received bytes.
+         *
+         * @return The number of frames dispatched.
+         */
+        size_t feed(uint8_t const* a_data, size_t const a_size) {
+            size_t frames = 0;
+
+            for (size_t i = 0; i < a_size;) {
+                switch (m_state) {
+                    case state::idle:
+                        m_buffer.clear();
+
+                        if (is_frame_start(a_data[i])) {
+                            m_state = state::message;
+                            m_header_size = frame_header_size(a_data[i]);
+                            m_frame_size = m_header_size;
+                        } else if (a_data[i] == '\n' || a_data[i] == '\r') {
+                            ++i; // Empty line or second half of "\r\n".
+                        } else {
+                            m_state = state::command;
+                        }
+                        break;
+                    case state::message: {
+                        size_t const take = std::min(m_frame_size - m_buffer.size(), a_size - i);
+                        m_buffer.insert(m_buffer.end(), a_data + i, a_data + i + take);
+                        i += take;
+
+                        if (m_buffer.size() == m_header_size && (m_buffer[0] & frame_flag_extended) != 0) {
+                            // Streamed through dispatch; only the trailer is buffered.
+                            m_dispatch.begin_stream(m_buffer.data());
+                            m_stream_remaining = bit_cast<uint32_t>(m_buffer.data() + m_header_size - 4);
+                            m_trailer_size = frame_trailer_size(m_buffer[0]);
+                            m_buffer.clear();
+                            m_state = state::stream;
+
+                            if (m_stream_remaining == 0 && m_trailer_size == 0) {
+                                m_last_status = m_dispatch.end_stream(m_buffer.data());
+                                m_state = state::idle;
+                                ++frames;
+                            }
+                            break;
+                        }
+
+                        if (m_buffer.size() == m_header_size && m_frame_size == m_header_size) {
+                            size_t const body_size = bit_cast<uint16_t>(m_buffer.data() + m_header_size - 2);
+
+                            size_t const trailer_size = frame_trailer_size(m_buffer[0]);
+
+                            if (body_size > m_max_body_size) {
+                                m_last_status = dispatch_status::invalid_body_size;
+                                m_discard_remaining = body_size + trailer_size;
+                                m_state = state::discard_message;
+                                break;
+                            }
+
+                            m_frame_size += body_size + trailer_size;
+                        }
+
+                        if (m_buffer.size() == m_frame_size) {
+                            m_last_status = m_dispatch.process_message(m_buffer.data());
+                            m_state = state::idle;
+                            ++frames;
+                        }
+                        break;
+                    }
+                    case state::stream: {
+                        size_t const take = std::min(m_stream_remaining, a_size - i);
+                        m_dispatch.stream_data(a_data + i, take);
+                        m_stream_remaining -= take;
+                        i += take;
+
+                        if (m_stream_remaining == 0) {
+                            size_t const trailer_take = std::min(m_trailer_size - m_buffer.size(), a_size - i);
+                            m_buffer.insert(m_buffer.end(), a_data + i, a_data + i + trailer_take);
+                            i += trailer_take;
+
+                            if (m_buffer.size() == m_trailer_size) {
+                                m_last_status = m_dispatch.end_stream(m_buffer.data());
+                                m_state = state::idle;
+                                ++frames;
+                            }
+                        }
+                        break;
+                    }
+                    case state::command: {
+                        uint8_t const* const end = std::find_if(a_data + i, a_data + a_size, [](uint8_t const a_byte) {
+                            return a_byte == '\n' || a_byte == '\r';
+                        });
+
+                        m_buffer.insert(m_buffer.end(), a_data + i, end);
+                        i = static_cast<size_t>(end - a_data);
+
+                        if (m_buffer.size() > m_max_body_size) {
+                            m_last_status = dispatch_status::malformed_syntax;
+                            m_state = state::discard_command;
+                            break;
+                        }
+
+                        if (i < a_size) {
+                            process_command_line();
+                            m_state = state::idle;
+                            ++frames;
+                        }
+                        break;
+                    }
+                    case state::discard_message: {
+                        size_t const skip = std::min(m_discard_remaining, a_size - i);
+                        m_discard_remaining -= skip;
+                        i += skip;
+
+                        if (m_discard_remaining == 0) {
+                            m_state = state::idle;
+                        }
+                        break;
+                    }
+                    case state::discard_command:
+                        if (a_data[i] == '\n' || a_data[i] == '\r') {
+                            m_state = state::idle;
+                        }
+                        ++i;
+                        break;
+                }
+            }
+
+            return frames;
+        }
+
+        /// Status of the most recently completed (or rejected) frame.
+        dispatch_status last_status() const noexcept {
+            return m_last_status;
+        }
+
+        /// Drop any partially received frame, e.g. after a link reset.
+        void reset() noexcept {
+            m_buffer.clear();
+            m_state = state::idle;
+        }
+
+    private:
+        void process_command_line() {
+            m_command.assign(m_buffer.begin(), m_buffer.end());
+            trim(m_command);
+
+            try {
+                m_last_status = m_dispatch.process_command(m_command);
+            } catch (std::exception const&) {
+                // Address, value and universe parsing report malformed input by throwing.
+                m_last_status = dispatch_status::malformed_syntax;
+            }
+        }
+    };
+
+    // ------------------------ END FRAMING --------------------------
+
+
 }
 
 #endif //DCSM_HPP
@@ -0,0 +1,210 @@
+#ifndef DCSM_ARTNET_HPP
+#define DCSM_ARTNET_HPP
+
+#include "dcsm.hpp"
+#include "dcsm_bridge.hpp"
+
+/*
+ * Art-Net ingest: parses ArtDmx packets in place and forwards their data through a universe_bridge,
+ * which resolves the 15-bit port-address (net, subnet, universe) with a table lookup and passes only
+ * changed universes on to the device. artnet_receiver (Linux) reads packets from a UDP socket in batches
+ * (see udp_receiver).
+ */
+
+namespace dcsm {
+    constexpr uint16_t artnet_port = 6454;
+    constexpr size_t   artdmx_header_size = 18;
+    constexpr size_t   artdmx_max_packet_size = artdmx_header_size + 512;
+    constexpr uint16_t artnet_port_address_count = 0x8000; ///< Port-addresses are 15 bits.
+    constexpr uint16_t artnet_protocol_version = 14;
+
+    /// The 15-bit port-address of a net (0 to 127), subnet (0 to 15) and universe (0 to 15).
+    constexpr uint16_t artnet_port_address(uint8_t const a_net, uint8_t const a_subnet, uint8_t const a_universe) noexcept {
+        return static_cast<uint16_t>((a_net & 0x7F) << 8 | (a_subnet & 0x0F) << 4 | (a_universe & 0x0F));
+    }
+
+    /// An ArtDmx packet, pointing into the received datagram.
+    struct artdmx_packet {
+        uint8_t        sequence;     ///< 1 to 255, or 0 if the sender does not sequence.
+        uint8_t        physical;     ///< The sender's physical input port, informational.
+        uint16_t       port_address;
+        uint8_t const* data;
+        uint16_t       count;        ///< Number of slot values (1 to 512).
+    };
+
+    /**
+     * @brief Parse an ArtDmx packet without copying.
+     *
+     * @param a_data   The datagram.
+     * @param a_size   The size of the datagram.
+     * @param a_packet Receives the packet fields, valid as long as a_data is.
+     *
+     * @return False if the datagram is not a well-formed ArtDmx packet (including every other Art-Net
+     *         opcode, such as ArtPoll).
+     */
+    inline bool parse_artdmx(uint8_t const* a_data, size_t const a_size, artdmx_packet& a_packet) noexcept {
+        static uint8_t const identifier[8] = { 'A', 'r', 't', '-', 'N', 'e', 't', 0 };
+
+        if (a_size < artdmx_header_size ||
+            std::memcmp(a_data, identifier, sizeof(identifier)) != 0 ||
+            a_data[8] != 0x00 || a_data[9] != 0x50 || // OpDmx, little-endian
+            load_be16(a_data + 10) < artnet_protocol_version) {
+            return false;
+        }
+
+        // The specification asks for an even length from 2; odd lengths are common enough to accept.
+        uint16_t const count = load_be16(a_data + 16);
+
+        if (count == 0 || count > 512 || a_size < artdmx_header_size + count) {
+            return false;
+        }
+
+        a_packet.sequence     = a_data[12];
+        a_packet.physical     = a_data[13];
+        a_packet.port_address = static_cast<uint16_t>((a_data[15] & 0x7F) << 8 | a_data[14]);
+        a_packet.data         = a_data + artdmx_header_size;
+        a_packet.count        = count;
+        return true;
+    }
+
+    /**
+     * @brief Append an ArtDmx packet, e.g. for a test sender.
+     *
+     * @param a_out          The buffer to which to append.
+     * @param a_port_address The 15-bit port-address (see artnet_port_address).
+     * @param a_sequence     The sequence number, or 0 to not sequence.
+     * @param a_data         Slot values (a_count bytes, 1 to 512); padded with a zero to an even length.
+     * @param a_count        The number of slot values.
+     * @param a_physical     The physical input port.
+     */
+    inline void append_artdmx(std::vector<uint8_t>& a_out, uint16_t const a_port_address, uint8_t const a_sequence,
+                              uint8_t const* a_data, uint16_t const a_count, uint8_t const a_physical = 0) {
+        uint16_t const length = static_cast<uint16_t>(a_count + (a_count & 1));
+
+        size_t const offset = a_out.size();
+        a_out.resize(offset + artdmx_header_size + length, 0);
+
+        uint8_t* const packet = a_out.data() + offset;
+
+        std::memcpy(packet, "Art-Net", 8);
+        packet[9]  = 0x50;
+        packet[11] = artnet_protocol_version;
+        packet[12] = a_sequence;
+        packet[13] = a_physical;
+        packet[14] = static_cast<uint8_t>(a_port_address);
+        packet[15] = static_cast<uint8_t>(a_port_address >> 8 & 0x7F);
+        packet[16] = static_cast<uint8_t>(length >> 8);
+        packet[17] = static_cast<uint8_t>(length);
+        std::memcpy(packet + artdmx_header_size, a_data, a_count);
+    }
+
+    struct artnet_options {
+        universe_bridge::clock::duration keep_alive = std::chrono::seconds(1); ///< See universe_bridge.
+        size_t delta_limit = 128;                                              ///< See universe_bridge.
+        bool check_sequence = true;                                            ///< Discard out-of-order packets.
+    };
+
+    /**
+     * @brief Forwards ArtDmx data through a universe_bridge, keyed by port-address.
+     *
+     * Packets for a port-address are taken as they come; merging several controllers onto one
+     * port-address is left to the network. Sequenced packets up to 20 behind the last one of their
+     * port-address are discarded as out of order.
+     */
+    class artnet_bridge {
+        using clock = universe_bridge::clock;
+
+        artnet_options m_options;
+        universe_bridge m_bridge;
+        std::vector<uint8_t> m_sequences; ///< Last sequence number per port-address, 0 if none.
+        uint64_t m_packets   = 0;
+        uint64_t m_discarded = 0;
+
+    public:
+        explicit artnet_bridge(universe_bridge::output a_output, artnet_options const& a_options = {}) :
+            m_options(a_options),
+            m_bridge(artnet_port_address_count, std::move(a_output), a_options.keep_alive, a_options.delta_limit),
+            m_sequences(artnet_port_address_count, 0)
+        {}
+
+        /// Forward port-address a_port_address (see artnet_port_address) to DCSM universe a_target.
+        void map(uint16_t const a_port_address, uint16_t const a_target) {
+            m_bridge.map(a_port_address, a_target);
+        }
+
+        universe_bridge& bridge() noexcept {
+            return m_bridge;
+        }
+
+        universe_bridge const& bridge() const noexcept {
+            return m_bridge;
+        }
+
+        /**
+         * @brief Process a received datagram.
+         *
+         * @return True if it forwarded a universe.
+         */
+        bool receive(uint8_t const* a_data, size_t const a_size, clock::time_point const a_now) {
+            ++m_packets;
+
+            artdmx_packet packet{};
+
+            if (!parse_artdmx(a_data, a_size, packet) || !m_bridge.mapped(packet.port_address)) {
+                ++m_discarded;
+                return false;
+            }
+
+            return receive(packet, a_now);
+        }
+
+        /// Process a parsed packet (see parse_artdmx).
+        bool receive(artdmx_packet const& a_packet, clock::time_point const a_now) {
+            if (m_options.check_sequence && a_packet.sequence != 0) {
+                uint8_t& last = m_sequences[a_packet.port_address];
+                auto const delta = static_cast<int8_t>(static_cast<uint8_t>(a_packet.sequence - last));
+
+                if (last != 0 && delta <= 0 && delta > -20) {
+                    ++m_discarded;
+                    return false;
+                }
+
+                last = a_packet.sequence;
+            }
+
+            return m_bridge.forward(a_packet.port_address, a_packet.data, a_packet.count, a_now);
+        }
+
+        /**
+         * @brief Send keep-alives.
+         *
+         * @return The number of universes forwarded as keep-alives.
+         */
+        size_t tick(clock::time_point const a_now) {
+            return m_bridge.keep_alive(a_now);
+        }
+
+        /// Datagrams received.
+        uint64_t packets() const noexcept {
+            return m_packets;
+        }
+
+        /// Datagrams not forwarded because they were malformed, unmapped or out of order.
+        uint64_t discarded() const noexcept {
+            return m_discarded;
+        }
+    };
+
+#if defined(__linux__)
+    /// UDP socket receiving Art-Net datagrams, broadcast or unicast, into an artnet_bridge with poll (Linux).
+    class artnet_receiver : public udp_receiver {
+    public:
+        /// See udp_receiver.
+        explicit artnet_receiver(uint16_t const a_port = artnet_port, char const* a_address = nullptr) :
+            udp_receiver(a_port, a_address)
+        {}
+    };
+#endif
+}
+
+#endif //DCSM_ARTNET_HPP
@@ -0,0 +1,402 @@
+#ifndef DCSM_BRIDGE_HPP
+#define DCSM_BRIDGE_HPP
+
+#include <chrono>
+
+#include "dcsm.hpp"
+#include "dcsm_changes.hpp"
+#include "dcsm_encoder.hpp"
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+/*
+ * Common core of the network ingest bridges (sACN, Art-Net): maps network universes to DCSM universes
+ * and forwards a universe only when its data changed, as setu or, for small changes, as setsp. A periodic
+ * keep-alive refreshes every mapped universe even while the show is static.
+ *
+ * Each route keeps its last data inside a ready-made setu frame, so incoming data is copied once and
+ * the frame is handed to the output as is, whether it goes to a dispatch or into a buffer for the link.
+ */
+
+namespace dcsm {
+    /// Network (big-endian) field loads for the protocol parsers.
+    inline uint16_t load_be16(uint8_t const* a_data) noexcept {
+        return static_cast<uint16_t>(a_data[0] << 8 | a_data[1]);
+    }
+
+    inline uint32_t load_be32(uint8_t const* a_data) noexcept {
+        return static_cast<uint32_t>(load_be16(a_data)) << 16 | load_be16(a_data + 2);
+    }
+
+    /**
+     * @brief Forwards network universe data to DCSM universes, suppressing unchanged frames.
+     *
+     * Network universes are numbered from 0 to the count given at construction and mapped to DCSM
+     * universes with map, through a table indexed by network universe. Data for unmapped universes is
+     * ignored.
+     */
+    class universe_bridge {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        /// Receives every forwarded universe as a single encoded frame (setu or setsp) and its size.
+        using output = std::function<void(uint8_t const*, size_t)>;
+
+    private:
+        static constexpr size_t setu_frame_size = message_header_size + 2 + 512;
+
+        struct route {
+            bool sent = false;             ///< The frame holds forwarded data.
+            clock::time_point last_sent{}; ///< When the universe was last forwarded.
+            std::array<uint8_t, setu_frame_size> frame{}; ///< setu of the last forwarded data.
+
+            uint8_t* data() noexcept {
+                return frame.data() + message_header_size + 2;
+            }
+        };
+
+        output m_output;
+        clock::duration m_keep_alive;
+        size_t m_delta_limit;
+        std::vector<uint32_t> m_routes_by_source; ///< Index into m_routes + 1, or 0 if unmapped.
+        std::vector<route> m_routes;
+        std::vector<universe_span> m_spans;
+        std::vector<uint8_t> m_delta_frame;
+        std::array<uint8_t, 512> m_padded{};      ///< Data shorter than a universe, zero-filled.
+        uint64_t m_forwarded  = 0;
+        uint64_t m_deltas     = 0;
+        uint64_t m_suppressed = 0;
+
+    public:
+        /**
+         * @param a_source_count Number of network universes (e.g. 64000 for sACN, 32768 for Art-Net).
+         * @param a_output       Receives forwarded universes (see to_dispatch and to_buffer).
+         * @param a_keep_alive   Forward unchanged universes again after this long; zero to never.
+         * @param a_delta_limit  Send changes as setsp while its body stays within this many bytes, rather
+         *                       than the 514 of setu; zero to always send setu.
+         */
+        universe_bridge(size_t const a_source_count, output a_output, clock::duration const a_keep_alive = std::chrono::seconds(1), size_t const a_delta_limit = 128) :
+            m_output(std::move(a_output)),
+            m_keep_alive(a_keep_alive),
+            m_delta_limit(a_delta_limit),
+            m_routes_by_source(a_source_count, 0)
+        {}
+
+        /// Output that dispatches each frame in place, e.g. into a device-side dispatch.
+        static output to_dispatch(dispatch& a_dispatch) {
+            return [&a_dispatch](uint8_t const* a_frame, size_t) {
+                a_dispatch.process_message(a_frame);
+            };
+        }
+
+        /// Output that appends each frame to a_out, e.g. to write to a serial port.
+        static output to_buffer(std::vector<uint8_t>& a_out) {
+            return [&a_out](uint8_t const* a_frame, size_t const a_size) {
+                a_out.insert(a_out.end(), a_frame, a_frame + a_size);
+            };
+        }
+
+        /// Forward network universe a_source to DCSM universe a_target. Ignored if a_source is out of range.
+        void map(uint16_t const a_source, uint16_t const a_target) {
+            if (a_source >= m_routes_by_source.size()) {
+                return;
+            }
+
+            uint32_t& index = m_routes_by_source[a_source];
+
+            if (index == 0) {
+                m_routes.emplace_back();
+                index = static_cast<uint32_t>(m_routes.size());
+            }
+
+            route& r = m_routes[index - 1];
+            r.sent = false;
+
+            // The frame header and universe number never change; forwarding only rewrites the data.
+            std::vector<uint8_t> header;
+            append_message(header, opcode::setu, 514);
+            std::memcpy(r.frame.data(), header.data(), message_header_size);
+            std::memcpy(r.frame.data() + message_header_size, &a_target, sizeof(a_target));
+        }
+
+        /// Map a_count consecutive network universes from a_first_source to DCSM universes from a_first_target.
+        void map_range(uint16_t const a_first_source, uint16_t const a_first_target, uint16_t const a_count) {
+            for (uint16_t i = 0; i < a_count; ++i) {
+                map(static_cast<uint16_t>(a_first_source + i), static_cast<uint16_t>(a_first_target + i));
+            }
+        }
+
+        bool mapped(uint16_t const a_source) const noexcept {
+            return a_source < m_routes_by_source.size() && m_routes_by_source[a_source] != 0;
+        }
+
+        /// The DCSM universe a network universe maps to, or 0 if unmapped.
+        uint16_t target(uint16_t const a_source) const noexcept {
+            return mapped(a_source) ? bit_cast<uint16_t>(m_routes[m_routes_by_source[a_source] - 1].frame.data() + message_header_size) : 0;
+        }
+
+        /**
+         * @brief Forward new data for a network universe if it changed.
+         *
+         * @param a_source The network universe number.
+         * @param a_data   The data (a_count bytes); addresses past a_count are zero.
+         * @param a_count  The number of addresses in a_data (at most 512).
+         * @param a_now    The current time, for keep-alive.
+         *
+         * @return True if the universe was forwarded.
+         */
+        bool forward(uint16_t const a_source, uint8_t const* a_data, size_t a_count, clock::time_point const a_now) {
+            if (!mapped(a_source)) {
+                return false;
+            }
+
+            route& r = m_routes[m_routes_by_source[a_source] - 1];
+            a_count = std::min<size_t>(a_count, 512);
+
+            if (a_count < 512) {
+                std::memcpy(m_padded.data(), a_data, a_count);
+                std::memset(m_padded.data() + a_count, 0, 512 - a_count);
+                a_data = m_padded.data();
+            }
+
+            if (!r.sent) {
+                std::memcpy(r.data(), a_data, 512);
+                send(r, a_now);
+                return true;
+            }
+
+            if (equal_bytes(a_data, r.data(), 512)) {
+                if (keep_alive_due(r, a_now)) {
+                    send(r, a_now);
+                    return true;
+                }
+
+                ++m_suppressed;
+                return false;
+            }
+
+            if (m_delta_limit == 0 || !send_changes(r, a_data, a_now)) {
+                std::memcpy(r.data(), a_data, 512);
+                send(r, a_now);
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Forward every mapped universe that has not been forwarded for the keep-alive interval.
+         *
+         * Call periodically, e.g. whenever the receiver wakes up, so universes whose source went quiet
+         * are still refreshed.
+         *
+         * @return The number of universes forwarded.
+         */
+        size_t keep_alive(clock::time_point const a_now) {
+            size_t forwarded = 0;
+
+            for (auto& r : m_routes) {
+                if (r.sent && keep_alive_due(r, a_now)) {
+                    send(r, a_now);
+                    ++forwarded;
+                }
+            }
+
+            return forwarded;
+        }
+
+        /// Universes forwarded, including keep-alives and deltas.
+        uint64_t forwarded() const noexcept {
+            return m_forwarded;
+        }
+
+        /// Universes forwarded as setsp.
+        uint64_t deltas() const noexcept {
+            return m_deltas;
+        }
+
+        /// Frames not forwarded because nothing changed.
+        uint64_t suppressed() const noexcept {
+            return m_suppressed;
+        }
+
+    private:
+        bool keep_alive_due(route const& a_route, clock::time_point const a_now) const noexcept {
+            return m_keep_alive != clock::duration::zero() && a_now - a_route.last_sent >= m_keep_alive;
+        }
+
+        void send(route& a_route, clock::time_point const a_now) {
+            a_route.sent = true;
+            a_route.last_sent = a_now;
+            ++m_forwarded;
+
+            m_output(a_route.frame.data(), a_route.frame.size());
+        }
+
+        /// Forward the changed addresses as setsp if small enough. False if setu is cheaper.
+        bool send_changes(route& a_route, uint8_t const* a_data, clock::time_point const a_now) {
+            uint16_t const target = bit_cast<uint16_t>(a_route.frame.data() + message_header_size);
+
+            m_spans.clear();
+            append_changed_spans(m_spans, target, a_data, diff_universe(a_data, a_route.data()), 6);
+
+            size_t body_size = 0;
+
+            for (auto const& span : m_spans) {
+                body_size += 6 + span.count;
+            }
+
+            if (body_size > m_delta_limit) {
+                return false;
+            }
+
+            m_delta_frame.clear();
+            encode_setsp(m_delta_frame, m_spans);
+
+            for (auto const& span : m_spans) {
+                std::memcpy(a_route.data() + span.start - 1, span.data, span.count);
+            }
+
+            a_route.last_sent = a_now;
+            ++m_forwarded;
+            ++m_deltas;
+
+            m_output(m_delta_frame.data(), m_delta_frame.size());
+            return true;
+        }
+    };
+
+#if defined(__linux__)
+    /**
+     * @brief Non-blocking UDP socket feeding datagrams to a network bridge (Linux).
+     *
+     * Datagrams are read in batches with recvmmsg into fixed buffers and handed to the bridge in place.
+     */
+    class udp_receiver {
+    public:
+        static constexpr size_t batch_size = 32;
+        static constexpr size_t max_datagram_size = 1024; ///< Larger datagrams are truncated, and rejected by the parsers.
+
+    private:
+        int m_fd = -1;
+        std::array<std::array<uint8_t, max_datagram_size>, batch_size> m_buffers;
+        std::array<iovec, batch_size>   m_iovecs;
+        std::array<mmsghdr, batch_size> m_messages;
+
+    public:
+        /**
+         * @param a_port    The UDP port, or 0 for any (see port), e.g. for tests.
+         * @param a_address The local IPv4 address to bind to, e.g. "127.0.0.1"; nullptr for any.
+         *
+         * @throws std::runtime_error if the socket cannot be opened.
+         */
+        udp_receiver(uint16_t const a_port, char const* a_address) {
+            m_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+            if (m_fd < 0) {
+                throw std::runtime_error(std::string("udp_receiver: socket: ") + std::strerror(errno));
+            }
+
+            // Room for bursts of full frames across many universes between polls.
+            int const enable = 1;
+            int const receive_buffer = 1 << 20;
+            ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+            ::setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer));
+
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(a_port);
+            address.sin_addr.s_addr = htonl(INADDR_ANY);
+
+            if ((a_address != nullptr && ::inet_pton(AF_INET, a_address, &address.sin_addr) != 1) ||
+                ::bind(m_fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0) {
+                int const error = errno;
+                ::close(m_fd);
+                throw std::runtime_error(std::string("udp_receiver: bind: ") + std::strerror(error));
+            }
+
+            for (size_t i = 0; i < batch_size; ++i) {
+                m_iovecs[i] = { m_buffers[i].data(), m_buffers[i].size() };
+                m_messages[i] = {};
+                m_messages[i].msg_hdr.msg_iov = &m_iovecs[i];
+                m_messages[i].msg_hdr.msg_iovlen = 1;
+            }
+        }
+
+        udp_receiver(udp_receiver const&) = delete;
+        udp_receiver& operator=(udp_receiver const&) = delete;
+
+        ~udp_receiver() {
+            if (m_fd >= 0) {
+                ::close(m_fd);
+            }
+        }
+
+        /// The socket, e.g. to wait on it alongside others. Non-blocking.
+        int fd() const noexcept {
+            return m_fd;
+        }
+
+        /// The bound UDP port.
+        uint16_t port() const noexcept {
+            sockaddr_in address{};
+            socklen_t size = sizeof(address);
+            ::getsockname(m_fd, reinterpret_cast<sockaddr*>(&address), &size);
+            return ntohs(address.sin_port);
+        }
+
+        /**
+         * @brief Receive pending datagrams into a bridge, then run its timers.
+         *
+         * @tparam T           A bridge with receive(data, size, now) and tick(now), e.g. sacn_bridge.
+         * @param a_bridge     The bridge to which to deliver.
+         * @param a_timeout_ms How long to wait for a first datagram; 0 to not wait, -1 for ever.
+         *
+         * @return The number of datagrams received.
+         */
+        template <typename T>
+        size_t poll(T& a_bridge, int const a_timeout_ms) {
+            pollfd descriptor{ m_fd, POLLIN, 0 };
+
+            if (a_timeout_ms != 0 && ::poll(&descriptor, 1, a_timeout_ms) <= 0) {
+                a_bridge.tick(universe_bridge::clock::now());
+                return 0;
+            }
+
+            size_t received = 0;
+
+            for (;;) {
+                int const count = ::recvmmsg(m_fd, m_messages.data(), batch_size, MSG_DONTWAIT, nullptr);
+
+                if (count <= 0) {
+                    break;
+                }
+
+                auto const now = universe_bridge::clock::now();
+
+                for (int i = 0; i < count; ++i) {
+                    a_bridge.receive(m_buffers[i].data(), m_messages[i].msg_len, now);
+                }
+
+                received += static_cast<size_t>(count);
+
+                if (static_cast<size_t>(count) < batch_size) {
+                    break;
+                }
+            }
+
+            a_bridge.tick(universe_bridge::clock::now());
+            return received;
+        }
+    };
+#endif
+}
+
+#endif //DCSM_BRIDGE_HPP
@@ -0,0 +1,293 @@
+#ifndef DCSM_CAPTURE_HPP
+#define DCSM_CAPTURE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <istream>
+#include <ostream>
+#include <thread>
+
+#include "dcsm.hpp"
+
+/*
+ * Capture format (all integers little-endian):
+ *
+ *   file header: "DCSM" (4 bytes), version (uint16, currently 1), reserved (uint16)
+ *   record:      delta time in ns since the previous record (varint), kind (uint8), length (varint), payload
+ *
+ * Varints are LEB128 (7 bits per byte, low bits first). Message payloads are complete frames
+ * (identifying byte, header and body) so they can be fed straight to dispatch::process_message.
+ * Command payloads are the command plaintext.
+ */
+
+namespace dcsm {
+    constexpr char     capture_magic[4] = { 'D', 'C', 'S', 'M' };
+    constexpr uint16_t capture_version  = 1;
+
+    /// Largest frame with a 16-bit body length and every flag field: the default record size limit of capture_reader.
+    constexpr size_t capture_max_record_size = frame_header_size(frame_flag_sequenced | frame_flag_checksummed) + 0xFFFF + frame_trailer_size(frame_flag_checksummed);
+
+    enum class capture_kind : uint8_t {
+        message = 0x00,
+        command = 0x01
+    };
+
+    struct capture_frame {
+        uint64_t             timestamp; ///< ns since the start of the capture.
+        capture_kind         kind;
+        std::vector<uint8_t> data;
+    };
+
+    /**
+     * @brief Writes incoming traffic of a dispatch to a stream in the capture format.
+     *
+     * Attach with dispatch::set_capture. The stream must be opened in binary mode.
+     */
+    class capture_writer final : public capture_sink {
+        using clock = std::chrono::steady_clock;
+
+        std::ostream& m_stream;
+        clock::time_point m_start;
+        uint64_t m_last_timestamp = 0;
+
+    public:
+        explicit capture_writer(std::ostream& a_stream) :
+            m_stream(a_stream),
+            m_start(clock::now())
+        {
+            uint8_t header[8];
+            uint16_t const reserved = 0;
+
+            memcpy(header,     capture_magic,    sizeof(capture_magic));
+            memcpy(header + 4, &capture_version, sizeof(capture_version));
+            memcpy(header + 6, &reserved,        sizeof(reserved));
+
+            m_stream.write(reinterpret_cast<char const*>(header), sizeof(header));
+        }
+
+        void capture_message(message_header const a_header, uint8_t const* a_body) override {
+            uint8_t prefix[5] = { 0x00 };
+            memcpy(prefix + 1, &a_header, sizeof(a_header));
+
+            write_record(now(), capture_kind::message, prefix, sizeof(prefix), a_body, a_header.length);
+        }
+
+        void capture_command(std::string const& a_command) override {
+            write_record(now(), capture_kind::command, reinterpret_cast<uint8_t const*>(a_command.data()), a_command.size(), nullptr, 0);
+        }
+
+        /**
+         * @brief Write a record with an explicit timestamp, e.g. when converting other recordings.
+         *
+         * @param a_timestamp ns since the start of the capture (must not decrease).
+         * @param a_kind      The record kind.
+         * @param a_data      The payload.
+         * @param a_size      The payload size.
+         */
+        void write(uint64_t const a_timestamp, capture_kind const a_kind, uint8_t const* a_data, size_t const a_size) {
+            write_record(a_timestamp, a_kind, a_data, a_size, nullptr, 0);
+        }
+
+    private:
+        uint64_t now() const {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_start).count());
+        }
+
+        void write_varint(uint64_t a_value) {
+            uint8_t bytes[10];
+            size_t size = 0;
+
+            do {
+                bytes[size] = static_cast<uint8_t>(a_value & 0x7F);
+                a_value >>= 7;
+                bytes[size++] |= a_value != 0 ? 0x80 : 0x00;
+            } while (a_value != 0);
+
+            m_stream.write(reinterpret_cast<char const*>(bytes), static_cast<std::streamsize>(size));
+        }
+
+        /// Payload may be split in two parts so framed messages need not be copied together first.
+        void write_record(uint64_t a_timestamp, capture_kind const a_kind, uint8_t const* a_first, size_t const a_first_size, uint8_t const* a_second, size_t const a_second_size) {
+            a_timestamp = std::max(a_timestamp, m_last_timestamp);
+
+            write_varint(a_timestamp - m_last_timestamp);
+            m_stream.put(static_cast<char>(a_kind));
+            write_varint(a_first_size + a_second_size);
+            m_stream.write(reinterpret_cast<char const*>(a_first), static_cast<std::streamsize>(a_first_size));
+
+            if (a_second_size != 0) {
+                m_stream.write(reinterpret_cast<char const*>(a_second), static_cast<std::streamsize>(a_second_size));
+            }
+
+            m_last_timestamp = a_timestamp;
+        }
+    };
+
+    /**
+     * @brief Reads records from a stream in the capture format.
+     */
+    class capture_reader {
+        std::istream& m_stream;
+        size_t m_max_record_size;
+        uint64_t m_timestamp = 0;
+        bool m_valid = false;
+
+    public:
+        /**
+         * @brief The stream must be opened in binary mode. Check valid() for a recognized file header.
+         *
+         * @param a_max_record_size Longest record accepted; raise it for captures holding extended-length frames.
+         */
+        explicit capture_reader(std::istream& a_stream, size_t const a_max_record_size = capture_max_record_size) :
+            m_stream(a_stream),
+            m_max_record_size(a_max_record_size)
+        {
+            uint8_t header[8];
+
+            if (!m_stream.read(reinterpret_cast<char*>(header), sizeof(header))) {
+                return;
+            }
+
+            m_valid = std::equal(capture_magic, capture_magic + sizeof(capture_magic), header) && bit_cast<uint16_t>(header + 4) == capture_version;
+        }
+
+        bool valid() const noexcept {
+            return m_valid;
+        }
+
+        /**
+         * @brief Read the next record.
+         *
+         * @param a_frame The frame to read into (its buffer is reused).
+         *
+         * @return False at the end of the capture, on a truncated record, or on a record longer than the
+         *         limit (which also ends the capture, as the stream is no longer trusted).
+         */
+        bool next(capture_frame& a_frame) {
+            uint64_t delta = 0;
+            uint64_t size  = 0;
+
+            if (!m_valid || !read_varint(delta)) {
+                return false;
+            }
+
+            int const kind = m_stream.get();
+
+            if (kind == std::char_traits<char>::eof() || !read_varint(size)) {
+                return false;
+            }
+
+            if (size > m_max_record_size) {
+                m_valid = false;
+                return false;
+            }
+
+            m_timestamp += delta;
+
+            a_frame.timestamp = m_timestamp;
+            a_frame.kind      = static_cast<capture_kind>(kind);
+            a_frame.data.resize(size);
+
+            return static_cast<bool>(m_stream.read(reinterpret_cast<char*>(a_frame.data.data()), static_cast<std::streamsize>(size)));
+        }
+
+        /// Read every remaining record.
+        std::vector<capture_frame> read_all() {
+            std::vector<capture_frame> frames;
+            capture_frame frame;
+
+            while (next(frame)) {
+                frames.push_back(frame);
+            }
+
+            return frames;
+        }
+
+    private:
+        bool read_varint(uint64_t& a_value) {
+            a_value = 0;
+
+            for (unsigned shift = 0; shift < 64; shift += 7) {
+                int const byte = m_stream.get();
+
+                if (byte == std::char_traits<char>::eof()) {
+                    return false;
+                }
+
+                a_value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+                if ((byte & 0x80) == 0) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    };
+
+    /// True if a captured message holds exactly one complete frame, as process_message expects.
+    inline bool is_complete_frame(std::vector<uint8_t> const& a_data) noexcept {
+        return is_complete_frame(a_data.data(), a_data.size());
+    }
+
+    struct replay_result {
+        size_t                frames   = 0;
+        size_t                bytes    = 0;
+        uint64_t              duration = 0; ///< Wall time of the whole replay in ns.
+        std::vector<uint64_t> latency;      ///< Per-frame dispatch latency in ns, in capture order.
+        size_t                failures = 0; ///< Frames that returned a non-success dispatch_status.
+    };
+
+    /**
+     * @brief Feed captured frames back into a dispatch.
+     *
+     * @param a_dispatch The dispatch to feed.
+     * @param a_frames   The captured frames.
+     * @param a_timed    If true, frames are fed at their original timing, otherwise as fast as possible.
+     *
+     * @return Throughput and per-frame latency of the replay.
+     */
+    inline replay_result replay_capture(dispatch& a_dispatch, std::vector<capture_frame> const& a_frames, bool const a_timed) {
+        using clock = std::chrono::steady_clock;
+
+        replay_result result;
+        result.latency.reserve(a_frames.size());
+
+        std::string command;
+        auto const start = clock::now();
+
+        for (auto const& frame : a_frames) {
+            if (a_timed) {
+                std::this_thread::sleep_until(start + std::chrono::nanoseconds(frame.timestamp));
+            }
+
+            auto const frame_start = clock::now();
+            dispatch_status status = dispatch_status::success;
+
+            if (frame.kind == capture_kind::message) {
+                status = is_complete_frame(frame.data) ? a_dispatch.process_message(frame.data.data()) : dispatch_status::invalid_header;
+            } else {
+                command.assign(frame.data.begin(), frame.data.end());
+
+                try {
+                    status = a_dispatch.process_command(command);
+                } catch (std::exception const&) {
+                    status = dispatch_status::malformed_syntax;
+                }
+            }
+
+            auto const frame_end = clock::now();
+
+            result.latency.push_back(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(frame_end - frame_start).count()));
+            result.failures += status != dispatch_status::success;
+            result.bytes    += frame.data.size();
+            ++result.frames;
+        }
+
+        result.duration = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+
+        return result;
+    }
+}
+
+#endif //DCSM_CAPTURE_HPP
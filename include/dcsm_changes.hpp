@@ -0,0 +1,450 @@
+#ifndef DCSM_CHANGES_HPP
+#define DCSM_CHANGES_HPP
+
+#include "dcsm.hpp"
+#include "dcsm_encoder.hpp"
+
+/// Set to 0 to use the portable universe diff even where the target has SIMD (SSE2, AArch64 NEON).
+#ifndef DCSM_DIFF_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(__aarch64__) && defined(__ARM_NEON))
+#define DCSM_DIFF_SIMD 1
+#else
+#define DCSM_DIFF_SIMD 0
+#endif
+#endif
+
+#if DCSM_DIFF_SIMD
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
+namespace dcsm {
+    /// Bit i (word i / 64, bit i % 64) is set if address i + 1 differs between two universes.
+    using universe_diff = std::array<uint64_t, 8>;
+
+    /// Compare two universes (512 bytes each), 8 bytes at a time.
+    inline universe_diff diff_universe_portable(uint8_t const* a_lhs, uint8_t const* a_rhs) noexcept {
+        universe_diff changed{};
+
+        for (size_t i = 0; i < 512; i += 8) {
+            if (bit_cast<uint64_t>(a_lhs + i) == bit_cast<uint64_t>(a_rhs + i)) {
+                continue;
+            }
+
+            for (size_t j = i; j < i + 8; ++j) {
+                changed[j / 64] |= static_cast<uint64_t>(a_lhs[j] != a_rhs[j]) << (j % 64);
+            }
+        }
+
+        return changed;
+    }
+
+    /**
+     * @brief Compare two universes (512 bytes each).
+     *
+     * Uses SSE2 or NEON, 16 bytes per compare, when the target has them (see DCSM_DIFF_SIMD), otherwise
+     * diff_universe_portable.
+     */
+    inline universe_diff diff_universe(uint8_t const* a_lhs, uint8_t const* a_rhs) noexcept {
+#if DCSM_DIFF_SIMD && (defined(__SSE2__) || defined(_M_X64))
+        universe_diff changed{};
+
+        for (size_t i = 0; i < 512; i += 16) {
+            __m128i const lhs = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a_lhs + i));
+            __m128i const rhs = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a_rhs + i));
+            auto const equal = static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(lhs, rhs))));
+
+            changed[i / 64] |= (~equal & 0xFFFF) << (i % 64);
+        }
+
+        return changed;
+#elif DCSM_DIFF_SIMD
+        // NEON has no movemask: weight each differing lane by its bit and add across each half.
+        static uint8_t const weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+        uint8x16_t const weight = vld1q_u8(weights);
+
+        universe_diff changed{};
+
+        for (size_t i = 0; i < 512; i += 16) {
+            uint8x16_t const differ = vandq_u8(vmvnq_u8(vceqq_u8(vld1q_u8(a_lhs + i), vld1q_u8(a_rhs + i))), weight);
+            uint64_t const bits = vaddv_u8(vget_low_u8(differ)) | static_cast<uint64_t>(vaddv_u8(vget_high_u8(differ))) << 8;
+
+            changed[i / 64] |= bits << (i % 64);
+        }
+
+        return changed;
+#else
+        return diff_universe_portable(a_lhs, a_rhs);
+#endif
+    }
+
+    /**
+     * @brief True if a_size bytes at a_lhs and a_rhs are equal.
+     *
+     * Compares 16 bytes per step with SSE2 or NEON (see DCSM_DIFF_SIMD) without branching until the end,
+     * since unchanged data is the common case.
+     */
+    inline bool equal_bytes(uint8_t const* a_lhs, uint8_t const* a_rhs, size_t const a_size) noexcept {
+        size_t i = 0;
+
+#if DCSM_DIFF_SIMD && (defined(__SSE2__) || defined(_M_X64))
+        __m128i differ = _mm_setzero_si128();
+
+        for (; i + 16 <= a_size; i += 16) {
+            __m128i const lhs = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a_lhs + i));
+            __m128i const rhs = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a_rhs + i));
+            differ = _mm_or_si128(differ, _mm_xor_si128(lhs, rhs));
+        }
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(differ, _mm_setzero_si128())) != 0xFFFF) {
+            return false;
+        }
+#elif DCSM_DIFF_SIMD
+        uint8x16_t differ = vdupq_n_u8(0);
+
+        for (; i + 16 <= a_size; i += 16) {
+            differ = vorrq_u8(differ, veorq_u8(vld1q_u8(a_lhs + i), vld1q_u8(a_rhs + i)));
+        }
+
+        if (vmaxvq_u8(differ) != 0) {
+            return false;
+        }
+#endif
+
+        for (; i + 8 <= a_size; i += 8) {
+            if (bit_cast<uint64_t>(a_lhs + i) != bit_cast<uint64_t>(a_rhs + i)) {
+                return false;
+            }
+        }
+
+        for (; i < a_size; ++i) {
+            if (a_lhs[i] != a_rhs[i]) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// Index of the first set bit of a_mask at or after a_from, or 512 if there is none.
+    inline size_t next_changed(universe_diff const& a_mask, size_t a_from) noexcept {
+        while (a_from < 512) {
+            uint64_t bits = a_mask[a_from / 64] >> (a_from % 64);
+
+            if (bits != 0) {
+#if defined(__GNUC__) || defined(__clang__)
+                return a_from + static_cast<size_t>(__builtin_ctzll(bits));
+#else
+                for (; (bits & 1) == 0; bits >>= 1) {
+                    ++a_from;
+                }
+
+                return a_from;
+#endif
+            }
+
+            a_from = (a_from / 64 + 1) * 64;
+        }
+
+        return 512;
+    }
+
+    /**
+     * @brief Append spans covering every address set in a mask (see diff_universe).
+     *
+     * @param a_out       The spans to which to append.
+     * @param a_universe  The universe number of the spans.
+     * @param a_data      Universe data (512 bytes) the spans point into.
+     * @param a_changed   Changed addresses.
+     * @param a_merge_gap Changes separated by fewer unchanged addresses than this share a span.
+     */
+    inline void append_changed_spans(std::vector<universe_span>& a_out, uint16_t const a_universe, uint8_t const* a_data, universe_diff const& a_changed, size_t const a_merge_gap) {
+        size_t i = next_changed(a_changed, 0);
+
+        while (i < 512) {
+            size_t const start = i;
+            size_t end = i + 1; // One past the last changed address.
+
+            for (;;) {
+                i = next_changed(a_changed, end);
+
+                if (i == 512 || i - end >= a_merge_gap) {
+                    break;
+                }
+
+                end = i + 1;
+            }
+
+            a_out.push_back({ a_universe, static_cast<uint16_t>(start + 1), static_cast<uint16_t>(end - start), a_data + start });
+        }
+    }
+
+    /**
+     * @brief Device-side change tracking for subscribed universes (sub/unsub), sent as chgu notifications.
+     *
+     * Record changes as they happen with update, and call flush once per output frame. Each flush
+     * holds the net change since the previous one: an address that changed several times is reported
+     * once, and one that changed back is not reported at all. A new subscription is reported in full.
+     */
+    class change_tracker {
+        struct subscription {
+            uint16_t universe;
+            bool     full;  ///< Report every address (new subscription).
+            bool     dirty; ///< Updated since the last flush.
+            std::array<uint8_t, 512> reported{}; ///< Values as of the last notification.
+            std::array<uint8_t, 512> current{};
+        };
+
+        std::vector<subscription> m_subscriptions;
+        std::vector<universe_span> m_spans;
+        std::vector<universe_span> m_message_spans; ///< Spans of one message, when they do not fit a single one.
+        size_t m_merge_gap;
+
+    public:
+        /**
+         * @param a_merge_gap Changes separated by fewer unchanged addresses than this share a span, since
+         *                    every span costs 6 bytes of header.
+         */
+        explicit change_tracker(size_t const a_merge_gap = 6) :
+            m_merge_gap(std::max<size_t>(a_merge_gap, 1))
+        {}
+
+        /**
+         * @brief Subscribe to a universe (see dispatch_interface::dcsm_sub).
+         *
+         * @param a_universe The universe number.
+         * @param a_data     Current data of the universe (512 bytes), reported in full on the next flush.
+         */
+        void subscribe(uint16_t const a_universe, uint8_t const* a_data) {
+            subscription* sub = find(a_universe);
+
+            if (sub == nullptr) {
+                m_subscriptions.emplace_back();
+                sub = &m_subscriptions.back();
+                sub->universe = a_universe;
+            }
+
+            std::memcpy(sub->current.data(), a_data, 512);
+            sub->full  = true;
+            sub->dirty = true;
+        }
+
+        void unsubscribe(uint16_t const a_universe) {
+            m_subscriptions.erase(std::remove_if(m_subscriptions.begin(), m_subscriptions.end(), [a_universe](subscription const& a_sub) {
+                return a_sub.universe == a_universe;
+            }), m_subscriptions.end());
+        }
+
+        bool subscribed(uint16_t const a_universe) const noexcept {
+            return std::any_of(m_subscriptions.begin(), m_subscriptions.end(), [a_universe](subscription const& a_sub) {
+                return a_sub.universe == a_universe;
+            });
+        }
+
+        size_t subscription_count() const noexcept {
+            return m_subscriptions.size();
+        }
+
+        /// Record new data (512 bytes) for a universe. Ignored if the universe is not subscribed.
+        void update(uint16_t const a_universe, uint8_t const* a_data) noexcept {
+            update(a_universe, 1, 512, a_data);
+        }
+
+        /// Record new values for addresses a_start to a_start + a_count - 1 (one-based) of a universe.
+        void update(uint16_t const a_universe, uint16_t const a_start, uint16_t const a_count, uint8_t const* a_values) noexcept {
+            subscription* const sub = find(a_universe);
+
+            if (sub == nullptr || a_start == 0 || a_start + a_count - 1 > 512) {
+                return;
+            }
+
+            std::memcpy(sub->current.data() + a_start - 1, a_values, a_count);
+            sub->dirty = true;
+        }
+
+        /**
+         * @brief Append the changes since the previous flush as chgu messages.
+         *
+         * @param a_out The buffer to which to append.
+         *
+         * @return The number of messages appended (0 if nothing changed).
+         */
+        size_t flush(std::vector<uint8_t>& a_out) {
+            m_spans.clear();
+
+            for (auto& sub : m_subscriptions) {
+                if (!sub.dirty) {
+                    continue;
+                }
+
+                if (sub.full) {
+                    m_spans.push_back({ sub.universe, 1, 512, sub.current.data() });
+                } else {
+                    append_changed_spans(m_spans, sub.universe, sub.current.data(), diff_universe(sub.current.data(), sub.reported.data()), m_merge_gap);
+                }
+            }
+
+            // Split into messages within the 65535-byte body limit.
+            size_t messages = 0;
+            size_t body_size = 0;
+            auto first = m_spans.begin();
+
+            for (auto it = m_spans.begin(); it != m_spans.end(); ++it) {
+                if (body_size + 6 + it->count > 0xFFFF) {
+                    m_message_spans.assign(first, it);
+                    encode_chgu(a_out, m_message_spans);
+                    ++messages;
+                    first = it;
+                    body_size = 0;
+                }
+
+                body_size += 6 + it->count;
+            }
+
+            if (first != m_spans.end()) {
+                if (first == m_spans.begin()) {
+                    encode_chgu(a_out, m_spans);
+                } else {
+                    m_message_spans.assign(first, m_spans.end());
+                    encode_chgu(a_out, m_message_spans);
+                }
+
+                ++messages;
+            }
+
+            for (auto& sub : m_subscriptions) {
+                if (sub.dirty) {
+                    sub.reported = sub.current;
+                    sub.full  = false;
+                    sub.dirty = false;
+                }
+            }
+
+            return messages;
+        }
+
+    private:
+        subscription* find(uint16_t const a_universe) noexcept {
+            auto const it = std::find_if(m_subscriptions.begin(), m_subscriptions.end(), [a_universe](subscription const& a_sub) {
+                return a_sub.universe == a_universe;
+            });
+
+            return it == m_subscriptions.end() ? nullptr : &*it;
+        }
+    };
+
+    /**
+     * @brief Device-side differential readback (getud), answered with difu replies.
+     *
+     * Keeps a shadow copy of each universe as last sent to each client session, with a generation number
+     * that the client echoes in its next request. If it matches, only the addresses that changed since
+     * are sent, and an idle universe costs an empty difu (11 bytes). Otherwise (first request, lost
+     * reply, evicted shadow) the whole universe is sent.
+     */
+    class differential_readback {
+        struct shadow {
+            uint16_t session;
+            uint16_t universe;
+            uint32_t generation;
+            uint64_t last_used;
+            std::array<uint8_t, 512> data;
+        };
+
+        std::vector<shadow> m_shadows;
+        std::vector<universe_span> m_spans;
+        size_t m_capacity;
+        size_t m_merge_gap;
+        uint64_t m_clock = 0;
+        uint32_t m_generation = 0;
+
+    public:
+        /**
+         * @param a_capacity  Shadow copies kept (session and universe pairs); the least recently used is
+         *                    evicted beyond this.
+         * @param a_merge_gap As change_tracker.
+         */
+        explicit differential_readback(size_t const a_capacity = 64, size_t const a_merge_gap = 6) :
+            m_capacity(std::max<size_t>(a_capacity, 1)),
+            m_merge_gap(std::max<size_t>(a_merge_gap, 1))
+        {}
+
+        /**
+         * @brief Append the reply to a getud request (see dispatch_interface::dcsm_getud).
+         *
+         * @param a_out        The buffer to which to append.
+         * @param a_universe   The requested universe number.
+         * @param a_session    The session from the request.
+         * @param a_generation The generation from the request.
+         * @param a_data       Current data of the universe (512 bytes).
+         */
+        void reply(std::vector<uint8_t>& a_out, uint16_t const a_universe, uint16_t const a_session, uint32_t const a_generation, uint8_t const* a_data) {
+            shadow& sh = find(a_session, a_universe);
+            sh.last_used = ++m_clock;
+
+            m_spans.clear();
+
+            if (a_generation == 0 || a_generation != sh.generation) {
+                m_spans.push_back({ a_universe, 1, 512, a_data });
+            } else {
+                append_changed_spans(m_spans, a_universe, a_data, diff_universe(a_data, sh.data.data()), m_merge_gap);
+            }
+
+            if (!m_spans.empty()) {
+                std::memcpy(sh.data.data(), a_data, 512);
+                sh.generation = next_generation();
+            }
+
+            encode_difu(a_out, a_universe, sh.generation, m_spans);
+        }
+
+        /// Drop the shadow copies of a session, e.g. when its connection closes.
+        void end_session(uint16_t const a_session) {
+            m_shadows.erase(std::remove_if(m_shadows.begin(), m_shadows.end(), [a_session](shadow const& a_shadow) {
+                return a_shadow.session == a_session;
+            }), m_shadows.end());
+        }
+
+        size_t shadow_count() const noexcept {
+            return m_shadows.size();
+        }
+
+    private:
+        /// Generations are unique across shadows, so a reply meant for another session or an evicted shadow never matches.
+        uint32_t next_generation() noexcept {
+            if (++m_generation == 0) {
+                m_generation = 1;
+            }
+
+            return m_generation;
+        }
+
+        shadow& find(uint16_t const a_session, uint16_t const a_universe) {
+            auto it = std::find_if(m_shadows.begin(), m_shadows.end(), [a_session, a_universe](shadow const& a_shadow) {
+                return a_shadow.session == a_session && a_shadow.universe == a_universe;
+            });
+
+            if (it != m_shadows.end()) {
+                return *it;
+            }
+
+            if (m_shadows.size() < m_capacity) {
+                m_shadows.emplace_back();
+                it = m_shadows.end() - 1;
+            } else {
+                it = std::min_element(m_shadows.begin(), m_shadows.end(), [](shadow const& a_lhs, shadow const& a_rhs) {
+                    return a_lhs.last_used < a_rhs.last_used;
+                });
+            }
+
+            it->session    = a_session;
+            it->universe   = a_universe;
+            it->generation = 0;
+            return *it;
+        }
+    };
+}
+
+#endif //DCSM_CHANGES_HPP
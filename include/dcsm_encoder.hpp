@@ -0,0 +1,415 @@
+#ifndef DCSM_ENCODER_HPP
+#define DCSM_ENCODER_HPP
+
+#include "dcsm.hpp"
+
+/*
+ * Host-side encoding of direct control messages and commands. Every function appends one complete
+ * frame (identifying byte, header and body) to the output buffer, so frames can be batched into a
+ * single write. Bodies are limited to 65535 bytes by the header; callers must split larger requests.
+ */
+
+namespace dcsm {
+    /// Write a uint16_t in wire byte order (same as the header, i.e. host order on little-endian devices).
+    inline void write_u16(uint8_t* const a_destination, uint16_t const a_value) noexcept {
+        std::memcpy(a_destination, &a_value, sizeof(a_value));
+    }
+
+    /**
+     * @brief Append a frame with an uninitialized body.
+     *
+     * @param a_out       The buffer to which to append.
+     * @param a_opcode    The opcode of the message.
+     * @param a_body_size The size of the body (at most 65535).
+     *
+     * @return Pointer to the body, valid until a_out is modified again.
+     */
+    inline uint8_t* append_message(std::vector<uint8_t>& a_out, opcode const a_opcode, size_t const a_body_size) {
+        size_t const offset = a_out.size();
+        a_out.resize(offset + message_header_size + a_body_size);
+
+        uint8_t* const frame = a_out.data() + offset;
+        message_header const header { static_cast<uint16_t>(a_opcode), static_cast<uint16_t>(a_body_size) };
+
+        frame[0] = 0x00;
+        std::memcpy(frame + 1, &header, sizeof(header));
+
+        return frame + message_header_size;
+    }
+
+    /**
+     * @brief Append the header of an extended-length frame (frame flag 0x04).
+     *
+     * The body follows separately, e.g. streamed from a file. For record-streamed opcodes (see
+     * stream_record_size), it is that opcode's ordinary bodies back to back.
+     *
+     * @param a_out       The buffer to which to append.
+     * @param a_opcode    The opcode of the message.
+     * @param a_body_size The size of the body.
+     */
+    inline void append_extended_header(std::vector<uint8_t>& a_out, opcode const a_opcode, uint32_t const a_body_size) {
+        size_t const offset = a_out.size();
+        a_out.resize(offset + frame_header_size(frame_flag_extended));
+
+        uint8_t* const frame = a_out.data() + offset;
+        auto const opcode_value = static_cast<uint16_t>(a_opcode);
+
+        frame[0] = frame_flag_extended;
+        std::memcpy(frame + 1, &opcode_value, sizeof(opcode_value));
+        std::memcpy(frame + 3, &a_body_size, sizeof(a_body_size));
+    }
+
+    /**
+     * @brief Add a CRC-32C trailer (frame flag 0x02) to the last frame in a buffer.
+     *
+     * @param a_out    The buffer holding the frame.
+     * @param a_offset The offset of the frame, i.e. the size of a_out before it was appended.
+     */
+    inline void append_checksum(std::vector<uint8_t>& a_out, size_t const a_offset) {
+        a_out[a_offset] |= frame_flag_checksummed;
+
+        uint32_t const crc = crc32c(a_out.data() + a_offset, a_out.size() - a_offset);
+
+        size_t const size = a_out.size();
+        a_out.resize(size + sizeof(crc));
+        std::memcpy(a_out.data() + size, &crc, sizeof(crc));
+    }
+
+    /// Append a message whose body is only a universe number (getu, newmu, delmu, getmu, clrmu, unpat, sub, unsub).
+    inline void encode_universe_message(std::vector<uint8_t>& a_out, opcode const a_opcode, uint16_t const a_universe) {
+        write_u16(append_message(a_out, a_opcode, 2), a_universe);
+    }
+
+    inline void encode_id(std::vector<uint8_t>& a_out) {
+        append_message(a_out, opcode::id, 0);
+    }
+
+    inline void encode_setu(std::vector<uint8_t>& a_out, uint16_t const a_universe, uint8_t const* a_data) {
+        uint8_t* const body = append_message(a_out, opcode::setu, 2 + 512);
+        write_u16(body, a_universe);
+        std::memcpy(body + 2, a_data, 512);
+    }
+
+    /**
+     * @brief Append a bulk universe update (setub).
+     *
+     * @param a_out       The buffer to which to append.
+     * @param a_universes pair: universe number, universe data (512 bytes). 1 to bulk_universe_max entries.
+     */
+    inline void encode_setub(std::vector<uint8_t>& a_out, std::vector<std::pair<uint16_t, uint8_t const*>> const& a_universes) {
+        uint8_t* it = append_message(a_out, opcode::setub, 2 + a_universes.size() * (2 + 512));
+        write_u16(it, static_cast<uint16_t>(a_universes.size()));
+        it += 2;
+
+        for (auto const& universe : a_universes) {
+            write_u16(it, universe.first);
+            std::memcpy(it + 2, universe.second, 512);
+            it += 2 + 512;
+        }
+    }
+
+    /// pair: address, value
+    inline void encode_setv(std::vector<uint8_t>& a_out, std::vector<std::pair<address_pack, uint8_t>> const& a_pairs) {
+        uint8_t* it = append_message(a_out, opcode::setv, a_pairs.size() * 5);
+
+        for (auto const& pair : a_pairs) {
+            write_u16(it,     pair.first.first);
+            write_u16(it + 2, pair.first.second);
+            *(it + 4) = pair.second;
+            it += 5;
+        }
+    }
+
+    /// Append a message made of spans (setsp, chgu). Each span must lie within its universe.
+    inline void encode_spans(std::vector<uint8_t>& a_out, opcode const a_opcode, std::vector<universe_span> const& a_spans) {
+        size_t body_size = 0;
+
+        for (auto const& span : a_spans) {
+            body_size += 6 + span.count;
+        }
+
+        uint8_t* it = append_message(a_out, a_opcode, body_size);
+
+        for (auto const& span : a_spans) {
+            write_u16(it,     span.universe);
+            write_u16(it + 2, span.start);
+            write_u16(it + 4, span.count);
+            std::memcpy(it + 6, span.data, span.count);
+            it += 6 + span.count;
+        }
+    }
+
+    /// Append spans of consecutive addresses (setsp). Each span must lie within its universe.
+    inline void encode_setsp(std::vector<uint8_t>& a_out, std::vector<universe_span> const& a_spans) {
+        encode_spans(a_out, opcode::setsp, a_spans);
+    }
+
+    /// Device side: append a change notification. See change_tracker for coalescing changes into it.
+    inline void encode_chgu(std::vector<uint8_t>& a_out, std::vector<universe_span> const& a_spans) {
+        encode_spans(a_out, opcode::chgu, a_spans);
+    }
+
+    /// pair: address of the coarse channel, 16-bit value
+    inline void encode_setv16(std::vector<uint8_t>& a_out, std::vector<std::pair<address_pack, uint16_t>> const& a_pairs) {
+        uint8_t* it = append_message(a_out, opcode::setv16, a_pairs.size() * 6);
+
+        for (auto const& pair : a_pairs) {
+            write_u16(it,     pair.first.first);
+            write_u16(it + 2, pair.first.second);
+            write_u16(it + 4, pair.second);
+            it += 6;
+        }
+    }
+
+    inline void encode_getu(std::vector<uint8_t>& a_out, uint16_t const a_universe) {
+        encode_universe_message(a_out, opcode::getu, a_universe);
+    }
+
+    inline void encode_setfr(std::vector<uint8_t>& a_out, uint8_t const a_framerate) {
+        *append_message(a_out, opcode::setfr, 1) = a_framerate;
+    }
+
+    inline void encode_getfr(std::vector<uint8_t>& a_out) {
+        append_message(a_out, opcode::getfr, 0);
+    }
+
+    inline void encode_newmu(std::vector<uint8_t>& a_out, uint16_t const a_universe) {
+        encode_universe_message(a_out, opcode::newmu, a_universe);
+    }
+
+    inline void encode_listmu(std::vector<uint8_t>& a_out) {
+        append_message(a_out, opcode::listmu, 0);
+    }
+
+    inline void encode_delmu(std::vector<uint8_t>& a_out, uint16_t const a_universe) {
+        encode_universe_message(a_out, opcode::delmu, a_universe);
+    }
+
+    inline void encode_setmu(std::vector<uint8_t>& a_out, uint16_t const a_universe, universe_mask const& a_mask, uint8_t const* a_data) {
+        uint8_t* const body = append_message(a_out, opcode::setmu, 2 + 64 + 512);
+        write_u16(body, a_universe);
+        bitset_to_bytes(body + 2, a_mask);
+        std::memcpy(body + 2 + 64, a_data, 512);
+    }
+
+    /// tuple: local address, masking, value
+    inline void encode_setmv(std::vector<uint8_t>& a_out, uint16_t const a_universe, std::vector<std::tuple<uint16_t, bool, uint8_t>> const& a_pairs) {
+        uint8_t* it = append_message(a_out, opcode::setmv, 2 + a_pairs.size() * 4);
+        write_u16(it, a_universe);
+        it += 2;
+
+        for (auto const& pair : a_pairs) {
+            write_u16(it, std::get<0>(pair));
+            *(it + 2) = std::get<1>(pair) ? 1 : 0;
+            *(it + 3) = std::get<2>(pair);
+            it += 4;
+        }
+    }
+
+    inline void encode_getmu(std::vector<uint8_t>& a_out, uint16_t const a_universe) {
+        encode_universe_message(a_out, opcode::getmu, a_universe);
+    }
+
+    inline void encode_clrmu(std::vector<uint8_t>& a_out, uint16_t const a_universe) {
+        encode_universe_message(a_out, opcode::clrmu, a_universe);
+    }
+
+    inline void encode_patch(std::vector<uint8_t>& a_out, uint16_t const a_input_universe, uint16_t const a_output_universe, uint16_t const a_mask_universe) {
+        uint8_t* const body = append_message(a_out, opcode::patch, 6);
+        write_u16(body,     a_input_universe);
+        write_u16(body + 2, a_output_universe);
+        write_u16(body + 4, a_mask_universe);
+    }
+
+    inline void encode_unpat(std::vector<uint8_t>& a_out, uint16_t const a_output_universe) {
+        encode_universe_message(a_out, opcode::unpat, a_output_universe);
+    }
+
+    inline void encode_listp(std::vector<uint8_t>& a_out) {
+        append_message(a_out, opcode::listp, 0);
+    }
+
+    inline void encode_copy(std::vector<uint8_t>& a_out, uint16_t const a_source_universe, uint16_t const a_destination_universe) {
+        uint8_t* const body = append_message(a_out, opcode::copy, 4);
+        write_u16(body,     a_source_universe);
+        write_u16(body + 2, a_destination_universe);
+    }
+
+    inline void encode_setutv(std::vector<uint8_t>& a_out, uint16_t const a_universe, uint8_t const a_value, universe_mask const& a_mask) {
+        uint8_t* const body = append_message(a_out, opcode::setutv, 2 + 1 + 64);
+        write_u16(body, a_universe);
+        *(body + 2) = a_value;
+        bitset_to_bytes(body + 3, a_mask);
+    }
+
+    inline void encode_setmtv(std::vector<uint8_t>& a_out, uint16_t const a_universe, uint8_t const a_value, universe_mask const& a_mask) {
+        uint8_t* const body = append_message(a_out, opcode::setmtv, 2 + 1 + 64);
+        write_u16(body, a_universe);
+        *(body + 2) = a_value;
+        bitset_to_bytes(body + 3, a_mask);
+    }
+
+    /// a_mask selects the coarse channels.
+    inline void encode_setutv16(std::vector<uint8_t>& a_out, uint16_t const a_universe, uint16_t const a_value, universe_mask const& a_mask) {
+        uint8_t* const body = append_message(a_out, opcode::setutv16, 2 + 2 + 64);
+        write_u16(body,     a_universe);
+        write_u16(body + 2, a_value);
+        bitset_to_bytes(body + 4, a_mask);
+    }
+
+    inline void encode_listu(std::vector<uint8_t>& a_out) {
+        append_message(a_out, opcode::listu, 0);
+    }
+
+    inline void encode_geta(std::vector<uint8_t>& a_out, std::vector<address_pack> const& a_addresses) {
+        uint8_t* it = append_message(a_out, opcode::geta, a_addresses.size() * 4);
+
+        for (auto const& address : a_addresses) {
+            write_u16(it,     address.first);
+            write_u16(it + 2, address.second);
+            it += 4;
+        }
+    }
+
+    inline void encode_getma(std::vector<uint8_t>& a_out, std::vector<address_pack> const& a_addresses) {
+        uint8_t* it = append_message(a_out, opcode::getma, a_addresses.size() * 4);
+
+        for (auto const& address : a_addresses) {
+            write_u16(it,     address.first);
+            write_u16(it + 2, address.second);
+            it += 4;
+        }
+    }
+
+    /**
+     * @brief Append a run-length encoded universe update (setuc).
+     *
+     * Typical show data compresses 3-10x; incompressible data is at most 5 bytes larger than setu.
+     *
+     * @param a_out      The buffer to which to append.
+     * @param a_universe The universe number.
+     * @param a_data     The universe data (512 bytes).
+     * @param a_previous The data the device currently holds (512 bytes) to send a delta against, or nullptr.
+     */
+    inline void encode_setuc(std::vector<uint8_t>& a_out, uint16_t const a_universe, uint8_t const* a_data, uint8_t const* a_previous = nullptr) {
+        std::array<uint8_t, compressed_universe_max_size> runs;
+        size_t size;
+
+        if (a_previous != nullptr) {
+            std::array<uint8_t, 512> delta;
+
+            for (size_t i = 0; i < 512; ++i) {
+                delta[i] = a_data[i] ^ a_previous[i];
+            }
+
+            size = compress_universe(runs.data(), delta.data());
+        } else {
+            size = compress_universe(runs.data(), a_data);
+        }
+
+        uint8_t* const body = append_message(a_out, opcode::setuc, 2 + 1 + size);
+        write_u16(body, a_universe);
+        *(body + 2) = static_cast<uint8_t>(a_previous != nullptr ? universe_encoding::delta : universe_encoding::runs);
+        std::memcpy(body + 3, runs.data(), size);
+    }
+
+    inline void encode_getr(std::vector<uint8_t>& a_out, uint16_t const a_universe, uint16_t const a_start, uint16_t const a_count) {
+        uint8_t* const body = append_message(a_out, opcode::getr, 6);
+        write_u16(body,     a_universe);
+        write_u16(body + 2, a_start);
+        write_u16(body + 4, a_count);
+    }
+
+    inline void encode_getmr(std::vector<uint8_t>& a_out, uint16_t const a_universe, uint16_t const a_start, uint16_t const a_count) {
+        uint8_t* const body = append_message(a_out, opcode::getmr, 6);
+        write_u16(body,     a_universe);
+        write_u16(body + 2, a_start);
+        write_u16(body + 4, a_count);
+    }
+
+    inline void encode_sub(std::vector<uint8_t>& a_out, uint16_t const a_universe) {
+        encode_universe_message(a_out, opcode::sub, a_universe);
+    }
+
+    inline void encode_unsub(std::vector<uint8_t>& a_out, uint16_t const a_universe) {
+        encode_universe_message(a_out, opcode::unsub, a_universe);
+    }
+
+    /// a_generation: from the last difu reply to this session, or 0 for the full universe.
+    inline void encode_getud(std::vector<uint8_t>& a_out, uint16_t const a_universe, uint16_t const a_session, uint32_t const a_generation) {
+        uint8_t* const body = append_message(a_out, opcode::getud, 8);
+        write_u16(body,     a_universe);
+        write_u16(body + 2, a_session);
+        std::memcpy(body + 4, &a_generation, sizeof(a_generation));
+    }
+
+    /// Device side: append a reply to getud. Spans must lie within the universe; their universe members are ignored.
+    inline void encode_difu(std::vector<uint8_t>& a_out, uint16_t const a_universe, uint32_t const a_generation, std::vector<universe_span> const& a_spans) {
+        size_t body_size = 6;
+
+        for (auto const& span : a_spans) {
+            body_size += 4 + span.count;
+        }
+
+        uint8_t* it = append_message(a_out, opcode::difu, body_size);
+        write_u16(it, a_universe);
+        std::memcpy(it + 2, &a_generation, sizeof(a_generation));
+        it += 6;
+
+        for (auto const& span : a_spans) {
+            write_u16(it,     span.start);
+            write_u16(it + 2, span.count);
+            std::memcpy(it + 4, span.data, span.count);
+            it += 4 + span.count;
+        }
+    }
+
+    /// a_combined: reply with a single hash of the range (see combine_hashes) instead of one per universe.
+    inline void encode_hashu(std::vector<uint8_t>& a_out, uint16_t const a_first, uint16_t const a_count, bool const a_combined = false) {
+        uint8_t* const body = append_message(a_out, opcode::hashu, 5);
+        write_u16(body,     a_first);
+        write_u16(body + 2, a_count);
+        body[4] = a_combined ? 0x01 : 0x00;
+    }
+
+    /// Device side: append a reply to hashu. a_hashes holds a_count hashes, or one combined hash.
+    inline void encode_hashr(std::vector<uint8_t>& a_out, uint16_t const a_first, uint16_t const a_count, std::vector<uint64_t> const& a_hashes) {
+        uint8_t* const body = append_message(a_out, opcode::hashr, 4 + a_hashes.size() * 8);
+        write_u16(body,     a_first);
+        write_u16(body + 2, a_count);
+        std::memcpy(body + 4, a_hashes.data(), a_hashes.size() * 8);
+    }
+
+    /// Device side: append an acknowledgement of sequenced frames (see dispatch_interface::dcsm_ack) for the host's flow_window.
+    inline void encode_ack(std::vector<uint8_t>& a_out, uint16_t const a_sequence, uint32_t const a_window, dispatch_status const a_status) {
+        uint8_t* const body = append_message(a_out, opcode::ack, 7);
+        write_u16(body, a_sequence);
+        std::memcpy(body + 2, &a_window, sizeof(a_window));
+        body[6] = static_cast<uint8_t>(a_status);
+    }
+
+    /**
+     * @brief Append an extended-length setu frame, e.g. to restore every universe of a show at once.
+     *
+     * @param a_out       The buffer to which to append.
+     * @param a_universes pair: universe number, universe data (512 bytes).
+     */
+    inline void encode_setu_stream(std::vector<uint8_t>& a_out, std::vector<std::pair<uint16_t, uint8_t const*>> const& a_universes) {
+        append_extended_header(a_out, opcode::setu, static_cast<uint32_t>(a_universes.size() * (2 + 512)));
+
+        for (auto const& universe : a_universes) {
+            size_t const offset = a_out.size();
+            a_out.resize(offset + 2 + 512);
+            write_u16(a_out.data() + offset, universe.first);
+            std::memcpy(a_out.data() + offset + 2, universe.second, 512);
+        }
+    }
+
+    /// Append a command line (terminated with '\n') for the command interface.
+    inline void encode_command(std::vector<uint8_t>& a_out, std::string const& a_command) {
+        a_out.insert(a_out.end(), a_command.begin(), a_command.end());
+        a_out.push_back('\n');
+    }
+}
+
+#endif //DCSM_ENCODER_HPP
@@ -0,0 +1,181 @@
+#ifndef DCSM_FLOW_HPP
+#define DCSM_FLOW_HPP
+
+#include <deque>
+
+#include "dcsm.hpp"
+#include "dcsm_encoder.hpp"
+
+/*
+ * Host-side flow control for pipelined direct control frames. Frames are sent as sequenced frames
+ * (identifying byte flag 0x01) while the bytes in flight fit the window the device advertises in its
+ * ack messages (see encode_ack), which dispatch delivers to the host's dcsm_ackr for acknowledge. The
+ * device only processes sequenced frames in order, so a lost or corrupted (checksummed) frame is
+ * recovered by resending everything from it onwards (go-back-N) rather than every universe.
+ */
+
+namespace dcsm {
+    /**
+     * @brief Append a frame as a sequenced frame.
+     *
+     * @param a_out      The buffer to which to append.
+     * @param a_frame    A single frame, as produced by the encoder (without a checksum).
+     * @param a_size     The size of the frame.
+     * @param a_sequence The sequence number of the frame.
+     *
+     * @return False, appending nothing, if a_size bytes are not exactly one complete frame.
+     */
+    inline bool append_sequenced(std::vector<uint8_t>& a_out, uint8_t const* a_frame, size_t const a_size, uint16_t const a_sequence) {
+        if (!is_complete_frame(a_frame, a_size)) {
+            return false;
+        }
+
+        uint8_t prefix[3] = { static_cast<uint8_t>(a_frame[0] | frame_flag_sequenced) };
+        std::memcpy(prefix + 1, &a_sequence, sizeof(a_sequence));
+
+        size_t const offset = a_out.size();
+        a_out.resize(offset + a_size + 2);
+
+        uint8_t* const frame = a_out.data() + offset;
+
+        // The prefix replaces the identifying byte.
+        std::memcpy(frame + 2, a_frame, a_size);
+        std::memcpy(frame, prefix, sizeof(prefix));
+        return true;
+    }
+
+    /**
+     * @brief Send window over sequenced frames.
+     *
+     * The window is in bytes of sequenced frames, since device receive buffers are. A frame larger than
+     * the whole window is still sent once nothing else is in flight.
+     */
+    class flow_window {
+        std::deque<std::vector<uint8_t>> m_in_flight; ///< Sequenced frames not yet acknowledged, oldest first.
+        size_t m_in_flight_bytes = 0;
+        size_t m_window;
+        uint16_t m_oldest;         ///< Sequence number of m_in_flight.front().
+        bool m_checksummed;        ///< Frames get a CRC-32C trailer.
+        bool m_recovering = false; ///< A resend was requested and nothing has been acknowledged since.
+
+    public:
+        /**
+         * @param a_window         Initial window in bytes, until the first acknowledgement.
+         * @param a_first_sequence Sequence number the device expects first (see dispatch::reset_sequence).
+         * @param a_checksummed    Add a CRC-32C trailer to every frame.
+         */
+        explicit flow_window(size_t const a_window, uint16_t const a_first_sequence = 0, bool const a_checksummed = false) :
+            m_window(a_window),
+            m_oldest(a_first_sequence),
+            m_checksummed(a_checksummed)
+        {}
+
+        /// True if a frame of a_size bytes (as produced by the encoder) fits in the window.
+        bool can_send(size_t const a_size) const noexcept {
+            return m_in_flight.empty() || m_in_flight_bytes + a_size + 2 + (m_checksummed ? 4 : 0) <= m_window;
+        }
+
+        /**
+         * @brief Sequence a frame and append it to a_out, keeping a copy until it is acknowledged.
+         *
+         * @param a_out   The buffer to which to append.
+         * @param a_frame A single frame, as produced by the encoder (without a checksum).
+         * @param a_size  The size of the frame.
+         *
+         * @return The sequence number of the frame.
+         *
+         * @throws std::invalid_argument if a_size bytes are not exactly one complete frame.
+         */
+        uint16_t send(std::vector<uint8_t>& a_out, uint8_t const* a_frame, size_t const a_size) {
+            uint16_t const sequence = next_sequence();
+
+            std::vector<uint8_t> frame;
+
+            if (!append_sequenced(frame, a_frame, a_size, sequence)) {
+                throw std::invalid_argument("flow_window: not a complete frame");
+            }
+
+            if (m_checksummed) {
+                append_checksum(frame, 0);
+            }
+
+            a_out.insert(a_out.end(), frame.begin(), frame.end());
+            m_in_flight_bytes += frame.size();
+            m_in_flight.push_back(std::move(frame));
+
+            return sequence;
+        }
+
+        /**
+         * @brief Process an acknowledgement from the device.
+         *
+         * @param a_sequence The acknowledged sequence number (cumulative).
+         * @param a_window   The window advertised with the acknowledgement, in bytes.
+         *
+         * @return True if the acknowledgement repeats an earlier one while frames are in flight, i.e. a
+         *         frame was lost: call resend. Further repeats are ignored until the resend is acknowledged.
+         */
+        bool acknowledge(uint16_t const a_sequence, size_t const a_window) {
+            m_window = a_window;
+
+            size_t acknowledged = static_cast<uint16_t>(a_sequence - m_oldest + 1);
+
+            if (acknowledged > m_in_flight.size()) {
+                // Stale or repeated acknowledgement.
+                acknowledged = 0;
+            }
+
+            for (size_t i = 0; i < acknowledged; ++i) {
+                m_in_flight_bytes -= m_in_flight.front().size();
+                m_in_flight.pop_front();
+            }
+
+            m_oldest = static_cast<uint16_t>(m_oldest + acknowledged);
+
+            if (acknowledged != 0) {
+                m_recovering = false;
+                return false;
+            }
+
+            if (m_in_flight.empty() || m_recovering) {
+                return false;
+            }
+
+            m_recovering = true;
+            return true;
+        }
+
+        /// Append every frame in flight to a_out, oldest first. Also use on an acknowledgement timeout.
+        void resend(std::vector<uint8_t>& a_out) const {
+            for (auto const& frame : m_in_flight) {
+                a_out.insert(a_out.end(), frame.begin(), frame.end());
+            }
+        }
+
+        /// Forget every frame in flight and start again at a_first_sequence, e.g. after reopening the link.
+        void reset(uint16_t const a_first_sequence = 0) noexcept {
+            m_in_flight.clear();
+            m_in_flight_bytes = 0;
+            m_oldest = a_first_sequence;
+            m_recovering = false;
+        }
+
+        size_t in_flight() const noexcept {
+            return m_in_flight.size();
+        }
+
+        size_t in_flight_bytes() const noexcept {
+            return m_in_flight_bytes;
+        }
+
+        size_t window() const noexcept {
+            return m_window;
+        }
+
+        uint16_t next_sequence() const noexcept {
+            return static_cast<uint16_t>(m_oldest + m_in_flight.size());
+        }
+    };
+}
+
+#endif //DCSM_FLOW_HPP
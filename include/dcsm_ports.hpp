@@ -0,0 +1,353 @@
+#ifndef DCSM_PORTS_HPP
+#define DCSM_PORTS_HPP
+
+#include "dcsm.hpp"
+#include "dcsm_encoder.hpp"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <memory>
+
+/*
+ * Host-side driver for many devices at once: owns the serial ports of every device on a host and
+ * drives them all from one thread. Frames are encoded straight into a per-port queue and written in
+ * as few large writes as the ports take, with a single epoll loop waiting on whichever ports are full.
+ * Universes are routed to ports through a table, so the application sets universes and never deals
+ * with devices.
+ */
+
+namespace dcsm {
+    /**
+     * @brief Open a serial port (e.g. /dev/ttyACM0) non-blocking in raw mode.
+     *
+     * USB CDC devices ignore the baud rate, so it is left as is.
+     *
+     * @return The file descriptor, or -1 on failure (see errno).
+     */
+    inline int open_serial(char const* a_path) {
+        int const fd = ::open(a_path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+
+        if (fd < 0) {
+            return -1;
+        }
+
+        termios attributes{};
+
+        if (::tcgetattr(fd, &attributes) == 0) {
+            ::cfmakeraw(&attributes);
+            ::tcsetattr(fd, TCSANOW, &attributes);
+        }
+
+        return fd;
+    }
+
+    /// Counters of a port, see port_driver::stats.
+    struct port_stats {
+        uint64_t written = 0; ///< Bytes written.
+        uint64_t writes  = 0; ///< Write calls that wrote something; written / writes is the batching achieved.
+        uint64_t dropped = 0; ///< Frames refused because the queue was full or the port failed.
+        uint64_t frames  = 0; ///< Frames and replies received from the device.
+    };
+
+    /**
+     * @brief Drives the serial ports of many devices from a single epoll loop (Linux).
+     *
+     * Add each device's file descriptor with add_port and route universes to ports. Frames queue per
+     * port until poll writes them; anything a device sends back is split into frames and dispatched to
+     * the handler given for its port. Call poll in a loop, e.g. once per output frame.
+     */
+    class port_driver {
+        struct port {
+            int fd;
+            std::vector<uint8_t> queue;  ///< Encoded frames, written from queue_sent on.
+            size_t queue_sent = 0;
+            bool waiting = false;        ///< Registered for EPOLLOUT after a short write.
+            bool connected = true;       ///< False once reading or writing failed, e.g. the device was unplugged.
+            port_stats stats;
+            std::unique_ptr<dispatch> dsp;
+            std::unique_ptr<frame_decoder> decoder;
+
+            size_t pending() const noexcept {
+                return queue.size() - queue_sent;
+            }
+        };
+
+        static constexpr uint16_t unrouted = 0xFFFF;
+
+        std::vector<port> m_ports;
+        std::vector<uint16_t> m_routes; ///< Port per universe, or unrouted.
+        size_t m_max_queue;
+        int m_epoll = -1;
+        std::array<epoll_event, 32> m_events;
+        std::vector<uint8_t> m_input = std::vector<uint8_t>(4096);
+
+    public:
+        /**
+         * @param a_max_queue Bytes a port may have queued; frames beyond that are refused (see port_stats::dropped).
+         *
+         * @throws std::runtime_error if epoll is unavailable.
+         */
+        explicit port_driver(size_t const a_max_queue = 1 << 20) :
+            m_routes(0x10000, uint16_t{unrouted}),
+            m_max_queue(a_max_queue)
+        {
+            m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+
+            if (m_epoll < 0) {
+                throw std::runtime_error(std::string("port_driver: epoll_create1: ") + std::strerror(errno));
+            }
+        }
+
+        port_driver(port_driver const&) = delete;
+        port_driver& operator=(port_driver const&) = delete;
+
+        /// Closes every port.
+        ~port_driver() {
+            for (auto const& p : m_ports) {
+                ::close(p.fd);
+            }
+
+            ::close(m_epoll);
+        }
+
+        /**
+         * @brief Take over the file descriptor of a device, e.g. from open_serial. It is made non-blocking.
+         *
+         * @param a_fd      The file descriptor; closed by the driver.
+         * @param a_replies Receives what the device sends (e.g. ack, or setu in reply to getu); nullptr to discard it.
+         *
+         * @return The port number, counting from 0.
+         */
+        size_t add_port(int const a_fd, dispatch_interface* const a_replies = nullptr) {
+            ::fcntl(a_fd, F_SETFL, ::fcntl(a_fd, F_GETFL) | O_NONBLOCK);
+
+            m_ports.emplace_back();
+            port& p = m_ports.back();
+            p.fd = a_fd;
+
+            if (a_replies != nullptr) {
+                p.dsp.reset(new dispatch(*a_replies));
+                p.decoder.reset(new frame_decoder(*p.dsp));
+            }
+
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = m_ports.size() - 1;
+            ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, a_fd, &event);
+
+            return m_ports.size() - 1;
+        }
+
+        size_t port_count() const noexcept {
+            return m_ports.size();
+        }
+
+        /// Send universe a_universe to port a_port. Ignored if the port does not exist.
+        void route(uint16_t const a_universe, size_t const a_port) {
+            if (a_port < m_ports.size()) {
+                m_routes[a_universe] = static_cast<uint16_t>(a_port);
+            }
+        }
+
+        /// Send a_count consecutive universes from a_first to port a_port.
+        void route_range(uint16_t const a_first, uint16_t const a_count, size_t const a_port) {
+            for (uint32_t i = 0; i < a_count; ++i) {
+                route(static_cast<uint16_t>(a_first + i), a_port);
+            }
+        }
+
+        /// The port of a universe, or -1 if it is not routed.
+        int port_of(uint16_t const a_universe) const noexcept {
+            return m_routes[a_universe] == unrouted ? -1 : m_routes[a_universe];
+        }
+
+        /**
+         * @brief Queue a setu for the port a universe is routed to.
+         *
+         * @return False if the universe is not routed or its port's queue is full.
+         */
+        bool setu(uint16_t const a_universe, uint8_t const* a_data) {
+            port* const p = routed_port(a_universe, message_header_size + 2 + 512);
+
+            if (p == nullptr) {
+                return false;
+            }
+
+            encode_setu(p->queue, a_universe, a_data);
+            return true;
+        }
+
+        /**
+         * @brief Queue an encoded frame (or several) for a port.
+         *
+         * @return False if the port does not exist or its queue is full.
+         */
+        bool send(size_t const a_port, uint8_t const* a_frames, size_t const a_size) {
+            if (a_port >= m_ports.size()) {
+                return false;
+            }
+
+            if (!has_room(m_ports[a_port], a_size)) {
+                ++m_ports[a_port].stats.dropped;
+                return false;
+            }
+
+            auto& queue = m_ports[a_port].queue;
+            queue.insert(queue.end(), a_frames, a_frames + a_size);
+            return true;
+        }
+
+        /// The queue of a port, to append frames to directly with the encoder, e.g. through a flow_window. Not bounded by the queue limit.
+        std::vector<uint8_t>& queue(size_t const a_port) {
+            return m_ports[a_port].queue;
+        }
+
+        /// Bytes queued for a port and not yet written.
+        size_t queue_depth(size_t const a_port) const noexcept {
+            return m_ports[a_port].pending();
+        }
+
+        port_stats const& stats(size_t const a_port) const noexcept {
+            return m_ports[a_port].stats;
+        }
+
+        /// False once the port failed (e.g. the device was unplugged); its frames are refused from then on.
+        bool connected(size_t const a_port) const noexcept {
+            return m_ports[a_port].connected;
+        }
+
+        /**
+         * @brief Write queued frames to every port, then wait for ports to take more or for devices to send.
+         *
+         * Ports whose queue does not fit in one write are continued when they become writable, without
+         * holding up the others.
+         *
+         * @param a_timeout_ms How long to wait for an event; 0 to not wait, -1 for ever.
+         *
+         * @return The number of bytes still queued over all ports.
+         */
+        size_t poll(int const a_timeout_ms) {
+            for (auto& p : m_ports) {
+                if (p.connected && !p.waiting) {
+                    write(p);
+                }
+            }
+
+            int const count = ::epoll_wait(m_epoll, m_events.data(), static_cast<int>(m_events.size()), a_timeout_ms);
+
+            for (int i = 0; i < count; ++i) {
+                port& p = m_ports[m_events[i].data.u64];
+
+                if ((m_events[i].events & EPOLLOUT) != 0 && p.connected) {
+                    write(p);
+                }
+
+                if ((m_events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0 && p.connected) {
+                    read(p);
+                }
+            }
+
+            size_t pending = 0;
+
+            for (auto const& p : m_ports) {
+                pending += p.pending();
+            }
+
+            return pending;
+        }
+
+    private:
+        bool has_room(port const& a_port, size_t const a_size) const noexcept {
+            return a_port.connected && a_port.pending() + a_size <= m_max_queue;
+        }
+
+        port* routed_port(uint16_t const a_universe, size_t const a_size) {
+            if (m_routes[a_universe] == unrouted) {
+                return nullptr;
+            }
+
+            port& p = m_ports[m_routes[a_universe]];
+
+            if (!has_room(p, a_size)) {
+                ++p.stats.dropped;
+                return nullptr;
+            }
+
+            return &p;
+        }
+
+        /// Write as much of the queue as the port takes, and wait for EPOLLOUT if it did not take all of it.
+        void write(port& a_port) {
+            while (a_port.pending() != 0) {
+                ssize_t const written = ::write(a_port.fd, a_port.queue.data() + a_port.queue_sent, a_port.pending());
+
+                if (written < 0 && errno != EAGAIN && errno != EINTR) {
+                    disconnect(a_port);
+                    return;
+                }
+
+                if (written <= 0) {
+                    break;
+                }
+
+                a_port.queue_sent += static_cast<size_t>(written);
+                a_port.stats.written += static_cast<uint64_t>(written);
+                ++a_port.stats.writes;
+            }
+
+            if (a_port.pending() == 0) {
+                a_port.queue.clear();
+                a_port.queue_sent = 0;
+            } else if (a_port.queue_sent >= a_port.pending()) {
+                a_port.queue.erase(a_port.queue.begin(), a_port.queue.begin() + static_cast<std::ptrdiff_t>(a_port.queue_sent));
+                a_port.queue_sent = 0;
+            }
+
+            bool const waiting = a_port.pending() != 0;
+
+            if (waiting != a_port.waiting) {
+                a_port.waiting = waiting;
+
+                epoll_event event{};
+                event.events = EPOLLIN | (waiting ? EPOLLOUT : 0u);
+                event.data.u64 = static_cast<uint64_t>(&a_port - m_ports.data());
+                ::epoll_ctl(m_epoll, EPOLL_CTL_MOD, a_port.fd, &event);
+            }
+        }
+
+        void read(port& a_port) {
+            for (;;) {
+                ssize_t const size = ::read(a_port.fd, m_input.data(), m_input.size());
+
+                if (size == 0 || (size < 0 && errno != EAGAIN && errno != EINTR)) {
+                    disconnect(a_port);
+                    return;
+                }
+
+                if (size < 0) {
+                    return;
+                }
+
+                if (a_port.decoder) {
+                    a_port.stats.frames += a_port.decoder->feed(m_input.data(), static_cast<size_t>(size));
+                }
+            }
+        }
+
+        void disconnect(port& a_port) {
+            ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, a_port.fd, nullptr);
+            a_port.connected = false;
+            a_port.waiting = false;
+            a_port.queue.clear();
+            a_port.queue_sent = 0;
+        }
+    };
+}
+#endif
+
+#endif //DCSM_PORTS_HPP
@@ -0,0 +1,428 @@
+#ifndef DCSM_REFERENCE_STORE_HPP
+#define DCSM_REFERENCE_STORE_HPP
+
+#include "dcsm.hpp"
+#include "dcsm_encoder.hpp"
+
+namespace dcsm {
+    /**
+     * @brief A complete in-memory device state (universes, mask universes, patches and framerate).
+     *
+     * Serves as the reference handler for tools, tests and host-side software nodes. Universes are
+     * numbered from 1 to the universe count given at construction; anything outside that is ignored.
+     *
+     * Queries are answered into the buffer set with reply_to: a direct control query with the frames that
+     * would set what it read (setu for getu, setsp for getr, setfr for getfr, an extended-length patch
+     * frame for listp, setmu for getmu, hashr for hashu), a command with the command lines that would.
+     * Sequenced frames are acknowledged there with ack messages.
+     */
+    class reference_store : public dispatch_interface {
+    public:
+        using universe_data = std::array<uint8_t, 512>;
+
+        struct mask_universe {
+            universe_mask mask; ///< Addresses that override the patch input.
+            universe_data data{};
+        };
+
+        struct patch_entry {
+            uint16_t input_universe;
+            uint16_t mask_universe; ///< 0 for no mask.
+        };
+
+    private:
+        std::vector<universe_data> m_universes;
+        universe_data* m_external = nullptr; ///< Storage given by a derived class, used instead of m_universes.
+        size_t m_universe_count;
+        std::map<uint16_t, mask_universe> m_mask_universes;
+        std::map<uint16_t, patch_entry> m_patches; ///< Key: output universe.
+        uint8_t m_framerate = 44;
+        std::vector<uint8_t>* m_replies = nullptr;
+        uint32_t m_window = 0;
+        std::vector<std::pair<address_pack, uint8_t>> m_reply_pairs;
+
+    public:
+        explicit reference_store(size_t const a_universe_count) :
+            m_universes(a_universe_count, universe_data{}),
+            m_universe_count(a_universe_count)
+        {}
+
+        size_t universe_count() const noexcept {
+            return m_universe_count;
+        }
+
+        /// Data of a universe, or nullptr if out of range.
+        uint8_t* universe(uint16_t const a_universe) noexcept {
+            return valid_universe(a_universe) ? storage()[a_universe - 1].data() : nullptr;
+        }
+
+        uint8_t const* universe(uint16_t const a_universe) const noexcept {
+            return valid_universe(a_universe) ? storage()[a_universe - 1].data() : nullptr;
+        }
+
+        /// Mask universe, or nullptr if it does not exist.
+        mask_universe const* mask(uint16_t const a_universe) const noexcept {
+            auto const it = m_mask_universes.find(a_universe);
+            return it == m_mask_universes.end() ? nullptr : &it->second;
+        }
+
+        std::map<uint16_t, mask_universe> const& masks() const noexcept {
+            return m_mask_universes;
+        }
+
+        std::map<uint16_t, patch_entry> const& patches() const noexcept {
+            return m_patches;
+        }
+
+        uint8_t framerate() const noexcept {
+            return m_framerate;
+        }
+
+        /**
+         * @brief Append replies to queries to a_out from now on, e.g. the output buffer of the requesting connection.
+         *
+         * @param a_out    The reply buffer; nullptr to drop replies.
+         * @param a_window Bytes of sequenced frames the requester may keep unacknowledged, advertised in acks (see dcsm_ack).
+         */
+        void reply_to(std::vector<uint8_t>* const a_out, uint32_t const a_window = 0xFFFF) noexcept {
+            m_replies = a_out;
+            m_window = a_window;
+        }
+
+        /// hash_universe of a universe with its mask universe and patch, as answered to hashu. Out of range universes hash as all zeros.
+        uint64_t hash(uint16_t const a_universe) const noexcept {
+            static universe_data const zeros{};
+
+            auto const data = universe(a_universe);
+            auto const mask_universe = mask(a_universe);
+            auto const patch = m_patches.find(a_universe);
+
+            std::pair<uint16_t, uint16_t> patch_pair;
+
+            if (patch != m_patches.end()) {
+                patch_pair = { patch->second.input_universe, patch->second.mask_universe };
+            }
+
+            return hash_universe(data != nullptr ? data : zeros.data(),
+                                 mask_universe != nullptr ? mask_universe->data.data() : nullptr,
+                                 mask_universe != nullptr ? &mask_universe->mask : nullptr,
+                                 patch != m_patches.end() ? &patch_pair : nullptr);
+        }
+
+        /// Hashes of universes a_first to a_first + a_count - 1 for a hashr reply: one per universe, or a single combine_hashes if a_combined.
+        std::vector<uint64_t> hashes(uint16_t const a_first, uint16_t const a_count, bool const a_combined) const {
+            std::vector<uint64_t> result;
+            result.reserve(a_count);
+
+            for (uint32_t i = 0; i < a_count; ++i) {
+                result.push_back(hash(static_cast<uint16_t>(a_first + i)));
+            }
+
+            if (a_combined) {
+                result.assign(1, combine_hashes(result.data(), result.size()));
+            }
+
+            return result;
+        }
+
+        /**
+         * @brief Compute what a universe outputs: its patch input (overridden by masking addresses) or its own data.
+         *
+         * @param a_universe The output universe.
+         * @param a_out      Destination of 512 bytes.
+         *
+         * @return False if the universe is out of range.
+         */
+        bool output(uint16_t const a_universe, uint8_t* const a_out) const noexcept {
+            if (!valid_universe(a_universe)) {
+                return false;
+            }
+
+            auto const patch = m_patches.find(a_universe);
+
+            if (patch == m_patches.end() || !valid_universe(patch->second.input_universe)) {
+                std::memcpy(a_out, universe(a_universe), 512);
+                return true;
+            }
+
+            std::memcpy(a_out, universe(patch->second.input_universe), 512);
+
+            if (auto const mask_universe = mask(patch->second.mask_universe)) {
+                for (size_t i = 0; i < 512; ++i) {
+                    if (mask_universe->mask.test(i)) {
+                        a_out[i] = mask_universe->data[i];
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        void dcsm_setu(command_context& a_ctx, uint16_t const a_universe, uint8_t const* a_data) override {
+            if (auto const data = universe(a_universe)) {
+                std::memcpy(data, a_data, 512);
+            }
+        }
+
+        uint8_t* dcsm_universe_buffer(command_context& a_ctx, uint16_t const a_universe) override {
+            return universe(a_universe);
+        }
+
+        void dcsm_setv(command_context& a_ctx, std::vector<std::pair<address_pack, uint8_t>> const& a_pairs) override {
+            for (auto const& pair : a_pairs) {
+                set_address(pair.first.first, pair.first.second, pair.second);
+            }
+        }
+
+        void dcsm_setsp(command_context& a_ctx, std::vector<universe_span> const& a_spans) override {
+            for (auto const& span : a_spans) {
+                if (auto const data = universe(span.universe)) {
+                    std::memcpy(data + span.start - 1, span.data, span.count);
+                }
+            }
+        }
+
+        void dcsm_setv16(command_context& a_ctx, std::vector<std::pair<address_pack, uint16_t>> const& a_pairs) override {
+            for (auto const& pair : a_pairs) {
+                set_fine_address(pair.first.first, pair.first.second, pair.second);
+            }
+        }
+
+        void dcsm_setutv16(command_context& a_ctx, uint16_t const a_universe, uint16_t const a_value, universe_mask const& a_mask) override {
+            for (uint16_t i = 0; i < 512; ++i) {
+                if (a_mask.test(i)) {
+                    set_fine_address(a_universe, i + 1, a_value);
+                }
+            }
+        }
+
+        void dcsm_setfr(command_context& a_ctx, uint8_t const a_framerate) override {
+            m_framerate = a_framerate;
+        }
+
+        void dcsm_getu(command_context& a_ctx, uint16_t const a_universe) override {
+            if (m_replies != nullptr && valid_universe(a_universe)) {
+                encode_setu(*m_replies, a_universe, universe(a_universe));
+            }
+        }
+
+        void dcsm_getr(command_context& a_ctx, uint16_t const a_universe, uint16_t const a_start, uint16_t const a_count) override {
+            if (m_replies != nullptr && valid_universe(a_universe)) {
+                encode_setsp(*m_replies, { universe_span{ a_universe, a_start, a_count, universe(a_universe) + a_start - 1 } });
+            }
+        }
+
+        void dcsm_geta(command_context& a_ctx, std::vector<address_pack> const& a_addresses) override {
+            if (m_replies == nullptr) {
+                return;
+            }
+
+            m_reply_pairs.clear();
+
+            for (auto const& address : a_addresses) {
+                if (address.second == 0 || address.second > 512 || !valid_universe(address.first)) {
+                    continue;
+                }
+
+                uint8_t const value = storage()[address.first - 1][address.second - 1];
+
+                if (a_ctx.mode == interface_mode::command) {
+                    reply_line("set " + std::to_string(address.first) + "/" + std::to_string(address.second) + " @ " + std::to_string(value));
+                } else {
+                    m_reply_pairs.emplace_back(address, value);
+                }
+            }
+
+            if (!m_reply_pairs.empty()) {
+                encode_setv(*m_replies, m_reply_pairs);
+            }
+        }
+
+        void dcsm_getfr(command_context& a_ctx) override {
+            if (m_replies == nullptr) {
+                return;
+            }
+
+            if (a_ctx.mode == interface_mode::command) {
+                reply_line("framerate " + std::to_string(m_framerate));
+            } else {
+                encode_setfr(*m_replies, m_framerate);
+            }
+        }
+
+        void dcsm_listp(command_context& a_ctx) override {
+            if (m_replies == nullptr) {
+                return;
+            }
+
+            if (a_ctx.mode == interface_mode::command) {
+                for (auto const& patch : m_patches) {
+                    reply_line("patch " + std::to_string(patch.second.input_universe) + " to " + std::to_string(patch.first) +
+                               (patch.second.mask_universe != 0 ? " mask " + std::to_string(patch.second.mask_universe) : std::string()));
+                }
+
+                return;
+            }
+
+            // One frame however many patches there are, so an empty list is answered too.
+            append_extended_header(*m_replies, opcode::patch, static_cast<uint32_t>(m_patches.size() * 6));
+
+            for (auto const& patch : m_patches) {
+                size_t const offset = m_replies->size();
+                m_replies->resize(offset + 6);
+                write_u16(m_replies->data() + offset,     patch.second.input_universe);
+                write_u16(m_replies->data() + offset + 2, patch.first);
+                write_u16(m_replies->data() + offset + 4, patch.second.mask_universe);
+            }
+        }
+
+        void dcsm_getmu(command_context& a_ctx, uint16_t const a_universe) override {
+            auto const mask_universe = mask(a_universe);
+
+            if (m_replies != nullptr && mask_universe != nullptr) {
+                encode_setmu(*m_replies, a_universe, mask_universe->mask, mask_universe->data.data());
+            }
+        }
+
+        void dcsm_ack(command_context& a_ctx, uint16_t const a_sequence, dispatch_status const a_status) override {
+            if (m_replies != nullptr) {
+                encode_ack(*m_replies, a_sequence, m_window, a_status);
+            }
+        }
+
+        void dcsm_hashu(command_context& a_ctx, uint16_t const a_first, uint16_t const a_count, bool const a_combined) override {
+            if (m_replies != nullptr) {
+                encode_hashr(*m_replies, a_first, a_count, hashes(a_first, a_count, a_combined));
+            }
+        }
+
+        void dcsm_newmu(command_context& a_ctx, uint16_t const a_universe) override {
+            m_mask_universes[a_universe];
+        }
+
+        void dcsm_delmu(command_context& a_ctx, uint16_t const a_universe) override {
+            m_mask_universes.erase(a_universe);
+        }
+
+        void dcsm_setmu(command_context& a_ctx, uint16_t const a_universe, universe_mask const& a_mask, uint8_t const* a_data) override {
+            auto const it = m_mask_universes.find(a_universe);
+
+            if (it != m_mask_universes.end()) {
+                it->second.mask = a_mask;
+                std::memcpy(it->second.data.data(), a_data, 512);
+            }
+        }
+
+        /// tuple: local address, masking, value
+        void dcsm_setmv(command_context& a_ctx, uint16_t const a_universe, std::vector<std::tuple<uint16_t, bool, uint8_t>> const& a_pairs) override {
+            auto const it = m_mask_universes.find(a_universe);
+
+            if (it == m_mask_universes.end()) {
+                return;
+            }
+
+            for (auto const& pair : a_pairs) {
+                auto const address = std::get<0>(pair);
+
+                if (address == 0 || address > 512) {
+                    continue;
+                }
+
+                it->second.mask.set(address - 1, std::get<1>(pair));
+                it->second.data[address - 1] = std::get<2>(pair);
+            }
+        }
+
+        void dcsm_clrmu(command_context& a_ctx, uint16_t const a_universe) override {
+            auto const it = m_mask_universes.find(a_universe);
+
+            if (it != m_mask_universes.end()) {
+                it->second = mask_universe{};
+            }
+        }
+
+        void dcsm_patch(command_context& a_ctx, uint16_t const a_input_universe, uint16_t const a_output_universe, uint16_t const a_mask_universe) override {
+            m_patches[a_output_universe] = { a_input_universe, a_mask_universe };
+        }
+
+        void dcsm_unpat(command_context& a_ctx, uint16_t const a_output_universe) override {
+            m_patches.erase(a_output_universe);
+        }
+
+        void dcsm_copy(command_context& a_ctx, uint16_t const a_source_universe, uint16_t const a_destination_universe) override {
+            auto const source      = universe(a_source_universe);
+            auto const destination = universe(a_destination_universe);
+
+            if (source != nullptr && destination != nullptr) {
+                std::memcpy(destination, source, 512);
+            }
+        }
+
+        void dcsm_setutv(command_context& a_ctx, uint16_t const a_universe, uint8_t const a_value, universe_mask const& a_mask) override {
+            if (auto const data = universe(a_universe)) {
+                for (size_t i = 0; i < 512; ++i) {
+                    if (a_mask.test(i)) {
+                        data[i] = a_value;
+                    }
+                }
+            }
+        }
+
+        void dcsm_setmtv(command_context& a_ctx, uint16_t const a_universe, uint8_t const a_value, universe_mask const& a_mask) override {
+            auto const it = m_mask_universes.find(a_universe);
+
+            if (it == m_mask_universes.end()) {
+                return;
+            }
+
+            it->second.mask |= a_mask;
+
+            for (size_t i = 0; i < 512; ++i) {
+                if (a_mask.test(i)) {
+                    it->second.data[i] = a_value;
+                }
+            }
+        }
+
+    protected:
+        /// Keep universe data in a_storage (a_universe_count zero-initialized universes, e.g. in shared memory) instead of owning it.
+        reference_store(universe_data* const a_storage, size_t const a_universe_count) noexcept :
+            m_external(a_storage),
+            m_universe_count(a_universe_count)
+        {}
+
+        universe_data* storage() noexcept {
+            return m_external != nullptr ? m_external : m_universes.data();
+        }
+
+        universe_data const* storage() const noexcept {
+            return m_external != nullptr ? m_external : m_universes.data();
+        }
+
+        /// Append a reply line for the command interface.
+        void reply_line(std::string const& a_line) {
+            encode_command(*m_replies, a_line);
+        }
+
+        bool valid_universe(uint16_t const a_universe) const noexcept {
+            return a_universe != 0 && a_universe <= m_universe_count;
+        }
+
+        /// Set a single one-based address, ignoring anything out of range.
+        void set_address(uint16_t const a_universe, uint16_t const a_address, uint8_t const a_value) noexcept {
+            if (a_address != 0 && a_address <= 512 && valid_universe(a_universe)) {
+                storage()[a_universe - 1][a_address - 1] = a_value;
+            }
+        }
+
+        /// Set a coarse/fine pair at a one-based address, ignoring pairs that do not fit in the universe.
+        void set_fine_address(uint16_t const a_universe, uint16_t const a_address, uint16_t const a_value) noexcept {
+            if (a_address != 0 && a_address < 512 && valid_universe(a_universe)) {
+                storage()[a_universe - 1][a_address - 1] = static_cast<uint8_t>(a_value >> 8);
+                storage()[a_universe - 1][a_address]     = static_cast<uint8_t>(a_value & 0xFF);
+            }
+        }
+    };
+}
+
+#endif //DCSM_REFERENCE_STORE_HPP
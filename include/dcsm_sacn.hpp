@@ -0,0 +1,391 @@
+#ifndef DCSM_SACN_HPP
+#define DCSM_SACN_HPP
+
+#include <map>
+
+#include "dcsm.hpp"
+#include "dcsm_bridge.hpp"
+
+/*
+ * sACN (ANSI E1.31) ingest: parses E1.31 data packets in place, resolves multiple sources per universe
+ * by priority and forwards the winning data through a universe_bridge, so only changed universes reach
+ * the device. sacn_receiver (Linux) reads packets from a UDP socket in batches (see udp_receiver).
+ */
+
+namespace dcsm {
+    constexpr uint16_t sacn_port = 5568;
+    constexpr size_t   sacn_header_size = 126;                    ///< Up to and including the start code.
+    constexpr size_t   sacn_max_packet_size = sacn_header_size + 512;
+    constexpr uint16_t sacn_universe_count = 64000;               ///< sACN universes are numbered 1 to 63999.
+
+    /// An E1.31 data packet, pointing into the received datagram.
+    struct sacn_packet {
+        uint8_t const* cid;          ///< Component identifier of the source (16 bytes).
+        char const*    source_name;  ///< Null-terminated within 64 bytes.
+        uint8_t        priority;     ///< 0 to 200.
+        uint16_t       sync_address;
+        uint8_t        sequence;
+        uint8_t        options;
+        uint16_t       universe;
+        uint8_t        start_code;   ///< 0 for DMX level data.
+        uint8_t const* data;         ///< Slot values after the start code.
+        uint16_t       count;        ///< Number of slot values (0 to 512).
+
+        bool preview() const noexcept {
+            return (options & 0x80) != 0;
+        }
+
+        bool terminated() const noexcept {
+            return (options & 0x40) != 0;
+        }
+    };
+
+    /**
+     * @brief Parse an E1.31 data packet without copying.
+     *
+     * @param a_data   The datagram.
+     * @param a_size   The size of the datagram.
+     * @param a_packet Receives the packet fields, valid as long as a_data is.
+     *
+     * @return False if the datagram is not a well-formed E1.31 data packet (including universe discovery
+     *         and synchronization packets, which carry no data).
+     */
+    inline bool parse_sacn(uint8_t const* a_data, size_t const a_size, sacn_packet& a_packet) noexcept {
+        static uint8_t const identifier[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+
+        if (a_size < sacn_header_size ||
+            load_be16(a_data) != 0x0010 || load_be16(a_data + 2) != 0x0000 ||
+            std::memcmp(a_data + 4, identifier, sizeof(identifier)) != 0 ||
+            load_be32(a_data + 18) != 0x00000004 || // VECTOR_ROOT_E131_DATA
+            load_be32(a_data + 40) != 0x00000002 || // VECTOR_E131_DATA_PACKET
+            a_data[117] != 0x02 ||                  // VECTOR_DMP_SET_PROPERTY
+            a_data[118] != 0xA1 ||
+            load_be16(a_data + 119) != 0x0000 ||
+            load_be16(a_data + 121) != 0x0001) {
+            return false;
+        }
+
+        uint16_t const property_count = load_be16(a_data + 123);
+
+        // The PDU lengths (low 12 bits of flags and length) must agree with the property count.
+        if (property_count == 0 || property_count > 513 ||
+            a_size < sacn_header_size - 1 + property_count ||
+            (load_be16(a_data + 16)  & 0x0FFF) != 109 + property_count ||
+            (load_be16(a_data + 38)  & 0x0FFF) != 87 + property_count ||
+            (load_be16(a_data + 115) & 0x0FFF) != 10 + property_count) {
+            return false;
+        }
+
+        uint16_t const universe = load_be16(a_data + 113);
+
+        if (universe == 0 || universe >= sacn_universe_count) {
+            return false;
+        }
+
+        a_packet.cid          = a_data + 22;
+        a_packet.source_name  = reinterpret_cast<char const*>(a_data + 44);
+        a_packet.priority     = a_data[108];
+        a_packet.sync_address = load_be16(a_data + 109);
+        a_packet.sequence     = a_data[111];
+        a_packet.options      = a_data[112];
+        a_packet.universe     = universe;
+        a_packet.start_code   = a_data[125];
+        a_packet.data         = a_data + sacn_header_size;
+        a_packet.count        = static_cast<uint16_t>(property_count - 1);
+        return a_packet.priority <= 200;
+    }
+
+    /// A sending component, for append_sacn.
+    struct sacn_source {
+        std::array<uint8_t, 16> cid{};
+        std::string name;
+        uint8_t priority = 100;
+    };
+
+    /**
+     * @brief Append an E1.31 data packet, e.g. for a test sender.
+     *
+     * @param a_out      The buffer to which to append.
+     * @param a_source   The sending component.
+     * @param a_universe The sACN universe (1 to 63999).
+     * @param a_sequence The sequence number.
+     * @param a_data     Slot values (a_count bytes, at most 512), sent with start code 0.
+     * @param a_count    The number of slot values.
+     * @param a_options  Options flags (0x40 stream terminated, 0x80 preview).
+     */
+    inline void append_sacn(std::vector<uint8_t>& a_out, sacn_source const& a_source, uint16_t const a_universe, uint8_t const a_sequence,
+                            uint8_t const* a_data, uint16_t const a_count, uint8_t const a_options = 0) {
+        size_t const offset = a_out.size();
+        a_out.resize(offset + sacn_header_size + a_count, 0);
+
+        uint8_t* const packet = a_out.data() + offset;
+
+        auto const store_be16 = [](uint8_t* a_at, uint32_t const a_value) {
+            a_at[0] = static_cast<uint8_t>(a_value >> 8);
+            a_at[1] = static_cast<uint8_t>(a_value);
+        };
+
+        uint32_t const property_count = a_count + 1u;
+
+        store_be16(packet, 0x0010);
+        std::memcpy(packet + 4, "ASC-E1.17", 9);
+        store_be16(packet + 16, 0x7000 | (109 + property_count));
+        packet[21] = 0x04;
+        std::memcpy(packet + 22, a_source.cid.data(), 16);
+        store_be16(packet + 38, 0x7000 | (87 + property_count));
+        packet[43] = 0x02;
+        std::memcpy(packet + 44, a_source.name.data(), std::min<size_t>(a_source.name.size(), 63));
+        packet[108] = a_source.priority;
+        packet[111] = a_sequence;
+        packet[112] = a_options;
+        store_be16(packet + 113, a_universe);
+        store_be16(packet + 115, 0x7000 | (10 + property_count));
+        packet[117] = 0x02;
+        packet[118] = 0xA1;
+        store_be16(packet + 121, 0x0001);
+        store_be16(packet + 123, property_count);
+        std::memcpy(packet + sacn_header_size, a_data, a_count);
+    }
+
+    /// How sources of the same universe at the same (highest) priority are combined.
+    enum class sacn_merge {
+        first_source, ///< The source seen first wins until it stops or terminates.
+        htp           ///< Highest takes precedence, per address.
+    };
+
+    struct sacn_options {
+        sacn_merge merge = sacn_merge::first_source;
+        uint8_t min_priority = 0;                                                        ///< Sources below this are ignored.
+        universe_bridge::clock::duration source_timeout = std::chrono::milliseconds(2500); ///< E1.31 network data loss timeout.
+        universe_bridge::clock::duration keep_alive = std::chrono::seconds(1);           ///< See universe_bridge.
+        size_t delta_limit = 128;                                                        ///< See universe_bridge.
+        bool accept_preview = false;                                                     ///< Forward preview data.
+    };
+
+    /**
+     * @brief Resolves sACN sources per universe and forwards the result through a universe_bridge.
+     *
+     * The highest priority source of a universe wins; sources at the same priority are combined as set by
+     * sacn_options::merge. A source is dropped once it terminates its stream or sends nothing for the
+     * source timeout. Out-of-order packets (E1.31 sequence numbers) are discarded.
+     */
+    class sacn_bridge {
+        using clock = universe_bridge::clock;
+
+        struct source {
+            std::array<uint8_t, 16> cid;
+            uint8_t priority;
+            uint8_t sequence;
+            clock::time_point last_seen;
+            std::array<uint8_t, 512> data; ///< Latest data, kept for htp only.
+        };
+
+        sacn_options m_options;
+        universe_bridge m_bridge;
+        std::map<uint16_t, std::vector<source>> m_sources; ///< Key: sACN universe. Sources in the order first seen.
+        std::array<uint8_t, 512> m_merged{};
+        uint64_t m_packets   = 0;
+        uint64_t m_discarded = 0;
+
+    public:
+        explicit sacn_bridge(universe_bridge::output a_output, sacn_options const& a_options = {}) :
+            m_options(a_options),
+            m_bridge(sacn_universe_count, std::move(a_output), a_options.keep_alive, a_options.delta_limit)
+        {}
+
+        /// Forward sACN universe a_universe to DCSM universe a_target.
+        void map(uint16_t const a_universe, uint16_t const a_target) {
+            m_bridge.map(a_universe, a_target);
+        }
+
+        universe_bridge& bridge() noexcept {
+            return m_bridge;
+        }
+
+        universe_bridge const& bridge() const noexcept {
+            return m_bridge;
+        }
+
+        /**
+         * @brief Process a received datagram.
+         *
+         * @return True if it forwarded a universe.
+         */
+        bool receive(uint8_t const* a_data, size_t const a_size, clock::time_point const a_now) {
+            ++m_packets;
+
+            sacn_packet packet{};
+
+            if (!parse_sacn(a_data, a_size, packet) || !m_bridge.mapped(packet.universe)) {
+                ++m_discarded;
+                return false;
+            }
+
+            return receive(packet, a_now);
+        }
+
+        /// Process a parsed packet (see parse_sacn).
+        bool receive(sacn_packet const& a_packet, clock::time_point const a_now) {
+            if (a_packet.start_code != 0 || a_packet.priority < m_options.min_priority || (a_packet.preview() && !m_options.accept_preview)) {
+                ++m_discarded;
+                return false;
+            }
+
+            auto& sources = m_sources[a_packet.universe];
+            expire(sources, a_now);
+
+            auto it = std::find_if(sources.begin(), sources.end(), [&a_packet](source const& a_source) {
+                return std::memcmp(a_source.cid.data(), a_packet.cid, 16) == 0;
+            });
+
+            if (it != sources.end()) {
+                // E1.31 6.7.2: discard if the sequence number is up to 20 behind the last one.
+                auto const delta = static_cast<int8_t>(static_cast<uint8_t>(a_packet.sequence - it->sequence));
+
+                if (delta <= 0 && delta > -20) {
+                    ++m_discarded;
+                    return false;
+                }
+            }
+
+            if (a_packet.terminated()) {
+                if (it != sources.end()) {
+                    sources.erase(it);
+                }
+
+                return false;
+            }
+
+            if (it == sources.end()) {
+                sources.emplace_back();
+                it = sources.end() - 1;
+                std::memcpy(it->cid.data(), a_packet.cid, 16);
+            }
+
+            it->priority  = a_packet.priority;
+            it->sequence  = a_packet.sequence;
+            it->last_seen = a_now;
+
+            if (m_options.merge == sacn_merge::htp) {
+                std::memcpy(it->data.data(), a_packet.data, a_packet.count);
+                std::memset(it->data.data() + a_packet.count, 0, 512 - a_packet.count);
+            }
+
+            uint8_t top = 0;
+            size_t at_top = 0;
+
+            for (auto const& s : sources) {
+                if (s.priority > top) {
+                    top = s.priority;
+                    at_top = 0;
+                }
+
+                at_top += s.priority == top;
+            }
+
+            if (it->priority < top) {
+                return false;
+            }
+
+            if (at_top == 1) {
+                return m_bridge.forward(a_packet.universe, a_packet.data, a_packet.count, a_now);
+            }
+
+            if (m_options.merge == sacn_merge::first_source) {
+                auto const first = std::find_if(sources.begin(), sources.end(), [top](source const& a_source) {
+                    return a_source.priority == top;
+                });
+
+                return first == it && m_bridge.forward(a_packet.universe, a_packet.data, a_packet.count, a_now);
+            }
+
+            m_merged.fill(0);
+
+            for (auto const& s : sources) {
+                if (s.priority == top) {
+                    for (size_t i = 0; i < 512; ++i) {
+                        m_merged[i] = std::max(m_merged[i], s.data[i]);
+                    }
+                }
+            }
+
+            return m_bridge.forward(a_packet.universe, m_merged.data(), 512, a_now);
+        }
+
+        /**
+         * @brief Drop sources that timed out and send keep-alives.
+         *
+         * @return The number of universes forwarded as keep-alives.
+         */
+        size_t tick(clock::time_point const a_now) {
+            for (auto& entry : m_sources) {
+                expire(entry.second, a_now);
+            }
+
+            return m_bridge.keep_alive(a_now);
+        }
+
+        /// Active sources of a sACN universe.
+        size_t source_count(uint16_t const a_universe) const noexcept {
+            auto const it = m_sources.find(a_universe);
+            return it == m_sources.end() ? 0 : it->second.size();
+        }
+
+        /// Datagrams received.
+        uint64_t packets() const noexcept {
+            return m_packets;
+        }
+
+        /// Datagrams not used: malformed, unmapped, filtered or out of sequence.
+        uint64_t discarded() const noexcept {
+            return m_discarded;
+        }
+
+    private:
+        void expire(std::vector<source>& a_sources, clock::time_point const a_now) const {
+            a_sources.erase(std::remove_if(a_sources.begin(), a_sources.end(), [this, a_now](source const& a_source) {
+                return a_now - a_source.last_seen > m_options.source_timeout;
+            }), a_sources.end());
+        }
+    };
+
+#if defined(__linux__)
+    /// The multicast group of a sACN universe (239.255.hi.lo), in network byte order.
+    inline in_addr sacn_multicast_group(uint16_t const a_universe) noexcept {
+        in_addr group{};
+        group.s_addr = htonl(0xEFFF0000u | a_universe);
+        return group;
+    }
+
+    /// UDP socket receiving sACN datagrams into a sacn_bridge with poll (Linux).
+    class sacn_receiver : public udp_receiver {
+    public:
+        /// See udp_receiver.
+        explicit sacn_receiver(uint16_t const a_port = sacn_port, char const* a_address = nullptr) :
+            udp_receiver(a_port, a_address)
+        {}
+
+        /**
+         * @brief Join the multicast group of a sACN universe.
+         *
+         * @param a_universe  The sACN universe.
+         * @param a_interface The local IPv4 address of the interface to join on; nullptr for the default.
+         *
+         * @return False if the group could not be joined.
+         */
+        bool join(uint16_t const a_universe, char const* a_interface = nullptr) {
+            ip_mreq request{};
+            request.imr_multiaddr = sacn_multicast_group(a_universe);
+            request.imr_interface.s_addr = htonl(INADDR_ANY);
+
+            if (a_interface != nullptr && ::inet_pton(AF_INET, a_interface, &request.imr_interface) != 1) {
+                return false;
+            }
+
+            return ::setsockopt(fd(), IPPROTO_IP, IP_ADD_MEMBERSHIP, &request, sizeof(request)) == 0;
+        }
+    };
+#endif
+}
+
+#endif //DCSM_SACN_HPP
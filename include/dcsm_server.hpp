@@ -0,0 +1,380 @@
+#ifndef DCSM_SERVER_HPP
+#define DCSM_SERVER_HPP
+
+#include "dcsm.hpp"
+#include "dcsm_reference_store.hpp"
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <memory>
+#include <unordered_map>
+
+/*
+ * Host-side software node: one process owns a device state (a reference_store) and serves it to any
+ * number of clients over TCP and Unix-domain sockets, e.g. show control, UIs and loggers at once. Each
+ * connection carries a byte stream like a serial link (direct control frames and command lines, split
+ * by a frame_decoder) and gets the replies to its own queries. A single epoll loop serves everything,
+ * so handlers run one at a time and the store needs no locking.
+ */
+
+namespace dcsm {
+    struct server_options {
+        size_t max_connections = 256;
+        size_t max_body_size = 0xFFFF;          ///< See frame_decoder.
+        size_t max_pending_output = 1 << 20;    ///< Stop reading from a client while this many reply bytes wait for it.
+        uint32_t window = 1 << 16;              ///< Bytes of sequenced frames a client may keep unacknowledged, advertised in its acks.
+    };
+
+    /**
+     * @brief Serves a reference_store over stream sockets with a single epoll loop (Linux).
+     *
+     * Every connection has its own frame_decoder and dispatch, so framing, sequencing (dcsm_ack) and
+     * extended-length streams of one client never mix with another's, while all of them apply to the
+     * same store. Call poll in a loop.
+     */
+    class server {
+        struct connection {
+            int fd;
+            dispatch dsp;
+            frame_decoder decoder;
+            std::vector<uint8_t> output;  ///< Replies not yet sent.
+            size_t output_sent = 0;       ///< Bytes of output already sent.
+            uint32_t events = 0;          ///< Events registered with epoll.
+
+            connection(int const a_fd, dispatch_interface& a_interface, size_t const a_max_body_size) :
+                fd(a_fd),
+                dsp(a_interface),
+                decoder(dsp, a_max_body_size)
+            {}
+
+            size_t pending() const noexcept {
+                return output.size() - output_sent;
+            }
+        };
+
+        struct listener {
+            int fd;
+            bool tcp;
+            std::string path; ///< Unix-domain socket file, removed on destruction.
+        };
+
+        reference_store& m_store;
+        server_options m_options;
+        int m_epoll = -1;
+        std::vector<listener> m_listeners;
+        std::unordered_map<int, std::unique_ptr<connection>> m_connections;
+        std::array<epoll_event, 64> m_events;
+        std::vector<uint8_t> m_input = std::vector<uint8_t>(1 << 16);
+        uint64_t m_frames = 0;
+        uint64_t m_accepted = 0;
+        uint64_t m_refused = 0;
+
+    public:
+        /**
+         * @param a_store   The device state to serve. Its reply target (reference_store::reply_to) is managed by the server.
+         * @param a_options Limits.
+         *
+         * @throws std::runtime_error if epoll is unavailable.
+         */
+        explicit server(reference_store& a_store, server_options const& a_options = {}) :
+            m_store(a_store),
+            m_options(a_options)
+        {
+            m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+
+            if (m_epoll < 0) {
+                throw std::runtime_error(std::string("server: epoll_create1: ") + std::strerror(errno));
+            }
+        }
+
+        server(server const&) = delete;
+        server& operator=(server const&) = delete;
+
+        ~server() {
+            for (auto const& entry : m_connections) {
+                ::close(entry.first);
+            }
+
+            for (auto const& l : m_listeners) {
+                ::close(l.fd);
+
+                if (!l.path.empty()) {
+                    ::unlink(l.path.c_str());
+                }
+            }
+
+            ::close(m_epoll);
+        }
+
+        /**
+         * @brief Accept TCP connections.
+         *
+         * @param a_port    The port, or 0 for any (see the return value), e.g. for tests.
+         * @param a_address The local IPv4 address to listen on, e.g. "127.0.0.1"; nullptr for any.
+         *
+         * @return The bound port.
+         *
+         * @throws std::runtime_error if the socket cannot be opened.
+         */
+        uint16_t listen_tcp(uint16_t const a_port, char const* a_address = nullptr) {
+            int const fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+            if (fd < 0) {
+                throw std::runtime_error(std::string("server: socket: ") + std::strerror(errno));
+            }
+
+            int const enable = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(a_port);
+            address.sin_addr.s_addr = htonl(INADDR_ANY);
+
+            if (a_address != nullptr && ::inet_pton(AF_INET, a_address, &address.sin_addr) != 1) {
+                ::close(fd);
+                throw std::runtime_error(std::string("server: invalid address: ") + a_address);
+            }
+
+            add_listener(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address), true, {});
+
+            socklen_t size = sizeof(address);
+            ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &size);
+            return ntohs(address.sin_port);
+        }
+
+        /**
+         * @brief Accept Unix-domain stream connections. A stale socket file at a_path is replaced.
+         *
+         * @throws std::runtime_error if the socket cannot be opened.
+         */
+        void listen_unix(std::string const& a_path) {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+
+            if (a_path.empty() || a_path.size() >= sizeof(address.sun_path)) {
+                throw std::runtime_error("server: invalid socket path: " + a_path);
+            }
+
+            std::memcpy(address.sun_path, a_path.c_str(), a_path.size() + 1);
+
+            int const fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+            if (fd < 0) {
+                throw std::runtime_error(std::string("server: socket: ") + std::strerror(errno));
+            }
+
+            ::unlink(a_path.c_str());
+            add_listener(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address), false, a_path);
+        }
+
+        /**
+         * @brief Wait for socket events and serve them: accept connections, dispatch what clients sent and send replies.
+         *
+         * Each ready connection is read once per call (up to 64 KiB), so one busy client cannot starve the others.
+         *
+         * @param a_timeout_ms How long to wait for an event; 0 to not wait, -1 for ever.
+         *
+         * @return The number of frames and commands dispatched.
+         */
+        size_t poll(int const a_timeout_ms) {
+            int const count = ::epoll_wait(m_epoll, m_events.data(), static_cast<int>(m_events.size()), a_timeout_ms);
+            size_t frames = 0;
+
+            for (int i = 0; i < count; ++i) {
+                int const fd = m_events[i].data.fd;
+                uint32_t const events = m_events[i].events;
+
+                auto const l = std::find_if(m_listeners.begin(), m_listeners.end(), [fd](listener const& a_listener) {
+                    return a_listener.fd == fd;
+                });
+
+                if (l != m_listeners.end()) {
+                    accept_all(*l);
+                    continue;
+                }
+
+                auto const it = m_connections.find(fd);
+
+                if (it == m_connections.end()) {
+                    continue; // Closed earlier in this batch.
+                }
+
+                connection& c = *it->second;
+
+                if ((events & EPOLLOUT) != 0 && !flush(c)) {
+                    close(c);
+                    continue;
+                }
+
+                if ((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0) {
+                    size_t received = 0;
+
+                    if (!read(c, received) || !flush(c)) {
+                        close(c);
+                        continue;
+                    }
+
+                    frames += received;
+                }
+
+                update_events(c);
+            }
+
+            m_frames += frames;
+            return frames;
+        }
+
+        size_t connection_count() const noexcept {
+            return m_connections.size();
+        }
+
+        /// Connections accepted since construction.
+        uint64_t accepted() const noexcept {
+            return m_accepted;
+        }
+
+        /// Connections closed right away because max_connections were open.
+        uint64_t refused() const noexcept {
+            return m_refused;
+        }
+
+        /// Frames and commands dispatched since construction.
+        uint64_t frames() const noexcept {
+            return m_frames;
+        }
+
+    private:
+        void add_listener(int const a_fd, sockaddr const* a_address, socklen_t const a_size, bool const a_tcp, std::string const& a_path) {
+            if (::bind(a_fd, a_address, a_size) != 0 || ::listen(a_fd, SOMAXCONN) != 0) {
+                int const error = errno;
+                ::close(a_fd);
+                throw std::runtime_error(std::string("server: bind: ") + std::strerror(error));
+            }
+
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = a_fd;
+            ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, a_fd, &event);
+
+            m_listeners.push_back({ a_fd, a_tcp, a_path });
+        }
+
+        void accept_all(listener const& a_listener) {
+            for (;;) {
+                int const fd = ::accept4(a_listener.fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+                if (fd < 0) {
+                    return;
+                }
+
+                if (m_connections.size() >= m_options.max_connections) {
+                    ::close(fd);
+                    ++m_refused;
+                    continue;
+                }
+
+                if (a_listener.tcp) {
+                    // Replies are small frames; don't hold them back for coalescing.
+                    int const enable = 1;
+                    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+                }
+
+                auto c = std::unique_ptr<connection>(new connection(fd, m_store, m_options.max_body_size));
+                c->events = EPOLLIN;
+
+                epoll_event event{};
+                event.events = c->events;
+                event.data.fd = fd;
+                ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event);
+
+                m_connections.emplace(fd, std::move(c));
+                ++m_accepted;
+            }
+        }
+
+        /// Read once and dispatch. False if the connection closed or failed.
+        bool read(connection& a_connection, size_t& a_frames) {
+            ssize_t const size = ::recv(a_connection.fd, m_input.data(), m_input.size(), 0);
+
+            if (size == 0) {
+                return false;
+            }
+
+            if (size < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+            }
+
+            m_store.reply_to(&a_connection.output, m_options.window);
+            a_frames = a_connection.decoder.feed(m_input.data(), static_cast<size_t>(size));
+            m_store.reply_to(nullptr);
+            return true;
+        }
+
+        /// Send pending replies as far as the socket takes them. False if the connection failed.
+        bool flush(connection& a_connection) {
+            while (a_connection.pending() != 0) {
+                ssize_t const sent = ::send(a_connection.fd, a_connection.output.data() + a_connection.output_sent,
+                                            a_connection.pending(), MSG_NOSIGNAL);
+
+                if (sent < 0) {
+                    int const error = errno;
+
+                    if (a_connection.output_sent >= a_connection.pending()) {
+                        // Keep the buffer from growing while a slow client catches up.
+                        a_connection.output.erase(a_connection.output.begin(), a_connection.output.begin() + static_cast<std::ptrdiff_t>(a_connection.output_sent));
+                        a_connection.output_sent = 0;
+                    }
+
+                    return error == EAGAIN || error == EWOULDBLOCK || error == EINTR;
+                }
+
+                a_connection.output_sent += static_cast<size_t>(sent);
+            }
+
+            a_connection.output.clear();
+            a_connection.output_sent = 0;
+            return true;
+        }
+
+        /// Wait for writability while replies are pending, and stop reading while too many are.
+        void update_events(connection& a_connection) {
+            uint32_t events = 0;
+
+            if (a_connection.pending() < m_options.max_pending_output) {
+                events |= EPOLLIN;
+            }
+
+            if (a_connection.pending() != 0) {
+                events |= EPOLLOUT;
+            }
+
+            if (events != a_connection.events) {
+                a_connection.events = events;
+
+                epoll_event event{};
+                event.events = events;
+                event.data.fd = a_connection.fd;
+                ::epoll_ctl(m_epoll, EPOLL_CTL_MOD, a_connection.fd, &event);
+            }
+        }
+
+        void close(connection& a_connection) {
+            int const fd = a_connection.fd;
+            ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+            ::close(fd);
+            m_connections.erase(fd);
+        }
+    };
+}
+#endif
+
+#endif //DCSM_SERVER_HPP
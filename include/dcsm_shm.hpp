@@ -0,0 +1,474 @@
+#ifndef DCSM_SHM_HPP
+#define DCSM_SHM_HPP
+
+#include "dcsm.hpp"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+
+/*
+ * Shared-memory transport for processes on the same machine (e.g. lighting software, a visualizer and a
+ * bridge feeding one node): a ring of direct control frames in a shared mapping, written by any number
+ * of producers and dispatched in place by one consumer. Frames never pass through the kernel; the
+ * consumer sleeps on a futex only when the ring is empty, and producers only wake it when it sleeps.
+ */
+
+namespace dcsm {
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "shared rings need address-free atomics");
+
+    /**
+     * @brief Header at the start of a ring region, followed by the ring itself.
+     *
+     * Positions count bytes since the ring was created and only grow; the ring offset is the position
+     * modulo the capacity. Each record is a uint32_t frame size and the frame, padded to 8 bytes. A
+     * record that would wrap is preceded by a padding record (size shm_ring_padding) up to the end.
+     */
+    struct shm_ring_header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t capacity;                              ///< Ring bytes, a power of two.
+        alignas(64) std::atomic<uint64_t> reserved;    ///< Producers: end of the last record claimed.
+        alignas(64) std::atomic<uint64_t> committed;   ///< Producers: every record before it is complete.
+        std::atomic<uint32_t> signal;                   ///< Futex word, bumped to wake a sleeping consumer.
+        std::atomic<uint32_t> sleeping;                 ///< The consumer is waiting on signal.
+        alignas(64) std::atomic<uint64_t> consumed;    ///< Consumer: every record before it was dispatched.
+    };
+
+    constexpr uint32_t shm_ring_magic   = 0x52534344; ///< "DCSR"
+    constexpr uint32_t shm_ring_padding = 0xFFFFFFFF;
+
+    /**
+     * @brief A ring of direct control frames in shared memory (Linux).
+     *
+     * Any number of producers (threads or processes) push frames; a single consumer dispatches them
+     * straight from the shared buffer. push never blocks: it fails while the ring is full. Producers
+     * publish in the order they claimed space, so one preempted between reserve and commit holds back
+     * the ones after it, never the consumer's view of earlier frames.
+     */
+    class shm_ring {
+    public:
+        /// Space claimed in the ring by reserve, to fill and commit.
+        struct reservation {
+            uint8_t* data;     ///< Where the frame goes (the size given to reserve).
+            uint64_t position; ///< Start of the record, including any padding before it.
+            uint64_t end;      ///< End of the record.
+        };
+
+    private:
+        int m_fd = -1;
+        void* m_mapping = MAP_FAILED;
+        size_t m_mapping_size = 0;
+        shm_ring_header* m_header = nullptr;
+        uint8_t* m_ring = nullptr;
+        uint64_t m_mask = 0;
+        uint64_t m_rejected = 0;
+        std::string m_name; ///< Set if this object created a named region; unlinked on destruction.
+
+    public:
+        /**
+         * @brief Create an anonymous ring (memfd), e.g. to share with a child process or over a Unix socket (see fd).
+         *
+         * @param a_capacity Ring bytes, rounded up to a power of two (at least 4096).
+         *
+         * @throws std::runtime_error if the region cannot be created.
+         */
+        explicit shm_ring(size_t const a_capacity) {
+            m_fd = ::memfd_create("dcsm_ring", MFD_CLOEXEC);
+            create(a_capacity);
+        }
+
+        /**
+         * @brief Create a named ring (POSIX shared memory, /dev/shm) for other processes to open, replacing any stale one.
+         *
+         * @param a_name     The name, starting with '/'.
+         * @param a_capacity Ring bytes, rounded up to a power of two (at least 4096).
+         *
+         * @throws std::runtime_error if the region cannot be created.
+         */
+        shm_ring(std::string const& a_name, size_t const a_capacity) :
+            m_name(a_name)
+        {
+            ::shm_unlink(a_name.c_str());
+            m_fd = ::shm_open(a_name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+            create(a_capacity);
+        }
+
+        /**
+         * @brief Map an existing ring, e.g. an fd received from its creator.
+         *
+         * @param a_fd The region; owned by the ring from now on.
+         *
+         * @throws std::runtime_error if a_fd is not a ring region.
+         */
+        static shm_ring attach(int const a_fd) {
+            return shm_ring(a_fd, attach_tag{});
+        }
+
+        /**
+         * @brief Open a named ring created by another process.
+         *
+         * @throws std::runtime_error if there is no such ring.
+         */
+        static shm_ring open(std::string const& a_name) {
+            int const fd = ::shm_open(a_name.c_str(), O_RDWR | O_CLOEXEC, 0);
+
+            if (fd < 0) {
+                throw std::runtime_error("shm_ring: cannot open " + a_name + ": " + std::strerror(errno));
+            }
+
+            return attach(fd);
+        }
+
+        shm_ring(shm_ring&& a_other) noexcept :
+            m_fd(a_other.m_fd),
+            m_mapping(a_other.m_mapping),
+            m_mapping_size(a_other.m_mapping_size),
+            m_header(a_other.m_header),
+            m_ring(a_other.m_ring),
+            m_mask(a_other.m_mask),
+            m_rejected(a_other.m_rejected),
+            m_name(std::move(a_other.m_name))
+        {
+            a_other.m_fd = -1;
+            a_other.m_mapping = MAP_FAILED;
+            a_other.m_name.clear();
+        }
+
+        shm_ring(shm_ring const&) = delete;
+        shm_ring& operator=(shm_ring const&) = delete;
+        shm_ring& operator=(shm_ring&&) = delete;
+
+        ~shm_ring() {
+            if (m_mapping != MAP_FAILED) {
+                ::munmap(m_mapping, m_mapping_size);
+            }
+
+            if (m_fd >= 0) {
+                ::close(m_fd);
+            }
+
+            if (!m_name.empty()) {
+                ::shm_unlink(m_name.c_str());
+            }
+        }
+
+        /// The region, to hand to another process.
+        int fd() const noexcept {
+            return m_fd;
+        }
+
+        size_t capacity() const noexcept {
+            return static_cast<size_t>(m_mask + 1);
+        }
+
+        /// Largest frame a single record can hold.
+        size_t max_frame_size() const noexcept {
+            return capacity() / 2 - sizeof(uint32_t);
+        }
+
+        /// Records consume skipped instead of dispatching, because they did not hold exactly one complete frame.
+        uint64_t rejected() const noexcept {
+            return m_rejected;
+        }
+
+        /// Bytes of records not yet dispatched, including padding.
+        size_t size() const noexcept {
+            return static_cast<size_t>(m_header->reserved.load(std::memory_order_acquire) - m_header->consumed.load(std::memory_order_acquire));
+        }
+
+        // ---- Producers ----
+
+        /**
+         * @brief Claim space for a frame of a_size bytes. Fill a_reservation.data, then commit.
+         *
+         * @return False if the ring is full, or the frame is shorter than a message header or larger than max_frame_size.
+         */
+        bool reserve(size_t const a_size, reservation& a_reservation) noexcept {
+            if (a_size < message_header_size || a_size > max_frame_size()) {
+                return false;
+            }
+
+            uint64_t const record = record_size(a_size);
+            uint64_t position = m_header->reserved.load(std::memory_order_relaxed);
+            uint64_t end;
+
+            do {
+                uint64_t const offset = position & m_mask;
+                uint64_t const padding = offset + record > capacity() ? capacity() - offset : 0;
+                end = position + padding + record;
+
+                if (end - m_header->consumed.load(std::memory_order_acquire) > capacity()) {
+                    return false;
+                }
+            } while (!m_header->reserved.compare_exchange_weak(position, end, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+            uint64_t const start = end - record;
+
+            if (start != position) {
+                store_size(position, shm_ring_padding);
+            }
+
+            store_size(start, static_cast<uint32_t>(a_size));
+
+            a_reservation.data = m_ring + (start & m_mask) + sizeof(uint32_t);
+            a_reservation.position = position;
+            a_reservation.end = end;
+            return true;
+        }
+
+        /// Publish a filled reservation, after every reservation claimed before it, and wake the consumer if it sleeps.
+        void commit(reservation const& a_reservation) noexcept {
+            // Yield after a while: the producer ahead may have been preempted between reserve and commit.
+            for (unsigned i = 0; m_header->committed.load(std::memory_order_acquire) != a_reservation.position; ++i) {
+                if (i < 64) {
+                    pause();
+                } else {
+                    ::sched_yield();
+                }
+            }
+
+            // Sequentially consistent with the consumer's sleeping/committed pair, so a wakeup is never missed.
+            m_header->committed.store(a_reservation.end);
+
+            if (m_header->sleeping.load() != 0) {
+                m_header->signal.fetch_add(1);
+                futex(&m_header->signal, FUTEX_WAKE, INT_MAX, nullptr);
+            }
+        }
+
+        /**
+         * @brief Copy an encoded frame into the ring.
+         *
+         * @param a_frame A single frame, as produced by the encoder (any frame flags).
+         * @param a_size  The size of the frame.
+         *
+         * @return False if the ring is full or a_frame is not exactly one complete frame.
+         */
+        bool push(uint8_t const* a_frame, size_t const a_size) noexcept {
+            reservation r{};
+
+            if (!is_complete_frame(a_frame, a_size) || !reserve(a_size, r)) {
+                return false;
+            }
+
+            std::memcpy(r.data, a_frame, a_size);
+            commit(r);
+            return true;
+        }
+
+        // ---- Consumer ----
+
+        /**
+         * @brief Dispatch committed frames in place.
+         *
+         * Any process that maps the region can write to it, so each record is checked to hold exactly one
+         * complete frame first; others are skipped and counted (see rejected). A record size that leaves
+         * the committed records skips all of them, as nothing after it can be trusted.
+         *
+         * @param a_dispatch  The dispatch to feed.
+         * @param a_max       Frames to dispatch at most.
+         *
+         * @return The number of frames dispatched.
+         */
+        size_t consume(dispatch& a_dispatch, size_t const a_max = std::numeric_limits<size_t>::max()) {
+            uint64_t position = m_header->consumed.load(std::memory_order_relaxed);
+            uint64_t const end = m_header->committed.load(std::memory_order_acquire);
+            size_t frames = 0;
+
+            while (position != end && frames < a_max) {
+                uint64_t const offset = position & m_mask;
+                uint32_t size;
+                std::memcpy(&size, m_ring + offset, sizeof(size));
+
+                if (size == shm_ring_padding) {
+                    position = capacity() - offset > end - position ? end : position + capacity() - offset;
+                    continue;
+                }
+
+                if (size > max_frame_size() || offset + record_size(size) > capacity() || record_size(size) > end - position) {
+                    ++m_rejected;
+                    position = end;
+                    break;
+                }
+
+                uint8_t const* const frame = m_ring + offset + sizeof(uint32_t);
+
+                if (is_complete_frame(frame, size)) {
+                    a_dispatch.process_message(frame);
+                    ++frames;
+                } else {
+                    ++m_rejected;
+                }
+
+                position += record_size(size);
+
+                // Free the record right away so producers are not held up by a long batch.
+                m_header->consumed.store(position, std::memory_order_release);
+            }
+
+            m_header->consumed.store(position, std::memory_order_release);
+            return frames;
+        }
+
+        /**
+         * @brief Wait until frames are committed: spin briefly, then sleep on the futex.
+         *
+         * @param a_timeout_ms How long to wait; 0 to not wait, -1 for ever.
+         * @param a_spin       Checks before sleeping; spinning saves the wakeup when frames follow closely.
+         *                     Ignored on a single CPU, where it would only hold up the producer.
+         *
+         * @return True if frames are ready to consume.
+         */
+        bool wait(int const a_timeout_ms, unsigned const a_spin = 200) noexcept {
+            static bool const multiprocessor = ::sysconf(_SC_NPROCESSORS_ONLN) > 1;
+
+            for (unsigned i = 0; i <= (multiprocessor ? a_spin : 0); ++i) {
+                if (ready()) {
+                    return true;
+                }
+
+                pause();
+            }
+
+            if (a_timeout_ms == 0) {
+                return false;
+            }
+
+            uint32_t const signal = m_header->signal.load();
+            m_header->sleeping.store(1);
+
+            if (!ready()) {
+                timespec timeout{ a_timeout_ms / 1000, (a_timeout_ms % 1000) * 1000000L };
+                futex(&m_header->signal, FUTEX_WAIT, signal, a_timeout_ms < 0 ? nullptr : &timeout);
+            }
+
+            m_header->sleeping.store(0);
+            return ready();
+        }
+
+        /// wait, then consume.
+        size_t poll(dispatch& a_dispatch, int const a_timeout_ms) {
+            return wait(a_timeout_ms) ? consume(a_dispatch) : 0;
+        }
+
+    private:
+        struct attach_tag {};
+
+        shm_ring(int const a_fd, attach_tag) :
+            m_fd(a_fd)
+        {
+            map_existing();
+        }
+
+        static uint64_t record_size(size_t const a_size) noexcept {
+            return (sizeof(uint32_t) + a_size + 7) & ~uint64_t{ 7 };
+        }
+
+        static void pause() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#elif defined(__aarch64__)
+            asm volatile("yield");
+#endif
+        }
+
+        static long futex(std::atomic<uint32_t>* a_word, int const a_operation, uint32_t const a_value, timespec const* a_timeout) noexcept {
+            // Not FUTEX_PRIVATE_FLAG: the word is shared between processes.
+            return ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(a_word), a_operation, a_value, a_timeout, nullptr, 0);
+        }
+
+        bool ready() const noexcept {
+            return m_header->committed.load() != m_header->consumed.load(std::memory_order_relaxed);
+        }
+
+        void store_size(uint64_t const a_position, uint32_t const a_size) noexcept {
+            std::memcpy(m_ring + (a_position & m_mask), &a_size, sizeof(a_size));
+        }
+
+        /// Release what the constructor acquired so far (the destructor does not run), then throw.
+        [[noreturn]] void fail(std::string const& a_message) {
+            if (m_mapping != MAP_FAILED) {
+                ::munmap(m_mapping, m_mapping_size);
+            }
+
+            if (m_fd >= 0) {
+                ::close(m_fd);
+            }
+
+            if (!m_name.empty()) {
+                ::shm_unlink(m_name.c_str());
+            }
+
+            throw std::runtime_error(a_message);
+        }
+
+        void create(size_t const a_capacity) {
+            if (m_fd < 0) {
+                fail(std::string("shm_ring: cannot create region: ") + std::strerror(errno));
+            }
+
+            size_t capacity = 4096;
+
+            while (capacity < a_capacity) {
+                capacity *= 2;
+            }
+
+            if (::ftruncate(m_fd, static_cast<off_t>(sizeof(shm_ring_header) + capacity)) != 0) {
+                fail(std::string("shm_ring: ftruncate: ") + std::strerror(errno));
+            }
+
+            map(sizeof(shm_ring_header) + capacity);
+
+            // The region is zero-filled; positions and futex words start at 0.
+            m_header->capacity = capacity;
+            m_header->version = 1;
+            m_header->magic = shm_ring_magic;
+            m_mask = capacity - 1;
+        }
+
+        void map_existing() {
+            struct stat status{};
+
+            if (m_fd < 0 || ::fstat(m_fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(shm_ring_header)) {
+                fail("shm_ring: not a ring region");
+            }
+
+            map(static_cast<size_t>(status.st_size));
+
+            uint64_t const capacity = m_header->capacity;
+
+            // The same capacities create makes, so the mask keeps every offset inside the mapping.
+            if (m_header->magic != shm_ring_magic || m_header->version != 1 ||
+                capacity < 4096 || (capacity & (capacity - 1)) != 0 ||
+                sizeof(shm_ring_header) + capacity != m_mapping_size) {
+                fail("shm_ring: not a ring region");
+            }
+
+            m_mask = capacity - 1;
+        }
+
+        void map(size_t const a_size) {
+            m_mapping = ::mmap(nullptr, a_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+
+            if (m_mapping == MAP_FAILED) {
+                fail(std::string("shm_ring: mmap: ") + std::strerror(errno));
+            }
+
+            m_mapping_size = a_size;
+            m_header = static_cast<shm_ring_header*>(m_mapping);
+            m_ring = static_cast<uint8_t*>(m_mapping) + sizeof(shm_ring_header);
+        }
+    };
+}
+#endif
+
+#endif //DCSM_SHM_HPP
@@ -0,0 +1,231 @@
+#ifndef DCSM_SHM_READER_HPP
+#define DCSM_SHM_READER_HPP
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+/*
+ * Reader side of the universes a node publishes in shared memory (see shm_reference_store in
+ * dcsm_shm_store.hpp). A visualizer or logger on the same host maps the segment read-only and copies
+ * consistent universes out of it at any rate, without a protocol round trip and without ever blocking
+ * the node. Depends on nothing else in the library, so readers only need this header.
+ */
+
+namespace dcsm {
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared universes need address-free atomics");
+
+    /**
+     * @brief Header at the start of a universe segment.
+     *
+     * It is followed by a uint64_t generation per universe (a seqlock: odd while the universe is being
+     * written, bumped by 2 per write), then, from slab_offset, the 512-byte universe slabs in order.
+     */
+    struct alignas(64) shm_universe_header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t universe_count;
+        uint32_t reserved;
+        uint64_t slab_offset; ///< Page aligned, so every slab is 512-byte aligned.
+    };
+
+    constexpr uint32_t shm_universe_magic = 0x55534344; ///< "DCSU"
+
+    /// Size of the segment for a_universe_count universes, and the offset of its first slab.
+    inline size_t shm_universe_segment_size(size_t const a_universe_count, size_t* const a_slab_offset = nullptr) noexcept {
+        size_t const slab_offset = (sizeof(shm_universe_header) + a_universe_count * sizeof(uint64_t) + 4095) & ~size_t{ 4095 };
+
+        if (a_slab_offset != nullptr) {
+            *a_slab_offset = slab_offset;
+        }
+
+        return slab_offset + a_universe_count * 512;
+    }
+
+    /**
+     * @brief Read-only view of a universe segment (Linux).
+     *
+     * Reads copy a universe and retry if the node wrote it meanwhile; the node never waits for readers.
+     */
+    class shm_universe_reader {
+        int m_fd = -1;
+        void* m_mapping = MAP_FAILED;
+        size_t m_mapping_size = 0;
+        shm_universe_header const* m_header = nullptr;
+        std::atomic<uint64_t> const* m_generations = nullptr;
+        uint8_t const* m_slabs = nullptr;
+        uint64_t m_retries = 0;
+
+    public:
+        /**
+         * @brief Map the segment a node published under a name.
+         *
+         * @param a_name The name given to the node, starting with '/'.
+         *
+         * @throws std::runtime_error if there is no such segment.
+         */
+        explicit shm_universe_reader(std::string const& a_name) {
+            m_fd = ::shm_open(a_name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+
+            if (m_fd < 0) {
+                throw std::runtime_error("shm_universe_reader: cannot open " + a_name + ": " + std::strerror(errno));
+            }
+
+            map();
+        }
+
+        /**
+         * @brief Map a segment by file descriptor, e.g. received from the node over a Unix socket.
+         *
+         * @param a_fd The segment; owned by the reader from now on.
+         *
+         * @throws std::runtime_error if a_fd is not a universe segment.
+         */
+        explicit shm_universe_reader(int const a_fd) :
+            m_fd(a_fd)
+        {
+            map();
+        }
+
+        shm_universe_reader(shm_universe_reader const&) = delete;
+        shm_universe_reader& operator=(shm_universe_reader const&) = delete;
+
+        ~shm_universe_reader() {
+            release();
+        }
+
+        size_t universe_count() const noexcept {
+            return m_header->universe_count;
+        }
+
+        /// Reads that had to start over because the node was writing the universe.
+        uint64_t retries() const noexcept {
+            return m_retries;
+        }
+
+        /**
+         * @brief Generation of a universe: grows with every write, so an unchanged generation means unchanged data.
+         *
+         * @return The generation, odd while a write is in progress; 0 if out of range or never written.
+         */
+        uint64_t generation(uint16_t const a_universe) const noexcept {
+            return valid_universe(a_universe) ? m_generations[a_universe - 1].load(std::memory_order_acquire) : 0;
+        }
+
+        /**
+         * @brief Copy a consistent universe.
+         *
+         * @param a_universe   The universe, from 1.
+         * @param a_out        Destination of 512 bytes.
+         * @param a_generation Receives the generation of the copy, if not nullptr.
+         *
+         * @return False if the universe is out of range.
+         */
+        bool read(uint16_t const a_universe, uint8_t* const a_out, uint64_t* const a_generation = nullptr) noexcept {
+            if (!valid_universe(a_universe)) {
+                return false;
+            }
+
+            auto const& generation = m_generations[a_universe - 1];
+            uint8_t const* const slab = m_slabs + (a_universe - 1) * size_t{ 512 };
+
+            for (unsigned attempt = 0;; ++attempt) {
+                uint64_t const before = generation.load(std::memory_order_acquire);
+
+                if ((before & 1) == 0) {
+                    std::memcpy(a_out, slab, 512);
+                    std::atomic_thread_fence(std::memory_order_acquire);
+
+                    if (generation.load(std::memory_order_relaxed) == before) {
+                        if (a_generation != nullptr) {
+                            *a_generation = before;
+                        }
+
+                        return true;
+                    }
+                }
+
+                ++m_retries;
+
+                // The node may have been preempted mid-write; let it run.
+                if (attempt >= 64) {
+                    ::sched_yield();
+                }
+            }
+        }
+
+        /**
+         * @brief Copy a universe only if it changed since a_generation, e.g. once per display frame.
+         *
+         * @param a_generation The generation of the last copy (0 at first), updated on a copy.
+         *
+         * @return True if a_out was updated.
+         */
+        bool read_changed(uint16_t const a_universe, uint8_t* const a_out, uint64_t& a_generation) noexcept {
+            if (generation(a_universe) == a_generation) {
+                return false;
+            }
+
+            return read(a_universe, a_out, &a_generation);
+        }
+
+    private:
+        bool valid_universe(uint16_t const a_universe) const noexcept {
+            return a_universe != 0 && a_universe <= m_header->universe_count;
+        }
+
+        void release() noexcept {
+            if (m_mapping != MAP_FAILED) {
+                ::munmap(m_mapping, m_mapping_size);
+            }
+
+            if (m_fd >= 0) {
+                ::close(m_fd);
+            }
+        }
+
+        void map() {
+            struct stat status{};
+
+            if (m_fd < 0 || ::fstat(m_fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(shm_universe_header)) {
+                release();
+                throw std::runtime_error("shm_universe_reader: not a universe segment");
+            }
+
+            m_mapping_size = static_cast<size_t>(status.st_size);
+            m_mapping = ::mmap(nullptr, m_mapping_size, PROT_READ, MAP_SHARED, m_fd, 0);
+
+            if (m_mapping == MAP_FAILED) {
+                int const error = errno;
+                release();
+                throw std::runtime_error(std::string("shm_universe_reader: mmap: ") + std::strerror(error));
+            }
+
+            m_header = static_cast<shm_universe_header const*>(m_mapping);
+            size_t slab_offset;
+
+            if (m_header->magic != shm_universe_magic || m_header->version != 1 ||
+                shm_universe_segment_size(m_header->universe_count, &slab_offset) != m_mapping_size ||
+                slab_offset != m_header->slab_offset) {
+                release();
+                throw std::runtime_error("shm_universe_reader: not a universe segment");
+            }
+
+            m_generations = reinterpret_cast<std::atomic<uint64_t> const*>(m_header + 1);
+            m_slabs = static_cast<uint8_t const*>(m_mapping) + slab_offset;
+        }
+    };
+}
+#endif
+
+#endif //DCSM_SHM_READER_HPP
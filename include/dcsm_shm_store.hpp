@@ -0,0 +1,260 @@
+#ifndef DCSM_SHM_STORE_HPP
+#define DCSM_SHM_STORE_HPP
+
+#include "dcsm.hpp"
+#include "dcsm_reference_store.hpp"
+#include "dcsm_shm_reader.hpp"
+
+#if defined(__linux__)
+
+/*
+ * A reference store whose universes live in a shared-memory segment, for readers on the same host
+ * (see shm_universe_reader in dcsm_shm_reader.hpp). Each universe is a 512-byte slab with a seqlock
+ * generation: the store makes it odd, writes the slab and makes it even again, so a reader copies a
+ * universe and keeps the copy if the generation did not move. The store never waits for readers.
+ */
+
+namespace dcsm {
+    static_assert(sizeof(reference_store::universe_data) == 512, "universe slabs are reference_store universes");
+
+    /// The segment of a shm_reference_store, as a base class so that it is mapped before the store is constructed on it.
+    class shm_universe_segment {
+    protected:
+        int m_segment_fd = -1;
+        void* m_mapping = MAP_FAILED;
+        size_t m_mapping_size = 0;
+        std::string m_name; ///< Set for a named segment; unlinked on destruction.
+        std::atomic<uint64_t>* m_generations = nullptr;
+        reference_store::universe_data* m_slabs = nullptr;
+
+        shm_universe_segment(std::string const& a_name, size_t const a_universe_count) :
+            m_name(a_name)
+        {
+            if (a_universe_count == 0 || a_universe_count > 0xFFFF) {
+                throw std::invalid_argument("shm_universe_segment: universe count out of range");
+            }
+
+            if (m_name.empty()) {
+                m_segment_fd = ::memfd_create("dcsm_universes", MFD_CLOEXEC);
+            } else {
+                ::shm_unlink(m_name.c_str());
+                m_segment_fd = ::shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+            }
+
+            if (m_segment_fd < 0) {
+                fail(std::string("shm_universe_segment: cannot create segment: ") + std::strerror(errno));
+            }
+
+            size_t slab_offset;
+            m_mapping_size = shm_universe_segment_size(a_universe_count, &slab_offset);
+
+            if (::ftruncate(m_segment_fd, static_cast<off_t>(m_mapping_size)) != 0) {
+                fail(std::string("shm_universe_segment: ftruncate: ") + std::strerror(errno));
+            }
+
+            m_mapping = ::mmap(nullptr, m_mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_segment_fd, 0);
+
+            if (m_mapping == MAP_FAILED) {
+                fail(std::string("shm_universe_segment: mmap: ") + std::strerror(errno));
+            }
+
+            // The segment is zero-filled: every universe starts dark at generation 0.
+            auto const header = static_cast<shm_universe_header*>(m_mapping);
+            header->universe_count = static_cast<uint32_t>(a_universe_count);
+            header->slab_offset = slab_offset;
+            header->version = 1;
+            header->magic = shm_universe_magic;
+
+            m_generations = reinterpret_cast<std::atomic<uint64_t>*>(header + 1);
+            m_slabs = reinterpret_cast<reference_store::universe_data*>(static_cast<uint8_t*>(m_mapping) + slab_offset);
+        }
+
+        shm_universe_segment(shm_universe_segment const&) = delete;
+        shm_universe_segment& operator=(shm_universe_segment const&) = delete;
+
+        ~shm_universe_segment() {
+            release();
+        }
+
+    private:
+        void release() noexcept {
+            if (m_mapping != MAP_FAILED) {
+                ::munmap(m_mapping, m_mapping_size);
+            }
+
+            if (m_segment_fd >= 0) {
+                ::close(m_segment_fd);
+            }
+
+            if (!m_name.empty()) {
+                ::shm_unlink(m_name.c_str());
+            }
+        }
+
+        /// Release what the constructor acquired so far (the destructor does not run), then throw.
+        [[noreturn]] void fail(std::string const& a_message) {
+            release();
+            throw std::runtime_error(a_message);
+        }
+    };
+
+    /**
+     * @brief A reference_store publishing its universes in shared memory (Linux).
+     *
+     * Every universe write that arrives through dispatch is published. Code writing universe data
+     * directly must bracket it with begin_write and end_write instead of going through universe(). The
+     * segment holds the universes as set, before patching; masks, patches and the framerate stay private.
+     */
+    class shm_reference_store : private shm_universe_segment, public reference_store {
+    public:
+        /**
+         * @brief Publish in an anonymous segment (memfd), to hand to readers by file descriptor (see fd).
+         *
+         * @throws std::runtime_error if the segment cannot be created.
+         */
+        explicit shm_reference_store(size_t const a_universe_count) :
+            shm_universe_segment(std::string(), a_universe_count),
+            reference_store(m_slabs, a_universe_count)
+        {}
+
+        /**
+         * @brief Publish under a name (POSIX shared memory, /dev/shm) for readers to open, replacing any stale segment.
+         *
+         * @param a_name The name, starting with '/'. Unlinked when the store is destroyed.
+         *
+         * @throws std::runtime_error if the segment cannot be created.
+         */
+        shm_reference_store(std::string const& a_name, size_t const a_universe_count) :
+            shm_universe_segment(a_name, a_universe_count),
+            reference_store(m_slabs, a_universe_count)
+        {}
+
+        /// The segment, e.g. to pass to a reader over a Unix socket.
+        int fd() const noexcept {
+            return m_segment_fd;
+        }
+
+        /// The generation readers see for a universe (see shm_universe_reader::generation).
+        uint64_t generation(uint16_t const a_universe) const noexcept {
+            return valid_universe(a_universe) ? m_generations[a_universe - 1].load(std::memory_order_relaxed) : 0;
+        }
+
+        /**
+         * @brief Start writing a universe directly: readers retry until end_write.
+         *
+         * @return The universe data, or nullptr if out of range (then do not call end_write).
+         */
+        uint8_t* begin_write(uint16_t const a_universe) noexcept {
+            if (!valid_universe(a_universe)) {
+                return nullptr;
+            }
+
+            auto& generation = m_generations[a_universe - 1];
+            generation.store(generation.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            return universe(a_universe);
+        }
+
+        /// Publish a universe written since begin_write.
+        void end_write(uint16_t const a_universe) noexcept {
+            auto& generation = m_generations[a_universe - 1];
+            generation.store(generation.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        void dcsm_setu(command_context& a_ctx, uint16_t const a_universe, uint8_t const* a_data) override {
+            if (auto const data = begin_write(a_universe)) {
+                std::memcpy(data, a_data, 512);
+                end_write(a_universe);
+            }
+        }
+
+        /// setuc decodes straight into the slab; dcsm_setuc publishes it.
+        uint8_t* dcsm_universe_buffer(command_context& a_ctx, uint16_t const a_universe) override {
+            return begin_write(a_universe);
+        }
+
+        void dcsm_setuc(command_context& a_ctx, uint16_t const a_universe) override {
+            end_write(a_universe);
+        }
+
+        void dcsm_setv(command_context& a_ctx, std::vector<std::pair<address_pack, uint8_t>> const& a_pairs) override {
+            written_universe written(*this);
+
+            for (auto const& pair : a_pairs) {
+                written.select(pair.first.first);
+                set_address(pair.first.first, pair.first.second, pair.second);
+            }
+        }
+
+        void dcsm_setsp(command_context& a_ctx, std::vector<universe_span> const& a_spans) override {
+            for (auto const& span : a_spans) {
+                if (auto const data = begin_write(span.universe)) {
+                    std::memcpy(data + span.start - 1, span.data, span.count);
+                    end_write(span.universe);
+                }
+            }
+        }
+
+        void dcsm_setv16(command_context& a_ctx, std::vector<std::pair<address_pack, uint16_t>> const& a_pairs) override {
+            written_universe written(*this);
+
+            for (auto const& pair : a_pairs) {
+                written.select(pair.first.first);
+                set_fine_address(pair.first.first, pair.first.second, pair.second);
+            }
+        }
+
+        void dcsm_setutv16(command_context& a_ctx, uint16_t const a_universe, uint16_t const a_value, universe_mask const& a_mask) override {
+            if (begin_write(a_universe) != nullptr) {
+                reference_store::dcsm_setutv16(a_ctx, a_universe, a_value, a_mask);
+                end_write(a_universe);
+            }
+        }
+
+        void dcsm_setutv(command_context& a_ctx, uint16_t const a_universe, uint8_t const a_value, universe_mask const& a_mask) override {
+            if (begin_write(a_universe) != nullptr) {
+                reference_store::dcsm_setutv(a_ctx, a_universe, a_value, a_mask);
+                end_write(a_universe);
+            }
+        }
+
+        void dcsm_copy(command_context& a_ctx, uint16_t const a_source_universe, uint16_t const a_destination_universe) override {
+            if (universe(a_source_universe) != nullptr && begin_write(a_destination_universe) != nullptr) {
+                reference_store::dcsm_copy(a_ctx, a_source_universe, a_destination_universe);
+                end_write(a_destination_universe);
+            }
+        }
+
+    private:
+        /// Keeps one universe open for writing across a run of addresses in it, so a batch costs one publication per universe run.
+        class written_universe {
+            shm_reference_store& m_store;
+            uint16_t m_universe = 0;
+
+        public:
+            explicit written_universe(shm_reference_store& a_store) noexcept :
+                m_store(a_store)
+            {}
+
+            ~written_universe() {
+                select(0);
+            }
+
+            void select(uint16_t const a_universe) noexcept {
+                if (a_universe == m_universe) {
+                    return;
+                }
+
+                if (m_universe != 0) {
+                    m_store.end_write(m_universe);
+                }
+
+                m_universe = m_store.begin_write(a_universe) != nullptr ? a_universe : 0;
+            }
+        };
+    };
+}
+#endif
+
+#endif //DCSM_SHM_STORE_HPP
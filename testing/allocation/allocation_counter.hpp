@@ -0,0 +1,23 @@
+#ifndef DCSM_TESTING_ALLOCATION_COUNTER_HPP
+#define DCSM_TESTING_ALLOCATION_COUNTER_HPP
+
+#include <atomic>
+#include <cstddef>
+
+// Global operator new/delete are replaced in new_delete.cpp for the whole dcsm_test binary, counting
+// every allocation. Tests compare the count before and after the code under test.
+
+namespace allocation {
+    /// Total number of allocations made through operator new so far.
+    size_t count() noexcept;
+
+    /// Number of allocations made while running a callable.
+    template <typename t_callable>
+    size_t count_during(t_callable&& a_callable) {
+        size_t const before = count();
+        a_callable();
+        return count() - before;
+    }
+}
+
+#endif //DCSM_TESTING_ALLOCATION_COUNTER_HPP
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+
+#include "allocation_counter.hpp"
+
+// Allocation budgets for dispatch. The direct control interface and the framing path promise zero
+// allocations once dispatch buffers are sized (reserve_scratch, or a warm-up message of the same size).
+// Commands that parse address ranges allocate while parsing and are held to a fixed budget instead.
+
+struct allocation_interface final : dcsm::dispatch_interface {
+    // The defaults convert to setv pairs, which allocates; handlers on the hot path override them.
+    void dcsm_setsp(dcsm::command_context &a_ctx, std::vector<dcsm::universe_span> const &a_spans) override {}
+    void dcsm_setv16(dcsm::command_context &a_ctx, std::vector<std::pair<dcsm::address_pack, uint16_t>> const &a_pairs) override {}
+    void dcsm_setutv16(dcsm::command_context &a_ctx, uint16_t const a_universe, uint16_t const a_value, dcsm::universe_mask const &a_mask) override {}
+};
+
+class allocation_fixture : public ::testing::Test {
+protected:
+    allocation_interface itf;
+    dcsm::dispatch dsp{ itf };
+
+    static constexpr size_t scratch_entries = 64;
+
+    void SetUp() override {
+        dsp.reserve_scratch(scratch_entries);
+    }
+
+    /// One frame per direct control opcode.
+    static std::vector<std::vector<uint8_t>> direct_control_frames() {
+        std::array<uint8_t, 512> data{};
+        dcsm::universe_mask mask;
+        mask.set(7);
+
+        std::vector<std::pair<dcsm::address_pack, uint8_t>> setv_pairs;
+        std::vector<std::pair<dcsm::address_pack, uint16_t>> setv16_pairs;
+        std::vector<std::tuple<uint16_t, bool, uint8_t>> setmv_pairs;
+        std::vector<dcsm::address_pack> addresses;
+
+        for (uint16_t i = 1; i <= scratch_entries; ++i) {
+            setv_pairs.emplace_back(dcsm::address_pack{ 1, i }, 10);
+            setv16_pairs.emplace_back(dcsm::address_pack{ 1, i }, 40000);
+            setmv_pairs.emplace_back(i, true, 10);
+            addresses.emplace_back(1, i);
+        }
+
+        std::vector<std::vector<uint8_t>> frames(37);
+
+        dcsm::encode_id    (frames[0]);
+        dcsm::encode_setu  (frames[1], 1, data.data());
+        dcsm::encode_setv  (frames[2], setv_pairs);
+        dcsm::encode_getu  (frames[3], 1);
+        dcsm::encode_setfr (frames[4], 44);
+        dcsm::encode_getfr (frames[5]);
+        dcsm::encode_newmu (frames[6], 2);
+        dcsm::encode_listmu(frames[7]);
+        dcsm::encode_delmu (frames[8], 2);
+        dcsm::encode_setmu (frames[9], 2, mask, data.data());
+        dcsm::encode_setmv (frames[10], 2, setmv_pairs);
+        dcsm::encode_getmu (frames[11], 2);
+        dcsm::encode_clrmu (frames[12], 2);
+        dcsm::encode_patch (frames[13], 1, 2, 3);
+        dcsm::encode_unpat (frames[14], 2);
+        dcsm::encode_listp (frames[15]);
+        dcsm::encode_copy  (frames[16], 1, 2);
+        dcsm::encode_setutv(frames[17], 1, 10, mask);
+        dcsm::encode_setmtv(frames[18], 2, 10, mask);
+        dcsm::encode_listu (frames[19]);
+        dcsm::encode_geta  (frames[20], addresses);
+        dcsm::encode_getma (frames[21], addresses);
+        dcsm::encode_setuc (frames[22], 1, data.data());
+        dcsm::encode_setub (frames[23], { { 1, data.data() }, { 2, data.data() } });
+        dcsm::encode_setsp (frames[24], { { 1, 1, 40, data.data() }, { 2, 100, 40, data.data() } });
+        dcsm::encode_getr  (frames[25], 1, 100, 48);
+        dcsm::encode_getmr (frames[26], 2, 100, 48);
+        dcsm::encode_setv16(frames[27], setv16_pairs);
+        dcsm::encode_setutv16(frames[28], 1, 40000, mask);
+        dcsm::encode_sub   (frames[29], 1);
+        dcsm::encode_unsub (frames[30], 1);
+        dcsm::encode_chgu  (frames[31], { { 1, 1, 40, data.data() }, { 2, 100, 40, data.data() } });
+        dcsm::encode_getud (frames[32], 1, 1, 5);
+        dcsm::encode_difu  (frames[33], 1, 6, { { 1, 1, 40, data.data() }, { 1, 100, 40, data.data() } });
+        dcsm::encode_hashu (frames[34], 1, 16);
+        dcsm::encode_hashr (frames[35], 1, 16, std::vector<uint64_t>(16, 7));
+        dcsm::encode_ack   (frames[36], 1, 4096, dcsm::dispatch_status::success);
+
+        return frames;
+    }
+};
+
+TEST(allocation, dispatch_construction) {
+    allocation_interface itf;
+
+    EXPECT_EQ(allocation::count_during([&] {
+        dcsm::dispatch dsp(itf);
+    }), 0);
+}
+
+TEST_F(allocation_fixture, direct_messages) {
+    auto const frames = direct_control_frames();
+
+    for (auto const& frame : frames) {
+        dcsm::message_header header{};
+        memcpy(&header, frame.data() + 1, sizeof(header));
+
+        EXPECT_EQ(allocation::count_during([&] {
+            dsp.process_message(frame.data());
+        }), 0) << "opcode 0x" << std::hex << header.opcode;
+    }
+}
+
+TEST_F(allocation_fixture, framing) {
+    std::vector<uint8_t> stream;
+
+    for (auto const& frame : direct_control_frames()) {
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    dcsm::frame_decoder decoder(dsp);
+
+    // Feed in USB-packet-sized pieces, like a device would.
+    EXPECT_EQ(allocation::count_during([&] {
+        for (size_t offset = 0; offset < stream.size(); offset += 64) {
+            decoder.feed(stream.data() + offset, std::min<size_t>(64, stream.size() - offset));
+        }
+    }), 0);
+}
+
+TEST_F(allocation_fixture, commands) {
+    static std::pair<std::string, size_t> const budgets[] {
+        // No address range: no allocations.
+        { "identify",                      0 },
+        { "patches",                       0 },
+        { "masks",                         0 },
+        { "ports",                         0 },
+        { "framerate",                     0 },
+        { "framerate 44",                  0 },
+        { "copy 1 to 2",                   0 },
+        { "patch 1 to 2 mask 3",           0 },
+        { "unpatch 2",                     0 },
+        { "createmask 3",                  0 },
+        { "clearmask 3",                   0 },
+        { "deletemask 3",                  0 },
+        // Address ranges: parsing allocates the range list.
+        { "set 1/20 thru 1/40 @ 50%",      1 },
+        { "set 1/1 thru 1/4 @ 1, 2, 3, 4", 1 },
+        { "mset 2/1 thru 2/16 @ full",     1 },
+        { "get 2/400 thru 2/450",          2 },
+        { "mget 2/1 thru 2/32",            1 },
+    };
+
+    for (auto const& budget : budgets) {
+        // Warm up buffers that are reused between commands.
+        dsp.process_command(budget.first);
+
+        auto const count = allocation::count_during([&] {
+            dsp.process_command(budget.first);
+        });
+        EXPECT_LE(count, budget.second) << budget.first;
+    }
+}
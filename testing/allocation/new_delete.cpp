@@ -0,0 +1,59 @@
+#include <cstdlib>
+#include <new>
+
+#include "allocation_counter.hpp"
+
+static std::atomic<size_t> allocations{ 0 };
+
+size_t allocation::count() noexcept {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+static void* counted_allocate(std::size_t const a_size) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(a_size == 0 ? 1 : a_size);
+}
+
+void* operator new(std::size_t const a_size) {
+    if (void* const pointer = counted_allocate(a_size)) {
+        return pointer;
+    }
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t const a_size) {
+    return operator new(a_size);
+}
+
+void* operator new(std::size_t const a_size, std::nothrow_t const&) noexcept {
+    return counted_allocate(a_size);
+}
+
+void* operator new[](std::size_t const a_size, std::nothrow_t const&) noexcept {
+    return counted_allocate(a_size);
+}
+
+void operator delete(void* const a_pointer) noexcept {
+    std::free(a_pointer);
+}
+
+void operator delete[](void* const a_pointer) noexcept {
+    std::free(a_pointer);
+}
+
+void operator delete(void* const a_pointer, std::size_t) noexcept {
+    std::free(a_pointer);
+}
+
+void operator delete[](void* const a_pointer, std::size_t) noexcept {
+    std::free(a_pointer);
+}
+
+void operator delete(void* const a_pointer, std::nothrow_t const&) noexcept {
+    std::free(a_pointer);
+}
+
+void operator delete[](void* const a_pointer, std::nothrow_t const&) noexcept {
+    std::free(a_pointer);
+}
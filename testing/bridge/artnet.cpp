@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_artnet.hpp>
+#include <dcsm_reference_store.hpp>
+
+namespace {
+    using clock = dcsm::universe_bridge::clock;
+
+    std::vector<uint8_t> packet(uint16_t const a_port_address, uint8_t const a_sequence, std::vector<uint8_t> const& a_data) {
+        std::vector<uint8_t> out;
+        dcsm::append_artdmx(out, a_port_address, a_sequence, a_data.data(), static_cast<uint16_t>(a_data.size()));
+        return out;
+    }
+}
+
+TEST(artnet, parse) {
+    std::vector<uint8_t> data(512);
+    data[0] = 10;
+    data[511] = 20;
+
+    uint16_t const port_address = dcsm::artnet_port_address(3, 2, 1);
+    EXPECT_EQ(port_address, 0x0321);
+
+    auto bytes = packet(port_address, 42, data);
+    ASSERT_EQ(bytes.size(), dcsm::artdmx_max_packet_size);
+
+    dcsm::artdmx_packet parsed{};
+    ASSERT_TRUE(dcsm::parse_artdmx(bytes.data(), bytes.size(), parsed));
+    EXPECT_EQ(parsed.port_address, 0x0321);
+    EXPECT_EQ(parsed.sequence, 42);
+    EXPECT_EQ(parsed.count, 512);
+    EXPECT_EQ(parsed.data, bytes.data() + dcsm::artdmx_header_size); // In place.
+    EXPECT_EQ(parsed.data[511], 20);
+
+    // SubUni and Net as laid out in the ArtDmx packet.
+    EXPECT_EQ(bytes[14], 0x21);
+    EXPECT_EQ(bytes[15], 0x03);
+
+    // Truncated, wrong identifier, another opcode (ArtPoll), too old a protocol.
+    EXPECT_FALSE(dcsm::parse_artdmx(bytes.data(), bytes.size() - 1, parsed));
+
+    auto broken = bytes;
+    broken[0] = 'X';
+    EXPECT_FALSE(dcsm::parse_artdmx(broken.data(), broken.size(), parsed));
+
+    broken = bytes;
+    broken[9] = 0x20;
+    EXPECT_FALSE(dcsm::parse_artdmx(broken.data(), broken.size(), parsed));
+
+    broken = bytes;
+    broken[11] = 13;
+    EXPECT_FALSE(dcsm::parse_artdmx(broken.data(), broken.size(), parsed));
+
+    // Odd lengths are padded when sent, but accepted when received.
+    bytes = packet(0, 0, { 1, 2, 3 });
+    EXPECT_EQ(bytes.size(), dcsm::artdmx_header_size + 4);
+    bytes[17] = 3;
+    ASSERT_TRUE(dcsm::parse_artdmx(bytes.data(), bytes.size(), parsed));
+    EXPECT_EQ(parsed.count, 3);
+}
+
+TEST(artnet, mapping) {
+    dcsm::reference_store store(4);
+    dcsm::dispatch dsp(store);
+
+    dcsm::artnet_bridge bridge(dcsm::universe_bridge::to_dispatch(dsp));
+    bridge.map(dcsm::artnet_port_address(0, 0, 0), 1);
+    bridge.map(dcsm::artnet_port_address(127, 15, 15), 4);
+
+    auto const now = clock::now();
+
+    EXPECT_TRUE(bridge.receive(packet(0, 0, std::vector<uint8_t>(512, 1)).data(), dcsm::artdmx_max_packet_size, now));
+    EXPECT_TRUE(bridge.receive(packet(0x7FFF, 0, std::vector<uint8_t>(512, 4)).data(), dcsm::artdmx_max_packet_size, now));
+    EXPECT_EQ(store.universe(1)[0], 1);
+    EXPECT_EQ(store.universe(4)[511], 4);
+    EXPECT_EQ(bridge.bridge().target(0x7FFF), 4);
+
+    // Unmapped.
+    EXPECT_FALSE(bridge.receive(packet(1, 0, std::vector<uint8_t>(512, 2)).data(), dcsm::artdmx_max_packet_size, now));
+    EXPECT_EQ(bridge.discarded(), 1);
+    EXPECT_EQ(bridge.packets(), 3);
+}
+
+TEST(artnet, sequence) {
+    dcsm::reference_store store(1);
+    dcsm::dispatch dsp(store);
+
+    dcsm::artnet_bridge bridge(dcsm::universe_bridge::to_dispatch(dsp));
+    bridge.map(0, 1);
+
+    auto const now = clock::now();
+    auto const send = [&](uint8_t const a_sequence, uint8_t const a_value) {
+        auto const bytes = packet(0, a_sequence, std::vector<uint8_t>(512, a_value));
+        return bridge.receive(bytes.data(), bytes.size(), now);
+    };
+
+    EXPECT_TRUE(send(10, 1));
+    EXPECT_FALSE(send(9, 2));  // Late.
+    EXPECT_FALSE(send(10, 2)); // Repeated.
+    EXPECT_TRUE(send(11, 3));
+    EXPECT_TRUE(send(0, 4));   // Unsequenced.
+    EXPECT_TRUE(send(100, 5)); // A restarted sender.
+    EXPECT_TRUE(send(255, 6));
+    EXPECT_TRUE(send(1, 7));   // Wrapped.
+    EXPECT_EQ(store.universe(1)[0], 7);
+    EXPECT_EQ(bridge.discarded(), 2);
+}
+
+TEST(artnet, delta) {
+    dcsm::reference_store store(1);
+    dcsm::dispatch dsp(store);
+    std::vector<uint16_t> sizes;
+
+    dcsm::artnet_bridge bridge([&](uint8_t const* a_frame, size_t const a_size) {
+        EXPECT_EQ(dsp.process_message(a_frame), dcsm::dispatch_status::success);
+        sizes.push_back(static_cast<uint16_t>(a_size));
+    });
+    bridge.map(0, 1);
+
+    auto const now = clock::now();
+    std::vector<uint8_t> data(512, 0);
+
+    for (uint8_t frame = 1; frame <= 3; ++frame) {
+        data[frame * 100] = frame;
+        bridge.receive(packet(0, frame, data).data(), dcsm::artdmx_max_packet_size, now);
+    }
+
+    // Three addresses apart: one span each after the first frame.
+    data.assign(512, 9);
+    bridge.receive(packet(0, 4, data).data(), dcsm::artdmx_max_packet_size, now);
+
+    EXPECT_EQ(sizes, (std::vector<uint16_t>{ 5 + 514, 5 + 7, 5 + 7, 5 + 514 }));
+    EXPECT_EQ(bridge.bridge().deltas(), 2);
+    EXPECT_EQ(std::vector<uint8_t>(store.universe(1), store.universe(1) + 512), data);
+}
+
+#if defined(__linux__)
+TEST(artnet, udp_receiver) {
+    dcsm::reference_store store(256);
+    dcsm::dispatch dsp(store);
+
+    dcsm::artnet_bridge bridge(dcsm::universe_bridge::to_dispatch(dsp));
+
+    for (uint16_t i = 0; i < 256; ++i) {
+        bridge.map(i, static_cast<uint16_t>(i + 1));
+    }
+
+    dcsm::artnet_receiver receiver(0, "127.0.0.1");
+    ASSERT_NE(receiver.port(), 0);
+
+    int const sender = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sender, 0);
+
+    sockaddr_in destination{};
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons(receiver.port());
+    ::inet_pton(AF_INET, "127.0.0.1", &destination.sin_addr);
+
+    std::vector<uint8_t> data(512, 0);
+    size_t received = 0;
+
+    for (uint8_t frame = 1; frame <= 4; ++frame) {
+        data[frame] = frame;
+
+        for (uint16_t i = 0; i < 256; ++i) {
+            auto const bytes = packet(i, frame, data);
+            ::sendto(sender, bytes.data(), bytes.size(), 0, reinterpret_cast<sockaddr const*>(&destination), sizeof(destination));
+        }
+
+        for (size_t attempt = 0; attempt < 10 && received < frame * 256u; ++attempt) {
+            received += receiver.poll(bridge, 100);
+        }
+    }
+
+    ::close(sender);
+
+    EXPECT_EQ(received, 4 * 256);
+    EXPECT_EQ(bridge.bridge().forwarded(), 4 * 256);
+    EXPECT_EQ(bridge.bridge().deltas(), 3 * 256);
+    EXPECT_EQ(store.universe(1)[4], 4);
+    EXPECT_EQ(store.universe(256)[4], 4);
+}
+#endif
@@ -0,0 +1,250 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_reference_store.hpp>
+#include <dcsm_sacn.hpp>
+
+namespace {
+    using clock = dcsm::universe_bridge::clock;
+
+    /// Applies forwarded frames to a store and records the universe after each.
+    struct forwarded_universes {
+        dcsm::reference_store store{ 16 };
+        dcsm::dispatch dsp{ store };
+        std::vector<std::pair<uint16_t, std::array<uint8_t, 512>>> calls;
+        std::vector<dcsm::opcode> opcodes;
+
+        dcsm::universe_bridge::output output() {
+            return [this](uint8_t const* a_frame, size_t const a_size) {
+                EXPECT_EQ(dsp.process_message(a_frame), dcsm::dispatch_status::success);
+
+                // setu and setsp both start with a universe number.
+                auto const universe = dcsm::bit_cast<uint16_t>(a_frame + dcsm::message_header_size);
+                calls.emplace_back(universe, std::array<uint8_t, 512>{});
+                std::memcpy(calls.back().second.data(), store.universe(universe), 512);
+                opcodes.push_back(static_cast<dcsm::opcode>(dcsm::bit_cast<uint16_t>(a_frame + 1)));
+            };
+        }
+    };
+
+    dcsm::sacn_source make_source(uint8_t const a_id, uint8_t const a_priority = 100) {
+        dcsm::sacn_source source;
+        source.cid.fill(a_id);
+        source.name = "source " + std::to_string(a_id);
+        source.priority = a_priority;
+        return source;
+    }
+
+    std::vector<uint8_t> packet(dcsm::sacn_source const& a_source, uint16_t const a_universe, uint8_t const a_sequence, std::vector<uint8_t> const& a_data, uint8_t const a_options = 0) {
+        std::vector<uint8_t> out;
+        dcsm::append_sacn(out, a_source, a_universe, a_sequence, a_data.data(), static_cast<uint16_t>(a_data.size()), a_options);
+        return out;
+    }
+}
+
+TEST(sacn, parse) {
+    std::vector<uint8_t> data(512);
+    data[0] = 10;
+    data[511] = 20;
+
+    auto const source = make_source(7, 150);
+    auto bytes = packet(source, 1234, 42, data);
+
+    ASSERT_EQ(bytes.size(), dcsm::sacn_max_packet_size);
+
+    dcsm::sacn_packet parsed{};
+    ASSERT_TRUE(dcsm::parse_sacn(bytes.data(), bytes.size(), parsed));
+    EXPECT_EQ(parsed.universe, 1234);
+    EXPECT_EQ(parsed.priority, 150);
+    EXPECT_EQ(parsed.sequence, 42);
+    EXPECT_EQ(parsed.start_code, 0);
+    EXPECT_EQ(parsed.count, 512);
+    EXPECT_EQ(parsed.data, bytes.data() + dcsm::sacn_header_size); // In place.
+    EXPECT_EQ(parsed.data[511], 20);
+    EXPECT_EQ(std::string(parsed.source_name), "source 7");
+    EXPECT_EQ(parsed.cid[15], 7);
+
+    // Root layer length of a full packet, as in E1.31 Table 4-1.
+    EXPECT_EQ(bytes[16], 0x72);
+    EXPECT_EQ(bytes[17], 0x6E);
+
+    // Truncated, wrong identifier, discovery packet, out of range universe.
+    EXPECT_FALSE(dcsm::parse_sacn(bytes.data(), bytes.size() - 1, parsed));
+
+    auto broken = bytes;
+    broken[4] = 'X';
+    EXPECT_FALSE(dcsm::parse_sacn(broken.data(), broken.size(), parsed));
+
+    broken = bytes;
+    broken[21] = 0x08;
+    EXPECT_FALSE(dcsm::parse_sacn(broken.data(), broken.size(), parsed));
+
+    broken = packet(source, 64000, 0, data);
+    EXPECT_FALSE(dcsm::parse_sacn(broken.data(), broken.size(), parsed));
+
+    // Short universes.
+    bytes = packet(source, 1, 0, { 1, 2, 3 });
+    ASSERT_TRUE(dcsm::parse_sacn(bytes.data(), bytes.size(), parsed));
+    EXPECT_EQ(parsed.count, 3);
+}
+
+TEST(sacn, change_suppression) {
+    forwarded_universes forwarded;
+    dcsm::sacn_bridge bridge(forwarded.output());
+    bridge.map(1, 10);
+
+    auto const source = make_source(1);
+    auto const start = clock::now();
+    std::vector<uint8_t> data(512, 0);
+    uint8_t sequence = 0;
+
+    auto const send = [&](std::chrono::milliseconds const a_at) {
+        auto const bytes = packet(source, 1, sequence++, data);
+        return bridge.receive(bytes.data(), bytes.size(), start + a_at);
+    };
+
+    EXPECT_TRUE(send(std::chrono::milliseconds(0)));
+    EXPECT_FALSE(send(std::chrono::milliseconds(25)));  // Unchanged.
+    data[300] = 1;
+    EXPECT_TRUE(send(std::chrono::milliseconds(50)));
+    EXPECT_FALSE(send(std::chrono::milliseconds(75)));
+
+    // Unchanged, but the keep-alive is due.
+    EXPECT_TRUE(send(std::chrono::milliseconds(1100)));
+
+    ASSERT_EQ(forwarded.calls.size(), 3);
+    EXPECT_EQ(forwarded.calls[0].first, 10);
+    EXPECT_EQ(forwarded.calls[1].second[300], 1);
+
+    // The single changed address went as setsp, the keep-alive as setu.
+    EXPECT_EQ(forwarded.opcodes, (std::vector<dcsm::opcode>{ dcsm::opcode::setu, dcsm::opcode::setsp, dcsm::opcode::setu }));
+    EXPECT_EQ(bridge.bridge().deltas(), 1);
+    EXPECT_EQ(bridge.bridge().suppressed(), 2);
+
+    // Keep-alive without packets, e.g. once the source stopped.
+    EXPECT_EQ(bridge.tick(start + std::chrono::milliseconds(1500)), 0);
+    EXPECT_EQ(bridge.tick(start + std::chrono::milliseconds(2200)), 1);
+
+    // A shorter universe zeroes the rest.
+    data.assign(10, 1);
+    EXPECT_TRUE(send(std::chrono::milliseconds(2300)));
+    EXPECT_EQ(forwarded.calls.back().second[9], 1);
+    EXPECT_EQ(forwarded.calls.back().second[300], 0);
+
+    // Unmapped universes are ignored.
+    auto const other = packet(source, 2, 0, data);
+    EXPECT_FALSE(bridge.receive(other.data(), other.size(), start));
+    EXPECT_EQ(bridge.discarded(), 1);
+}
+
+TEST(sacn, priority) {
+    forwarded_universes forwarded;
+    dcsm::sacn_bridge bridge(forwarded.output());
+    bridge.map(1, 1);
+
+    auto const start = clock::now();
+    auto const low  = make_source(1, 100);
+    auto const high = make_source(2, 120);
+
+    EXPECT_TRUE(bridge.receive(packet(low, 1, 0, std::vector<uint8_t>(512, 1)).data(), dcsm::sacn_max_packet_size, start));
+    EXPECT_TRUE(bridge.receive(packet(high, 1, 0, std::vector<uint8_t>(512, 2)).data(), dcsm::sacn_max_packet_size, start));
+    EXPECT_FALSE(bridge.receive(packet(low, 1, 1, std::vector<uint8_t>(512, 3)).data(), dcsm::sacn_max_packet_size, start));
+    EXPECT_EQ(bridge.source_count(1), 2);
+    EXPECT_EQ(forwarded.calls.back().second[0], 2);
+
+    // The high priority source terminates: the low one takes over with its next packet.
+    EXPECT_FALSE(bridge.receive(packet(high, 1, 1, std::vector<uint8_t>(512, 2), 0x40).data(), dcsm::sacn_max_packet_size, start));
+    EXPECT_TRUE(bridge.receive(packet(low, 1, 2, std::vector<uint8_t>(512, 4)).data(), dcsm::sacn_max_packet_size, start));
+    EXPECT_EQ(forwarded.calls.back().second[0], 4);
+
+    // Out of sequence: discarded.
+    EXPECT_FALSE(bridge.receive(packet(low, 1, 1, std::vector<uint8_t>(512, 5)).data(), dcsm::sacn_max_packet_size, start));
+
+    // Equal priority: the first source wins.
+    auto const second = make_source(3, 100);
+    EXPECT_FALSE(bridge.receive(packet(second, 1, 0, std::vector<uint8_t>(512, 6)).data(), dcsm::sacn_max_packet_size, start));
+
+    // Timed out: the second source takes over.
+    auto const later = start + std::chrono::seconds(3);
+    EXPECT_TRUE(bridge.receive(packet(second, 1, 1, std::vector<uint8_t>(512, 6)).data(), dcsm::sacn_max_packet_size, later));
+    EXPECT_EQ(bridge.source_count(1), 1);
+
+    // Preview data and other start codes are not forwarded.
+    auto preview = packet(second, 1, 2, std::vector<uint8_t>(512, 7), 0x80);
+    EXPECT_FALSE(bridge.receive(preview.data(), preview.size(), later));
+
+    auto per_address_priority = packet(second, 1, 3, std::vector<uint8_t>(512, 7));
+    per_address_priority[dcsm::sacn_header_size - 1] = 0xDD;
+    EXPECT_FALSE(bridge.receive(per_address_priority.data(), per_address_priority.size(), later));
+    EXPECT_EQ(forwarded.calls.back().second[0], 6);
+}
+
+TEST(sacn, htp) {
+    forwarded_universes forwarded;
+    dcsm::sacn_options options;
+    options.merge = dcsm::sacn_merge::htp;
+
+    dcsm::sacn_bridge bridge(forwarded.output(), options);
+    bridge.map(1, 1);
+
+    auto const start = clock::now();
+    std::vector<uint8_t> a(512, 0);
+    std::vector<uint8_t> b(512, 0);
+    a[0] = 200;
+    a[1] = 10;
+    b[1] = 50;
+
+    bridge.receive(packet(make_source(1), 1, 0, a).data(), dcsm::sacn_max_packet_size, start);
+    bridge.receive(packet(make_source(2), 1, 0, b).data(), dcsm::sacn_max_packet_size, start);
+
+    ASSERT_EQ(forwarded.calls.size(), 2);
+    EXPECT_EQ(forwarded.calls.back().second[0], 200);
+    EXPECT_EQ(forwarded.calls.back().second[1], 50);
+}
+
+#if defined(__linux__)
+TEST(sacn, udp_receiver) {
+    dcsm::reference_store store(4);
+    dcsm::dispatch dsp(store);
+
+    dcsm::sacn_bridge bridge(dcsm::universe_bridge::to_dispatch(dsp));
+    bridge.map(5, 2);
+
+    dcsm::sacn_receiver receiver(0, "127.0.0.1");
+    ASSERT_NE(receiver.port(), 0);
+
+    int const sender = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sender, 0);
+
+    sockaddr_in destination{};
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons(receiver.port());
+    ::inet_pton(AF_INET, "127.0.0.1", &destination.sin_addr);
+
+    auto const source = make_source(9);
+    std::vector<uint8_t> data(512, 0);
+    size_t received = 0;
+
+    for (uint8_t frame = 0; frame < 50; ++frame) {
+        data[frame] = 255;
+        auto const bytes = packet(source, 5, static_cast<uint8_t>(frame * 2), data);
+        ::sendto(sender, bytes.data(), bytes.size(), 0, reinterpret_cast<sockaddr const*>(&destination), sizeof(destination));
+
+        // An unchanged repeat.
+        auto const repeat = packet(source, 5, static_cast<uint8_t>(frame * 2 + 1), data);
+        ::sendto(sender, repeat.data(), repeat.size(), 0, reinterpret_cast<sockaddr const*>(&destination), sizeof(destination));
+
+        for (size_t attempt = 0; attempt < 10 && received < (frame + 1) * 2u; ++attempt) {
+            received += receiver.poll(bridge, 100);
+        }
+    }
+
+    ::close(sender);
+
+    EXPECT_EQ(received, 100);
+    EXPECT_EQ(bridge.bridge().forwarded(), 50);
+    EXPECT_EQ(bridge.bridge().suppressed(), 50);
+    EXPECT_EQ(store.universe(2)[49], 255);
+    EXPECT_EQ(store.universe(2)[50], 0);
+}
+#endif
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include <dcsm.hpp>
+#include <dcsm_capture.hpp>
+
+struct capture_interface final : dcsm::dispatch_interface {
+    size_t getu = 0;
+    size_t setutv = 0;
+
+    void dcsm_getu(dcsm::command_context &a_ctx, uint16_t const a_universe) override {
+        ++getu;
+        EXPECT_EQ(a_universe, 7);
+    }
+
+    void dcsm_setutv(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const a_value, dcsm::universe_mask const &a_mask) override {
+        ++setutv;
+    }
+};
+
+TEST(capture, record_and_replay) {
+    std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+
+    capture_interface recorded_itf;
+    dcsm::dispatch recorded_dsp(recorded_itf);
+
+    {
+        dcsm::capture_writer writer(stream);
+        recorded_dsp.set_capture(&writer);
+
+        uint8_t getu[5 + 2] { 0x00 };
+        dcsm::message_header const header { 0x0004, 2 };
+        uint16_t const universe = 7;
+        memcpy(getu + 1, &header, sizeof(header));
+        memcpy(getu + 5, &universe, sizeof(universe));
+
+        recorded_dsp.process_message(getu);
+        recorded_dsp.process_command("set 1 thru 10 @ full; set 1/1 thru 2/1 @ out");
+        recorded_dsp.process_message(getu);
+
+        recorded_dsp.set_capture(nullptr);
+        recorded_dsp.process_message(getu); // Not captured.
+    }
+
+    dcsm::capture_reader reader(stream);
+    ASSERT_TRUE(reader.valid());
+
+    auto const frames = reader.read_all();
+    ASSERT_EQ(frames.size(), 3);
+
+    EXPECT_EQ(frames[0].kind, dcsm::capture_kind::message);
+    EXPECT_EQ(frames[0].data.size(), 7);
+    EXPECT_EQ(frames[1].kind, dcsm::capture_kind::command);
+    EXPECT_EQ(std::string(frames[1].data.begin(), frames[1].data.end()), "set 1 thru 10 @ full; set 1/1 thru 2/1 @ out");
+    EXPECT_LE(frames[0].timestamp, frames[1].timestamp);
+    EXPECT_LE(frames[1].timestamp, frames[2].timestamp);
+
+    capture_interface replayed_itf;
+    dcsm::dispatch replayed_dsp(replayed_itf);
+
+    auto const result = dcsm::replay_capture(replayed_dsp, frames, false);
+
+    EXPECT_EQ(result.frames, 3);
+    EXPECT_EQ(result.failures, 0);
+    EXPECT_EQ(result.latency.size(), 3);
+    EXPECT_EQ(replayed_itf.getu, 2);
+    EXPECT_EQ(replayed_itf.setutv, 3);
+}
+
+TEST(capture, rejects_foreign_data) {
+    std::stringstream stream("not a capture", std::ios::in | std::ios::binary);
+    dcsm::capture_reader reader(stream);
+
+    EXPECT_FALSE(reader.valid());
+}
+
+TEST(capture, rejects_corrupt_records) {
+    std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+
+    {
+        dcsm::capture_writer writer(stream);
+
+        // A getu cut short: the header announces a 2-byte body, one byte is there.
+        uint8_t truncated[5 + 1] { 0x00 };
+        dcsm::message_header const header { 0x0004, 2 };
+        memcpy(truncated + 1, &header, sizeof(header));
+        writer.write(0, dcsm::capture_kind::message, truncated, sizeof(truncated));
+
+        // One byte too many.
+        uint8_t padded[5 + 3] { 0x00 };
+        memcpy(padded + 1, &header, sizeof(header));
+        writer.write(0, dcsm::capture_kind::message, padded, sizeof(padded));
+    }
+
+    // A record claiming far more than any frame.
+    uint8_t const oversized[] = { 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F };
+    stream.write(reinterpret_cast<char const*>(oversized), sizeof(oversized));
+
+    dcsm::capture_reader reader(stream);
+    ASSERT_TRUE(reader.valid());
+
+    auto const frames = reader.read_all();
+    ASSERT_EQ(frames.size(), 2);
+    EXPECT_FALSE(reader.valid());
+
+    capture_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    auto const result = dcsm::replay_capture(dsp, frames, false);
+
+    EXPECT_EQ(result.failures, 2);
+    EXPECT_EQ(itf.getu, 0);
+}
@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_changes.hpp>
+#include <dcsm_encoder.hpp>
+
+#include <random>
+
+/// Device: keeps universes and reports changes to subscribers through a change_tracker.
+struct notifying_device final : dcsm::dispatch_interface {
+    std::array<std::array<uint8_t, 512>, 16> universes{};
+    dcsm::change_tracker changes;
+
+    void dcsm_setu(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const *a_data) override {
+        memcpy(universes[a_universe - 1].data(), a_data, 512);
+        changes.update(a_universe, a_data);
+    }
+
+    void dcsm_sub(dcsm::command_context &a_ctx, uint16_t const a_universe) override {
+        changes.subscribe(a_universe, universes[a_universe - 1].data());
+    }
+
+    void dcsm_unsub(dcsm::command_context &a_ctx, uint16_t const a_universe) override {
+        changes.unsubscribe(a_universe);
+    }
+};
+
+/// Host: mirrors subscribed universes from the notifications alone.
+struct mirroring_host final : dcsm::dispatch_interface {
+    std::array<std::array<uint8_t, 512>, 16> universes{};
+    std::vector<dcsm::universe_span> last_spans;
+    size_t notifications = 0;
+
+    void dcsm_chgu(dcsm::command_context &a_ctx, std::vector<dcsm::universe_span> const &a_spans) override {
+        last_spans = a_spans;
+        ++notifications;
+
+        for (auto const& span : a_spans) {
+            memcpy(universes[span.universe - 1].data() + span.start - 1, span.data, span.count);
+        }
+    }
+};
+
+TEST(change_tracker, notifications) {
+    notifying_device device;
+    dcsm::dispatch device_dsp(device);
+
+    mirroring_host host;
+    dcsm::dispatch host_dsp(host);
+    dcsm::frame_decoder host_decoder(host_dsp);
+
+    device.universes[2][10] = 40;
+
+    std::vector<uint8_t> to_device;
+    dcsm::encode_sub(to_device, 3);
+    EXPECT_EQ(device_dsp.process_message(to_device.data()), dcsm::dispatch_status::success);
+    EXPECT_TRUE(device.changes.subscribed(3));
+
+    // Full contents first.
+    std::vector<uint8_t> to_host;
+    EXPECT_EQ(device.changes.flush(to_host), 1);
+    host_decoder.feed(to_host.data(), to_host.size());
+    EXPECT_EQ(host.universes[2], device.universes[2]);
+
+    // Nothing changed: nothing sent.
+    to_host.clear();
+    EXPECT_EQ(device.changes.flush(to_host), 0);
+    EXPECT_TRUE(to_host.empty());
+
+    // Coalesced within a frame: the latest value once, changes that were undone not at all.
+    std::array<uint8_t, 512> data = device.universes[2];
+    uint8_t const original = data[401];
+
+    for (uint8_t value = 1; value <= 5; ++value) {
+        data[100] = value;
+        data[103] = value;
+        data[300] = value;
+        data[400] = value;
+        data[401] = value == 5 ? original : value;
+        to_device.clear();
+        dcsm::encode_setu(to_device, 3, data.data());
+        device_dsp.process_message(to_device.data());
+    }
+
+    EXPECT_EQ(device.changes.flush(to_host), 1);
+    host_decoder.feed(to_host.data(), to_host.size());
+    EXPECT_EQ(host.universes[2], device.universes[2]);
+
+    // 101 and 104 share a span; 301 and 401 are apart.
+    ASSERT_EQ(host.last_spans.size(), 3);
+    EXPECT_EQ(host.last_spans[0].start, 101);
+    EXPECT_EQ(host.last_spans[0].count, 4);
+    EXPECT_EQ(host.last_spans[1].start, 301);
+    EXPECT_EQ(host.last_spans[1].count, 1);
+    EXPECT_EQ(host.last_spans[2].start, 401);
+    EXPECT_EQ(host.last_spans[2].count, 1);
+
+    // Unsubscribed universes are not reported.
+    to_device.clear();
+    dcsm::encode_unsub(to_device, 3);
+    device_dsp.process_message(to_device.data());
+
+    data[0] = 1;
+    to_device.clear();
+    dcsm::encode_setu(to_device, 3, data.data());
+    device_dsp.process_message(to_device.data());
+
+    to_host.clear();
+    EXPECT_EQ(device.changes.flush(to_host), 0);
+    EXPECT_EQ(device.changes.subscription_count(), 0);
+}
+
+TEST(change_tracker, mirror) {
+    dcsm::change_tracker changes;
+    std::array<std::array<uint8_t, 512>, 16> universes{};
+
+    mirroring_host host;
+    dcsm::dispatch host_dsp(host);
+
+    std::mt19937 random(3);
+    std::vector<uint8_t> to_host;
+
+    for (uint16_t universe = 1; universe <= 16; ++universe) {
+        changes.subscribe(universe, universes[universe - 1].data());
+    }
+
+    for (size_t frame = 0; frame < 200; ++frame) {
+        // A few input changes per frame, as from a DMX input port.
+        for (size_t change = random() % 4; change != 0; --change) {
+            auto& data = universes[random() % 16];
+            uint16_t const start = static_cast<uint16_t>(1 + random() % 500);
+            uint16_t const count = static_cast<uint16_t>(1 + random() % 12);
+
+            for (uint16_t i = 0; i < count; ++i) {
+                data[start - 1 + i] = static_cast<uint8_t>(random());
+            }
+
+            auto const universe = static_cast<uint16_t>(&data - universes.data() + 1);
+            changes.update(universe, start, count, data.data() + start - 1);
+        }
+
+        to_host.clear();
+        changes.flush(to_host);
+
+        // Traffic scales with the amount of change: far below a getu of every universe.
+        EXPECT_LT(to_host.size(), frame == 0 ? 16 * 530 : 512);
+
+        for (size_t offset = 0; offset < to_host.size();) {
+            dcsm::message_header header{};
+            memcpy(&header, to_host.data() + offset + 1, sizeof(header));
+            EXPECT_EQ(host_dsp.process_message(to_host.data() + offset), dcsm::dispatch_status::success);
+            offset += dcsm::message_header_size + header.length;
+        }
+
+        ASSERT_EQ(host.universes, universes) << "frame " << frame;
+    }
+}
+
+TEST(change_tracker, large_flush) {
+    dcsm::change_tracker changes;
+    std::array<uint8_t, 512> data{};
+
+    for (uint16_t universe = 1; universe <= 300; ++universe) {
+        changes.subscribe(universe, data.data());
+    }
+
+    std::vector<uint8_t> out;
+    size_t const messages = changes.flush(out);
+
+    // 300 full universes do not fit one message.
+    EXPECT_EQ(messages, 3);
+
+    struct counting_host final : dcsm::dispatch_interface {
+        size_t universes = 0;
+
+        void dcsm_chgu(dcsm::command_context &a_ctx, std::vector<dcsm::universe_span> const &a_spans) override {
+            universes += a_spans.size();
+        }
+    } host;
+
+    dcsm::dispatch dsp(host);
+    dcsm::frame_decoder decoder(dsp);
+
+    EXPECT_EQ(decoder.feed(out.data(), out.size()), 3);
+    EXPECT_EQ(host.universes, 300);
+}
@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_changes.hpp>
+#include <dcsm_encoder.hpp>
+
+#include <random>
+
+TEST(differential_readback, diff_universe) {
+    std::mt19937 random(17);
+    std::array<uint8_t, 520> lhs{};
+    std::array<uint8_t, 520> rhs{};
+
+    for (size_t round = 0; round < 200; ++round) {
+        for (auto& byte : lhs) {
+            byte = static_cast<uint8_t>(random());
+        }
+
+        rhs = lhs;
+
+        for (size_t change = random() % 40; change != 0; --change) {
+            rhs[random() % rhs.size()] ^= static_cast<uint8_t>(1 + random() % 255);
+        }
+
+        // Any alignment.
+        size_t const offset = random() % 8;
+
+        dcsm::universe_diff expected{};
+
+        for (size_t i = 0; i < 512; ++i) {
+            expected[i / 64] |= static_cast<uint64_t>(lhs[offset + i] != rhs[offset + i]) << (i % 64);
+        }
+
+        ASSERT_EQ(dcsm::diff_universe(lhs.data() + offset, rhs.data() + offset), expected) << round;
+        ASSERT_EQ(dcsm::diff_universe_portable(lhs.data() + offset, rhs.data() + offset), expected) << round;
+
+        size_t const size = random() % 513;
+        ASSERT_EQ(dcsm::equal_bytes(lhs.data() + offset, rhs.data() + offset, size), std::memcmp(lhs.data() + offset, rhs.data() + offset, size) == 0) << round;
+    }
+
+    // Spans merge across short gaps only.
+    dcsm::universe_diff changed{};
+
+    for (size_t const i : { 0, 3, 63, 64, 200, 511 }) {
+        changed[i / 64] |= uint64_t{ 1 } << (i % 64);
+    }
+
+    std::vector<dcsm::universe_span> spans;
+    dcsm::append_changed_spans(spans, 9, lhs.data(), changed, 6);
+
+    ASSERT_EQ(spans.size(), 4);
+    EXPECT_EQ(spans[0].start, 1);
+    EXPECT_EQ(spans[0].count, 4);
+    EXPECT_EQ(spans[1].start, 64);
+    EXPECT_EQ(spans[1].count, 2);
+    EXPECT_EQ(spans[2].start, 201);
+    EXPECT_EQ(spans[3].start, 512);
+    EXPECT_EQ(spans[3].count, 1);
+    EXPECT_EQ(spans[3].data, lhs.data() + 511);
+}
+
+/// Device: answers getud from its universes.
+struct readback_device final : dcsm::dispatch_interface {
+    std::array<std::array<uint8_t, 512>, 4> universes{};
+    dcsm::differential_readback readback;
+    std::vector<uint8_t> replies;
+
+    explicit readback_device(size_t const a_capacity = 64) :
+        readback(a_capacity)
+    {}
+
+    void dcsm_getud(dcsm::command_context &a_ctx, uint16_t const a_universe, uint16_t const a_session, uint32_t const a_generation) override {
+        readback.reply(replies, a_universe, a_session, a_generation, universes[a_universe - 1].data());
+    }
+};
+
+/// Host: mirrors a universe from difu replies.
+struct readback_host final : dcsm::dispatch_interface {
+    std::array<std::array<uint8_t, 512>, 4> universes{};
+    std::array<uint32_t, 4> generations{};
+    size_t last_span_count = 0;
+
+    void dcsm_difu(dcsm::command_context &a_ctx, uint16_t const a_universe, uint32_t const a_generation, std::vector<dcsm::universe_span> const &a_spans) override {
+        for (auto const& span : a_spans) {
+            memcpy(universes[a_universe - 1].data() + span.start - 1, span.data, span.count);
+        }
+
+        generations[a_universe - 1] = a_generation;
+        last_span_count = a_spans.size();
+    }
+};
+
+/// Send a getud from a_host to a_device and deliver the reply; returns the size of the reply.
+static size_t poll(readback_device& a_device, readback_host& a_host, uint16_t const a_universe, uint16_t const a_session, bool const a_deliver = true) {
+    dcsm::dispatch device_dsp(a_device);
+    dcsm::dispatch host_dsp(a_host);
+
+    std::vector<uint8_t> request;
+    dcsm::encode_getud(request, a_universe, a_session, a_host.generations[a_universe - 1]);
+    EXPECT_EQ(device_dsp.process_message(request.data()), dcsm::dispatch_status::success);
+
+    size_t const size = a_device.replies.size();
+
+    if (a_deliver) {
+        EXPECT_EQ(host_dsp.process_message(a_device.replies.data()), dcsm::dispatch_status::success);
+    }
+
+    a_device.replies.clear();
+    return size;
+}
+
+TEST(differential_readback, sync) {
+    readback_device device;
+    readback_host host;
+
+    device.universes[0][7] = 70;
+
+    // First request: the whole universe.
+    EXPECT_EQ(poll(device, host, 1, 1), dcsm::message_header_size + 6 + 4 + 512);
+    EXPECT_EQ(host.universes[0], device.universes[0]);
+    EXPECT_NE(host.generations[0], 0);
+
+    // Idle: an empty reply, and the generation holds.
+    uint32_t const generation = host.generations[0];
+    EXPECT_EQ(poll(device, host, 1, 1), dcsm::message_header_size + 6);
+    EXPECT_EQ(host.last_span_count, 0);
+    EXPECT_EQ(host.generations[0], generation);
+
+    // Only the changes.
+    device.universes[0][100] = 1;
+    device.universes[0][102] = 2;
+    device.universes[0][400] = 3;
+    EXPECT_EQ(poll(device, host, 1, 1), dcsm::message_header_size + 6 + 4 + 3 + 4 + 1);
+    EXPECT_EQ(host.last_span_count, 2);
+    EXPECT_EQ(host.universes[0], device.universes[0]);
+    EXPECT_NE(host.generations[0], generation);
+
+    // A lost reply: the next request carries a stale generation and gets everything again.
+    device.universes[0][5] = 9;
+    poll(device, host, 1, 1, false);
+    device.universes[0][6] = 9;
+    EXPECT_EQ(poll(device, host, 1, 1), dcsm::message_header_size + 6 + 4 + 512);
+    EXPECT_EQ(host.universes[0], device.universes[0]);
+}
+
+TEST(differential_readback, sessions) {
+    readback_device device(2);
+    readback_host first;
+    readback_host second;
+
+    poll(device, first, 1, 1);
+    poll(device, second, 1, 2);
+    EXPECT_EQ(device.readback.shadow_count(), 2);
+
+    // Each session gets the changes since its own last reply.
+    device.universes[0][0] = 1;
+    poll(device, first, 1, 1);
+    EXPECT_EQ(first.last_span_count, 1);
+    EXPECT_EQ(first.universes[0], device.universes[0]);
+
+    device.universes[0][300] = 1;
+    poll(device, second, 1, 2);
+    EXPECT_EQ(second.last_span_count, 2);
+    EXPECT_EQ(second.universes[0], device.universes[0]);
+
+    // A generation from another session does not match.
+    second.generations[0] = first.generations[0];
+    EXPECT_EQ(poll(device, second, 1, 2), dcsm::message_header_size + 6 + 4 + 512);
+
+    // A third shadow evicts the least recently used, session 1's.
+    poll(device, second, 2, 2);
+    EXPECT_EQ(device.readback.shadow_count(), 2);
+    EXPECT_EQ(poll(device, first, 1, 1), dcsm::message_header_size + 6 + 4 + 512);
+
+    device.readback.end_session(2);
+    EXPECT_EQ(device.readback.shadow_count(), 1);
+}
+
+TEST(differential_readback, malformed) {
+    readback_host host;
+    dcsm::dispatch dsp(host);
+
+    std::array<uint8_t, 512> data{};
+    std::vector<uint8_t> reply;
+    dcsm::encode_difu(reply, 1, 5, { { 1, 500, 14, data.data() } });
+
+    // Span past the end of the universe.
+    EXPECT_EQ(dsp.process_message(reply.data()), dcsm::dispatch_status::invalid_body_size);
+
+    // Truncated span header.
+    reply.clear();
+    dcsm::encode_difu(reply, 1, 5, {});
+    reply.push_back(1);
+    reply[3] = 7;
+    EXPECT_EQ(dsp.process_message(reply.data()), dcsm::dispatch_status::invalid_body_size);
+    EXPECT_EQ(host.generations[0], 0);
+}
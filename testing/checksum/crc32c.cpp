@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+#include <dcsm_flow.hpp>
+
+#include <random>
+
+TEST(checksum, crc32c) {
+    std::string const check = "123456789";
+    auto const* const data = reinterpret_cast<uint8_t const*>(check.data());
+
+    EXPECT_EQ(dcsm::crc32c(data, check.size()), 0xE3069283);
+    EXPECT_EQ(dcsm::crc32c_portable(data, check.size()), 0xE3069283);
+    EXPECT_EQ(dcsm::crc32c(data, 0), 0);
+
+    // In pieces.
+    EXPECT_EQ(dcsm::crc32c(data + 4, 5, dcsm::crc32c(data, 4)), 0xE3069283);
+    EXPECT_EQ(dcsm::crc32c_portable(data + 4, 5, dcsm::crc32c_portable(data, 4)), 0xE3069283);
+
+    // Both paths agree for every length and alignment.
+    std::mt19937 random(11);
+    std::vector<uint8_t> bytes(600);
+
+    for (auto& byte : bytes) {
+        byte = static_cast<uint8_t>(random());
+    }
+
+    for (size_t offset = 0; offset < 8; ++offset) {
+        for (size_t size = 0; size < 530; size += 1 + size / 16) {
+            ASSERT_EQ(dcsm::crc32c(bytes.data() + offset, size), dcsm::crc32c_portable(bytes.data() + offset, size)) << offset << ", " << size;
+        }
+    }
+}
+
+struct checksum_interface final : dcsm::dispatch_interface {
+    std::vector<uint16_t> universes;
+    std::vector<std::pair<uint16_t, dcsm::dispatch_status>> acks;
+
+    void dcsm_setu(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const *a_data) override {
+        universes.push_back(a_universe);
+    }
+
+    void dcsm_ack(dcsm::command_context &a_ctx, uint16_t const a_sequence, dcsm::dispatch_status const a_status) override {
+        acks.emplace_back(a_sequence, a_status);
+    }
+};
+
+TEST(checksum, dispatch) {
+    checksum_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    std::array<uint8_t, 512> data{};
+
+    std::vector<uint8_t> frame;
+    dcsm::encode_setu(frame, 1, data.data());
+    dcsm::append_checksum(frame, 0);
+
+    ASSERT_EQ(frame.size(), dcsm::message_header_size + 514 + 4);
+    EXPECT_EQ(frame[0], dcsm::frame_flag_checksummed);
+    EXPECT_EQ(dsp.process_message(frame.data()), dcsm::dispatch_status::success);
+
+    // Corrupted body, then corrupted trailer.
+    frame[300] ^= 0x10;
+    EXPECT_EQ(dsp.process_message(frame.data()), dcsm::dispatch_status::checksum_mismatch);
+    frame[300] ^= 0x10;
+    frame.back() ^= 0x01;
+    EXPECT_EQ(dsp.process_message(frame.data()), dcsm::dispatch_status::checksum_mismatch);
+
+    EXPECT_EQ(itf.universes, std::vector<uint16_t>{ 1 });
+    EXPECT_TRUE(itf.acks.empty());
+}
+
+TEST(checksum, sequenced) {
+    checksum_interface itf;
+    dcsm::dispatch dsp(itf);
+    dcsm::frame_decoder decoder(dsp);
+    dcsm::flow_window window(4096, 0, true);
+
+    std::array<uint8_t, 512> data{};
+    std::vector<uint8_t> frame;
+    std::vector<uint8_t> stream;
+
+    for (uint16_t universe = 1; universe <= 3; ++universe) {
+        frame.clear();
+        dcsm::encode_setu(frame, universe, data.data());
+        window.send(stream, frame.data(), frame.size());
+    }
+
+    // Noise in the body of the second frame: it is dropped along with the one after it.
+    size_t const sequenced_size = frame.size() + 2 + 4;
+    ASSERT_EQ(stream.size(), sequenced_size * 3);
+    stream[sequenced_size + 200] ^= 0xFF;
+
+    EXPECT_EQ(decoder.feed(stream.data(), stream.size()), 3);
+    EXPECT_EQ(itf.universes, std::vector<uint16_t>{ 1 });
+
+    using status = dcsm::dispatch_status;
+    EXPECT_EQ(itf.acks, (std::vector<std::pair<uint16_t, status>>{
+        { 0, status::success },
+        { 0, status::checksum_mismatch },
+        { 0, status::out_of_sequence }
+    }));
+
+    // The host resends from the corrupted frame only.
+    stream.clear();
+
+    for (size_t i = 0; i < itf.acks.size(); ++i) {
+        if (window.acknowledge(itf.acks[i].first, 4096)) {
+            window.resend(stream);
+        }
+    }
+
+    EXPECT_EQ(stream.size(), sequenced_size * 2);
+    EXPECT_EQ(decoder.feed(stream.data(), stream.size()), 2);
+    EXPECT_EQ(itf.universes, (std::vector<uint16_t>{ 1, 2, 3 }));
+}
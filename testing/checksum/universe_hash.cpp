@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+#include <dcsm_reference_store.hpp>
+
+#include <random>
+
+TEST(universe_hash, hash64) {
+    std::mt19937 random(23);
+    std::vector<uint8_t> bytes(1200);
+
+    for (auto& byte : bytes) {
+        byte = static_cast<uint8_t>(random());
+    }
+
+    // Both lane paths agree.
+    auto const& keys = dcsm::hash64_key().values;
+
+    for (size_t offset = 0; offset < 8; ++offset) {
+        uint64_t selected[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+        uint64_t portable[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+        dcsm::hash64_stripe(selected, bytes.data() + offset, keys + offset);
+        dcsm::hash64_stripe_portable(portable, bytes.data() + offset, keys + offset);
+
+        ASSERT_TRUE(std::equal(std::begin(selected), std::end(selected), std::begin(portable))) << offset;
+    }
+
+    // Every single-bit change in a universe changes the hash.
+    uint64_t const hash = dcsm::hash64(bytes.data(), 512);
+
+    for (size_t bit = 0; bit < 512 * 8; ++bit) {
+        bytes[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+        ASSERT_NE(dcsm::hash64(bytes.data(), 512), hash) << bit;
+        bytes[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+    }
+
+    // Swapped stripes and blocks, trailing zeros and seeds all count.
+    std::vector<uint8_t> swapped(bytes);
+    std::swap_ranges(swapped.begin(), swapped.begin() + 64, swapped.begin() + 64);
+    EXPECT_NE(dcsm::hash64(swapped.data(), 512), hash);
+
+    swapped = bytes;
+    std::swap_ranges(swapped.begin(), swapped.begin() + 512, swapped.begin() + 512);
+    EXPECT_NE(dcsm::hash64(swapped.data(), 1024), dcsm::hash64(bytes.data(), 1024));
+
+    std::vector<uint8_t> zeros(100);
+    EXPECT_NE(dcsm::hash64(zeros.data(), 99), dcsm::hash64(zeros.data(), 100));
+    EXPECT_NE(dcsm::hash64(bytes.data(), 512, 1), hash);
+    EXPECT_EQ(dcsm::hash64(bytes.data(), 512), hash);
+}
+
+TEST(universe_hash, state) {
+    dcsm::reference_store device(8);
+    dcsm::reference_store host(8);
+    dcsm::dispatch device_dsp(device);
+    dcsm::dispatch host_dsp(host);
+
+    auto const both = [&](std::string const& a_command) {
+        EXPECT_EQ(device_dsp.process_command(a_command), dcsm::dispatch_status::success);
+        EXPECT_EQ(host_dsp.process_command(a_command), dcsm::dispatch_status::success);
+    };
+
+    both("set 1/1 thru 1/512 @ 10");
+    both("createmask 3");
+    both("mset 3/5 thru 3/6 @ 200");
+    both("patch 1 to 3 mask 3");
+
+    for (uint16_t universe = 1; universe <= 9; ++universe) {
+        EXPECT_EQ(device.hash(universe), host.hash(universe)) << universe;
+    }
+
+    // Data, mask data, masking flags and patches each show up, in the universe they belong to.
+    uint64_t const before = device.hash(3);
+
+    device_dsp.process_command("set 3/1 @ 1");
+    EXPECT_NE(device.hash(3), before);
+    host_dsp.process_command("set 3/1 @ 1");
+    EXPECT_EQ(device.hash(3), host.hash(3));
+
+    device_dsp.process_command("mset 3/7 @ 0");
+    EXPECT_NE(device.hash(3), host.hash(3));
+    host_dsp.process_command("mset 3/7 @ 0");
+    EXPECT_EQ(device.hash(3), host.hash(3));
+
+    device_dsp.process_command("unpatch 3");
+    EXPECT_NE(device.hash(3), host.hash(3));
+    EXPECT_EQ(device.hash(1), host.hash(1));
+}
+
+/// Host: compares hashr replies against its own copy and records the universes that differ.
+struct verifying_host final : dcsm::dispatch_interface {
+    dcsm::reference_store const& mirror;
+    std::vector<uint16_t> differing;
+    bool range_matches = false;
+
+    explicit verifying_host(dcsm::reference_store const& a_mirror) :
+        mirror(a_mirror)
+    {}
+
+    void dcsm_hashr(dcsm::command_context &a_ctx, uint16_t const a_first, uint16_t const a_count, std::vector<uint64_t> const &a_hashes) override {
+        auto const expected = mirror.hashes(a_first, a_count, a_hashes.size() == 1 && a_count > 1);
+
+        if (a_hashes.size() == 1 && a_count > 1) {
+            range_matches = a_hashes[0] == expected[0];
+            return;
+        }
+
+        for (uint16_t i = 0; i < a_count; ++i) {
+            if (a_hashes[i] != expected[i]) {
+                differing.push_back(static_cast<uint16_t>(a_first + i));
+            }
+        }
+    }
+};
+
+/// Device: a reference store that answers hashu.
+struct hashing_device final : dcsm::dispatch_interface {
+    dcsm::reference_store store{ 64 };
+    std::vector<uint8_t> replies;
+
+    void dcsm_hashu(dcsm::command_context &a_ctx, uint16_t const a_first, uint16_t const a_count, bool const a_combined) override {
+        dcsm::encode_hashr(replies, a_first, a_count, store.hashes(a_first, a_count, a_combined));
+    }
+};
+
+TEST(universe_hash, sync_verification) {
+    hashing_device device;
+    dcsm::reference_store mirror(64);
+
+    std::mt19937 random(29);
+
+    for (uint16_t universe = 1; universe <= 64; ++universe) {
+        for (size_t i = 0; i < 512; ++i) {
+            mirror.universe(universe)[i] = device.store.universe(universe)[i] = static_cast<uint8_t>(random());
+        }
+    }
+
+    dcsm::dispatch device_dsp(device);
+    verifying_host host(mirror);
+    dcsm::dispatch host_dsp(host);
+    dcsm::frame_decoder host_decoder(host_dsp);
+
+    auto const verify = [&](bool const a_combined) {
+        std::vector<uint8_t> request;
+        dcsm::encode_hashu(request, 1, 64, a_combined);
+        EXPECT_EQ(device_dsp.process_message(request.data()), dcsm::dispatch_status::success);
+        EXPECT_EQ(host_decoder.feed(device.replies.data(), device.replies.size()), 1);
+        device.replies.clear();
+    };
+
+    // In sync: one combined hash (8 bytes) settles it.
+    verify(true);
+    EXPECT_TRUE(host.range_matches);
+
+    // Out of sync after a reconnect: per-universe hashes name the universes to pull with getu.
+    device.store.universe(7)[100] ^= 1;
+    device.store.universe(40)[0] ^= 1;
+
+    verify(true);
+    EXPECT_FALSE(host.range_matches);
+
+    verify(false);
+    EXPECT_EQ(host.differing, (std::vector<uint16_t>{ 7, 40 }));
+}
+
+TEST(universe_hash, malformed) {
+    dcsm::reference_store mirror(1);
+    verifying_host host(mirror);
+    dcsm::dispatch dsp(host);
+
+    std::vector<uint8_t> message;
+
+    // No universes, then too many per-universe hashes for a reply.
+    dcsm::encode_hashu(message, 1, 0);
+    EXPECT_EQ(dsp.process_message(message.data()), dcsm::dispatch_status::invalid_body_size);
+
+    message.clear();
+    dcsm::encode_hashu(message, 1, static_cast<uint16_t>(dcsm::hash_universe_max + 1));
+    EXPECT_EQ(dsp.process_message(message.data()), dcsm::dispatch_status::invalid_body_size);
+
+    message.clear();
+    dcsm::encode_hashu(message, 1, static_cast<uint16_t>(dcsm::hash_universe_max + 1), true);
+    EXPECT_EQ(dsp.process_message(message.data()), dcsm::dispatch_status::success);
+
+    // Neither one hash per universe nor one combined hash.
+    message.clear();
+    dcsm::encode_hashr(message, 1, 3, { 1, 2 });
+    EXPECT_EQ(dsp.process_message(message.data()), dcsm::dispatch_status::invalid_body_size);
+    EXPECT_TRUE(host.differing.empty());
+}
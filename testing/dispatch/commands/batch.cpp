@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include "dcsm.hpp"
+
+struct cmd_batch_interface final : dcsm::dispatch_interface {
+    std::vector<std::string> calls;
+    size_t command_count = 0;
+
+    void dcsm_begin_batch(dcsm::command_context &a_ctx, size_t const a_command_count) override {
+        calls.emplace_back("begin");
+        command_count = a_command_count;
+    }
+
+    void dcsm_end_batch(dcsm::command_context &a_ctx) override {
+        calls.emplace_back("end");
+    }
+
+    void dcsm_setutv(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const a_value, dcsm::universe_mask const &a_mask) override {
+        EXPECT_EQ(a_ctx.mode, dcsm::interface_mode::command);
+        calls.emplace_back("setutv " + std::to_string(a_universe) + " " + std::to_string(a_value) + " " + std::to_string(a_mask.count()));
+    }
+
+    void dcsm_setmtv(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const a_value, dcsm::universe_mask const &a_mask) override {
+        calls.emplace_back("setmtv " + std::to_string(a_universe) + " " + std::to_string(a_value) + " " + std::to_string(a_mask.count()));
+    }
+};
+
+TEST(dispatch_commands, batch) {
+    cmd_batch_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    EXPECT_EQ(dsp.process_command("set 1 thru 24 @ full; set 25 thru 48 @ out; mset 2/1 @ 100%;"), dcsm::dispatch_status::success);
+
+    std::vector<std::string> const expected {
+        "begin",
+        "setutv 1 255 24",
+        "setutv 1 0 24",
+        "setmtv 2 255 1",
+        "end",
+    };
+
+    EXPECT_EQ(itf.calls, expected);
+    EXPECT_EQ(itf.command_count, 3);
+}
+
+TEST(dispatch_commands, batch_malformed) {
+    cmd_batch_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    // Missing '@' in the second command.
+    EXPECT_EQ(dsp.process_command("set 1 thru 24 @ full; set 25 thru 48 out"), dcsm::dispatch_status::malformed_syntax);
+    // Unparsable address in the second command.
+    EXPECT_EQ(dsp.process_command("set 1 @ full; set x thru 4 @ out"), dcsm::dispatch_status::malformed_syntax);
+    // Unknown command.
+    EXPECT_EQ(dsp.process_command("set 1 @ full; blackout"), dcsm::dispatch_status::malformed_syntax);
+    // No commands at all.
+    EXPECT_EQ(dsp.process_command(" ; ;"), dcsm::dispatch_status::malformed_syntax);
+
+    // A rejected batch must not deliver anything.
+    EXPECT_TRUE(itf.calls.empty());
+}
+
+struct cmd_batch_readback_interface final : dcsm::dispatch_interface {
+    std::vector<size_t> chunk_sizes;
+    size_t capacity = 30;
+    bool continued = false;
+    dcsm::address_pack next;
+
+    void dcsm_geta(dcsm::command_context &a_ctx, std::vector<dcsm::address_pack> const &a_addresses) override {
+        chunk_sizes.push_back(a_addresses.size());
+        capacity -= std::min(capacity, a_addresses.size());
+    }
+
+    size_t dcsm_readback_capacity(dcsm::command_context &a_ctx) override {
+        return capacity;
+    }
+
+    void dcsm_readback_continue(dcsm::command_context &a_ctx, dcsm::address_pack const a_next) override {
+        continued = true;
+        next = a_next;
+    }
+};
+
+TEST(dispatch_commands, batch_readback) {
+    cmd_batch_readback_interface itf;
+    dcsm::dispatch dsp(itf);
+    dsp.set_readback_chunk_size(20);
+
+    // The handler's capacity and the chunk size apply inside a batch as well, across its commands.
+    EXPECT_EQ(dsp.process_command("get 1 thru 20; get 2/1 thru 2/40"), dcsm::dispatch_status::success);
+
+    EXPECT_EQ(itf.chunk_sizes, (std::vector<size_t>{ 20, 10 }));
+    EXPECT_TRUE(itf.continued);
+    EXPECT_EQ(itf.next, dcsm::address_pack(2, 11));
+}
+
+#if DCSM_ENABLE_STATISTICS
+TEST(dispatch_commands, batch_statistics) {
+    cmd_batch_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    // A rejected batch counts once, as its status; none of its commands were delivered.
+    EXPECT_EQ(dsp.process_command("set 1 @ full; set 2 @ full; set 3"), dcsm::dispatch_status::malformed_syntax);
+
+    auto snapshot = dsp.statistics().snapshot();
+    EXPECT_EQ(snapshot.commands[0].messages, 0);
+    EXPECT_EQ(snapshot.statuses[static_cast<size_t>(dcsm::dispatch_status::malformed_syntax)], 1);
+    EXPECT_EQ(snapshot.statuses[static_cast<size_t>(dcsm::dispatch_status::success)], 0);
+
+    // A delivered batch counts every command.
+    EXPECT_EQ(dsp.process_command("set 1 @ full; set 2 @ full"), dcsm::dispatch_status::success);
+    EXPECT_EQ(dsp.process_command("set 3 @ full; set 4 @ full"), dcsm::dispatch_status::success);
+
+    snapshot = dsp.statistics().snapshot();
+    EXPECT_EQ(snapshot.commands[0].messages, 4);
+    EXPECT_EQ(snapshot.statuses[static_cast<size_t>(dcsm::dispatch_status::success)], 4);
+    EXPECT_EQ(itf.calls.size(), 2 * 4);
+}
+#endif
@@ -52,4 +52,67 @@ TEST(dispatch_commands, get) {
         EXPECT_EQ(itf.universes, itf.range.size());
         EXPECT_TRUE(itf.received);
     }
-}
\ No newline at end of file
+}
+
+struct cmd_get_paged_interface final : dcsm::dispatch_interface {
+    std::vector<size_t> chunk_sizes;
+    std::vector<dcsm::address_pack> addresses;
+    size_t capacity = std::numeric_limits<size_t>::max();
+    bool continued = false;
+    dcsm::address_pack next;
+
+    void dcsm_geta(dcsm::command_context &a_ctx, std::vector<dcsm::address_pack> const &a_addresses) override {
+        chunk_sizes.push_back(a_addresses.size());
+        addresses.insert(addresses.end(), a_addresses.begin(), a_addresses.end());
+        capacity -= std::min(capacity, a_addresses.size());
+    }
+
+    size_t dcsm_readback_capacity(dcsm::command_context &a_ctx) override {
+        return capacity;
+    }
+
+    void dcsm_readback_continue(dcsm::command_context &a_ctx, dcsm::address_pack const a_next) override {
+        continued = true;
+        next = a_next;
+    }
+};
+
+TEST(dispatch_commands, get_paged) {
+    cmd_get_paged_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    // Chunks span universe boundaries and the whole range is delivered.
+    dsp.set_readback_chunk_size(100);
+    dsp.process_command("get 1/450 thru 3/10");
+
+    EXPECT_EQ(itf.addresses.size(), 63 + 512 + 10);
+    EXPECT_EQ(itf.chunk_sizes, (std::vector<size_t>{ 100, 100, 100, 100, 100, 85 }));
+    EXPECT_FALSE(itf.continued);
+
+    // Page limit stops the readback and reports where the next page starts.
+    itf = {};
+    dsp.set_readback_limit(150);
+    dsp.process_command("get 1/450 thru 3/10");
+
+    EXPECT_EQ(itf.addresses.size(), 150);
+    EXPECT_TRUE(itf.continued);
+    EXPECT_EQ(itf.next, dcsm::address_pack(2, 88));
+
+    // Requesting the next page resumes exactly where the last one stopped.
+    itf = {};
+    dsp.process_command("get 1/450 thru 3/10 from 2/88");
+
+    EXPECT_EQ(itf.addresses.front(), dcsm::address_pack(2, 88));
+    EXPECT_EQ(itf.addresses.size(), 150);
+    EXPECT_EQ(itf.next, dcsm::address_pack(2, 238));
+
+    // A full handler buffer stops the readback early.
+    itf = {};
+    itf.capacity = 30;
+    dsp.set_readback_limit(std::numeric_limits<size_t>::max());
+    dsp.process_command("get 1 thru 40");
+
+    EXPECT_EQ(itf.chunk_sizes, std::vector<size_t>{ 30 });
+    EXPECT_TRUE(itf.continued);
+    EXPECT_EQ(itf.next, dcsm::address_pack(1, 31));
+}
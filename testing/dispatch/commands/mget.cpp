@@ -52,4 +52,32 @@ TEST(dispatch_commands, mget) {
         EXPECT_EQ(itf.universes, itf.range.size());
         EXPECT_TRUE(itf.received);
     }
-}
\ No newline at end of file
+}
+
+struct cmd_mget_paged_interface final : dcsm::dispatch_interface {
+    size_t address_count = 0;
+    size_t chunks = 0;
+    dcsm::address_pack next;
+
+    void dcsm_getma(dcsm::command_context &a_ctx, std::vector<dcsm::address_pack> const &a_addresses) override {
+        ++chunks;
+        address_count += a_addresses.size();
+    }
+
+    void dcsm_readback_continue(dcsm::command_context &a_ctx, dcsm::address_pack const a_next) override {
+        next = a_next;
+    }
+};
+
+TEST(dispatch_commands, mget_paged) {
+    cmd_mget_paged_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    dsp.set_readback_chunk_size(64);
+    dsp.set_readback_limit(512);
+    dsp.process_command("mget 1 thru 4/512");
+
+    EXPECT_EQ(itf.chunks, 8);
+    EXPECT_EQ(itf.address_count, 512);
+    EXPECT_EQ(itf.next, dcsm::address_pack(2, 1));
+}
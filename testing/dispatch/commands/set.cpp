@@ -61,4 +61,96 @@ TEST(dispatch_commands, set) {
         EXPECT_EQ(itf.universes, itf.range.size());
         EXPECT_TRUE(itf.received);
     }
-}
\ No newline at end of file
+}
+
+struct cmd_set_values_interface final : dcsm::dispatch_interface {
+    std::vector<std::tuple<uint16_t, uint16_t, std::vector<uint8_t>>> spans;
+
+    void dcsm_setsp(dcsm::command_context &a_ctx, std::vector<dcsm::universe_span> const &a_spans) override {
+        for (auto const& span : a_spans) {
+            spans.emplace_back(span.universe, span.start, std::vector<uint8_t>(span.data, span.data + span.count));
+        }
+    }
+};
+
+TEST(dispatch_commands, set_values) {
+    cmd_set_values_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    // One value per address, in address order. Gaps and universe boundaries split spans.
+    EXPECT_EQ(dsp.process_command("set 1/10 thru 1/12 + 1/20 + 1/511 thru 2/1 @ 10, full, 50%, 4, 5, 6, out"), dcsm::dispatch_status::success);
+
+    decltype(itf.spans) const expected {
+        std::make_tuple(uint16_t{ 1 }, uint16_t{ 10 },  std::vector<uint8_t>{ 10, 255, 127 }),
+        std::make_tuple(uint16_t{ 1 }, uint16_t{ 20 },  std::vector<uint8_t>{ 4 }),
+        std::make_tuple(uint16_t{ 1 }, uint16_t{ 511 }, std::vector<uint8_t>{ 5, 6 }),
+        std::make_tuple(uint16_t{ 2 }, uint16_t{ 1 },   std::vector<uint8_t>{ 0 }),
+    };
+
+    EXPECT_EQ(itf.spans, expected);
+
+    // Value count must match the address count.
+    itf.spans.clear();
+
+    EXPECT_EQ(dsp.process_command("set 1/1 thru 1/3 @ 1, 2"), dcsm::dispatch_status::malformed_syntax);
+    EXPECT_EQ(dsp.process_command("set 1/1 thru 1/3 @ 1, 2, 3, 4"), dcsm::dispatch_status::malformed_syntax);
+    EXPECT_EQ(dsp.process_command("set 1/1 thru 1/3 @ 1, , 3"), dcsm::dispatch_status::malformed_syntax);
+
+    // Batched, the values are copied until the batch is applied.
+    EXPECT_EQ(dsp.process_command("set 1/1 thru 1/2 @ 7, 8; set 1/5 @ 9"), dcsm::dispatch_status::success);
+
+    decltype(itf.spans) const batched {
+        std::make_tuple(uint16_t{ 1 }, uint16_t{ 1 }, std::vector<uint8_t>{ 7, 8 }),
+    };
+
+    EXPECT_EQ(itf.spans, batched);
+}
+
+struct cmd_set_fine_interface final : dcsm::dispatch_interface {
+    std::vector<std::tuple<uint16_t, uint16_t, dcsm::universe_mask>> calls;
+
+    void dcsm_setutv16(dcsm::command_context &a_ctx, uint16_t const a_universe, uint16_t const a_value, dcsm::universe_mask const &a_mask) override {
+        calls.emplace_back(a_universe, a_value, a_mask);
+    }
+};
+
+TEST(dispatch_commands, set_fine) {
+    cmd_set_fine_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    std::pair<std::string, uint16_t> const cases[] {
+        { "16b:40000", 40000 },
+        { "16b: 513",  513   },
+        { "16b:50%",   32767 },
+        { "16b:full",  65535 },
+        { "16b:out",   0     },
+    };
+
+    for (auto const& test_case : cases) {
+        itf.calls.clear();
+
+        EXPECT_EQ(dsp.process_command("set 1/1 + 2/5 @ " + test_case.first), dcsm::dispatch_status::success) << test_case.first;
+
+        ASSERT_EQ(itf.calls.size(), 2) << test_case.first;
+        EXPECT_EQ(std::get<0>(itf.calls[0]), 1);
+        EXPECT_EQ(std::get<1>(itf.calls[0]), test_case.second) << test_case.first;
+        EXPECT_TRUE(std::get<2>(itf.calls[0]).test(0));
+        EXPECT_EQ(std::get<0>(itf.calls[1]), 2);
+        EXPECT_TRUE(std::get<2>(itf.calls[1]).test(4));
+    }
+
+    // Out of 16-bit range, and not supported in value lists or for mask universes.
+    EXPECT_EQ(dsp.process_command("set 1/1 @ 16b:65536; set 1/2 @ 1"), dcsm::dispatch_status::malformed_syntax);
+    EXPECT_EQ(dsp.process_command("set 1/1 thru 1/2 @ 16b:1, 16b:2"), dcsm::dispatch_status::malformed_syntax);
+    EXPECT_EQ(dsp.process_command("mset 1/1 @ 16b:40000"), dcsm::dispatch_status::malformed_syntax);
+
+    // Address 512 has no fine channel after it, wherever it falls in the range.
+    itf.calls.clear();
+
+    EXPECT_EQ(dsp.process_command("set 1/512 @ 16b:258"), dcsm::dispatch_status::malformed_syntax);
+    EXPECT_EQ(dsp.process_command("set 1/1 + 2/512 @ 16b:258"), dcsm::dispatch_status::malformed_syntax);
+    EXPECT_TRUE(itf.calls.empty());
+
+    EXPECT_EQ(dsp.process_command("set 1/511 @ 16b:258"), dcsm::dispatch_status::success);
+    EXPECT_EQ(itf.calls.size(), 1);
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+
+static constexpr uint16_t universe_number = 5;
+static constexpr uint16_t start_address   = 100;
+static constexpr uint16_t address_count   = 48;
+
+struct getmr_interface final : dcsm::dispatch_interface {
+    bool received = false;
+
+    void dcsm_getmr(dcsm::command_context &a_ctx, uint16_t const a_universe, uint16_t const a_start, uint16_t const a_count) override {
+        received = true;
+
+        EXPECT_EQ(a_universe, universe_number);
+        EXPECT_EQ(a_start,    start_address  );
+        EXPECT_EQ(a_count,    address_count  );
+    }
+};
+
+static dcsm::dispatch_status send_getmr(dcsm::dispatch& a_dispatch, uint16_t const a_start, uint16_t const a_count) {
+    // Message buffer.
+    std::vector<uint8_t> data;
+    data.resize(5 /* header */ + 2 /* universe number */ + 2 /* start address */ + 2 /* count */);
+    uint8_t* buf = data.data();
+
+    // Identifying byte.
+    buf[0] = 0x00;
+
+    // Copy message header into buffer.
+    dcsm::message_header const header { 0x001B, static_cast<uint16_t>(data.size() - 5) };
+    memcpy(buf + 1, &header, sizeof(header));
+
+    // Copy universe number, start address and count into buffer.
+    memcpy(buf + 5, &universe_number, sizeof(universe_number));
+    memcpy(buf + 7, &a_start, sizeof(a_start));
+    memcpy(buf + 9, &a_count, sizeof(a_count));
+
+    return a_dispatch.process_message(buf);
+}
+
+TEST(dispatch_direct_messages, getmr) {
+    getmr_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    EXPECT_EQ(send_getmr(dsp, start_address, address_count), dcsm::dispatch_status::success);
+
+    EXPECT_TRUE(itf.received);
+}
+
+TEST(dispatch_direct_messages, getmr_out_of_universe) {
+    getmr_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    EXPECT_EQ(send_getmr(dsp, 0, 10), dcsm::dispatch_status::invalid_body_size);
+    EXPECT_EQ(send_getmr(dsp, 500, 14), dcsm::dispatch_status::invalid_body_size);
+    EXPECT_EQ(send_getmr(dsp, 1, 0), dcsm::dispatch_status::invalid_body_size);
+
+    EXPECT_FALSE(itf.received);
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+
+struct setsp_interface final : dcsm::dispatch_interface {
+    struct span {
+        uint16_t universe;
+        uint16_t start;
+        std::vector<uint8_t> values;
+    };
+
+    std::vector<span> spans;
+    uint8_t const* body_begin = nullptr;
+    uint8_t const* body_end   = nullptr;
+
+    void dcsm_setsp(dcsm::command_context &a_ctx, std::vector<dcsm::universe_span> const &a_spans) override {
+        for (auto const& span : a_spans) {
+            // Values are handed over in place, without a copy.
+            EXPECT_GE(span.data, body_begin);
+            EXPECT_LE(span.data + span.count, body_end);
+
+            spans.push_back({ span.universe, span.start, std::vector<uint8_t>(span.data, span.data + span.count) });
+        }
+    }
+};
+
+TEST(dispatch_direct_messages, setsp) {
+    setsp_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    std::vector<uint8_t> first(40);
+    std::vector<uint8_t> const second { 1, 2, 3 };
+
+    for (size_t i = 0; i < first.size(); ++i) {
+        first[i] = static_cast<uint8_t>(i * 3);
+    }
+
+    std::vector<uint8_t> message;
+    dcsm::encode_setsp(message, { { 3, 101, 40, first.data() }, { 7, 510, 3, second.data() } });
+
+    // 40 consecutive addresses cost 6 + 40 bytes instead of 200 with setv.
+    EXPECT_EQ(message.size(), 5 + 6 + 40 + 6 + 3);
+
+    itf.body_begin = message.data() + 5;
+    itf.body_end   = message.data() + message.size();
+
+    EXPECT_EQ(dsp.process_message(message.data()), dcsm::dispatch_status::success);
+
+    ASSERT_EQ(itf.spans.size(), 2);
+    EXPECT_EQ(itf.spans[0].universe, 3);
+    EXPECT_EQ(itf.spans[0].start, 101);
+    EXPECT_EQ(itf.spans[0].values, first);
+    EXPECT_EQ(itf.spans[1].universe, 7);
+    EXPECT_EQ(itf.spans[1].start, 510);
+    EXPECT_EQ(itf.spans[1].values, second);
+}
+
+TEST(dispatch_direct_messages, setsp_invalid) {
+    setsp_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    std::vector<uint8_t> const values(8, 1);
+
+    auto const send = [&dsp](std::vector<dcsm::universe_span> const& a_spans, int const a_truncate) {
+        std::vector<uint8_t> message;
+        dcsm::encode_setsp(message, a_spans);
+
+        dcsm::message_header header{};
+        memcpy(&header, message.data() + 1, sizeof(header));
+        header.length = static_cast<uint16_t>(header.length - a_truncate);
+
+        return dsp.process_message(header, message.data() + 5);
+    };
+
+    // Past the end of the universe.
+    EXPECT_EQ(send({ { 1, 510, 4, values.data() } }, 0), dcsm::dispatch_status::invalid_body_size);
+    // Address 0.
+    EXPECT_EQ(send({ { 1, 0, 4, values.data() } }, 0), dcsm::dispatch_status::invalid_body_size);
+    // Empty span.
+    EXPECT_EQ(send({ { 1, 1, 0, values.data() } }, 0), dcsm::dispatch_status::invalid_body_size);
+    // Truncated values.
+    EXPECT_EQ(send({ { 1, 1, 8, values.data() } }, 1), dcsm::dispatch_status::invalid_body_size);
+    // Truncated span header after a valid span.
+    EXPECT_EQ(send({ { 1, 1, 8, values.data() }, { 1, 20, 1, values.data() } }, 2), dcsm::dispatch_status::invalid_body_size);
+    // Empty body.
+    EXPECT_EQ(send({}, 0), dcsm::dispatch_status::invalid_body_size);
+
+    EXPECT_TRUE(itf.spans.empty());
+}
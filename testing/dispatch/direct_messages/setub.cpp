@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+
+static std::array<uint8_t, 512> make_universe(uint8_t const a_seed) {
+    std::array<uint8_t, 512> data{};
+
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(a_seed + i * 7);
+    }
+
+    return data;
+}
+
+struct setub_interface final : dcsm::dispatch_interface {
+    std::vector<std::pair<uint16_t, std::array<uint8_t, 512>>> bulk;
+    size_t bulk_calls = 0;
+
+    void dcsm_setu_bulk(dcsm::command_context &a_ctx, std::vector<std::pair<uint16_t, uint8_t const*>> const &a_universes) override {
+        ++bulk_calls;
+
+        for (auto const& universe : a_universes) {
+            bulk.emplace_back(universe.first, std::array<uint8_t, 512>{});
+            memcpy(bulk.back().second.data(), universe.second, 512);
+        }
+    }
+};
+
+/// Only implements dcsm_setu, so setub falls back to one call per universe.
+struct setub_fallback_interface final : dcsm::dispatch_interface {
+    std::vector<std::pair<uint16_t, uint8_t>> setu;
+
+    void dcsm_setu(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const *a_data) override {
+        setu.emplace_back(a_universe, a_data[511]);
+    }
+};
+
+TEST(dispatch_direct_messages, setub) {
+    setub_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    auto const first  = make_universe(1);
+    auto const second = make_universe(2);
+    auto const third  = make_universe(3);
+
+    std::vector<uint8_t> message;
+    dcsm::encode_setub(message, { { 4, first.data() }, { 9, second.data() }, { 5, third.data() } });
+
+    EXPECT_EQ(message.size(), 5 + 2 + 3 * (2 + 512));
+    EXPECT_EQ(dsp.process_message(message.data()), dcsm::dispatch_status::success);
+
+    ASSERT_EQ(itf.bulk_calls, 1);
+    ASSERT_EQ(itf.bulk.size(), 3);
+    EXPECT_EQ(itf.bulk[0].first, 4);
+    EXPECT_EQ(itf.bulk[0].second, first);
+    EXPECT_EQ(itf.bulk[1].first, 9);
+    EXPECT_EQ(itf.bulk[1].second, second);
+    EXPECT_EQ(itf.bulk[2].first, 5);
+    EXPECT_EQ(itf.bulk[2].second, third);
+}
+
+TEST(dispatch_direct_messages, setub_fallback) {
+    setub_fallback_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    auto const first  = make_universe(1);
+    auto const second = make_universe(2);
+
+    std::vector<uint8_t> message;
+    dcsm::encode_setub(message, { { 4, first.data() }, { 9, second.data() } });
+
+    EXPECT_EQ(dsp.process_message(message.data()), dcsm::dispatch_status::success);
+
+    std::vector<std::pair<uint16_t, uint8_t>> const expected { { 4, first[511] }, { 9, second[511] } };
+    EXPECT_EQ(itf.setu, expected);
+}
+
+TEST(dispatch_direct_messages, setub_invalid_size) {
+    setub_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    auto const data = make_universe(1);
+
+    std::vector<uint8_t> message;
+    dcsm::encode_setub(message, { { 4, data.data() }, { 9, data.data() } });
+
+    dcsm::message_header header{};
+    memcpy(&header, message.data() + 1, sizeof(header));
+
+    // Count says three universes, body holds two.
+    dcsm::write_u16(message.data() + 5, 3);
+    EXPECT_EQ(dsp.process_message(header, message.data() + 5), dcsm::dispatch_status::invalid_body_size);
+
+    // No universes.
+    dcsm::write_u16(message.data() + 5, 0);
+    EXPECT_EQ(dsp.process_message({ header.opcode, 2 }, message.data() + 5), dcsm::dispatch_status::invalid_body_size);
+
+    // Truncated record.
+    dcsm::write_u16(message.data() + 5, 2);
+    EXPECT_EQ(dsp.process_message({ header.opcode, static_cast<uint16_t>(header.length - 1) }, message.data() + 5), dcsm::dispatch_status::invalid_body_size);
+
+    // No count.
+    EXPECT_EQ(dsp.process_message({ header.opcode, 1 }, message.data() + 5), dcsm::dispatch_status::invalid_body_size);
+
+    EXPECT_EQ(itf.bulk_calls, 0);
+}
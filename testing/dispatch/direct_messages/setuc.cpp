@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+
+#include <random>
+
+static constexpr uint16_t universe_number = 3;
+
+/// Show-like data: runs of 0 and 255 with a few faded channels.
+static std::array<uint8_t, 512> show_universe(uint8_t const a_fade) {
+    std::array<uint8_t, 512> data{};
+
+    std::fill(data.begin() + 40, data.begin() + 120, 255);
+    std::fill(data.begin() + 300, data.begin() + 310, a_fade);
+    data[200] = a_fade;
+    data[201] = 17;
+
+    return data;
+}
+
+struct setuc_interface final : dcsm::dispatch_interface {
+    std::array<uint8_t, 512> universe{};
+    bool has_buffer = true;
+    size_t updates = 0;
+    size_t setu_calls = 0;
+
+    uint8_t* dcsm_universe_buffer(dcsm::command_context &a_ctx, uint16_t const a_universe) override {
+        EXPECT_EQ(a_universe, universe_number);
+        return has_buffer ? universe.data() : nullptr;
+    }
+
+    void dcsm_setuc(dcsm::command_context &a_ctx, uint16_t const a_universe) override {
+        EXPECT_EQ(a_universe, universe_number);
+        ++updates;
+    }
+
+    void dcsm_setu(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const *a_data) override {
+        EXPECT_EQ(a_universe, universe_number);
+        memcpy(universe.data(), a_data, 512);
+        ++setu_calls;
+    }
+};
+
+TEST(dispatch_direct_messages, setuc) {
+    setuc_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    auto const first  = show_universe(100);
+    auto const second = show_universe(140);
+
+    // Absolute update, decoded straight into the universe buffer.
+    std::vector<uint8_t> message;
+    dcsm::encode_setuc(message, universe_number, first.data());
+
+    EXPECT_LT(message.size(), 514 / 3);
+    EXPECT_EQ(dsp.process_message(message.data()), dcsm::dispatch_status::success);
+    EXPECT_EQ(itf.universe, first);
+    EXPECT_EQ(itf.updates, 1);
+
+    // Delta against the previous frame.
+    message.clear();
+    dcsm::encode_setuc(message, universe_number, second.data(), first.data());
+
+    EXPECT_LT(message.size(), 514 / 10);
+    EXPECT_EQ(dsp.process_message(message.data()), dcsm::dispatch_status::success);
+    EXPECT_EQ(itf.universe, second);
+    EXPECT_EQ(itf.updates, 2);
+    EXPECT_EQ(itf.setu_calls, 0);
+}
+
+TEST(dispatch_direct_messages, setuc_without_buffer) {
+    setuc_interface itf;
+    itf.has_buffer = false;
+
+    dcsm::dispatch dsp(itf);
+
+    auto const data = show_universe(100);
+
+    std::vector<uint8_t> message;
+    dcsm::encode_setuc(message, universe_number, data.data());
+
+    EXPECT_EQ(dsp.process_message(message.data()), dcsm::dispatch_status::success);
+    EXPECT_EQ(itf.universe, data);
+    EXPECT_EQ(itf.setu_calls, 1);
+
+    // A delta needs the current data, which only a universe buffer provides.
+    message.clear();
+    dcsm::encode_setuc(message, universe_number, data.data(), data.data());
+
+    EXPECT_EQ(dsp.process_message(message.data()), dcsm::dispatch_status::unsupported);
+    EXPECT_EQ(itf.setu_calls, 1);
+}
+
+TEST(dispatch_direct_messages, setuc_malformed) {
+    setuc_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    itf.universe.fill(9);
+
+    auto const send = [&dsp](std::vector<uint8_t> const& a_body) {
+        std::vector<uint8_t> message;
+        uint8_t* const body = dcsm::append_message(message, dcsm::opcode::setuc, a_body.size());
+        std::copy(a_body.begin(), a_body.end(), body);
+        return dsp.process_message(message.data());
+    };
+
+    // Runs cover 511 addresses.
+    EXPECT_EQ(send({ 3, 0, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFE, 0 }), dcsm::dispatch_status::invalid_body_size);
+    // Runs cover 513 addresses.
+    EXPECT_EQ(send({ 3, 0, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0x00, 1 }), dcsm::dispatch_status::invalid_body_size);
+    // Truncated literal.
+    EXPECT_EQ(send({ 3, 0, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0x7F, 1, 2 }), dcsm::dispatch_status::invalid_body_size);
+    // No universe number.
+    EXPECT_EQ(send({ 3 }), dcsm::dispatch_status::invalid_body_size);
+    // Unknown encoding.
+    EXPECT_EQ(send({ 3, 0, 7, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0 }), dcsm::dispatch_status::unsupported);
+
+    // Nothing was written.
+    EXPECT_EQ(itf.updates, 0);
+    EXPECT_EQ(itf.universe[0], 9);
+}
+
+TEST(dispatch_direct_messages, setuc_compression_bounds) {
+    std::mt19937 random(7);
+    std::array<uint8_t, dcsm::compressed_universe_max_size> runs{};
+    std::array<uint8_t, 512> data{};
+    std::array<uint8_t, 512> decoded{};
+
+    for (size_t round = 0; round < 200; ++round) {
+        // From noise to long runs.
+        uint32_t const run_chance = static_cast<uint32_t>(round % 10);
+
+        for (size_t i = 0; i < 512; ++i) {
+            data[i] = i != 0 && random() % 10 < run_chance ? data[i - 1] : static_cast<uint8_t>(random());
+        }
+
+        size_t const size = dcsm::compress_universe(runs.data(), data.data());
+
+        ASSERT_LE(size, dcsm::compressed_universe_max_size);
+        ASSERT_TRUE(dcsm::validate_universe_runs(runs.data(), size));
+
+        dcsm::expand_universe_runs(decoded.data(), runs.data(), size);
+        ASSERT_EQ(decoded, data);
+    }
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+
+static constexpr uint16_t universe_number = 3;
+static constexpr uint16_t value           = 40000;
+
+struct setutv16_interface final : dcsm::dispatch_interface {
+    bool received = false;
+    dcsm::universe_mask mask;
+
+    void dcsm_setutv16(dcsm::command_context &a_ctx, uint16_t const a_universe, uint16_t const a_value, dcsm::universe_mask const &a_mask) override {
+        received = true;
+
+        EXPECT_EQ(a_universe, universe_number);
+        EXPECT_EQ(a_value, value);
+        EXPECT_EQ(a_mask, mask);
+    }
+};
+
+TEST(dispatch_direct_messages, setutv16) {
+    setutv16_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    // Pan/tilt coarse channels of four fixtures.
+    for (size_t fixture = 0; fixture < 4; ++fixture) {
+        itf.mask.set(fixture * 20);
+        itf.mask.set(fixture * 20 + 2);
+    }
+
+    // Message buffer.
+    std::vector<uint8_t> data;
+    data.resize(5 /* header */ + 2 /* universe number */ + 2 /* value */ + 64 /* mask */);
+    uint8_t* buf = data.data();
+
+    // Identifying byte.
+    buf[0] = 0x00;
+
+    // Copy message header into buffer.
+    dcsm::message_header const header { 0x001D, static_cast<uint16_t>(data.size() - 5) };
+    memcpy(buf + 1, &header, sizeof(header));
+
+    // Copy universe number and value into buffer.
+    memcpy(buf + 5, &universe_number, sizeof(universe_number));
+    memcpy(buf + 7, &value, sizeof(value));
+
+    // Copy mask into buffer.
+    dcsm::bitset_to_bytes(buf + 9, itf.mask);
+
+    EXPECT_EQ(dsp.process_message(buf), dcsm::dispatch_status::success);
+
+    EXPECT_TRUE(itf.received);
+}
+
+TEST(dispatch_direct_messages, setutv16_address_range) {
+    setutv16_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    uint8_t body[2 + 2 + 64] {};
+    memcpy(body,     &universe_number, sizeof(universe_number));
+    memcpy(body + 2, &value,           sizeof(value));
+
+    // Address 512 has no fine channel after it.
+    itf.mask.set(511);
+    dcsm::bitset_to_bytes(body + 4, itf.mask);
+
+    EXPECT_EQ(dsp.process_message({ 0x001D, sizeof(body) }, body), dcsm::dispatch_status::invalid_body_size);
+    EXPECT_FALSE(itf.received);
+
+    // Address 511 is the last coarse channel.
+    itf.mask.reset();
+    itf.mask.set(510);
+    dcsm::bitset_to_bytes(body + 4, itf.mask);
+
+    EXPECT_EQ(dsp.process_message({ 0x001D, sizeof(body) }, body), dcsm::dispatch_status::success);
+    EXPECT_TRUE(itf.received);
+}
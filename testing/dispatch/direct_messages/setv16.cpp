@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+
+static std::pair<dcsm::address_pack, uint16_t> const values[] {
+    { { 1, 1   }, 40000 },
+    { { 1, 17  }, 0     },
+    { { 4, 511 }, 65535 },
+};
+
+static constexpr size_t value_count = sizeof(values) / sizeof(values[0]);
+
+struct setv16_interface final : dcsm::dispatch_interface {
+    bool received = false;
+
+    void dcsm_setv16(dcsm::command_context &a_ctx, std::vector<std::pair<dcsm::address_pack, uint16_t>> const &a_pairs) override {
+        received = true;
+
+        ASSERT_EQ(a_pairs.size(), value_count);
+
+        for (size_t i = 0; i < a_pairs.size(); ++i) {
+            EXPECT_EQ(a_pairs[i], values[i]);
+        }
+    }
+};
+
+/// Only implements dcsm_setv: every value must arrive as its MSB and LSB in the same call.
+struct setv16_fallback_interface final : dcsm::dispatch_interface {
+    std::vector<std::vector<std::pair<dcsm::address_pack, uint8_t>>> calls;
+
+    void dcsm_setv(dcsm::command_context &a_ctx, std::vector<std::pair<dcsm::address_pack, uint8_t>> const &a_pairs) override {
+        calls.push_back(a_pairs);
+    }
+};
+
+static std::vector<uint8_t> setv16_message() {
+    // Message buffer.
+    std::vector<uint8_t> data;
+    data.resize(5 /* header */ + value_count * 6 /* universe number + address + value */);
+    uint8_t* buf = data.data();
+
+    // Identifying byte.
+    buf[0] = 0x00;
+
+    // Copy message header into buffer.
+    dcsm::message_header const header { 0x001C, static_cast<uint16_t>(data.size() - 5) };
+    memcpy(buf + 1, &header, sizeof(header));
+
+    uint8_t* it = buf + 5;
+
+    for (auto const& value : values) {
+        memcpy(it,     &value.first.first,  2);
+        memcpy(it + 2, &value.first.second, 2);
+        memcpy(it + 4, &value.second,       2);
+        it += 6;
+    }
+
+    return data;
+}
+
+TEST(dispatch_direct_messages, setv16) {
+    setv16_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    auto const message = setv16_message();
+
+    EXPECT_EQ(dsp.process_message(message.data()), dcsm::dispatch_status::success);
+    EXPECT_TRUE(itf.received);
+
+    // Not a multiple of 6 bytes.
+    EXPECT_EQ(dsp.process_message({ 0x001C, 7 }, message.data() + 5), dcsm::dispatch_status::invalid_body_size);
+}
+
+TEST(dispatch_direct_messages, setv16_fallback) {
+    setv16_fallback_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    auto const message = setv16_message();
+
+    EXPECT_EQ(dsp.process_message(message.data()), dcsm::dispatch_status::success);
+
+    std::vector<std::pair<dcsm::address_pack, uint8_t>> const expected {
+        { { 1, 1   }, 0x9C }, { { 1, 2   }, 0x40 },
+        { { 1, 17  }, 0x00 }, { { 1, 18  }, 0x00 },
+        { { 4, 511 }, 0xFF }, { { 4, 512 }, 0xFF },
+    };
+
+    ASSERT_EQ(itf.calls.size(), 1);
+    EXPECT_EQ(itf.calls[0], expected);
+}
+
+TEST(dispatch_direct_messages, setv16_address_range) {
+    setv16_fallback_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    // Address 512 has no fine channel; address 0 does not exist.
+    for (uint16_t const address : { uint16_t{512}, uint16_t{0} }) {
+        uint8_t body[6];
+        uint16_t const universe = 1;
+        uint16_t const value    = 258;
+        memcpy(body,     &universe, 2);
+        memcpy(body + 2, &address,  2);
+        memcpy(body + 4, &value,    2);
+
+        EXPECT_EQ(dsp.process_message({ 0x001C, 6 }, body), dcsm::dispatch_status::invalid_body_size);
+    }
+
+    EXPECT_TRUE(itf.calls.empty());
+}
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+
+#include <numeric>
+
+struct statistics_interface final : dcsm::dispatch_interface {};
+
+static uint64_t latency_total(dcsm::statistics_snapshot::entry const& a_entry) {
+    return std::accumulate(a_entry.latency.begin(), a_entry.latency.end(), uint64_t{ 0 });
+}
+
+TEST(dispatch, statistics) {
+    static_assert(dcsm::statistics_type::enabled, "dcsm_test is built with DCSM_ENABLE_STATISTICS=1");
+
+    statistics_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    // getu, valid.
+    uint8_t getu[5 + 2] { 0x00 };
+    dcsm::message_header const getu_header { 0x0004, 2 };
+    memcpy(getu + 1, &getu_header, sizeof(getu_header));
+
+    EXPECT_EQ(dsp.process_message(getu), dcsm::dispatch_status::success);
+    EXPECT_EQ(dsp.process_message(getu), dcsm::dispatch_status::success);
+
+    // getu, wrong body size.
+    EXPECT_EQ(dsp.process_message({ 0x0004, 3 }, getu + 5), dcsm::dispatch_status::invalid_body_size);
+
+    // Unknown opcode and bad identifying byte.
+    EXPECT_EQ(dsp.process_message({ 0x7FFF, 0 }, getu + 5), dcsm::dispatch_status::invalid_header);
+    getu[0] = 0xFF;
+    EXPECT_EQ(dsp.process_message(getu), dcsm::dispatch_status::invalid_header);
+
+    EXPECT_EQ(dsp.process_command("set 1 thru 10 @ full"), dcsm::dispatch_status::success);
+    EXPECT_EQ(dsp.process_command("set 1 thru 10"), dcsm::dispatch_status::malformed_syntax);
+    EXPECT_EQ(dsp.process_command("blackout"), dcsm::dispatch_status::malformed_syntax);
+
+    auto const snapshot = dsp.statistics().snapshot();
+
+    auto const& getu_stats = snapshot.opcodes[0x0004];
+    EXPECT_EQ(getu_stats.messages, 3);
+    EXPECT_EQ(getu_stats.bytes, 2 + 2 + 3);
+    EXPECT_EQ(latency_total(getu_stats), 3);
+
+    EXPECT_STREQ(dcsm::dispatch::command_name(0), "set");
+    auto const& set_stats = snapshot.commands[0];
+    EXPECT_EQ(set_stats.messages, 2);
+    EXPECT_EQ(set_stats.bytes, 20 + 13);
+    EXPECT_EQ(latency_total(set_stats), 2);
+
+    EXPECT_EQ(snapshot.statuses[static_cast<size_t>(dcsm::dispatch_status::success)],           3);
+    EXPECT_EQ(snapshot.statuses[static_cast<size_t>(dcsm::dispatch_status::invalid_body_size)], 1);
+    EXPECT_EQ(snapshot.statuses[static_cast<size_t>(dcsm::dispatch_status::invalid_header)],    2);
+    EXPECT_EQ(snapshot.statuses[static_cast<size_t>(dcsm::dispatch_status::malformed_syntax)],  2);
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+
+// Every encoded message must decode, through dispatch, to the arguments it was encoded from.
+
+struct encoder_interface final : dcsm::dispatch_interface {
+    std::vector<std::string> calls;
+
+    void dcsm_id(dcsm::command_context &a_ctx) override { calls.emplace_back("id"); }
+    void dcsm_setu(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const *a_data) override { calls.emplace_back("setu " + std::to_string(a_universe) + " " + std::to_string(a_data[100])); }
+    void dcsm_setv(dcsm::command_context &a_ctx, std::vector<std::pair<dcsm::address_pack, uint8_t>> const &a_pairs) override { calls.emplace_back("setv " + std::to_string(a_pairs.size()) + " " + std::to_string(a_pairs[1].first.second) + " " + std::to_string(a_pairs[1].second)); }
+    void dcsm_getu(dcsm::command_context &a_ctx, uint16_t const a_universe) override { calls.emplace_back("getu " + std::to_string(a_universe)); }
+    void dcsm_setfr(dcsm::command_context &a_ctx, uint8_t const a_framerate) override { calls.emplace_back("setfr " + std::to_string(a_framerate)); }
+    void dcsm_getfr(dcsm::command_context &a_ctx) override { calls.emplace_back("getfr"); }
+    void dcsm_newmu(dcsm::command_context &a_ctx, uint16_t const a_universe) override { calls.emplace_back("newmu " + std::to_string(a_universe)); }
+    void dcsm_listmu(dcsm::command_context &a_ctx) override { calls.emplace_back("listmu"); }
+    void dcsm_delmu(dcsm::command_context &a_ctx, uint16_t const a_universe) override { calls.emplace_back("delmu " + std::to_string(a_universe)); }
+    void dcsm_setmu(dcsm::command_context &a_ctx, uint16_t const a_universe, dcsm::universe_mask const &a_mask, uint8_t const *a_data) override { calls.emplace_back("setmu " + std::to_string(a_universe) + " " + std::to_string(a_mask.count()) + " " + std::to_string(a_data[100])); }
+    void dcsm_setmv(dcsm::command_context &a_ctx, uint16_t const a_universe, std::vector<std::tuple<uint16_t, bool, uint8_t>> const &a_pairs) override { calls.emplace_back("setmv " + std::to_string(a_universe) + " " + std::to_string(std::get<0>(a_pairs[0])) + " " + std::to_string(std::get<1>(a_pairs[0])) + " " + std::to_string(std::get<2>(a_pairs[0]))); }
+    void dcsm_getmu(dcsm::command_context &a_ctx, uint16_t const a_universe) override { calls.emplace_back("getmu " + std::to_string(a_universe)); }
+    void dcsm_clrmu(dcsm::command_context &a_ctx, uint16_t const a_universe) override { calls.emplace_back("clrmu " + std::to_string(a_universe)); }
+    void dcsm_patch(dcsm::command_context &a_ctx, uint16_t const a_input, uint16_t const a_output, uint16_t const a_mask) override { calls.emplace_back("patch " + std::to_string(a_input) + " " + std::to_string(a_output) + " " + std::to_string(a_mask)); }
+    void dcsm_unpat(dcsm::command_context &a_ctx, uint16_t const a_output) override { calls.emplace_back("unpat " + std::to_string(a_output)); }
+    void dcsm_listp(dcsm::command_context &a_ctx) override { calls.emplace_back("listp"); }
+    void dcsm_setutv(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const a_value, dcsm::universe_mask const &a_mask) override { calls.emplace_back("setutv " + std::to_string(a_universe) + " " + std::to_string(a_value) + " " + std::to_string(a_mask.count())); }
+    void dcsm_setmtv(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const a_value, dcsm::universe_mask const &a_mask) override { calls.emplace_back("setmtv " + std::to_string(a_universe) + " " + std::to_string(a_value) + " " + std::to_string(a_mask.count())); }
+    void dcsm_setv16(dcsm::command_context &a_ctx, std::vector<std::pair<dcsm::address_pack, uint16_t>> const &a_pairs) override { calls.emplace_back("setv16 " + std::to_string(a_pairs[0].first.first) + " " + std::to_string(a_pairs[0].first.second) + " " + std::to_string(a_pairs[0].second)); }
+    void dcsm_setutv16(dcsm::command_context &a_ctx, uint16_t const a_universe, uint16_t const a_value, dcsm::universe_mask const &a_mask) override { calls.emplace_back("setutv16 " + std::to_string(a_universe) + " " + std::to_string(a_value) + " " + std::to_string(a_mask.count())); }
+    void dcsm_listu(dcsm::command_context &a_ctx) override { calls.emplace_back("listu"); }
+    void dcsm_geta(dcsm::command_context &a_ctx, std::vector<dcsm::address_pack> const &a_addresses) override { calls.emplace_back("geta " + std::to_string(a_addresses.size()) + " " + std::to_string(a_addresses[0].first) + "/" + std::to_string(a_addresses[0].second)); }
+    void dcsm_getr(dcsm::command_context &a_ctx, uint16_t const a_universe, uint16_t const a_start, uint16_t const a_count) override { calls.emplace_back("getr " + std::to_string(a_universe) + " " + std::to_string(a_start) + " " + std::to_string(a_count)); }
+    void dcsm_getmr(dcsm::command_context &a_ctx, uint16_t const a_universe, uint16_t const a_start, uint16_t const a_count) override { calls.emplace_back("getmr " + std::to_string(a_universe) + " " + std::to_string(a_start) + " " + std::to_string(a_count)); }
+    void dcsm_sub(dcsm::command_context &a_ctx, uint16_t const a_universe) override { calls.emplace_back("sub " + std::to_string(a_universe)); }
+    void dcsm_unsub(dcsm::command_context &a_ctx, uint16_t const a_universe) override { calls.emplace_back("unsub " + std::to_string(a_universe)); }
+    void dcsm_chgu(dcsm::command_context &a_ctx, std::vector<dcsm::universe_span> const &a_spans) override { calls.emplace_back("chgu " + std::to_string(a_spans.size()) + " " + std::to_string(a_spans[0].universe) + " " + std::to_string(a_spans[0].start) + " " + std::to_string(a_spans[0].data[0])); }
+    void dcsm_getud(dcsm::command_context &a_ctx, uint16_t const a_universe, uint16_t const a_session, uint32_t const a_generation) override { calls.emplace_back("getud " + std::to_string(a_universe) + " " + std::to_string(a_session) + " " + std::to_string(a_generation)); }
+    void dcsm_difu(dcsm::command_context &a_ctx, uint16_t const a_universe, uint32_t const a_generation, std::vector<dcsm::universe_span> const &a_spans) override { calls.emplace_back("difu " + std::to_string(a_universe) + " " + std::to_string(a_generation) + " " + std::to_string(a_spans.size())); }
+    void dcsm_hashu(dcsm::command_context &a_ctx, uint16_t const a_first, uint16_t const a_count, bool const a_combined) override { calls.emplace_back("hashu " + std::to_string(a_first) + " " + std::to_string(a_count) + " " + std::to_string(a_combined)); }
+    void dcsm_hashr(dcsm::command_context &a_ctx, uint16_t const a_first, uint16_t const a_count, std::vector<uint64_t> const &a_hashes) override { calls.emplace_back("hashr " + std::to_string(a_first) + " " + std::to_string(a_count) + " " + std::to_string(a_hashes.size()) + " " + std::to_string(a_hashes.back())); }
+    void dcsm_ackr(dcsm::command_context &a_ctx, uint16_t const a_sequence, uint32_t const a_window, dcsm::dispatch_status const a_status) override { calls.emplace_back("ack " + std::to_string(a_sequence) + " " + std::to_string(a_window) + " " + std::to_string(static_cast<int>(a_status))); }
+    void dcsm_getma(dcsm::command_context &a_ctx, std::vector<dcsm::address_pack> const &a_addresses) override { calls.emplace_back("getma " + std::to_string(a_addresses.size()) + " " + std::to_string(a_addresses[0].first) + "/" + std::to_string(a_addresses[0].second)); }
+};
+
+TEST(encoder, round_trip) {
+    std::array<uint8_t, 512> data{};
+    data[100] = 77;
+
+    dcsm::universe_mask mask;
+    mask.set(3);
+    mask.set(400);
+
+    std::vector<uint8_t> stream;
+
+    dcsm::encode_id(stream);
+    dcsm::encode_setu(stream, 4, data.data());
+    dcsm::encode_setv(stream, { { { 1, 2 }, 3 }, { { 4, 5 }, 6 } });
+    dcsm::encode_getu(stream, 5);
+    dcsm::encode_setfr(stream, 30);
+    dcsm::encode_getfr(stream);
+    dcsm::encode_newmu(stream, 6);
+    dcsm::encode_listmu(stream);
+    dcsm::encode_delmu(stream, 7);
+    dcsm::encode_setmu(stream, 8, mask, data.data());
+    dcsm::encode_setmv(stream, 9, { std::make_tuple(uint16_t{ 10 }, true, uint8_t{ 11 }) });
+    dcsm::encode_getmu(stream, 12);
+    dcsm::encode_clrmu(stream, 13);
+    dcsm::encode_patch(stream, 14, 15, 16);
+    dcsm::encode_unpat(stream, 17);
+    dcsm::encode_listp(stream);
+    dcsm::encode_setutv(stream, 18, 19, mask);
+    dcsm::encode_setmtv(stream, 20, 21, mask);
+    dcsm::encode_listu(stream);
+    dcsm::encode_geta(stream, { { 22, 23 }, { 24, 25 } });
+    dcsm::encode_getma(stream, { { 26, 27 } });
+    dcsm::encode_setuc(stream, 28, data.data());
+    dcsm::encode_setub(stream, { { 29, data.data() }, { 30, data.data() } });
+    dcsm::encode_setsp(stream, { { 31, 100, 2, data.data() + 100 } });
+    dcsm::encode_getr(stream, 32, 33, 34);
+    dcsm::encode_getmr(stream, 35, 36, 37);
+    dcsm::encode_setv16(stream, { { { 38, 39 }, 40000 } });
+    dcsm::encode_setutv16(stream, 41, 50000, mask);
+    dcsm::encode_sub(stream, 42);
+    dcsm::encode_unsub(stream, 43);
+    dcsm::encode_chgu(stream, { { 44, 100, 1, data.data() + 100 }, { 45, 1, 2, data.data() } });
+    dcsm::encode_getud(stream, 46, 47, 70000);
+    dcsm::encode_difu(stream, 48, 70001, { { 48, 1, 2, data.data() } });
+    dcsm::encode_difu(stream, 49, 70001, {});
+    dcsm::encode_hashu(stream, 50, 3);
+    dcsm::encode_hashu(stream, 51, 300, true);
+    dcsm::encode_hashr(stream, 52, 2, { 1, 0xFEDCBA9876543210 });
+    dcsm::encode_ack(stream, 53, 70002, dcsm::dispatch_status::out_of_sequence);
+
+    encoder_interface itf;
+    dcsm::dispatch dsp(itf);
+    dcsm::frame_decoder decoder(dsp);
+
+    EXPECT_EQ(decoder.feed(stream.data(), stream.size()), 38);
+
+    std::vector<std::string> const expected {
+        "id",
+        "setu 4 77",
+        "setv 2 5 6",
+        "getu 5",
+        "setfr 30",
+        "getfr",
+        "newmu 6",
+        "listmu",
+        "delmu 7",
+        "setmu 8 2 77",
+        "setmv 9 10 1 11",
+        "getmu 12",
+        "clrmu 13",
+        "patch 14 15 16",
+        "unpat 17",
+        "listp",
+        "setutv 18 19 2",
+        "setmtv 20 21 2",
+        "listu",
+        "geta 2 22/23",
+        "getma 1 26/27",
+        "setu 28 77", // setuc is delivered as setu to handlers without a universe buffer.
+        "setu 29 77", // setub falls back to setu per universe.
+        "setu 30 77",
+        "setv 2 101 0", // setsp falls back to setv.
+        "getr 32 33 34",
+        "getmr 35 36 37",
+        "setv16 38 39 40000",
+        "setutv16 41 50000 2",
+        "sub 42",
+        "unsub 43",
+        "chgu 2 44 100 77",
+        "getud 46 47 70000",
+        "difu 48 70001 1",
+        "difu 49 70001 0",
+        "hashu 50 3 0",
+        "hashu 51 300 1",
+        "hashr 52 2 2 18364758544493064720",
+        "ack 53 70002 5",
+    };
+
+    EXPECT_EQ(itf.calls, expected);
+}
@@ -0,0 +1,295 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+#include <dcsm_flow.hpp>
+
+#include <numeric>
+
+struct sequenced_interface final : dcsm::dispatch_interface {
+    std::vector<uint16_t> universes;
+    std::vector<std::pair<uint16_t, dcsm::dispatch_status>> acks;
+
+    void dcsm_getu(dcsm::command_context &a_ctx, uint16_t const a_universe) override {
+        universes.push_back(a_universe);
+    }
+
+    void dcsm_ack(dcsm::command_context &a_ctx, uint16_t const a_sequence, dcsm::dispatch_status const a_status) override {
+        EXPECT_EQ(a_ctx.mode, dcsm::interface_mode::direct_control);
+        acks.emplace_back(a_sequence, a_status);
+    }
+};
+
+static std::vector<uint8_t> sequenced_getu(uint16_t const a_universe, uint16_t const a_sequence) {
+    std::vector<uint8_t> frame;
+    dcsm::encode_getu(frame, a_universe);
+
+    std::vector<uint8_t> sequenced;
+    dcsm::append_sequenced(sequenced, frame.data(), frame.size(), a_sequence);
+
+    return sequenced;
+}
+
+TEST(flow_window, sequenced_frames) {
+    sequenced_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    using status = dcsm::dispatch_status;
+
+    EXPECT_EQ(dsp.process_message(sequenced_getu(1, 0).data()), status::success);
+    EXPECT_EQ(dsp.process_message(sequenced_getu(2, 1).data()), status::success);
+    // Duplicate.
+    EXPECT_EQ(dsp.process_message(sequenced_getu(2, 1).data()), status::out_of_sequence);
+    // Gap.
+    EXPECT_EQ(dsp.process_message(sequenced_getu(4, 3).data()), status::out_of_sequence);
+    EXPECT_EQ(dsp.process_message(sequenced_getu(3, 2).data()), status::success);
+
+    // Unsequenced frames are processed regardless, without an acknowledgement.
+    std::vector<uint8_t> frame;
+    dcsm::encode_getu(frame, 5);
+    EXPECT_EQ(dsp.process_message(frame.data()), status::success);
+
+    EXPECT_EQ(itf.universes, (std::vector<uint16_t>{ 1, 2, 3, 5 }));
+    EXPECT_EQ(itf.acks, (std::vector<std::pair<uint16_t, status>>{
+        { 0, status::success },
+        { 1, status::success },
+        { 1, status::out_of_sequence },
+        { 1, status::out_of_sequence },
+        { 2, status::success }
+    }));
+
+    // Wraps around.
+    itf.acks.clear();
+    dsp.reset_sequence(0xFFFF);
+
+    EXPECT_EQ(dsp.process_message(sequenced_getu(6, 0).data()), status::out_of_sequence);
+    EXPECT_EQ(dsp.process_message(sequenced_getu(6, 0xFFFF).data()), status::success);
+    EXPECT_EQ(dsp.process_message(sequenced_getu(7, 0).data()), status::success);
+
+    EXPECT_EQ(itf.acks, (std::vector<std::pair<uint16_t, status>>{
+        { 0xFFFE, status::out_of_sequence },
+        { 0xFFFF, status::success },
+        { 0,      status::success }
+    }));
+
+    // Unknown flags.
+    frame[0] = 0x40;
+    EXPECT_EQ(dsp.process_message(frame.data()), status::invalid_header);
+}
+
+TEST(flow_window, acknowledge) {
+    std::vector<uint8_t> frame;
+    dcsm::encode_getu(frame, 1);
+
+    size_t const sequenced_size = frame.size() + 2;
+
+    dcsm::flow_window window(sequenced_size * 3, 0xFFFE);
+    std::vector<uint8_t> out;
+
+    EXPECT_EQ(window.send(out, frame.data(), frame.size()), 0xFFFE);
+    EXPECT_EQ(window.send(out, frame.data(), frame.size()), 0xFFFF);
+    EXPECT_EQ(window.send(out, frame.data(), frame.size()), 0);
+    EXPECT_FALSE(window.can_send(frame.size()));
+    EXPECT_EQ(window.in_flight_bytes(), sequenced_size * 3);
+    EXPECT_EQ(out.size(), sequenced_size * 3);
+
+    // Cumulative, across the wrap.
+    EXPECT_FALSE(window.acknowledge(0xFFFF, sequenced_size * 3));
+    EXPECT_EQ(window.in_flight(), 1);
+    EXPECT_TRUE(window.can_send(frame.size()));
+
+    // Repeated acknowledgement: resend once.
+    EXPECT_TRUE(window.acknowledge(0xFFFF, sequenced_size * 3));
+    EXPECT_FALSE(window.acknowledge(0xFFFF, sequenced_size * 3));
+
+    out.clear();
+    window.resend(out);
+    EXPECT_EQ(out, sequenced_getu(1, 0));
+
+    // A shrunk window stops sending, but a single frame always fits when nothing is in flight.
+    EXPECT_FALSE(window.acknowledge(0, 1));
+    EXPECT_EQ(window.in_flight(), 0);
+    EXPECT_TRUE(window.can_send(frame.size()));
+    EXPECT_EQ(window.send(out, frame.data(), frame.size()), 1);
+    EXPECT_FALSE(window.can_send(frame.size()));
+
+    // Not exactly one frame.
+    EXPECT_FALSE(dcsm::append_sequenced(out, frame.data(), 0, 2));
+    EXPECT_FALSE(dcsm::append_sequenced(out, frame.data(), frame.size() - 1, 2));
+    EXPECT_THROW(window.send(out, frame.data(), dcsm::message_header_size - 1), std::invalid_argument);
+    EXPECT_EQ(window.in_flight(), 1);
+}
+
+/**
+ * @brief Device end of the loopback link: a bounded receive buffer drained by a frame_decoder.
+ *
+ * The device advertises half its receive buffer, leaving room for resent frames that arrive while
+ * older copies are still buffered. Acknowledgements are encoded into replies, the way back to the host.
+ */
+struct loopback_device final : dcsm::dispatch_interface {
+    size_t buffer_size;
+    std::vector<uint8_t> received;
+    size_t peak_received = 0;
+
+    std::vector<uint16_t> delivered;
+    std::vector<uint8_t> replies;
+    size_t dropped = 0;
+
+    explicit loopback_device(size_t const a_buffer_size) :
+        buffer_size(a_buffer_size)
+    {}
+
+    void dcsm_setu(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const *a_data) override {
+        delivered.push_back(a_universe);
+    }
+
+    void dcsm_ack(dcsm::command_context &a_ctx, uint16_t const a_sequence, dcsm::dispatch_status const a_status) override {
+        dropped += a_status == dcsm::dispatch_status::out_of_sequence;
+        dcsm::encode_ack(replies, a_sequence, static_cast<uint32_t>(buffer_size / 2), a_status);
+    }
+};
+
+/// Host end of the loopback link: feeds the acknowledgements it decodes to its flow_window.
+struct loopback_host final : dcsm::dispatch_interface {
+    dcsm::flow_window window;
+    size_t acks = 0;
+    bool resend = false;
+
+    explicit loopback_host(size_t const a_window) :
+        window(a_window)
+    {}
+
+    void dcsm_ackr(dcsm::command_context &a_ctx, uint16_t const a_sequence, uint32_t const a_window, dcsm::dispatch_status const a_status) override {
+        ++acks;
+        resend |= window.acknowledge(a_sequence, a_window);
+    }
+};
+
+/**
+ * @brief Sends a_frames setu frames over a loopback link that loses every a_loss-th write (0: none).
+ *
+ * Every step, the link moves link_rate bytes into the device's receive buffer, the device processes
+ * process_rate bytes of it, and the acknowledgements of the previous step reach the host.
+ */
+static void run_loopback(size_t const a_frames, size_t const a_loss, loopback_device& a_device, size_t& a_peak_in_flight) {
+    constexpr size_t link_rate    = 300;
+    constexpr size_t process_rate = 200;
+
+    dcsm::dispatch dsp(a_device);
+    dcsm::frame_decoder decoder(dsp);
+
+    loopback_host host(a_device.buffer_size / 2);
+    dcsm::dispatch host_dsp(host);
+    dcsm::frame_decoder host_decoder(host_dsp);
+    auto& window = host.window;
+
+    std::deque<std::vector<uint8_t>> link;
+    std::array<uint8_t, 512> data{};
+    std::vector<uint8_t> frame;
+    std::vector<uint8_t> out;
+
+    size_t next_frame = 0;
+    size_t writes = 0;
+
+    auto const write = [&] {
+        if (a_loss == 0 || ++writes % a_loss != 0) {
+            link.push_back(out);
+        }
+
+        out.clear();
+    };
+
+    for (size_t step = 0; step < a_frames * 100 && a_device.delivered.size() < a_frames; ++step) {
+        // Acknowledgements.
+        host.acks = 0;
+        host_decoder.feed(a_device.replies.data(), a_device.replies.size());
+        a_device.replies.clear();
+
+        if (host.resend) {
+            host.resend = false;
+            window.resend(out);
+            write();
+        }
+
+        // Timeout: the link went quiet with frames still in flight.
+        if (host.acks == 0 && link.empty() && a_device.received.empty() && window.in_flight() != 0) {
+            window.resend(out);
+            write();
+        }
+
+        // Host.
+        while (next_frame < a_frames) {
+            frame.clear();
+            dcsm::encode_setu(frame, static_cast<uint16_t>(next_frame), data.data());
+
+            if (!window.can_send(frame.size())) {
+                break;
+            }
+
+            window.send(out, frame.data(), frame.size());
+            write();
+            ++next_frame;
+        }
+
+        a_peak_in_flight = std::max(a_peak_in_flight, window.in_flight_bytes());
+
+        // Link.
+        for (size_t budget = link_rate; budget != 0 && !link.empty();) {
+            auto& chunk = link.front();
+            size_t const size = std::min(budget, chunk.size());
+
+            a_device.received.insert(a_device.received.end(), chunk.begin(), chunk.begin() + size);
+            chunk.erase(chunk.begin(), chunk.begin() + size);
+            budget -= size;
+
+            if (chunk.empty()) {
+                link.pop_front();
+            }
+        }
+
+        a_device.peak_received = std::max(a_device.peak_received, a_device.received.size());
+
+        // Device.
+        size_t const size = std::min(process_rate, a_device.received.size());
+        decoder.feed(a_device.received.data(), size);
+        a_device.received.erase(a_device.received.begin(), a_device.received.begin() + size);
+    }
+}
+
+TEST(flow_window, loopback) {
+    constexpr size_t frames = 200;
+
+    loopback_device device(4096);
+    size_t peak_in_flight = 0;
+
+    run_loopback(frames, 0, device, peak_in_flight);
+
+    std::vector<uint16_t> expected(frames);
+    std::iota(expected.begin(), expected.end(), uint16_t{ 0 });
+
+    // In order, exactly once, and pipelined without overrunning the window.
+    EXPECT_EQ(device.delivered, expected);
+    EXPECT_EQ(device.dropped, 0);
+    EXPECT_GT(peak_in_flight, 521 * 2);
+    EXPECT_LE(peak_in_flight, device.buffer_size / 2);
+    EXPECT_LE(device.peak_received, device.buffer_size);
+}
+
+TEST(flow_window, loopback_lossy) {
+    constexpr size_t frames = 200;
+
+    for (size_t const loss : { 3, 7, 13 }) {
+        loopback_device device(4096);
+        size_t peak_in_flight = 0;
+
+        run_loopback(frames, loss, device, peak_in_flight);
+
+        std::vector<uint16_t> expected(frames);
+        std::iota(expected.begin(), expected.end(), uint16_t{ 0 });
+
+        EXPECT_EQ(device.delivered, expected) << "loss " << loss;
+        EXPECT_GT(device.dropped, 0) << "loss " << loss;
+        EXPECT_LE(peak_in_flight, device.buffer_size / 2) << "loss " << loss;
+        EXPECT_LE(device.peak_received, device.buffer_size) << "loss " << loss;
+    }
+}
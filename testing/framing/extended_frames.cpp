@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+#include <dcsm_flow.hpp>
+
+#include <numeric>
+#include <random>
+
+struct stream_interface final : dcsm::dispatch_interface {
+    std::vector<uint16_t> universes;
+    std::vector<std::array<uint16_t, 3>> patches;
+    size_t getu = 0;
+
+    bool accept_raw = false;
+    std::vector<uint8_t> raw;
+    std::vector<dcsm::dispatch_status> ends;
+
+    void dcsm_setu(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const *a_data) override {
+        EXPECT_EQ(a_data[0], static_cast<uint8_t>(a_universe));
+        EXPECT_EQ(a_data[511], static_cast<uint8_t>(a_universe >> 8));
+        universes.push_back(a_universe);
+    }
+
+    void dcsm_patch(dcsm::command_context &a_ctx, uint16_t const a_input_universe, uint16_t const a_output_universe, uint16_t const a_mask_universe) override {
+        patches.push_back({ a_input_universe, a_output_universe, a_mask_universe });
+    }
+
+    void dcsm_getu(dcsm::command_context &a_ctx, uint16_t const a_universe) override {
+        ++getu;
+    }
+
+    bool dcsm_stream_begin(dcsm::command_context &a_ctx, uint16_t const a_opcode, uint32_t const a_length) override {
+        return dispatch_interface::dcsm_stream_begin(a_ctx, a_opcode, a_length) || accept_raw;
+    }
+
+    void dcsm_stream_data(dcsm::command_context &a_ctx, uint8_t const *a_data, size_t const a_size) override {
+        raw.insert(raw.end(), a_data, a_data + a_size);
+    }
+
+    void dcsm_stream_end(dcsm::command_context &a_ctx, dcsm::dispatch_status const a_status) override {
+        ends.push_back(a_status);
+    }
+};
+
+/// Show restore: a_count universes, each tagged with its number in the first and last address.
+static std::vector<uint8_t> restore_stream(uint16_t const a_count, std::vector<std::array<uint8_t, 512>>& a_data) {
+    a_data.assign(a_count, {});
+    std::vector<std::pair<uint16_t, uint8_t const*>> universes;
+
+    for (uint16_t i = 0; i < a_count; ++i) {
+        uint16_t const universe = static_cast<uint16_t>(i + 1);
+        a_data[i][0]   = static_cast<uint8_t>(universe);
+        a_data[i][511] = static_cast<uint8_t>(universe >> 8);
+        universes.emplace_back(universe, a_data[i].data());
+    }
+
+    std::vector<uint8_t> stream;
+    dcsm::encode_setu_stream(stream, universes);
+    return stream;
+}
+
+TEST(framing, extended_setu_stream) {
+    std::vector<std::array<uint8_t, 512>> data;
+    auto stream = restore_stream(300, data);
+
+    // Beyond the uint16_t body limit.
+    ASSERT_GT(stream.size(), 0xFFFF);
+
+    dcsm::encode_getu(stream, 7);
+
+    std::mt19937 random(5);
+
+    for (size_t const max_piece : { 1, 7, 600, 100000 }) {
+        stream_interface itf;
+        dcsm::dispatch dsp(itf);
+        dcsm::frame_decoder decoder(dsp, 64); // Far smaller than the frame: it must not be buffered.
+
+        size_t frames = 0;
+
+        for (size_t offset = 0; offset < stream.size();) {
+            size_t const piece = std::min<size_t>(1 + random() % max_piece, stream.size() - offset);
+            frames += decoder.feed(stream.data() + offset, piece);
+            offset += piece;
+        }
+
+        std::vector<uint16_t> expected(300);
+        std::iota(expected.begin(), expected.end(), uint16_t{ 1 });
+
+        EXPECT_EQ(frames, 2);
+        EXPECT_EQ(itf.universes, expected);
+        EXPECT_EQ(itf.ends, std::vector<dcsm::dispatch_status>{ dcsm::dispatch_status::success });
+        EXPECT_EQ(itf.getu, 1);
+        EXPECT_EQ(decoder.last_status(), dcsm::dispatch_status::success);
+    }
+
+    // A complete frame in memory.
+    stream_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    EXPECT_EQ(dsp.process_message(stream.data()), dcsm::dispatch_status::success);
+    EXPECT_EQ(itf.universes.size(), 300);
+}
+
+TEST(framing, extended_records) {
+    stream_interface itf;
+    dcsm::dispatch dsp(itf);
+    dcsm::frame_decoder decoder(dsp);
+
+    // Patch table.
+    std::vector<uint8_t> stream;
+    dcsm::append_extended_header(stream, dcsm::opcode::patch, 12);
+
+    for (uint16_t const value : { 1, 2, 0, 3, 4, 9 }) {
+        stream.push_back(static_cast<uint8_t>(value));
+        stream.push_back(0);
+    }
+
+    // A partial record at the end: the whole records are still delivered.
+    std::array<uint8_t, 512> data{};
+    dcsm::append_extended_header(stream, dcsm::opcode::setu, 514 + 100);
+    stream.push_back(1);
+    stream.push_back(0);
+    data[0] = 1;
+    stream.insert(stream.end(), data.begin(), data.end());
+    stream.insert(stream.end(), 100, 0);
+
+    EXPECT_EQ(decoder.feed(stream.data(), stream.size()), 2);
+    EXPECT_EQ(itf.patches, (std::vector<std::array<uint16_t, 3>>{ { 1, 2, 0 }, { 3, 4, 9 } }));
+    EXPECT_EQ(itf.universes, std::vector<uint16_t>{ 1 });
+    EXPECT_EQ(itf.ends, (std::vector<dcsm::dispatch_status>{ dcsm::dispatch_status::success, dcsm::dispatch_status::invalid_body_size }));
+    EXPECT_EQ(decoder.last_status(), dcsm::dispatch_status::invalid_body_size);
+}
+
+TEST(framing, extended_raw) {
+    std::vector<uint8_t> body(100000);
+
+    for (size_t i = 0; i < body.size(); ++i) {
+        body[i] = static_cast<uint8_t>(i * 7);
+    }
+
+    std::vector<uint8_t> stream;
+    dcsm::append_extended_header(stream, dcsm::opcode::listu, static_cast<uint32_t>(body.size()));
+    stream.insert(stream.end(), body.begin(), body.end());
+    dcsm::encode_getu(stream, 1);
+
+    // Rejected by default: skipped as unsupported, without losing the next frame.
+    {
+        stream_interface itf;
+        dcsm::dispatch dsp(itf);
+        dcsm::frame_decoder decoder(dsp);
+
+        EXPECT_EQ(decoder.feed(stream.data(), stream.size()), 2);
+        EXPECT_TRUE(itf.raw.empty());
+        EXPECT_TRUE(itf.ends.empty());
+        EXPECT_EQ(itf.getu, 1);
+        EXPECT_EQ(dsp.statistics().snapshot().statuses[static_cast<size_t>(dcsm::dispatch_status::unsupported)], 1);
+    }
+
+    // Accepted: delivered in chunks.
+    {
+        stream_interface itf;
+        itf.accept_raw = true;
+
+        dcsm::dispatch dsp(itf);
+        dcsm::frame_decoder decoder(dsp);
+
+        for (size_t offset = 0; offset < stream.size(); offset += 4096) {
+            decoder.feed(stream.data() + offset, std::min<size_t>(4096, stream.size() - offset));
+        }
+
+        EXPECT_EQ(itf.raw, body);
+        EXPECT_EQ(itf.ends, std::vector<dcsm::dispatch_status>{ dcsm::dispatch_status::success });
+        EXPECT_EQ(itf.getu, 1);
+    }
+}
+
+TEST(framing, extended_checksummed) {
+    std::vector<std::array<uint8_t, 512>> data;
+    auto const stream = restore_stream(200, data);
+
+    dcsm::flow_window window(1 << 20, 0, true);
+    std::vector<uint8_t> sequenced;
+    window.send(sequenced, stream.data(), stream.size());
+
+    stream_interface itf;
+    dcsm::dispatch dsp(itf);
+    dcsm::frame_decoder decoder(dsp);
+
+    EXPECT_EQ(decoder.feed(sequenced.data(), sequenced.size()), 1);
+    EXPECT_EQ(itf.universes.size(), 200);
+    EXPECT_EQ(itf.ends, std::vector<dcsm::dispatch_status>{ dcsm::dispatch_status::success });
+    EXPECT_FALSE(window.acknowledge(0, 1 << 20));
+
+    // Corrupted: the records are held back until the trailer, so none is delivered, and the
+    // sequence number is not consumed.
+    window.send(sequenced, stream.data(), stream.size());
+    sequenced.erase(sequenced.begin(), sequenced.begin() + static_cast<std::ptrdiff_t>(sequenced.size() / 2));
+    sequenced[50000] ^= 0x04;
+
+    EXPECT_EQ(decoder.feed(sequenced.data(), sequenced.size()), 1);
+    EXPECT_EQ(itf.universes.size(), 200);
+    EXPECT_EQ(itf.ends.back(), dcsm::dispatch_status::checksum_mismatch);
+    EXPECT_EQ(decoder.last_status(), dcsm::dispatch_status::checksum_mismatch);
+
+    sequenced.clear();
+    EXPECT_TRUE(window.acknowledge(0, 1 << 20));
+    window.resend(sequenced);
+
+    EXPECT_EQ(decoder.feed(sequenced.data(), sequenced.size()), 1);
+    EXPECT_EQ(itf.universes.size(), 400);
+    EXPECT_EQ(itf.ends.back(), dcsm::dispatch_status::success);
+    EXPECT_FALSE(window.acknowledge(1, 1 << 20));
+    EXPECT_EQ(window.in_flight(), 0);
+
+    // Bodies that would have to be held beyond the staging limit are skipped.
+    dsp.set_stream_staging_limit(100 * (2 + 512));
+    sequenced.clear();
+    window.send(sequenced, stream.data(), stream.size());
+
+    EXPECT_EQ(decoder.feed(sequenced.data(), sequenced.size()), 1);
+    EXPECT_EQ(itf.universes.size(), 400);
+    EXPECT_EQ(decoder.last_status(), dcsm::dispatch_status::unsupported);
+}
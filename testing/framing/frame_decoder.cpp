@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+
+struct framing_interface final : dcsm::dispatch_interface {
+    std::vector<uint16_t> setu_universes;
+    std::vector<uint16_t> getu_universes;
+    size_t setutv = 0;
+
+    void dcsm_setu(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const *a_data) override {
+        setu_universes.push_back(a_universe);
+        EXPECT_EQ(a_data[511], static_cast<uint8_t>(a_universe));
+    }
+
+    void dcsm_getu(dcsm::command_context &a_ctx, uint16_t const a_universe) override {
+        getu_universes.push_back(a_universe);
+    }
+
+    void dcsm_setutv(dcsm::command_context &a_ctx, uint16_t const a_universe, uint8_t const a_value, dcsm::universe_mask const &a_mask) override {
+        EXPECT_EQ(a_ctx.mode, dcsm::interface_mode::command);
+        ++setutv;
+    }
+};
+
+static std::vector<uint8_t> mixed_stream() {
+    std::vector<uint8_t> stream;
+    std::array<uint8_t, 512> data{};
+
+    for (uint16_t universe = 1; universe <= 3; ++universe) {
+        data[511] = static_cast<uint8_t>(universe);
+        dcsm::encode_setu(stream, universe, data.data());
+    }
+
+    dcsm::encode_command(stream, "set 1 thru 10 @ full");
+    dcsm::encode_getu(stream, 10);
+
+    // Serial monitors terminate lines with "\r\n".
+    std::string const command = "set 2/1 @ 50%\r\n";
+    stream.insert(stream.end(), command.begin(), command.end());
+
+    dcsm::encode_getu(stream, 11);
+
+    return stream;
+}
+
+TEST(framing, frame_decoder) {
+    auto const stream = mixed_stream();
+
+    // Any split of the stream must decode to the same frames.
+    for (size_t const chunk : { size_t{ 1 }, size_t{ 3 }, size_t{ 64 }, stream.size() }) {
+        framing_interface itf;
+        dcsm::dispatch dsp(itf);
+        dcsm::frame_decoder decoder(dsp);
+
+        size_t frames = 0;
+
+        for (size_t offset = 0; offset < stream.size(); offset += chunk) {
+            frames += decoder.feed(stream.data() + offset, std::min(chunk, stream.size() - offset));
+        }
+
+        EXPECT_EQ(frames, 7);
+        EXPECT_EQ(itf.setu_universes, (std::vector<uint16_t>{ 1, 2, 3 }));
+        EXPECT_EQ(itf.getu_universes, (std::vector<uint16_t>{ 10, 11 }));
+        EXPECT_EQ(itf.setutv, 2);
+        EXPECT_EQ(decoder.last_status(), dcsm::dispatch_status::success);
+    }
+}
+
+TEST(framing, frame_decoder_oversized) {
+    framing_interface itf;
+    dcsm::dispatch dsp(itf);
+    dcsm::frame_decoder decoder(dsp, 16);
+
+    std::vector<uint8_t> stream;
+    std::array<uint8_t, 512> data{};
+
+    dcsm::encode_setu(stream, 1, data.data());  // Too large, skipped.
+    dcsm::encode_command(stream, "set 1 thru 10 @ full"); // Too long, skipped.
+    dcsm::encode_getu(stream, 5);
+
+    EXPECT_EQ(decoder.feed(stream.data(), stream.size()), 1);
+    EXPECT_TRUE(itf.setu_universes.empty());
+    EXPECT_EQ(itf.setutv, 0);
+    EXPECT_EQ(itf.getu_universes, std::vector<uint16_t>{ 5 });
+}
+
+TEST(framing, frame_decoder_malformed_command) {
+    framing_interface itf;
+    dcsm::dispatch dsp(itf);
+    dcsm::frame_decoder decoder(dsp);
+
+    std::vector<uint8_t> stream;
+    dcsm::encode_command(stream, "set x @ full");
+
+    EXPECT_EQ(decoder.feed(stream.data(), stream.size()), 1);
+    EXPECT_EQ(decoder.last_status(), dcsm::dispatch_status::malformed_syntax);
+}
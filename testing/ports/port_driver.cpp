@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+#include <dcsm_ports.hpp>
+#include <dcsm_reference_store.hpp>
+
+#if defined(__linux__)
+namespace {
+    /// The device end of a pseudo-terminal pair, feeding a reference store.
+    struct pty_device {
+        int fd = -1;
+        dcsm::reference_store store{ 16 };
+        dcsm::dispatch dsp{ store };
+        dcsm::frame_decoder decoder{ dsp };
+
+        /// Open a pty pair; returns the host end for the driver.
+        int open() {
+            int const host = ::posix_openpt(O_RDWR | O_NOCTTY);
+            EXPECT_GE(host, 0);
+            ::grantpt(host);
+            ::unlockpt(host);
+
+            fd = ::open(::ptsname(host), O_RDWR | O_NOCTTY | O_NONBLOCK);
+            EXPECT_GE(fd, 0);
+
+            // No echo or line discipline, like a USB CDC device.
+            termios attributes{};
+            ::tcgetattr(fd, &attributes);
+            ::cfmakeraw(&attributes);
+            ::tcsetattr(fd, TCSANOW, &attributes);
+
+            return host;
+        }
+
+        ~pty_device() {
+            ::close(fd);
+        }
+
+        void drain() {
+            uint8_t buffer[4096];
+            ssize_t size;
+
+            while ((size = ::read(fd, buffer, sizeof(buffer))) > 0) {
+                decoder.feed(buffer, static_cast<size_t>(size));
+            }
+        }
+    };
+
+    struct framerate_listener final : dcsm::dispatch_interface {
+        uint8_t framerate = 0;
+
+        void dcsm_setfr(dcsm::command_context& a_ctx, uint8_t const a_framerate) override {
+            framerate = a_framerate;
+        }
+    };
+}
+
+TEST(port_driver, routing) {
+    std::array<pty_device, 4> devices;
+    framerate_listener listener;
+    dcsm::port_driver driver;
+
+    for (size_t i = 0; i < devices.size(); ++i) {
+        EXPECT_EQ(driver.add_port(devices[i].open(), i == 2 ? &listener : nullptr), i);
+        driver.route_range(static_cast<uint16_t>(1 + i * 4), 4, i);
+    }
+
+    EXPECT_EQ(driver.port_of(5), 1);
+    EXPECT_EQ(driver.port_of(17), -1);
+
+    std::vector<uint8_t> data(512, 0);
+
+    for (uint16_t universe = 1; universe <= 16; ++universe) {
+        data[0] = static_cast<uint8_t>(universe);
+        EXPECT_TRUE(driver.setu(universe, data.data()));
+    }
+
+    EXPECT_FALSE(driver.setu(17, data.data()));
+    EXPECT_EQ(driver.queue_depth(0), 4 * (dcsm::message_header_size + 514));
+
+    for (size_t attempt = 0; attempt < 100; ++attempt) {
+        size_t const pending = driver.poll(10);
+
+        for (auto& device : devices) {
+            device.drain();
+        }
+
+        if (pending == 0) {
+            break;
+        }
+    }
+
+    for (uint16_t universe = 1; universe <= 16; ++universe) {
+        EXPECT_EQ(devices[(universe - 1) / 4].store.universe(universe)[0], universe);
+        EXPECT_EQ(devices[(universe - 1) / 4 ^ 1].store.universe(universe)[0], 0);
+    }
+
+    // Each port got its four universes in a single write.
+    EXPECT_EQ(driver.stats(0).written, 4 * (dcsm::message_header_size + 514));
+    EXPECT_EQ(driver.stats(0).writes, 1);
+    EXPECT_EQ(driver.queue_depth(0), 0);
+
+    // Replies from a device reach the handler of its port.
+    std::vector<uint8_t> reply;
+    dcsm::encode_setfr(reply, 30);
+    ASSERT_EQ(::write(devices[2].fd, reply.data(), reply.size()), static_cast<ssize_t>(reply.size()));
+
+    for (size_t attempt = 0; attempt < 100 && listener.framerate == 0; ++attempt) {
+        driver.poll(10);
+    }
+
+    EXPECT_EQ(listener.framerate, 30);
+    EXPECT_EQ(driver.stats(2).frames, 1);
+}
+
+TEST(port_driver, backpressure) {
+    pty_device device;
+    dcsm::port_driver driver(64 * 1024);
+    driver.add_port(device.open());
+    driver.route(1, 0);
+
+    // The device does not read: the pty fills up and the rest stays queued, up to the limit.
+    std::vector<uint8_t> data(512, 1);
+    size_t queued = 0;
+
+    while (driver.setu(1, data.data())) {
+        ++queued;
+        driver.poll(0);
+    }
+
+    EXPECT_GT(queued, 64 * 1024 / (dcsm::message_header_size + 514));
+    EXPECT_GT(driver.queue_depth(0), 64 * 1024 - (dcsm::message_header_size + 514));
+    EXPECT_EQ(driver.stats(0).dropped, 1);
+
+    // Once the device reads, everything arrives in order.
+    for (size_t attempt = 0; attempt < 1000 && driver.poll(1) != 0; ++attempt) {
+        device.drain();
+    }
+
+    device.drain();
+    EXPECT_EQ(driver.stats(0).written, queued * (dcsm::message_header_size + 514));
+    EXPECT_EQ(device.store.universe(1)[511], 1);
+    EXPECT_TRUE(driver.connected(0));
+
+    // The device goes away.
+    ::close(device.fd);
+    device.fd = -1;
+
+    for (size_t attempt = 0; attempt < 100 && driver.connected(0); ++attempt) {
+        driver.poll(10);
+    }
+
+    EXPECT_FALSE(driver.connected(0));
+    EXPECT_FALSE(driver.setu(1, data.data()));
+}
+#endif
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+#include <dcsm_reference_store.hpp>
+
+TEST(reference_store, universes) {
+    dcsm::reference_store store(4);
+    dcsm::dispatch dsp(store);
+
+    EXPECT_EQ(dsp.process_command("set 1/1 thru 1/10 @ full"), dcsm::dispatch_status::success);
+    EXPECT_EQ(dsp.process_command("copy 1 to 2"), dcsm::dispatch_status::success);
+    EXPECT_EQ(dsp.process_command("set 9/1 @ full"), dcsm::dispatch_status::success); // Out of range, ignored.
+
+    EXPECT_EQ(store.universe(1)[9], 255);
+    EXPECT_EQ(store.universe(1)[10], 0);
+    EXPECT_EQ(store.universe(2)[9], 255);
+    EXPECT_EQ(store.universe(9), nullptr);
+}
+
+TEST(reference_store, patch_with_mask) {
+    dcsm::reference_store store(4);
+    dcsm::dispatch dsp(store);
+
+    dsp.process_command("set 1/1 thru 1/512 @ 10");
+    dsp.process_command("createmask 3");
+    dsp.process_command("mset 3/5 thru 3/6 @ 200");
+    dsp.process_command("patch 1 to 2 mask 3");
+
+    std::array<uint8_t, 512> output{};
+    ASSERT_TRUE(store.output(2, output.data()));
+
+    EXPECT_EQ(output[0], 10);
+    EXPECT_EQ(output[4], 200);
+    EXPECT_EQ(output[5], 200);
+    EXPECT_EQ(output[6], 10);
+
+    dsp.process_command("unpatch 2");
+    ASSERT_TRUE(store.output(2, output.data()));
+    EXPECT_EQ(output[4], 0);
+}
+
+TEST(reference_store, corrupted_stream) {
+    dcsm::reference_store store(4);
+    dcsm::dispatch dsp(store);
+    dcsm::frame_decoder decoder(dsp);
+
+    std::array<uint8_t, 512> data{};
+    data.fill(200);
+
+    std::vector<uint8_t> frame;
+    dcsm::encode_setu_stream(frame, { { 1, data.data() }, { 2, data.data() } });
+    dcsm::append_checksum(frame, 0);
+
+    // One flipped body byte in the second record: neither record may reach the store.
+    auto corrupted = frame;
+    corrupted[dcsm::frame_header_size(dcsm::frame_flag_extended) + 514 + 100] ^= 0x01;
+
+    EXPECT_EQ(decoder.feed(corrupted.data(), corrupted.size()), 1);
+    EXPECT_EQ(decoder.last_status(), dcsm::dispatch_status::checksum_mismatch);
+    EXPECT_EQ(store.universe(1)[0], 0);
+    EXPECT_EQ(store.universe(2)[0], 0);
+
+    EXPECT_EQ(decoder.feed(frame.data(), frame.size()), 1);
+    EXPECT_EQ(decoder.last_status(), dcsm::dispatch_status::success);
+    EXPECT_EQ(store.universe(1)[0], 200);
+    EXPECT_EQ(store.universe(2)[0], 200);
+}
+
+TEST(reference_store, replies) {
+    dcsm::reference_store store(4);
+    dcsm::dispatch dsp(store);
+
+    dsp.process_command("set 1/1 thru 1/3 @ 10");
+    dsp.process_command("createmask 3");
+    dsp.process_command("patch 1 to 2 mask 3");
+    dsp.process_command("patch 1 to 4");
+
+    // Without a reply target, queries are ignored.
+    EXPECT_EQ(dsp.process_command("patches"), dcsm::dispatch_status::success);
+
+    std::vector<uint8_t> replies;
+    store.reply_to(&replies);
+
+    dsp.process_command("get 1/2 thru 1/3");
+    dsp.process_command("framerate");
+    dsp.process_command("patches");
+    EXPECT_EQ(std::string(replies.begin(), replies.end()), "set 1/2 @ 10\nset 1/3 @ 10\nframerate 44\npatch 1 to 2 mask 3\npatch 1 to 4\n");
+
+    // Direct control replies set what was read, so a mirror applying them ends up with the same state.
+    replies.clear();
+
+    std::vector<uint8_t> queries;
+    dcsm::encode_getu(queries, 1);
+    dcsm::encode_getfr(queries);
+    dcsm::encode_listp(queries);
+    dcsm::encode_getmu(queries, 3);
+
+    dcsm::frame_decoder decoder(dsp);
+    EXPECT_EQ(decoder.feed(queries.data(), queries.size()), 4);
+
+    dcsm::reference_store mirror(4);
+    dcsm::dispatch mirror_dsp(mirror);
+    mirror_dsp.process_command("createmask 3");
+    mirror_dsp.process_command("framerate 30");
+
+    dcsm::frame_decoder mirror_decoder(mirror_dsp);
+    EXPECT_EQ(mirror_decoder.feed(replies.data(), replies.size()), 4);
+
+    for (uint16_t universe = 1; universe <= 4; ++universe) {
+        EXPECT_EQ(mirror.hash(universe), store.hash(universe)) << universe;
+    }
+
+    EXPECT_EQ(mirror.framerate(), 44);
+
+    store.reply_to(nullptr);
+}
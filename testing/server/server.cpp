@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+#include <dcsm_flow.hpp>
+#include <dcsm_reference_store.hpp>
+#include <dcsm_server.hpp>
+
+#if defined(__linux__)
+namespace {
+    /// A blocking client socket.
+    struct client {
+        int fd = -1;
+
+        client(dcsm::server& a_server, uint16_t const a_port) {
+            fd = ::socket(AF_INET, SOCK_STREAM, 0);
+
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(a_port);
+            ::inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+
+            EXPECT_EQ(::connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)), 0);
+            accept(a_server);
+        }
+
+        client(dcsm::server& a_server, std::string const& a_path) {
+            fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, a_path.c_str(), a_path.size() + 1);
+
+            EXPECT_EQ(::connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)), 0);
+            accept(a_server);
+        }
+
+        ~client() {
+            ::close(fd);
+        }
+
+        void accept(dcsm::server& a_server) {
+            uint64_t const before = a_server.accepted() + a_server.refused();
+
+            for (size_t attempt = 0; attempt < 100 && a_server.accepted() + a_server.refused() == before; ++attempt) {
+                a_server.poll(10);
+            }
+        }
+
+        void send(std::vector<uint8_t> const& a_bytes) {
+            ASSERT_EQ(::send(fd, a_bytes.data(), a_bytes.size(), 0), static_cast<ssize_t>(a_bytes.size()));
+        }
+
+        /// Serve until a_size reply bytes arrived, or nothing more comes.
+        std::vector<uint8_t> receive(dcsm::server& a_server, size_t const a_size) {
+            std::vector<uint8_t> bytes;
+            uint8_t buffer[4096];
+
+            for (size_t attempt = 0; attempt < 100 && bytes.size() < a_size; ++attempt) {
+                a_server.poll(10);
+
+                ssize_t const size = ::recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+
+                if (size > 0) {
+                    bytes.insert(bytes.end(), buffer, buffer + size);
+                }
+            }
+
+            return bytes;
+        }
+
+        /// Whether any bytes wait on the socket.
+        bool readable() const {
+            uint8_t byte;
+            return ::recv(fd, &byte, 1, MSG_DONTWAIT | MSG_PEEK) > 0;
+        }
+
+        /// Whether the server closed the connection.
+        bool closed() const {
+            uint8_t byte;
+            return ::recv(fd, &byte, 1, 0) == 0;
+        }
+    };
+
+    /// Host end of a connection: feeds the acknowledgements it decodes to its flow_window.
+    struct flow_host final : dcsm::dispatch_interface {
+        dcsm::flow_window window;
+        std::vector<uint16_t> acks;
+
+        explicit flow_host(size_t const a_window) :
+            window(a_window)
+        {}
+
+        void dcsm_ackr(dcsm::command_context &a_ctx, uint16_t const a_sequence, uint32_t const a_window, dcsm::dispatch_status const a_status) override {
+            EXPECT_EQ(a_status, dcsm::dispatch_status::success);
+            acks.push_back(a_sequence);
+            window.acknowledge(a_sequence, a_window);
+        }
+    };
+
+    /// Serve until a_frames frames and commands were dispatched in total.
+    void serve(dcsm::server& a_server, uint64_t const a_frames) {
+        for (size_t attempt = 0; attempt < 100 && a_server.frames() < a_frames; ++attempt) {
+            a_server.poll(10);
+        }
+    }
+}
+
+TEST(server, shared_state) {
+    dcsm::reference_store store(8);
+    dcsm::server server(store);
+
+    uint16_t const port = server.listen_tcp(0, "127.0.0.1");
+    std::string const path = "/tmp/dcsm_server_test_" + std::to_string(::getpid());
+    server.listen_unix(path);
+
+    client control(server, port);
+    client ui(server, port);
+    client logger(server, path);
+    ASSERT_EQ(server.connection_count(), 3);
+
+    // Show control sets a universe with setu and a patch with a command.
+    std::vector<uint8_t> data(512, 0);
+    data[0] = 255;
+
+    std::vector<uint8_t> bytes;
+    dcsm::encode_setu(bytes, 1, data.data());
+    dcsm::encode_command(bytes, "patch 1 to 2");
+    control.send(bytes);
+    serve(server, 2);
+    EXPECT_EQ(store.universe(1)[0], 255);
+
+    // The UI reads it back; the reply goes to the UI only.
+    bytes.clear();
+    dcsm::encode_getu(bytes, 1);
+    dcsm::encode_listp(bytes);
+    ui.send(bytes);
+
+    auto const reply = ui.receive(server, dcsm::message_header_size + 514 + 7 + 6);
+    ASSERT_EQ(reply.size(), dcsm::message_header_size + 514 + 7 + 6);
+    EXPECT_EQ(reply[dcsm::message_header_size + 2], 255);
+    EXPECT_FALSE(control.readable());
+
+    // The logger speaks the command interface over the Unix-domain socket.
+    logger.send({ 'p', 'a', 't', 'c', 'h', 'e', 's', '\n' });
+    auto const lines = logger.receive(server, 13);
+    EXPECT_EQ(std::string(lines.begin(), lines.end()), "patch 1 to 2\n");
+
+    EXPECT_EQ(server.frames(), 5);
+}
+
+TEST(server, disconnect) {
+    dcsm::reference_store store(1);
+    dcsm::server_options options;
+    options.max_connections = 1;
+
+    dcsm::server server(store, options);
+    uint16_t const port = server.listen_tcp(0, "127.0.0.1");
+
+    {
+        client first(server, port);
+        client second(server, port); // Over the limit: closed right away.
+        EXPECT_EQ(server.connection_count(), 1);
+        EXPECT_TRUE(second.closed());
+        EXPECT_EQ(server.refused(), 1);
+    }
+
+    for (size_t attempt = 0; attempt < 100 && server.connection_count() != 0; ++attempt) {
+        server.poll(10);
+    }
+
+    EXPECT_EQ(server.connection_count(), 0);
+
+    // A frame split across writes is reassembled per connection.
+    client third(server, port);
+    std::vector<uint8_t> getfr;
+    dcsm::encode_getfr(getfr);
+
+    third.send({ getfr.begin(), getfr.begin() + 2 });
+    server.poll(10);
+    EXPECT_EQ(server.frames(), 0);
+    third.send({ getfr.begin() + 2, getfr.end() });
+    EXPECT_EQ(third.receive(server, dcsm::message_header_size + 1).size(), dcsm::message_header_size + 1);
+}
+
+TEST(server, sequenced_frames) {
+    dcsm::reference_store store(4);
+    dcsm::server_options options;
+    options.window = 4096;
+
+    dcsm::server server(store, options);
+    client control(server, server.listen_tcp(0, "127.0.0.1"));
+
+    // The host starts with room for one setu frame and learns the connection's window from the acks.
+    flow_host host(600);
+    dcsm::dispatch host_dsp(host);
+    dcsm::frame_decoder decoder(host_dsp);
+
+    std::vector<uint8_t> data(512, 7);
+    std::vector<uint8_t> frame;
+    size_t acks = 0;
+
+    for (uint16_t universe = 1; universe <= 4; ++universe) {
+        frame.clear();
+        dcsm::encode_setu(frame, universe, data.data());
+        ASSERT_TRUE(host.window.can_send(frame.size() + 2));
+
+        std::vector<uint8_t> bytes;
+        host.window.send(bytes, frame.data(), frame.size());
+        control.send(bytes);
+
+        // ack: header + sequence (2) + window (4) + status (1)
+        auto const reply = control.receive(server, dcsm::message_header_size + 7);
+        ASSERT_EQ(reply.size(), dcsm::message_header_size + 7);
+        decoder.feed(reply.data(), reply.size());
+
+        ASSERT_EQ(host.acks.size(), ++acks);
+        EXPECT_EQ(host.acks.back(), universe - 1);
+        EXPECT_EQ(host.window.in_flight(), 0);
+        EXPECT_EQ(host.window.window(), 4096);
+    }
+
+    EXPECT_EQ(store.universe(4)[511], 7);
+}
+#endif
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+#include <dcsm_reference_store.hpp>
+#include <dcsm_shm.hpp>
+
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/wait.h>
+
+namespace {
+    /// Records setv pairs in arrival order; the universe identifies the producer.
+    struct ordered_interface final : dcsm::dispatch_interface {
+        std::vector<std::vector<uint16_t>> received = std::vector<std::vector<uint16_t>>(8);
+
+        void dcsm_setv(dcsm::command_context &a_ctx, std::vector<std::pair<dcsm::address_pack, uint8_t>> const &a_pairs) override {
+            for (auto const& pair : a_pairs) {
+                received[pair.first.first].push_back(pair.first.second);
+            }
+        }
+    };
+
+    std::vector<uint8_t> setv(uint16_t const a_universe, uint16_t const a_address) {
+        std::vector<uint8_t> frame;
+        dcsm::encode_setv(frame, { { { a_universe, a_address }, 1 } });
+        return frame;
+    }
+}
+
+TEST(shm_ring, frames) {
+    dcsm::shm_ring ring(4096);
+    EXPECT_EQ(ring.capacity(), 4096);
+
+    dcsm::reference_store store(4);
+    dcsm::dispatch dsp(store);
+
+    std::vector<uint8_t> data(512, 0);
+    std::vector<uint8_t> frame;
+
+    // Many times around a small ring, so records wrap with padding.
+    for (uint8_t round = 1; round <= 100; ++round) {
+        data[0] = round;
+        frame.clear();
+        dcsm::encode_setu(frame, static_cast<uint16_t>(1 + round % 4), data.data());
+
+        ASSERT_TRUE(ring.push(frame.data(), frame.size())) << round;
+
+        if (round % 3 == 0) {
+            ring.consume(dsp);
+        }
+    }
+
+    EXPECT_TRUE(ring.wait(0));
+    EXPECT_EQ(ring.consume(dsp), 1);
+    EXPECT_FALSE(ring.wait(0));
+    EXPECT_EQ(ring.size(), 0);
+    EXPECT_EQ(store.universe(1)[0], 100);
+    EXPECT_EQ(store.universe(4)[0], 99);
+
+    // Full, then too large for any record.
+    size_t pushed = 0;
+
+    while (ring.push(frame.data(), frame.size())) {
+        ++pushed;
+    }
+
+    EXPECT_EQ(pushed, 4096 / (4 + frame.size() + 3));
+    EXPECT_EQ(ring.consume(dsp, 2), 2);
+    EXPECT_TRUE(ring.push(frame.data(), frame.size()));
+
+    std::vector<uint8_t> large(ring.max_frame_size() + 1);
+    EXPECT_FALSE(ring.push(large.data(), large.size()));
+
+    // A region that is not a ring.
+    int const other = ::memfd_create("not_a_ring", 0);
+    EXPECT_THROW(dcsm::shm_ring::attach(other), std::runtime_error);
+}
+
+TEST(shm_ring, forged_header) {
+    // Regions sized to match a header whose capacity is empty, too small or not a power of two.
+    for (uint64_t const capacity : { uint64_t{ 0 }, uint64_t{ 2048 }, uint64_t{ 6144 } }) {
+        int const fd = ::memfd_create("forged_ring", 0);
+        ASSERT_EQ(::ftruncate(fd, static_cast<off_t>(sizeof(dcsm::shm_ring_header) + capacity)), 0);
+
+        dcsm::shm_ring_header header{};
+        header.magic = dcsm::shm_ring_magic;
+        header.version = 1;
+        header.capacity = capacity;
+        ASSERT_EQ(::pwrite(fd, &header, sizeof(header), 0), static_cast<ssize_t>(sizeof(header)));
+
+        EXPECT_THROW(dcsm::shm_ring::attach(fd), std::runtime_error) << capacity;
+    }
+
+    // A genuine header passes the same checks.
+    dcsm::shm_ring ring(4096);
+    EXPECT_NO_THROW(dcsm::shm_ring::attach(::dup(ring.fd())));
+}
+
+TEST(shm_ring, producers) {
+    dcsm::shm_ring ring(16384);
+    ordered_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    constexpr uint16_t producers = 4;
+    constexpr uint16_t frames = 5000;
+
+    std::vector<std::thread> threads;
+
+    for (uint16_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&ring, p] {
+            for (uint16_t i = 1; i <= frames; ++i) {
+                auto const frame = setv(p, i);
+
+                while (!ring.push(frame.data(), frame.size())) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    size_t consumed = 0;
+
+    while (consumed < producers * frames) {
+        consumed += ring.poll(dsp, 100);
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Every frame, in order per producer.
+    for (uint16_t p = 0; p < producers; ++p) {
+        ASSERT_EQ(itf.received[p].size(), frames);
+
+        for (uint16_t i = 0; i < frames; ++i) {
+            ASSERT_EQ(itf.received[p][i], i + 1);
+        }
+    }
+}
+
+TEST(shm_ring, processes) {
+    std::string const name = "/dcsm_ring_test_" + std::to_string(::getpid());
+    dcsm::shm_ring ring(name, 8192);
+
+    ordered_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    pid_t const child = ::fork();
+    ASSERT_GE(child, 0);
+
+    if (child == 0) {
+        // Give the parent time to fall asleep on the futex.
+        ::usleep(50000);
+
+        auto producer = dcsm::shm_ring::open(name);
+
+        for (uint16_t i = 1; i <= 100; ++i) {
+            auto const frame = setv(1, i);
+
+            while (!producer.push(frame.data(), frame.size())) {}
+        }
+
+        ::_exit(0);
+    }
+
+    size_t consumed = 0;
+
+    for (size_t attempt = 0; attempt < 100 && consumed < 100; ++attempt) {
+        consumed += ring.poll(dsp, 100);
+    }
+
+    int status = 0;
+    ::waitpid(child, &status, 0);
+
+    EXPECT_EQ(consumed, 100);
+    ASSERT_EQ(itf.received[1].size(), 100);
+    EXPECT_EQ(itf.received[1].back(), 100);
+    EXPECT_THROW(dcsm::shm_ring::open("/dcsm_ring_test_missing"), std::runtime_error);
+}
+
+TEST(shm_ring, bad_records) {
+    dcsm::shm_ring ring(4096);
+    ordered_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    auto const frame = setv(1, 1);
+
+    // push takes exactly one complete frame.
+    std::vector<uint8_t> overlong = frame;
+    overlong.push_back(0);
+    EXPECT_FALSE(ring.push(overlong.data(), overlong.size()));
+    EXPECT_FALSE(ring.push(frame.data(), frame.size() - 1));
+    EXPECT_FALSE(ring.push(frame.data(), 2));
+
+    // Another producer writes records around push: one shorter and one longer than the frame in it.
+    dcsm::shm_ring::reservation r{};
+    ASSERT_TRUE(ring.reserve(frame.size() - 1, r));
+    std::memcpy(r.data, frame.data(), frame.size() - 1);
+    ring.commit(r);
+
+    ASSERT_TRUE(ring.reserve(overlong.size(), r));
+    std::memcpy(r.data, overlong.data(), overlong.size());
+    ring.commit(r);
+
+    ASSERT_TRUE(ring.push(frame.data(), frame.size()));
+
+    EXPECT_EQ(ring.consume(dsp), 1);
+    EXPECT_EQ(ring.rejected(), 2);
+    EXPECT_EQ(itf.received[1].size(), 1);
+
+    // A record size reaching past the committed records: nothing after it is dispatched.
+    ASSERT_TRUE(ring.reserve(frame.size(), r));
+    std::memcpy(r.data, frame.data(), frame.size());
+    uint32_t const size = 2048;
+    std::memcpy(r.data - sizeof(size), &size, sizeof(size));
+    ring.commit(r);
+
+    ASSERT_TRUE(ring.push(frame.data(), frame.size()));
+
+    EXPECT_EQ(ring.consume(dsp), 0);
+    EXPECT_EQ(ring.rejected(), 3);
+    EXPECT_EQ(ring.size(), 0);
+
+    ASSERT_TRUE(ring.push(frame.data(), frame.size()));
+    EXPECT_EQ(ring.consume(dsp), 1);
+    EXPECT_EQ(itf.received[1].size(), 2);
+}
+#endif
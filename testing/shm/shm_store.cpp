@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+#include <dcsm_shm_store.hpp>
+
+#include <thread>
+
+#if defined(__linux__)
+TEST(shm_reference_store, publishes) {
+    std::string const name = "/dcsm_store_test_" + std::to_string(::getpid());
+    dcsm::shm_reference_store store(name, 8);
+    dcsm::dispatch dsp(store);
+
+    dcsm::shm_universe_reader reader(name);
+    EXPECT_EQ(reader.universe_count(), 8);
+
+    std::vector<uint8_t> data(512, 0);
+    std::vector<uint8_t> out(512);
+    std::vector<uint8_t> frames;
+    uint64_t generation = 0;
+
+    data[0] = 1;
+    data[511] = 2;
+    dcsm::encode_setu(frames, 1, data.data());
+    dcsm::encode_setv(frames, { { { 2, 1 }, 10 }, { { 2, 2 }, 11 }, { { 3, 1 }, 12 }, { { 9, 1 }, 13 } });
+    dcsm::encode_setsp(frames, { dcsm::universe_span{ 4, 511, 2, data.data() + 510 } });
+    dcsm::encode_setuc(frames, 5, data.data());
+
+    dcsm::frame_decoder decoder(dsp);
+    EXPECT_EQ(decoder.feed(frames.data(), frames.size()), 4);
+
+    ASSERT_TRUE(reader.read(1, out.data(), &generation));
+    EXPECT_EQ(out, data);
+    EXPECT_EQ(generation, 2);
+
+    // A run of addresses in one universe is published once.
+    EXPECT_EQ(reader.generation(2), 2);
+    EXPECT_EQ(reader.generation(3), 2);
+    ASSERT_TRUE(reader.read(2, out.data()));
+    EXPECT_EQ(out[0], 10);
+    EXPECT_EQ(out[1], 11);
+
+    ASSERT_TRUE(reader.read(4, out.data()));
+    EXPECT_EQ(out[511], 2);
+    ASSERT_TRUE(reader.read(5, out.data()));
+    EXPECT_EQ(out, data);
+    EXPECT_EQ(reader.generation(5), 2);
+
+    EXPECT_EQ(reader.generation(6), 0);
+    EXPECT_FALSE(reader.read(9, out.data()));
+    EXPECT_EQ(reader.retries(), 0);
+
+    // Only changed universes are copied again.
+    generation = reader.generation(1);
+    EXPECT_FALSE(reader.read_changed(1, out.data(), generation));
+
+    uint8_t* const direct = store.begin_write(1);
+    direct[0] = 3;
+    EXPECT_EQ(reader.generation(1) & 1, 1);
+    store.end_write(1);
+
+    EXPECT_TRUE(reader.read_changed(1, out.data(), generation));
+    EXPECT_EQ(out[0], 3);
+    EXPECT_EQ(generation, 4);
+    EXPECT_EQ(store.generation(1), 4);
+
+    // By file descriptor, and a region that is not a segment.
+    dcsm::shm_reference_store anonymous(2);
+    dcsm::shm_universe_reader by_fd(::dup(anonymous.fd()));
+    EXPECT_EQ(by_fd.universe_count(), 2);
+
+    EXPECT_THROW(dcsm::shm_universe_reader{ ::memfd_create("not_a_segment", 0) }, std::runtime_error);
+    EXPECT_THROW(dcsm::shm_universe_reader{ "/dcsm_store_test_missing" }, std::runtime_error);
+}
+
+TEST(shm_reference_store, consistent_reads) {
+    dcsm::shm_reference_store store(4);
+    dcsm::dispatch dsp(store);
+    dcsm::shm_universe_reader reader(::dup(store.fd()));
+
+    std::atomic<bool> running{ true };
+
+    // Every write fills a universe with a single value, so a torn read shows mixed values.
+    std::thread writer([&] {
+        std::vector<uint8_t> data(512);
+        std::vector<uint8_t> frame;
+
+        for (uint32_t i = 0; running.load(std::memory_order_relaxed); ++i) {
+            std::fill(data.begin(), data.end(), static_cast<uint8_t>(i));
+            frame.clear();
+            dcsm::encode_setu(frame, static_cast<uint16_t>(1 + i % 4), data.data());
+            dsp.process_message(frame.data());
+        }
+    });
+
+    std::vector<uint8_t> out(512);
+    uint64_t last = 0;
+
+    for (size_t i = 0; i < 20000; ++i) {
+        uint64_t generation;
+        ASSERT_TRUE(reader.read(1, out.data(), &generation));
+        ASSERT_EQ(generation & 1, 0);
+        ASSERT_GE(generation, last);
+        ASSERT_EQ(std::count(out.begin(), out.end(), out[0]), 512);
+        last = generation;
+    }
+
+    running = false;
+    writer.join();
+}
+#endif
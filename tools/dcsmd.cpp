@@ -0,0 +1,114 @@
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#include <dcsm.hpp>
+#include <dcsm_reference_store.hpp>
+#include <dcsm_server.hpp>
+#include <dcsm_shm_store.hpp>
+
+// Software node daemon (Linux only): owns a device state and serves it to any number of clients, each
+// connection speaking the serial protocol (direct control frames and command lines).
+//
+//   dcsmd [--tcp [<address>:]<port>] [--unix <path>] [--universes <n>] [--shm <name>]
+//
+// At least one of --tcp and --unix is required. Replies go back to the connection that asked. With
+// --shm, the universes are also published in shared memory under that name (e.g. /dcsmd) for
+// shm_universe_reader.
+
+namespace {
+    volatile std::sig_atomic_t g_running = 1;
+
+    void stop(int) {
+        g_running = 0;
+    }
+}
+
+int main(int const argc, char** const argv) {
+    std::vector<std::string> tcp;
+    std::vector<std::string> unix_paths;
+    size_t universes = 64;
+    std::string shm_name;
+
+    auto const usage = [&] {
+        std::cerr << "usage: " << argv[0] << " [--tcp [<address>:]<port>] [--unix <path>] [--universes <n>] [--shm <name>]" << std::endl;
+        return 2;
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--tcp") == 0 && i + 1 < argc) {
+            tcp.emplace_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--unix") == 0 && i + 1 < argc) {
+            unix_paths.emplace_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--universes") == 0 && i + 1 < argc) {
+            std::string const count = argv[++i];
+            size_t parsed = 0;
+
+            // std::stoul throws on anything that does not start with a number.
+            try {
+                universes = std::stoul(count, &parsed);
+            } catch (std::logic_error const&) {
+                return usage();
+            }
+
+            if (parsed != count.size() || universes == 0 || universes > 0xFFFF) {
+                std::cerr << "--universes: expected a number from 1 to 65535" << std::endl;
+                return 2;
+            }
+        } else if (std::strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else {
+            return usage();
+        }
+    }
+
+    if (tcp.empty() && unix_paths.empty()) {
+        std::cerr << "nothing to listen on: give --tcp and/or --unix" << std::endl;
+        return 2;
+    }
+
+    std::unique_ptr<dcsm::reference_store> store;
+
+    try {
+        if (shm_name.empty()) {
+            store.reset(new dcsm::reference_store(universes));
+        } else {
+            store.reset(new dcsm::shm_reference_store(shm_name, universes));
+            std::cerr << "publishing universes in " << shm_name << std::endl;
+        }
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    dcsm::server server(*store);
+
+    try {
+        for (auto const& endpoint : tcp) {
+            auto const colon = endpoint.rfind(':');
+            std::string const address = colon == std::string::npos ? std::string() : endpoint.substr(0, colon);
+            auto const port = static_cast<uint16_t>(std::stoul(colon == std::string::npos ? endpoint : endpoint.substr(colon + 1)));
+
+            std::cerr << "listening on tcp port " << server.listen_tcp(port, address.empty() ? nullptr : address.c_str()) << std::endl;
+        }
+
+        for (auto const& path : unix_paths) {
+            server.listen_unix(path);
+            std::cerr << "listening on " << path << std::endl;
+        }
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+
+    while (g_running) {
+        server.poll(250);
+    }
+
+    std::cerr << server.accepted() << " connections, " << server.frames() << " frames served" << std::endl;
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <dcsm.hpp>
+#include <dcsm_capture.hpp>
+
+#include "report.hpp"
+
+// Replays a capture (see dcsm_capture.hpp) into a dispatch and reports throughput and per-frame latency.
+//
+//   dcsm_replay <capture file> [--timed] [--loops <n>]
+//
+// --timed feeds frames at their original timing, otherwise frames are fed as fast as possible.
+
+int main(int const argc, char** const argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <capture file> [--timed] [--loops <n>]" << std::endl;
+        return 2;
+    }
+
+    bool timed = false;
+    size_t loops = 1;
+
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--timed") == 0) {
+            timed = true;
+        } else if (std::strcmp(argv[i], "--loops") == 0 && i + 1 < argc) {
+            loops = std::max<size_t>(std::stoul(argv[++i]), 1);
+        } else {
+            std::cerr << "unknown argument: " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    dcsm::capture_reader reader(file);
+
+    if (!reader.valid()) {
+        std::cerr << "not a DCSM capture: " << argv[1] << std::endl;
+        return 1;
+    }
+
+    auto const frames = reader.read_all();
+
+    // Handlers do nothing, so the replay measures the library itself.
+    dcsm::dispatch_interface itf;
+    dcsm::dispatch dsp(itf);
+
+    std::vector<uint64_t> latency;
+    size_t total_frames = 0;
+    size_t total_bytes = 0;
+    size_t failures = 0;
+    uint64_t duration = 0;
+
+    for (size_t loop = 0; loop < loops; ++loop) {
+        auto result = dcsm::replay_capture(dsp, frames, timed);
+
+        latency.insert(latency.end(), result.latency.begin(), result.latency.end());
+        total_frames += result.frames;
+        total_bytes  += result.bytes;
+        failures     += result.failures;
+        duration     += result.duration;
+    }
+
+    print_throughput(total_frames, total_bytes, duration);
+    print_latency("per-frame", latency);
+
+    if (failures != 0) {
+        std::printf("%zu frames returned a non-success status\n", failures);
+    }
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef DCSM_TOOLS_REPORT_HPP
+#define DCSM_TOOLS_REPORT_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Shared result printing for the command-line tools.
+
+/// Value at a percentile (0-100) of sorted samples.
+inline uint64_t percentile(std::vector<uint64_t> const& a_sorted, double const a_percentile) {
+    if (a_sorted.empty()) {
+        return 0;
+    }
+
+    auto const index = static_cast<size_t>(a_percentile / 100.0 * static_cast<double>(a_sorted.size() - 1) + 0.5);
+    return a_sorted[std::min(index, a_sorted.size() - 1)];
+}
+
+/// Print p50/p99/p999/max of latency samples in ns (sorts the samples).
+inline void print_latency(char const* a_label, std::vector<uint64_t>& a_samples) {
+    std::sort(a_samples.begin(), a_samples.end());
+
+    std::printf("%s latency (ns): p50 %llu, p99 %llu, p999 %llu, max %llu\n",
+        a_label,
+        static_cast<unsigned long long>(percentile(a_samples, 50.0)),
+        static_cast<unsigned long long>(percentile(a_samples, 99.0)),
+        static_cast<unsigned long long>(percentile(a_samples, 99.9)),
+        static_cast<unsigned long long>(a_samples.empty() ? 0 : a_samples.back()));
+}
+
+/// Print frames/s and MB/s for a run.
+inline void print_throughput(size_t const a_frames, size_t const a_bytes, uint64_t const a_duration_ns) {
+    double const seconds = static_cast<double>(a_duration_ns) / 1e9;
+
+    std::printf("%zu frames, %zu bytes in %.3f s: %.0f frames/s, %.2f MB/s\n",
+        a_frames, a_bytes, seconds,
+        seconds > 0 ? static_cast<double>(a_frames) / seconds : 0.0,
+        seconds > 0 ? static_cast<double>(a_bytes) / seconds / 1e6 : 0.0);
+}
+
+#endif //DCSM_TOOLS_REPORT_HPP
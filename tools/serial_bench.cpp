@@ -0,0 +1,259 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+
+#include "report.hpp"
+
+// End-to-end serial latency over a pseudo-terminal pair (Linux only): a writer thread encodes frames
+// into the master end, a reader thread feeds the slave end through frame_decoder into a dispatch.
+//
+//   dcsm_serial_bench [--baud <bits/s>] [--frames <n>] [--mix setu|setv|mixed] [--read-buffer <bytes>] [--write-chunk <bytes>]
+//
+// Latency is measured from the write of a frame's first byte until its dcsm_setu/dcsm_setv callback
+// returns, so it includes transmission time at the throttled rate. --baud 0 writes as fast as the pty
+// accepts; otherwise writes are paced at 10 bits per byte (8N1). --read-buffer and --write-chunk mirror
+// the device's receive buffer and the host's USB transfer size.
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    enum class traffic_mix {
+        setu,
+        setv,
+        mixed
+    };
+
+    struct bench_options {
+        uint64_t    baud        = 0;
+        size_t      frames      = 10000;
+        traffic_mix mix         = traffic_mix::mixed;
+        size_t      read_buffer = 64;
+        size_t      write_chunk = 64;
+    };
+
+    int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief Records callback latency against the write times published by the writer thread.
+     *
+     * Frames arrive in order over the pty, so the n-th callback belongs to the n-th frame written.
+     */
+    class latency_interface final : public dcsm::dispatch_interface {
+        std::atomic<int64_t> const* m_sent;
+        std::vector<uint64_t> m_latency;
+
+    public:
+        explicit latency_interface(std::atomic<int64_t> const* a_sent, size_t const a_frames) :
+            m_sent(a_sent)
+        {
+            m_latency.reserve(a_frames);
+        }
+
+        void dcsm_setu(dcsm::command_context& a_ctx, uint16_t const a_universe, uint8_t const* a_data) override {
+            record();
+        }
+
+        void dcsm_setv(dcsm::command_context& a_ctx, std::vector<std::pair<dcsm::address_pack, uint8_t>> const& a_pairs) override {
+            record();
+        }
+
+        size_t received() const noexcept {
+            return m_latency.size();
+        }
+
+        std::vector<uint64_t>& latency() noexcept {
+            return m_latency;
+        }
+
+    private:
+        void record() {
+            int64_t const sent = m_sent[m_latency.size()].load(std::memory_order_acquire);
+            m_latency.push_back(static_cast<uint64_t>(std::max<int64_t>(now_ns() - sent, 0)));
+        }
+    };
+
+    /// One frame per entry; setv bursts are the size of a fixture group.
+    std::vector<std::vector<uint8_t>> generate_frames(bench_options const& a_options) {
+        std::vector<std::vector<uint8_t>> frames(a_options.frames);
+        std::array<uint8_t, 512> levels{};
+        std::vector<std::pair<dcsm::address_pack, uint8_t>> pairs;
+
+        for (size_t i = 0; i < frames.size(); ++i) {
+            bool const setu = a_options.mix == traffic_mix::setu || (a_options.mix == traffic_mix::mixed && i % 4 == 0);
+
+            if (setu) {
+                std::fill(levels.begin(), levels.end(), static_cast<uint8_t>(i));
+                dcsm::encode_setu(frames[i], static_cast<uint16_t>(1 + i % 16), levels.data());
+            } else {
+                pairs.clear();
+
+                for (uint16_t address = 1; address <= 16; ++address) {
+                    pairs.emplace_back(dcsm::address_pack{ static_cast<uint16_t>(1 + i % 16), address }, static_cast<uint8_t>(i));
+                }
+
+                dcsm::encode_setv(frames[i], pairs);
+            }
+        }
+
+        return frames;
+    }
+
+    bool write_all(int const a_fd, uint8_t const* a_data, size_t a_size) {
+        while (a_size != 0) {
+            ssize_t const written = ::write(a_fd, a_data, a_size);
+
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                return false;
+            }
+
+            a_data += written;
+            a_size -= static_cast<size_t>(written);
+        }
+
+        return true;
+    }
+
+    bool parse_mix(char const* a_text, traffic_mix& a_mix) {
+        if (std::strcmp(a_text, "setu") == 0) {
+            a_mix = traffic_mix::setu;
+        } else if (std::strcmp(a_text, "setv") == 0) {
+            a_mix = traffic_mix::setv;
+        } else if (std::strcmp(a_text, "mixed") == 0) {
+            a_mix = traffic_mix::mixed;
+        } else {
+            return false;
+        }
+
+        return true;
+    }
+}
+
+int main(int const argc, char** const argv) {
+    bench_options options;
+
+    for (int i = 1; i < argc; ++i) {
+        bool const has_value = i + 1 < argc;
+
+        if (std::strcmp(argv[i], "--baud") == 0 && has_value) {
+            options.baud = std::stoull(argv[++i]);
+        } else if (std::strcmp(argv[i], "--frames") == 0 && has_value) {
+            options.frames = std::max<size_t>(std::stoul(argv[++i]), 1);
+        } else if (std::strcmp(argv[i], "--mix") == 0 && has_value && parse_mix(argv[i + 1], options.mix)) {
+            ++i;
+        } else if (std::strcmp(argv[i], "--read-buffer") == 0 && has_value) {
+            options.read_buffer = std::max<size_t>(std::stoul(argv[++i]), 1);
+        } else if (std::strcmp(argv[i], "--write-chunk") == 0 && has_value) {
+            options.write_chunk = std::max<size_t>(std::stoul(argv[++i]), 1);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--baud <bits/s>] [--frames <n>] [--mix setu|setv|mixed] [--read-buffer <bytes>] [--write-chunk <bytes>]" << std::endl;
+            return 2;
+        }
+    }
+
+    int master = -1;
+    int slave  = -1;
+
+    if (openpty(&master, &slave, nullptr, nullptr, nullptr) != 0) {
+        std::perror("openpty");
+        return 1;
+    }
+
+    // Raw mode: no line discipline processing, no echo back to the writer.
+    termios attributes{};
+    tcgetattr(slave, &attributes);
+    cfmakeraw(&attributes);
+    tcsetattr(slave, TCSANOW, &attributes);
+
+    auto const frames = generate_frames(options);
+    std::unique_ptr<std::atomic<int64_t>[]> sent(new std::atomic<int64_t>[frames.size()]);
+
+    latency_interface itf(sent.get(), frames.size());
+    dcsm::dispatch dsp(itf);
+    dcsm::frame_decoder decoder(dsp);
+
+    size_t total_bytes = 0;
+
+    for (auto const& frame : frames) {
+        total_bytes += frame.size();
+    }
+
+    std::atomic<bool> write_failed{ false };
+    auto const start = clock::now();
+
+    std::thread writer([&] {
+        size_t bytes_written = 0;
+
+        for (size_t i = 0; i < frames.size(); ++i) {
+            auto const& frame = frames[i];
+
+            for (size_t offset = 0; offset < frame.size(); offset += options.write_chunk) {
+                size_t const size = std::min(options.write_chunk, frame.size() - offset);
+
+                if (options.baud != 0) {
+                    // A byte is 10 bits on the wire (start, 8 data, stop).
+                    std::this_thread::sleep_until(start + std::chrono::nanoseconds(bytes_written * 10 * 1000000000ull / options.baud));
+                }
+
+                if (offset == 0) {
+                    sent[i].store(now_ns(), std::memory_order_release);
+                }
+
+                if (!write_all(master, frame.data() + offset, size)) {
+                    write_failed = true;
+                    return;
+                }
+
+                bytes_written += size;
+            }
+        }
+    });
+
+    std::vector<uint8_t> buffer(options.read_buffer);
+
+    while (itf.received() < frames.size() && !write_failed) {
+        ssize_t const size = ::read(slave, buffer.data(), buffer.size());
+
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (size <= 0) {
+            break;
+        }
+
+        decoder.feed(buffer.data(), static_cast<size_t>(size));
+    }
+
+    auto const duration = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+
+    writer.join();
+    close(master);
+    close(slave);
+
+    if (itf.received() < frames.size()) {
+        std::cerr << "received " << itf.received() << " of " << frames.size() << " frames" << std::endl;
+        return 1;
+    }
+
+    std::printf("baud %llu, read buffer %zu, write chunk %zu\n", static_cast<unsigned long long>(options.baud), options.read_buffer, options.write_chunk);
+    print_throughput(frames.size(), total_bytes, duration);
+    print_latency("write-to-callback", itf.latency());
+
+    return 0;
+}
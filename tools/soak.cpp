@@ -0,0 +1,246 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include <dcsm.hpp>
+#include <dcsm_encoder.hpp>
+#include <dcsm_reference_store.hpp>
+
+#include "report.hpp"
+
+// Sustained-load soak test: generates show-like traffic for N universes at a framerate and feeds it,
+// in real time, through frame_decoder into a dispatch backed by a reference_store.
+//
+//   dcsm_soak [--universes <n>] [--framerate <hz>] [--duration <s>] [--chunk <bytes>] [--sweep]
+//
+// Per-frame latency is measured from when a frame is due (its slot at the framerate) until it has been
+// dispatched, so it includes any queueing behind earlier frames. --sweep searches for the universe
+// count at which the backlog starts to grow.
+
+namespace {
+    using clock = std::chrono::steady_clock;
+
+    struct soak_options {
+        size_t universes = 16;
+        double framerate = 44.0;
+        double duration  = 5.0;
+        size_t chunk     = 64; ///< Bytes per feed call, like a USB full-speed packet.
+        bool   sweep     = false;
+    };
+
+    struct soak_result {
+        size_t frames = 0;
+        size_t bytes  = 0;
+        uint64_t duration = 0;
+        std::vector<uint64_t> latency;
+        double backlog_start = 0; ///< Average frames behind over the first quarter of the run.
+        double backlog_end   = 0; ///< Average frames behind over the last quarter of the run.
+
+        bool falling_behind() const noexcept {
+            return backlog_end > backlog_start + 1.0;
+        }
+    };
+
+    /**
+     * Mixed traffic: a setu stream for every universe, bursty setv from faders, setutv from console
+     * selections and occasional getu/listp readbacks.
+     */
+    class traffic_generator {
+        size_t m_universes;
+        std::mt19937 m_random;
+        std::vector<std::array<uint8_t, 512>> m_levels;
+
+    public:
+        explicit traffic_generator(size_t const a_universes) :
+            m_universes(a_universes),
+            m_random(1234),
+            m_levels(a_universes)
+        {}
+
+        void generate(size_t const a_frame, std::vector<uint8_t>& a_out) {
+            std::uniform_real_distribution<double> chance(0.0, 1.0);
+            std::uniform_int_distribution<uint16_t> universe(1, static_cast<uint16_t>(m_universes));
+            std::uniform_int_distribution<uint16_t> address(1, 512);
+
+            for (size_t u = 0; u < m_universes; ++u) {
+                auto& levels = m_levels[u];
+
+                // Slow chase over the first fixtures, everything else static.
+                for (size_t i = 0; i < 96; ++i) {
+                    levels[i] = static_cast<uint8_t>((i * 8 + a_frame * 3 + u) & 0xFF);
+                }
+
+                dcsm::encode_setu(a_out, static_cast<uint16_t>(u + 1), levels.data());
+            }
+
+            if (chance(m_random) < 0.3) {
+                std::vector<std::pair<dcsm::address_pack, uint8_t>> pairs;
+                size_t const burst = std::uniform_int_distribution<size_t>(1, 32)(m_random);
+                uint16_t const fader_universe = universe(m_random);
+
+                for (size_t i = 0; i < burst; ++i) {
+                    pairs.emplace_back(dcsm::address_pack{ fader_universe, address(m_random) }, static_cast<uint8_t>(m_random()));
+                }
+
+                dcsm::encode_setv(a_out, pairs);
+            }
+
+            if (chance(m_random) < 0.05) {
+                dcsm::universe_mask selection;
+                size_t const first = address(m_random) - 1;
+
+                for (size_t i = first; i < std::min<size_t>(first + 48, 512); ++i) {
+                    selection.set(i);
+                }
+
+                dcsm::encode_setutv(a_out, universe(m_random), static_cast<uint8_t>(m_random()), selection);
+            }
+
+            if (chance(m_random) < 0.02) {
+                dcsm::encode_getu(a_out, universe(m_random));
+            }
+
+            if (chance(m_random) < 0.005) {
+                dcsm::encode_listp(a_out);
+            }
+        }
+    };
+
+    soak_result run_soak(size_t const a_universes, soak_options const& a_options) {
+        // Pre-generate a loop of frames so generation does not count towards latency. Bounded to about 64 MiB.
+        size_t const distinct_frames = std::max<size_t>(2, std::min<size_t>(64, (size_t{ 64 } << 20) / (a_universes * (dcsm::message_header_size + 514))));
+
+        traffic_generator generator(a_universes);
+        std::vector<std::vector<uint8_t>> frames(distinct_frames);
+
+        for (size_t i = 0; i < distinct_frames; ++i) {
+            generator.generate(i, frames[i]);
+        }
+
+        dcsm::reference_store store(a_universes);
+        dcsm::dispatch dsp(store);
+        dcsm::frame_decoder decoder(dsp);
+
+        auto const period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / a_options.framerate));
+        auto const frame_count = std::max<size_t>(static_cast<size_t>(a_options.duration * a_options.framerate), 4);
+
+        soak_result result;
+        result.latency.reserve(frame_count);
+
+        std::vector<double> backlog;
+        backlog.reserve(frame_count);
+
+        auto const start = clock::now();
+
+        for (size_t frame = 0; frame < frame_count; ++frame) {
+            auto const due = start + period * static_cast<clock::rep>(frame);
+
+            if (clock::now() < due) {
+                std::this_thread::sleep_until(due);
+            }
+
+            auto const& bytes = frames[frame % distinct_frames];
+
+            for (size_t offset = 0; offset < bytes.size(); offset += a_options.chunk) {
+                decoder.feed(bytes.data() + offset, std::min(a_options.chunk, bytes.size() - offset));
+            }
+
+            auto const late = clock::now() - due;
+
+            result.latency.push_back(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(late).count()));
+            backlog.push_back(std::chrono::duration<double>(late) / period);
+            result.bytes += bytes.size();
+        }
+
+        result.frames   = frame_count;
+        result.duration = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+
+        size_t const quarter = frame_count / 4;
+
+        for (size_t i = 0; i < quarter; ++i) {
+            result.backlog_start += backlog[i] / static_cast<double>(quarter);
+            result.backlog_end   += backlog[frame_count - quarter + i] / static_cast<double>(quarter);
+        }
+
+        return result;
+    }
+
+    void print_result(size_t const a_universes, soak_result& a_result) {
+        std::printf("--- %zu universes ---\n", a_universes);
+        print_throughput(a_result.frames, a_result.bytes, a_result.duration);
+        std::printf("%.0f universes/s\n", static_cast<double>(a_result.frames * a_universes) / (static_cast<double>(a_result.duration) / 1e9));
+        print_latency("per-frame", a_result.latency);
+        std::printf("backlog (frames behind): %.2f at start, %.2f at end%s\n", a_result.backlog_start, a_result.backlog_end, a_result.falling_behind() ? " - FALLING BEHIND" : "");
+    }
+}
+
+int main(int const argc, char** const argv) {
+    soak_options options;
+
+    for (int i = 1; i < argc; ++i) {
+        bool const has_value = i + 1 < argc;
+
+        if (std::strcmp(argv[i], "--universes") == 0 && has_value) {
+            options.universes = std::min<size_t>(std::max<size_t>(std::stoul(argv[++i]), 1), 0xFFFF);
+        } else if (std::strcmp(argv[i], "--framerate") == 0 && has_value) {
+            options.framerate = std::stod(argv[++i]);
+        } else if (std::strcmp(argv[i], "--duration") == 0 && has_value) {
+            options.duration = std::stod(argv[++i]);
+        } else if (std::strcmp(argv[i], "--chunk") == 0 && has_value) {
+            options.chunk = std::max<size_t>(std::stoul(argv[++i]), 1);
+        } else if (std::strcmp(argv[i], "--sweep") == 0) {
+            options.sweep = true;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--universes <n>] [--framerate <hz>] [--duration <s>] [--chunk <bytes>] [--sweep]" << std::endl;
+            return 2;
+        }
+    }
+
+    if (!options.sweep) {
+        auto result = run_soak(options.universes, options);
+        print_result(options.universes, result);
+
+        return result.falling_behind() ? 1 : 0;
+    }
+
+    // Double the universe count until the backlog grows, ending on --universes itself, then bisect.
+    size_t sustained = 0;
+    size_t failing = 0;
+
+    for (size_t universes = 1; universes <= options.universes; universes = std::min(universes * 2, options.universes)) {
+        auto result = run_soak(universes, options);
+        print_result(universes, result);
+
+        if (result.falling_behind()) {
+            failing = universes;
+            break;
+        }
+
+        sustained = universes;
+
+        if (universes == options.universes) {
+            break;
+        }
+    }
+
+    if (failing == 0) {
+        std::printf("\nsustained all %zu universes at %.1f Hz\n", sustained, options.framerate);
+        return 0;
+    }
+
+    // Bisect to within about 3%, finer steps are below the run-to-run noise.
+    while (failing - sustained > std::max<size_t>(1, failing / 32)) {
+        size_t const universes = sustained + (failing - sustained) / 2;
+
+        auto result = run_soak(universes, options);
+        print_result(universes, result);
+
+        (result.falling_behind() ? failing : sustained) = universes;
+    }
+
+    std::printf("\nsustained %zu universes at %.1f Hz; backlog grows from %zu universes\n", sustained, options.framerate, failing);
+
+    return 0;
+}